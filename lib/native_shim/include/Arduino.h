@@ -0,0 +1,69 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Host shim for the subset of the Arduino-ESP32 core used by the firmware
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+
+#define LOW    0x0
+#define HIGH   0x1
+#define INPUT  0x01
+#define OUTPUT 0x03
+
+#define LED_BUILTIN 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+
+#ifdef __cplusplus
+}
+
+#include <string>
+
+class String {
+public:
+    String(const char* str = "") : value(str ? str : "") {}
+    String(const std::string& str) : value(str) {}
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool operator==(const char* other) const { return value == other; }
+
+private:
+    std::string value;
+};
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(const uint8_t* data, size_t size) { return fwrite(data, 1, size, stdout); }
+    size_t print(const char* str) { return (size_t)fputs(str, stdout); }
+    size_t println(const char* str = "") { return print(str) + print("\n"); }
+    void flush() { fflush(stdout); }
+};
+
+extern HardwareSerial Serial;
+
+void setup(void);
+void loop(void);
+
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+// Host shim for the Arduino-ESP32 WiFi station API. Connections are made to
+// a simulated access point whose behaviour is configured with environment
+// variables (see sim_wifi.cpp); driver events are delivered from a
+// simulated driver task like the real Arduino event task.
+
+#include "Arduino.h"
+
+#ifdef __cplusplus
+
+#include <functional>
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA
+} wifi_mode_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef struct {
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+    wifi_event_sta_connected_t wifi_sta_connected;
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+// Disconnect reasons used by the simulated AP
+#define WIFI_REASON_ASSOC_LEAVE    8
+#define WIFI_REASON_BEACON_TIMEOUT 200
+#define WIFI_REASON_NO_AP_FOUND    201
+
+typedef size_t wifi_event_id_t;
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    uint8_t operator[](int index) const { return octets[index]; }
+    String toString() const;
+
+private:
+    uint8_t octets[4];
+};
+
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* passphrase = NULL, int32_t channel = 0,
+                      const uint8_t* bssid = NULL, bool connect = true);
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    bool mode(wifi_mode_t mode);
+    bool setAutoReconnect(bool auto_reconnect);
+    wl_status_t status();
+
+    String SSID() const;
+    IPAddress localIP();
+    uint8_t* BSSID();
+    int32_t channel();
+
+    wifi_event_id_t onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    void removeEvent(wifi_event_id_t id);
+};
+
+extern WiFiClass WiFi;
+
+#endif
+
+#endif
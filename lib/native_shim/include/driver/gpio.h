@@ -0,0 +1,9 @@
+#ifndef SIM_DRIVER_GPIO_H
+#define SIM_DRIVER_GPIO_H
+
+// ESP32-S3: GPIO0-48
+#define SOC_GPIO_PIN_COUNT 49
+#define GPIO_IS_VALID_GPIO(pin) ((unsigned)(pin) < SOC_GPIO_PIN_COUNT)
+#define GPIO_IS_VALID_OUTPUT_GPIO(pin) GPIO_IS_VALID_GPIO(pin)
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated heap of SIM_HEAP_SIZE bytes less the host's live allocations
+#define SIM_HEAP_SIZE (320 * 1024)
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+uint32_t esp_random(void);
+void esp_restart(void) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
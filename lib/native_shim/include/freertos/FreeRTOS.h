@@ -0,0 +1,69 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+// Host shim: FreeRTOS types and constants as configured by ESP-IDF
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+typedef TickType_t EventBits_t;
+
+typedef struct sim_task* TaskHandle_t;
+typedef struct sim_event_group* EventGroupHandle_t;
+typedef struct sim_queue* QueueHandle_t;
+
+typedef void (*TaskFunction_t)(void*);
+
+// Opaque storage for the *CreateStatic() calls, large enough for the
+// simulator's own objects (checked in sim_kernel.c)
+typedef struct { void* opaque[32]; } StaticTask_t;
+typedef struct { void* opaque[2]; } StaticEventGroup_t;
+typedef struct { void* opaque[6]; } StaticQueue_t;
+
+#define configTICK_RATE_HZ 1000
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configUSE_TRACE_FACILITY 1
+#define configGENERATE_RUN_TIME_STATS 0
+#define configMAX_PRIORITIES 25
+
+#define portNUM_PROCESSORS 2
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+#define errQUEUE_FULL 0
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define tskIDLE_PRIORITY 0
+
+// Only one simulated task runs at a time, so critical sections are no-ops
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define taskENTER_CRITICAL(mux) ((void)(mux))
+#define taskEXIT_CRITICAL(mux) ((void)(mux))
+
+// Trace hooks, called by the scheduler as in FreeRTOS; a build defines the
+// ones it needs before this header (see trace_recorder_hooks.h)
+#ifndef traceTASK_SWITCHED_IN
+#define traceTASK_SWITCHED_IN()
+#endif
+#ifndef traceTASK_SWITCHED_OUT
+#define traceTASK_SWITCHED_OUT()
+#endif
+
+#endif
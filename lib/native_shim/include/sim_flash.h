@@ -0,0 +1,28 @@
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H
+
+// Access counters for the simulated data partitions behind esp_partition.h,
+// so tests can see how many reads a lookup takes and how often a sector is
+// erased. Counts are per partition and never reset.
+
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t erased_sectors;
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+} sim_flash_stats_t;
+
+bool sim_flash_get_stats(const esp_partition_t* partition, sim_flash_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+// Virtual-time scheduler behind the FreeRTOS shim. Simulated tasks are
+// pthreads, but only the highest-priority ready task runs at any moment and
+// code executes in zero virtual time; the tick counter advances only when
+// every task is blocked. Runs are therefore repeatable and independent of
+// host load.
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Stops the simulation (and the process) once the tick count reaches end_tick
+void sim_kernel_init(TickType_t end_tick);
+// Exit status when the simulation ends by itself (duration reached or every
+// task blocked forever); 0 by default. Unit tests end the process with their
+// result and set it non-zero, so a test that hangs fails instead.
+void sim_kernel_set_finish_status(int status);
+void sim_kernel_run(void) __attribute__((noreturn));
+// Synthetic CPU load for scheduling tests: the caller keeps one of its cores
+// busy for ticks of virtual time and returns when it has had them. Tasks of
+// higher (or equal, standing in for time slicing) priority still run on that
+// core; lower-priority ones allowed only there wait. tskNO_AFFINITY tasks
+// take whichever core is free.
+void sim_kernel_busy(TickType_t ticks);
+void sim_kernel_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
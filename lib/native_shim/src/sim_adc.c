@@ -0,0 +1,108 @@
+#include "driver/adc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+
+#include <math.h>
+#include <string.h>
+
+#define SIM_ADC_MAX_PATTERN 8
+#define SIM_ADC_SIGNAL_PERIOD_S 30.0
+
+static bool initialized = false;
+static bool started = false;
+static uint32_t frame_bytes = 0;
+static uint32_t sample_freq_hz = 0;
+static uint8_t pattern_channels[SIM_ADC_MAX_PATTERN];
+static uint32_t pattern_count = 0;
+static uint64_t sample_index = 0;
+static uint64_t start_us = 0;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config) {
+    if (!init_config || init_config->conv_num_each_intr == 0) return ESP_ERR_INVALID_ARG;
+    if (initialized) return ESP_ERR_INVALID_STATE;
+
+    frame_bytes = init_config->conv_num_each_intr;
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config) {
+    if (!initialized) return ESP_ERR_INVALID_STATE;
+    if (!config || config->pattern_num == 0 || config->pattern_num > SIM_ADC_MAX_PATTERN ||
+        config->sample_freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (uint32_t i = 0; i < config->pattern_num; i++) {
+        pattern_channels[i] = config->adc_pattern[i].channel;
+    }
+    pattern_count = config->pattern_num;
+    sample_freq_hz = config->sample_freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_start(void) {
+    if (!initialized || pattern_count == 0) return ESP_ERR_INVALID_STATE;
+
+    started = true;
+    sample_index = 0;
+    start_us = (uint64_t)xTaskGetTickCount() * portTICK_PERIOD_MS * 1000ULL;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_stop(void) {
+    started = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize(void) {
+    initialized = false;
+    started = false;
+    return ESP_OK;
+}
+
+static uint32_t sim_adc_value(uint8_t channel, uint64_t index) {
+    double t = (double)index / sample_freq_hz;
+    double phase = 2.0 * M_PI * t / SIM_ADC_SIGNAL_PERIOD_S + channel;
+    int32_t noise = (int32_t)(esp_random() % 65) - 32;
+    int32_t value = 2048 + (int32_t)(800.0 * sin(phase)) + noise;
+
+    if (value < 0) value = 0;
+    if (value > 4095) value = 4095;
+    return (uint32_t)value;
+}
+
+// Blocks until one DMA frame worth of conversions exists in virtual time
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms) {
+    if (!started) return ESP_ERR_INVALID_STATE;
+
+    uint32_t bytes = (length_max < frame_bytes ? length_max : frame_bytes) & ~(SOC_ADC_DIGI_RESULT_BYTES - 1);
+    uint32_t results = bytes / SOC_ADC_DIGI_RESULT_BYTES;
+
+    // Virtual time at which the last conversion of this frame completes
+    uint64_t ready_us = start_us + ((sample_index + results) * 1000000ULL) / sample_freq_hz;
+    uint64_t now_us = (uint64_t)xTaskGetTickCount() * portTICK_PERIOD_MS * 1000ULL;
+
+    if (ready_us > now_us) {
+        uint64_t wait_ms = (ready_us - now_us + 999) / 1000;
+        if (wait_ms > timeout_ms) {
+            vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+            *out_length = 0;
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+    }
+
+    adc_digi_output_data_t* out = (adc_digi_output_data_t*)buf;
+    for (uint32_t i = 0; i < results; i++) {
+        uint8_t channel = pattern_channels[(sample_index + i) % pattern_count];
+        out[i].val = 0;
+        out[i].type2.channel = channel;
+        out[i].type2.data = sim_adc_value(channel, sample_index + i);
+    }
+
+    sample_index += results;
+    *out_length = bytes;
+    return ESP_OK;
+}
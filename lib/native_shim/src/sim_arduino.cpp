@@ -0,0 +1,94 @@
+#include "Arduino.h"
+#include "WiFi.h"
+
+#include <malloc.h>
+#include "esp_timer.h"
+
+static const char* TAG = "SimGpio";
+
+#define SIM_PIN_COUNT 128
+
+static uint8_t pin_levels[SIM_PIN_COUNT];
+static uint32_t pin_writes[SIM_PIN_COUNT];
+static uint32_t minimum_free_heap = SIM_HEAP_SIZE;
+static uint32_t random_state = 0x2545F491;
+
+HardwareSerial Serial;
+
+extern "C" {
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+// Set SIM_TRACE_GPIO=1 to log every level change with its virtual time
+void digitalWrite(uint8_t pin, uint8_t value) {
+    static int trace = -1;
+    if (trace < 0) {
+        trace = getenv("SIM_TRACE_GPIO") != NULL;
+    }
+
+    if (pin >= SIM_PIN_COUNT) return;
+
+    if (trace && pin_levels[pin] != value) {
+        ESP_LOGI(TAG, "pin %d -> %d", pin, value);
+    }
+    pin_levels[pin] = value;
+    pin_writes[pin]++;
+}
+
+int digitalRead(uint8_t pin) {
+    return (pin < SIM_PIN_COUNT) ? pin_levels[pin] : LOW;
+}
+
+unsigned long millis(void) {
+    return (unsigned long)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+unsigned long micros(void) {
+    return (unsigned long)esp_timer_get_time();
+}
+
+void delay(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    struct mallinfo2 info = mallinfo2();
+    uint32_t used = (uint32_t)info.uordblks;
+    uint32_t free_bytes = (used < SIM_HEAP_SIZE) ? SIM_HEAP_SIZE - used : 0;
+
+    if (free_bytes < minimum_free_heap) {
+        minimum_free_heap = free_bytes;
+    }
+    return free_bytes;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+    esp_get_free_heap_size();
+    return minimum_free_heap;
+}
+
+// Deterministic so simulation runs are repeatable
+uint32_t esp_random(void) {
+    uint32_t x = random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    random_state = x;
+    return x;
+}
+
+void esp_restart(void) {
+    ESP_LOGW("SimSystem", "esp_restart() called, ending simulation");
+    exit(1);
+}
+
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buffer);
+}
@@ -0,0 +1,104 @@
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <stdlib.h>
+
+// ESP_TIMER_TASK dispatch on the virtual clock. Simulated tasks never run
+// concurrently, so the timer list needs no lock.
+
+#define SIM_ESP_TIMER_PRIORITY 22
+#define SIM_ESP_TIMER_STACK 4096
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    int64_t alarm_us;
+    bool armed;
+    struct esp_timer* next;
+};
+
+static struct esp_timer* timer_list = NULL;
+static TaskHandle_t timer_task = NULL;
+
+static void sim_esp_timer_task(void* arg) {
+    (void)arg;
+
+    for (;;) {
+        struct esp_timer* earliest = NULL;
+        for (struct esp_timer* timer = timer_list; timer; timer = timer->next) {
+            if (timer->armed && (!earliest || timer->alarm_us < earliest->alarm_us)) {
+                earliest = timer;
+            }
+        }
+
+        int64_t now_us = esp_timer_get_time();
+        if (earliest && earliest->alarm_us <= now_us) {
+            // Disarmed first, so the callback can start it again
+            earliest->armed = false;
+            earliest->callback(earliest->arg);
+            continue;
+        }
+
+        TickType_t wait = portMAX_DELAY;
+        if (earliest) {
+            int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+            wait = (TickType_t)((earliest->alarm_us - now_us + tick_us - 1) / tick_us);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle) {
+    if (!args || !args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+
+    if (!timer_task &&
+        xTaskCreate(sim_esp_timer_task, "esp_timer", SIM_ESP_TIMER_STACK, NULL,
+                    SIM_ESP_TIMER_PRIORITY, &timer_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    struct esp_timer* timer = (struct esp_timer*)calloc(1, sizeof(*timer));
+    if (!timer) return ESP_ERR_NO_MEM;
+
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    timer->next = timer_list;
+    timer_list = timer;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+
+    timer->alarm_us = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->armed = true;
+    xTaskNotifyGive(timer_task);
+    return ESP_OK;
+}
+
+// ESP_ERR_INVALID_STATE when not armed, including while its callback runs
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (!timer->armed) return ESP_ERR_INVALID_STATE;
+
+    timer->armed = false;
+    return ESP_OK;
+}
+
+// Like ESP-IDF 4.4, an armed timer has to be stopped first
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+
+    for (struct esp_timer** link = &timer_list; *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+    free(timer);
+    return ESP_OK;
+}
@@ -0,0 +1,138 @@
+#include "esp_partition.h"
+#include "sim_flash.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIM_FLASH_MAX_PARTITIONS 8
+
+typedef struct {
+    esp_partition_t partition;
+    uint8_t* data;
+    sim_flash_stats_t stats;
+} sim_partition_t;
+
+static sim_partition_t partitions[SIM_FLASH_MAX_PARTITIONS];
+static int partition_count = 0;
+
+static uint32_t sim_flash_size(void) {
+    const char* value = getenv("SIM_FLASH_SIZE_KB");
+    uint32_t kb = value ? (uint32_t)strtoul(value, NULL, 10) : 384;
+    return (kb ? kb : 384) * 1024;
+}
+
+// One image file per label: "<SIM_FLASH_IMAGE>.<label>"
+static uint8_t* sim_flash_map(const char* label, uint32_t size) {
+    const char* image = getenv("SIM_FLASH_IMAGE");
+
+    if (!image) {
+        uint8_t* data = (uint8_t*)malloc(size);
+        if (data) memset(data, 0xFF, size);
+        return data;
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s.%s", image, label);
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    bool fresh = fstat(fd, &st) == 0 && st.st_size != (off_t)size;
+    if (fresh && ftruncate(fd, size) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    uint8_t* data = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    // A new (or resized) image starts fully erased
+    if (fresh) memset(data, 0xFF, size);
+    return data;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    if (type != ESP_PARTITION_TYPE_DATA || !label) return NULL;
+
+    for (int i = 0; i < partition_count; i++) {
+        if (strcmp(partitions[i].partition.label, label) == 0) {
+            return &partitions[i].partition;
+        }
+    }
+
+    if (partition_count == SIM_FLASH_MAX_PARTITIONS) return NULL;
+
+    sim_partition_t* sim = &partitions[partition_count];
+    uint32_t size = sim_flash_size();
+
+    sim->data = sim_flash_map(label, size);
+    if (!sim->data) return NULL;
+
+    memset(&sim->partition, 0, sizeof(sim->partition));
+    memset(&sim->stats, 0, sizeof(sim->stats));
+    sim->partition.type = type;
+    sim->partition.subtype = subtype;
+    sim->partition.address = 0x390000 + (uint32_t)partition_count * size;
+    sim->partition.size = size;
+    strncpy(sim->partition.label, label, sizeof(sim->partition.label) - 1);
+    partition_count++;
+    return &sim->partition;
+}
+
+static sim_partition_t* sim_partition(const esp_partition_t* partition) {
+    return (sim_partition_t*)partition; // partition is the first member
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    if (!partition || !dst) return ESP_ERR_INVALID_ARG;
+    if (src_offset > partition->size || size > partition->size - src_offset) return ESP_ERR_INVALID_SIZE;
+
+    sim_partition_t* sim = sim_partition(partition);
+    sim->stats.reads++;
+    sim->stats.read_bytes += size;
+    memcpy(dst, sim->data + src_offset, size);
+    return ESP_OK;
+}
+
+// NOR semantics: programming can only clear bits, so writing over data that
+// was not erased first corrupts it the same way it would on the chip
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    if (!partition || !src) return ESP_ERR_INVALID_ARG;
+    if (dst_offset > partition->size || size > partition->size - dst_offset) return ESP_ERR_INVALID_SIZE;
+
+    sim_partition_t* sim = sim_partition(partition);
+    sim->stats.writes++;
+    sim->stats.write_bytes += size;
+
+    uint8_t* data = sim->data + dst_offset;
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        data[i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (!partition) return ESP_ERR_INVALID_ARG;
+    if (offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+    if (offset > partition->size || size > partition->size - offset) return ESP_ERR_INVALID_SIZE;
+
+    sim_partition(partition)->stats.erased_sectors += size / SPI_FLASH_SEC_SIZE;
+    memset(sim_partition(partition)->data + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+bool sim_flash_get_stats(const esp_partition_t* partition, sim_flash_stats_t* stats) {
+    if (!partition || !stats) return false;
+
+    *stats = sim_partition(partition)->stats;
+    return true;
+}
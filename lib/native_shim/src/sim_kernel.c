@@ -0,0 +1,818 @@
+#include "sim_kernel.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Host threads need far more stack than the firmware asks for (printf alone
+// uses several KB), so simulated tasks get at least this much.
+#define SIM_MIN_THREAD_STACK (256 * 1024)
+
+typedef enum {
+    SIM_TASK_READY = 0,
+    SIM_TASK_BLOCKED,
+    SIM_TASK_DELETED
+} sim_task_state_t;
+
+struct sim_task {
+    pthread_t thread;
+    pthread_cond_t cond;
+    char name[16];
+    TaskFunction_t function;
+    void* arg;
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    BaseType_t core_id;
+    sim_task_state_t state;
+    uint64_t ready_seq;
+    const void* wait_object;
+    bool has_timeout;
+    bool timed_out;
+    TickType_t busy_ticks; // CPU time still to burn in sim_kernel_busy()
+    int busy_core;         // Core it burns it on this tick, -1 if none
+    bool killed;
+    bool thread_exited; // Its host thread no longer touches this struct
+    TickType_t wake_tick;
+    uint32_t notify_value;
+    uint32_t switches;
+    bool is_static;
+    struct sim_task* next;
+};
+
+struct sim_event_group {
+    EventBits_t bits;
+    bool is_static;
+};
+
+struct sim_queue {
+    bool is_static;
+    uint8_t* storage;
+    UBaseType_t item_size;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+_Static_assert(sizeof(StaticTask_t) >= sizeof(struct sim_task), "StaticTask_t too small");
+_Static_assert(sizeof(StaticEventGroup_t) >= sizeof(struct sim_event_group), "StaticEventGroup_t too small");
+_Static_assert(sizeof(StaticQueue_t) >= sizeof(struct sim_queue), "StaticQueue_t too small");
+
+static pthread_mutex_t kernel_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_task* task_list = NULL;
+static struct sim_task* current = NULL;
+static volatile TickType_t tick_count = 0;
+static TickType_t end_tick = portMAX_DELAY;
+static uint64_t ready_counter = 0;
+static uint64_t context_switches = 0;
+static esp_log_level_t log_level = ESP_LOG_INFO;
+static int finish_status = 0;
+static const char busy_marker = 0; // wait_object of tasks in sim_kernel_busy()
+static unsigned busy_tasks = 0;
+static pthread_cond_t exit_cond = PTHREAD_COND_INITIALIZER; // A task thread exited
+
+// Scheduler internals; all called with kernel_lock held
+
+static void sim_finish(const char* reason) __attribute__((noreturn));
+
+static void sim_make_ready(struct sim_task* task) {
+    task->state = SIM_TASK_READY;
+    task->ready_seq = ++ready_counter;
+    task->wait_object = NULL;
+    task->has_timeout = false;
+}
+
+static void sim_wake_waiters(const void* object) {
+    for (struct sim_task* task = task_list; task; task = task->next) {
+        if (task->state == SIM_TASK_BLOCKED && task->wait_object == object) {
+            sim_make_ready(task);
+        }
+    }
+}
+
+static bool sim_runs_on(const struct sim_task* task, int core) {
+    return task->core_id == tskNO_AFFINITY || task->core_id == core;
+}
+
+// The task burning CPU on each core this tick: busy tasks take cores in
+// priority order, each the first free one it may run on
+static void sim_assign_cores(struct sim_task* occupant[portNUM_PROCESSORS]) {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        occupant[core] = NULL;
+    }
+    if (!busy_tasks) return;
+
+    for (struct sim_task* task = task_list; task; task = task->next) {
+        task->busy_core = -1;
+    }
+
+    for (int round = 0; round < portNUM_PROCESSORS; round++) {
+        struct sim_task* best = NULL;
+        int best_core = -1;
+        for (struct sim_task* task = task_list; task; task = task->next) {
+            if (task->wait_object != &busy_marker || task->state != SIM_TASK_BLOCKED || task->busy_core >= 0) continue;
+            if (best && task->priority <= best->priority) continue;
+
+            for (int core = 0; core < portNUM_PROCESSORS; core++) {
+                if (!occupant[core] && sim_runs_on(task, core)) {
+                    best = task;
+                    best_core = core;
+                    break;
+                }
+            }
+        }
+        if (!best) break;
+
+        best->busy_core = best_core;
+        occupant[best_core] = best;
+    }
+}
+
+// Highest-priority ready task with a core to run on. A core burning CPU
+// for a busy task only takes a task of at least its priority; equal
+// priority stands in for time slicing.
+static struct sim_task* sim_highest_ready(void) {
+    struct sim_task* occupant[portNUM_PROCESSORS];
+    sim_assign_cores(occupant);
+
+    struct sim_task* best = NULL;
+    for (struct sim_task* task = task_list; task; task = task->next) {
+        if (task->state != SIM_TASK_READY) continue;
+        if (best && (task->priority < best->priority ||
+                     (task->priority == best->priority && task->ready_seq > best->ready_seq))) {
+            continue;
+        }
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            if (sim_runs_on(task, core) && (!occupant[core] || occupant[core]->priority <= task->priority)) {
+                best = task;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+// One tick of CPU for every task burning it; they become ready once done
+static void sim_burn_tick(void) {
+    struct sim_task* occupant[portNUM_PROCESSORS];
+    sim_assign_cores(occupant);
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (occupant[core] && --occupant[core]->busy_ticks == 0) {
+            busy_tasks--;
+            sim_make_ready(occupant[core]);
+        }
+    }
+}
+
+// Pick the next task to run, advancing virtual time to the earliest timeout
+// when nothing is ready. While tasks burn CPU, time advances a tick at a
+// time instead.
+static struct sim_task* sim_pick_next(void) {
+    for (;;) {
+        struct sim_task* next = sim_highest_ready();
+        if (next) return next;
+
+        if (busy_tasks) {
+            if ((int32_t)(tick_count + 1 - end_tick) >= 0) {
+                tick_count = end_tick;
+                sim_finish("simulated duration reached");
+            }
+            sim_burn_tick();
+            tick_count++;
+            for (struct sim_task* task = task_list; task; task = task->next) {
+                if (task->state == SIM_TASK_BLOCKED && task->has_timeout &&
+                    (int32_t)(task->wake_tick - tick_count) <= 0) {
+                    sim_make_ready(task);
+                    task->timed_out = true;
+                }
+            }
+            continue;
+        }
+
+        struct sim_task* earliest = NULL;
+        for (struct sim_task* task = task_list; task; task = task->next) {
+            if (task->state == SIM_TASK_BLOCKED && task->has_timeout &&
+                (!earliest || (int32_t)(task->wake_tick - earliest->wake_tick) < 0)) {
+                earliest = task;
+            }
+        }
+
+        if (!earliest) {
+            sim_finish("every task is blocked forever");
+        }
+
+        if ((int32_t)(earliest->wake_tick - end_tick) >= 0) {
+            tick_count = end_tick;
+            sim_finish("simulated duration reached");
+        }
+
+        if ((int32_t)(earliest->wake_tick - tick_count) > 0) {
+            tick_count = earliest->wake_tick;
+        }
+
+        for (struct sim_task* task = task_list; task; task = task->next) {
+            if (task->state == SIM_TASK_BLOCKED && task->has_timeout &&
+                (int32_t)(task->wake_tick - tick_count) <= 0) {
+                sim_make_ready(task);
+                task->timed_out = true;
+            }
+        }
+    }
+}
+
+static void sim_wait_until_current(struct sim_task* self) {
+    while (current != self) {
+        if (self->killed) {
+            self->thread_exited = true;
+            pthread_cond_broadcast(&exit_cond);
+            pthread_mutex_unlock(&kernel_lock);
+            pthread_exit(NULL);
+        }
+        pthread_cond_wait(&self->cond, &kernel_lock);
+    }
+}
+
+static void sim_switch_to(struct sim_task* next) {
+    if (next != current) {
+        context_switches++;
+        next->switches++;
+        if (current) {
+            traceTASK_SWITCHED_OUT();
+        }
+        current = next;
+        traceTASK_SWITCHED_IN();
+    }
+    pthread_cond_signal(&next->cond);
+}
+
+// Hand the CPU to whichever task should run now; returns once the caller is
+// scheduled again.
+static void sim_reschedule(void) {
+    struct sim_task* self = current;
+    struct sim_task* next = sim_pick_next();
+
+    if (next != self) {
+        sim_switch_to(next);
+        sim_wait_until_current(self);
+    }
+}
+
+// Preempt the caller if waking others made a higher-priority task ready
+static void sim_preempt_check(void) {
+    struct sim_task* self = current;
+    if (!self) return;
+
+    struct sim_task* best = sim_highest_ready();
+    if (best && best != self && best->priority > self->priority) {
+        sim_make_ready(self);
+        sim_reschedule();
+    }
+}
+
+// Block the caller on an object until woken or until the timeout expires.
+// Returns false on timeout.
+static bool sim_block(const void* object, TickType_t deadline, bool has_timeout) {
+    struct sim_task* self = current;
+
+    self->state = SIM_TASK_BLOCKED;
+    self->wait_object = object;
+    self->has_timeout = has_timeout;
+    self->wake_tick = deadline;
+    self->timed_out = false;
+
+    sim_reschedule();
+    return !self->timed_out;
+}
+
+static void sim_finish(const char* reason) {
+    printf("[%7lu][SIM]: Simulation finished: %s\n", (unsigned long)tick_count, reason);
+    sim_kernel_print_stats();
+    fflush(stdout);
+    exit(finish_status);
+}
+
+static void* sim_task_entry(void* arg) {
+    struct sim_task* self = (struct sim_task*)arg;
+
+    pthread_mutex_lock(&kernel_lock);
+    sim_wait_until_current(self);
+    pthread_mutex_unlock(&kernel_lock);
+
+    self->function(self->arg);
+
+    // FreeRTOS tasks must not return; treat it as self-deletion
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+// Kernel control
+
+void sim_kernel_init(TickType_t duration_ticks) {
+    const char* level = getenv("SIM_LOG_LEVEL");
+    if (level) {
+        log_level = (esp_log_level_t)atoi(level);
+    }
+
+    end_tick = duration_ticks;
+}
+
+void sim_kernel_set_finish_status(int status) {
+    finish_status = status;
+}
+
+void sim_kernel_run(void) {
+    pthread_mutex_lock(&kernel_lock);
+    sim_switch_to(sim_pick_next());
+
+    // The host main thread only waits; sim_finish() ends the process
+    pthread_cond_t never = PTHREAD_COND_INITIALIZER;
+    for (;;) {
+        pthread_cond_wait(&never, &kernel_lock);
+    }
+}
+
+void sim_kernel_busy(TickType_t ticks) {
+    if (ticks == 0) return;
+
+    pthread_mutex_lock(&kernel_lock);
+
+    struct sim_task* self = current;
+    self->busy_ticks = ticks;
+    busy_tasks++;
+    sim_block(&busy_marker, 0, false);
+
+    pthread_mutex_unlock(&kernel_lock);
+}
+
+void sim_kernel_print_stats(void) {
+    printf("[%7lu][SIM]: %llu context switches\n",
+           (unsigned long)tick_count, (unsigned long long)context_switches);
+    printf("[%7lu][SIM]: %-16s %4s %6s %10s %8s\n",
+           (unsigned long)tick_count, "task", "prio", "stack", "switches", "state");
+
+    for (struct sim_task* task = task_list; task; task = task->next) {
+        static const char* states[] = { "ready", "blocked", "deleted" };
+        printf("[%7lu][SIM]: %-16s %4u %6lu %10lu %8s\n",
+               (unsigned long)tick_count, task->name, task->priority,
+               (unsigned long)task->stack_depth, (unsigned long)task->switches,
+               states[task->state]);
+    }
+}
+
+void sim_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+
+    if (level > log_level) return;
+
+    va_list args;
+    va_start(args, format);
+    printf("[%7lu][%c][%s]: ", (unsigned long)tick_count, letters[level], tag);
+    vprintf(format, args);
+    putchar('\n');
+    va_end(args);
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)tick_count * portTICK_PERIOD_MS * 1000;
+}
+
+// Tasks
+
+// A deleted task leaves the task list, so its control block can be freed
+// or, for a static task, its buffer reused or overwritten
+static void sim_unlink(struct sim_task* task) {
+    for (struct sim_task** link = &task_list; *link; link = &(*link)->next) {
+        if (*link == task) {
+            *link = task->next;
+            return;
+        }
+    }
+}
+
+// The host thread stack is always allocated by pthreads; a static task
+// only keeps its control block in the caller's buffer
+static BaseType_t sim_task_create(struct sim_task* task, TaskFunction_t fn, const char* name,
+                                  uint32_t stack_depth, void* arg, UBaseType_t priority,
+                                  TaskHandle_t* handle, BaseType_t core_id) {
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->function = fn;
+    task->arg = arg;
+    task->priority = priority;
+    task->stack_depth = stack_depth;
+    task->core_id = core_id;
+    pthread_cond_init(&task->cond, NULL);
+
+    pthread_mutex_lock(&kernel_lock);
+
+    sim_make_ready(task);
+    task->next = task_list;
+    task_list = task;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, stack_depth > SIM_MIN_THREAD_STACK ? stack_depth : SIM_MIN_THREAD_STACK);
+
+    if (pthread_create(&task->thread, &attr, sim_task_entry, task) != 0) {
+        task->state = SIM_TASK_DELETED;
+        sim_unlink(task);
+        pthread_attr_destroy(&attr);
+        pthread_mutex_unlock(&kernel_lock);
+        return pdFAIL;
+    }
+    pthread_attr_destroy(&attr);
+
+    if (handle) {
+        *handle = task;
+    }
+
+    sim_preempt_check();
+    pthread_mutex_unlock(&kernel_lock);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core_id) {
+    struct sim_task* task = (struct sim_task*)calloc(1, sizeof(struct sim_task));
+    if (!task) return pdFAIL;
+
+    return sim_task_create(task, fn, name, stack_depth, arg, priority, handle, core_id);
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                                           void* arg, UBaseType_t priority, StackType_t* stack,
+                                           StaticTask_t* task_buffer, BaseType_t core_id) {
+    if (!stack || !task_buffer) return NULL;
+
+    struct sim_task* task = (struct sim_task*)task_buffer;
+
+    memset(task, 0, sizeof(*task));
+    task->is_static = true;
+
+    TaskHandle_t handle = NULL;
+    sim_task_create(task, fn, name, stack_depth, arg, priority, &handle, core_id);
+    return handle;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                               void* arg, UBaseType_t priority, StackType_t* stack,
+                               StaticTask_t* task_buffer) {
+    return xTaskCreateStaticPinnedToCore(fn, name, stack_depth, arg, priority, stack,
+                                         task_buffer, tskNO_AFFINITY);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    pthread_mutex_lock(&kernel_lock);
+
+    if (!task || task == current) {
+        struct sim_task* self = current;
+        self->state = SIM_TASK_DELETED;
+        self->thread_exited = true; // Only pthread_exit() after the unlock
+        sim_unlink(self);
+        sim_switch_to(sim_pick_next());
+        if (!self->is_static) {
+            free(self);
+        }
+        pthread_mutex_unlock(&kernel_lock);
+        pthread_exit(NULL);
+    }
+
+    // The victim is parked inside the kernel; wake it so its thread exits
+    if (task->state != SIM_TASK_DELETED) {
+        if (task->state == SIM_TASK_BLOCKED && task->wait_object == &busy_marker) {
+            busy_tasks--;
+        }
+        task->state = SIM_TASK_DELETED;
+        task->killed = true;
+        pthread_cond_signal(&task->cond);
+    }
+
+    // As on the target, the control block is free once this returns
+    while (!task->thread_exited) {
+        pthread_cond_wait(&exit_cond, &kernel_lock);
+    }
+    sim_unlink(task);
+    if (!task->is_static) {
+        free(task);
+    }
+    pthread_mutex_unlock(&kernel_lock);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    pthread_mutex_lock(&kernel_lock);
+
+    if (ticks == 0) {
+        sim_make_ready(current); // Yield to tasks of equal priority
+        sim_reschedule();
+    } else {
+        sim_block(NULL, tick_count + ticks, true);
+    }
+
+    pthread_mutex_unlock(&kernel_lock);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t* previous_wake_time, TickType_t increment) {
+    pthread_mutex_lock(&kernel_lock);
+
+    TickType_t target = *previous_wake_time + increment;
+    BaseType_t delayed = pdFALSE;
+    *previous_wake_time = target;
+
+    if ((int32_t)(target - tick_count) > 0) {
+        sim_block(NULL, target, true);
+        delayed = pdTRUE;
+    }
+
+    pthread_mutex_unlock(&kernel_lock);
+    return delayed;
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t increment) {
+    xTaskDelayUntil(previous_wake_time, increment);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return tick_count;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    task = task ? task : current;
+    return task ? task->name : "";
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    task = task ? task : current;
+    return task ? task->priority : 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Host stacks are not comparable to target stacks; report the request
+    task = task ? task : current;
+    return task ? task->stack_depth : 0;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t capacity, uint32_t* total_runtime) {
+    static const eTaskState states[] = { eReady, eBlocked, eDeleted };
+    UBaseType_t count = 0;
+
+    pthread_mutex_lock(&kernel_lock);
+    for (struct sim_task* task = task_list; task && count < capacity; task = task->next) {
+        if (task->state == SIM_TASK_DELETED) continue;
+
+        TaskStatus_t* entry = &status[count++];
+        memset(entry, 0, sizeof(*entry));
+        entry->xHandle = task;
+        entry->pcTaskName = task->name;
+        entry->xTaskNumber = count;
+        entry->eCurrentState = task == current ? eRunning : states[task->state];
+        entry->uxCurrentPriority = task->priority;
+        entry->uxBasePriority = task->priority;
+        entry->usStackHighWaterMark = task->stack_depth;
+        entry->xCoreID = task->core_id;
+    }
+    pthread_mutex_unlock(&kernel_lock);
+
+    // No run-time counter (configGENERATE_RUN_TIME_STATS is 0)
+    if (total_runtime) {
+        *total_runtime = 0;
+    }
+    return count;
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return (current && current->core_id != tskNO_AFFINITY) ? current->core_id : 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&kernel_lock);
+
+    task->notify_value++;
+    if (task->state == SIM_TASK_BLOCKED && task->wait_object == task) {
+        sim_make_ready(task);
+    }
+    sim_preempt_check();
+
+    pthread_mutex_unlock(&kernel_lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&kernel_lock);
+
+    struct sim_task* self = current;
+    TickType_t deadline = tick_count + ticks_to_wait;
+
+    while (self->notify_value == 0 && ticks_to_wait != 0) {
+        if (!sim_block(self, deadline, ticks_to_wait != portMAX_DELAY)) {
+            break;
+        }
+    }
+
+    uint32_t value = self->notify_value;
+    if (value) {
+        self->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+
+    pthread_mutex_unlock(&kernel_lock);
+    return value;
+}
+
+// Event groups
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return (EventGroupHandle_t)calloc(1, sizeof(struct sim_event_group));
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* buffer) {
+    if (!buffer) return NULL;
+
+    struct sim_event_group* group = (struct sim_event_group*)buffer;
+    memset(group, 0, sizeof(*group));
+    group->is_static = true;
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    pthread_mutex_lock(&kernel_lock);
+    sim_wake_waiters(group);
+    pthread_mutex_unlock(&kernel_lock);
+    if (!group->is_static) {
+        free(group);
+    }
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&kernel_lock);
+
+    group->bits |= bits;
+    EventBits_t result = group->bits;
+    sim_wake_waiters(group);
+    sim_preempt_check();
+
+    pthread_mutex_unlock(&kernel_lock);
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&kernel_lock);
+
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+
+    pthread_mutex_unlock(&kernel_lock);
+    return previous;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&kernel_lock);
+
+    TickType_t deadline = tick_count + ticks_to_wait;
+    bool waiting = ticks_to_wait != 0;
+    EventBits_t value;
+
+    for (;;) {
+        value = group->bits;
+        bool satisfied = wait_for_all ? (value & bits) == bits : (value & bits) != 0;
+
+        if (satisfied) {
+            if (clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            break;
+        }
+
+        if (!waiting) break;
+        waiting = sim_block(group, deadline, ticks_to_wait != portMAX_DELAY);
+    }
+
+    pthread_mutex_unlock(&kernel_lock);
+    return value;
+}
+
+// Queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct sim_queue* queue = (struct sim_queue*)calloc(1, sizeof(struct sim_queue));
+    if (!queue) return NULL;
+
+    queue->storage = (uint8_t*)malloc((size_t)length * item_size);
+    if (!queue->storage) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t* storage,
+                                 StaticQueue_t* buffer) {
+    if (!storage || !buffer) return NULL;
+
+    struct sim_queue* queue = (struct sim_queue*)buffer;
+    memset(queue, 0, sizeof(*queue));
+    queue->is_static = true;
+    queue->storage = storage;
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_lock(&kernel_lock);
+    sim_wake_waiters(queue);
+    pthread_mutex_unlock(&kernel_lock);
+    if (!queue->is_static) {
+        free(queue->storage);
+        free(queue);
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&kernel_lock);
+
+    TickType_t deadline = tick_count + ticks_to_wait;
+    bool waiting = ticks_to_wait != 0;
+
+    while (queue->count == queue->length) {
+        if (!waiting) {
+            pthread_mutex_unlock(&kernel_lock);
+            return errQUEUE_FULL;
+        }
+        waiting = sim_block(queue, deadline, ticks_to_wait != portMAX_DELAY);
+    }
+
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->storage + (size_t)tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+
+    sim_wake_waiters(queue);
+    sim_preempt_check();
+
+    pthread_mutex_unlock(&kernel_lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&kernel_lock);
+
+    TickType_t deadline = tick_count + ticks_to_wait;
+    bool waiting = ticks_to_wait != 0;
+
+    while (queue->count == 0) {
+        if (!waiting) {
+            pthread_mutex_unlock(&kernel_lock);
+            return pdFALSE;
+        }
+        waiting = sim_block(queue, deadline, ticks_to_wait != portMAX_DELAY);
+    }
+
+    memcpy(item, queue->storage + (size_t)queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+
+    sim_wake_waiters(queue);
+    sim_preempt_check();
+
+    pthread_mutex_unlock(&kernel_lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&kernel_lock);
+
+    queue->head = 0;
+    queue->count = 0;
+    sim_wake_waiters(queue);
+
+    pthread_mutex_unlock(&kernel_lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->count;
+}
@@ -0,0 +1,81 @@
+#include "driver/ledc.h"
+#include "esp_log.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const char* TAG = "SimLedc";
+
+static uint32_t channel_duty[LEDC_CHANNEL_MAX];
+static bool fade_installed = false;
+
+// Set SIM_TRACE_LEDC=1 to log every duty update and fade with its virtual time
+static bool ledc_trace(void) {
+    static int trace = -1;
+    if (trace < 0) {
+        trace = getenv("SIM_TRACE_LEDC") != NULL;
+    }
+    return trace;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* config) {
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* config) {
+    if (!config || config->channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    channel_duty[config->channel] = config->duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+
+    if (fade_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    fade_installed = true;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty_and_update(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint) {
+    (void)mode;
+    (void)hpoint;
+
+    if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+
+    if (ledc_trace()) {
+        ESP_LOGI(TAG, "ch %d duty %lu", channel, (unsigned long)duty);
+    }
+    channel_duty[channel] = duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_fade_time_and_start(ledc_mode_t mode, ledc_channel_t channel, uint32_t target_duty,
+                                       uint32_t max_fade_time_ms, ledc_fade_mode_t fade_mode) {
+    (void)mode;
+    (void)fade_mode;
+
+    if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    if (!fade_installed) return ESP_ERR_INVALID_STATE;
+
+    if (ledc_trace()) {
+        ESP_LOGI(TAG, "ch %d fade %lu -> %lu over %lu ms", channel,
+                 (unsigned long)channel_duty[channel], (unsigned long)target_duty,
+                 (unsigned long)max_fade_time_ms);
+    }
+    channel_duty[channel] = target_duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_stop(ledc_mode_t mode, ledc_channel_t channel, uint32_t idle_level) {
+    (void)mode;
+
+    if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+
+    channel_duty[channel] = idle_level ? 1 : 0;
+    return ESP_OK;
+}
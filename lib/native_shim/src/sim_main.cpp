@@ -0,0 +1,34 @@
+#include "Arduino.h"
+#include "sim_kernel.h"
+
+// Host entry point: runs the sketch's setup()/loop() in a "loopTask" like
+// the Arduino-ESP32 core, for a simulated duration given in milliseconds as
+// the first argument or SIM_DURATION_MS (default 60000). Unit test builds
+// bring their own main().
+
+#ifndef PIO_UNIT_TESTING
+
+#define SIM_DEFAULT_DURATION_MS 60000
+
+static void loop_task(void* arg) {
+    (void)arg;
+
+    setup();
+    for (;;) {
+        loop();
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* duration = (argc > 1) ? argv[1] : getenv("SIM_DURATION_MS");
+    unsigned long duration_ms = duration ? strtoul(duration, NULL, 10) : SIM_DEFAULT_DURATION_MS;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("[%7d][SIM]: Simulating %lu ms of virtual time\n", 0, duration_ms);
+
+    sim_kernel_init(pdMS_TO_TICKS(duration_ms));
+    xTaskCreatePinnedToCore(loop_task, "loopTask", 8192, NULL, 1, NULL, 1);
+    sim_kernel_run();
+}
+
+#endif
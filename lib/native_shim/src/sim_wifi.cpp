@@ -0,0 +1,302 @@
+#include "WiFi.h"
+#include "freertos/queue.h"
+
+#include <vector>
+
+// Simulated access point, configured through the environment:
+//   SIM_WIFI_CONNECT_MS       time to associate after a full scan (1500)
+//   SIM_WIFI_FAST_CONNECT_MS  time to associate with BSSID+channel given (300)
+//   SIM_WIFI_DROP_AT_MS       comma-separated virtual times the AP drops us
+//   SIM_WIFI_OUTAGE_MS        how long the AP stays away after a drop (0)
+//   SIM_WIFI_NO_AP            set to make every attempt fail with NO_AP_FOUND
+
+static const char* TAG = "SimWiFi";
+
+#define SIM_WIFI_TASK_PRIORITY 23
+#define SIM_WIFI_DHCP_MS 100
+#define SIM_WIFI_CHANNEL 6
+#define SIM_WIFI_MAX_HANDLERS 8
+
+typedef enum {
+    SIM_WIFI_CMD_BEGIN = 0,
+    SIM_WIFI_CMD_DISCONNECT
+} sim_wifi_cmd_type_t;
+
+typedef struct {
+    sim_wifi_cmd_type_t type;
+    bool fast;
+} sim_wifi_cmd_t;
+
+typedef struct {
+    wifi_event_id_t id;
+    arduino_event_id_t event;
+    WiFiEventCb callback;
+    WiFiEventFuncCb function;
+} sim_wifi_handler_t;
+
+static const uint8_t sim_bssid[6] = { 0x02, 0x00, 0x00, 0x5A, 0x11, 0x01 };
+
+static QueueHandle_t command_queue = NULL;
+static std::vector<sim_wifi_handler_t> handlers;
+static wifi_event_id_t next_handler_id = 1;
+static std::vector<TickType_t> drop_ticks;
+static size_t next_drop = 0;
+
+static char current_ssid[33];
+static uint8_t current_bssid[6];
+static bool associated = false;
+static bool has_ip = false;
+
+static TickType_t connect_ticks;
+static TickType_t fast_connect_ticks;
+static TickType_t outage_ticks;
+static bool no_ap = false;
+
+static TickType_t assoc_at = 0;
+static TickType_t ip_at = 0;
+static TickType_t fail_at = 0;
+static TickType_t outage_until = 0;
+static bool assoc_pending = false;
+static bool ip_pending = false;
+static bool fail_pending = false;
+
+static TickType_t sim_env_ms(const char* name, uint32_t fallback) {
+    const char* value = getenv(name);
+    return pdMS_TO_TICKS(value ? strtoul(value, NULL, 10) : fallback);
+}
+
+static void sim_wifi_dispatch(arduino_event_id_t event, uint8_t reason) {
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+
+    if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+        memcpy(info.wifi_sta_connected.bssid, sim_bssid, sizeof(sim_bssid));
+        info.wifi_sta_connected.channel = SIM_WIFI_CHANNEL;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        info.wifi_sta_disconnected.reason = reason;
+    }
+
+    // Handlers may unregister themselves while being called. The copy is on
+    // the stack: tests check that nothing allocates once setup() is done.
+    sim_wifi_handler_t snapshot[SIM_WIFI_MAX_HANDLERS];
+    size_t count = handlers.size();
+    for (size_t i = 0; i < count; i++) {
+        snapshot[i] = handlers[i];
+    }
+    for (size_t i = 0; i < count; i++) {
+        const sim_wifi_handler_t& handler = snapshot[i];
+        if (handler.event != ARDUINO_EVENT_MAX && handler.event != event) continue;
+
+        if (handler.callback) {
+            handler.callback(event);
+        } else if (handler.function) {
+            handler.function(event, info);
+        }
+    }
+}
+
+static void sim_wifi_link_down(uint8_t reason) {
+    bool was_up = associated;
+
+    associated = false;
+    has_ip = false;
+    assoc_pending = false;
+    ip_pending = false;
+    fail_pending = false;
+
+    if (was_up) {
+        ESP_LOGI(TAG, "Link down (reason %d)", reason);
+        sim_wifi_dispatch(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, reason);
+    }
+}
+
+static void sim_wifi_handle_command(const sim_wifi_cmd_t* command) {
+    TickType_t now = xTaskGetTickCount();
+
+    switch (command->type) {
+        case SIM_WIFI_CMD_BEGIN:
+            sim_wifi_link_down(WIFI_REASON_ASSOC_LEAVE);
+
+            if (no_ap || (int32_t)(outage_until - now) > 0) {
+                fail_pending = true;
+                fail_at = now + connect_ticks;
+            } else {
+                assoc_pending = true;
+                assoc_at = now + (command->fast ? fast_connect_ticks : connect_ticks);
+            }
+            break;
+
+        case SIM_WIFI_CMD_DISCONNECT:
+            sim_wifi_link_down(WIFI_REASON_ASSOC_LEAVE);
+            break;
+    }
+}
+
+static void sim_wifi_consider(TickType_t now, bool pending, TickType_t at, TickType_t* timeout) {
+    if (!pending) return;
+
+    int32_t remaining = (int32_t)(at - now);
+    TickType_t wait = (remaining > 0) ? (TickType_t)remaining : 0;
+    if (wait < *timeout) {
+        *timeout = wait;
+    }
+}
+
+static void sim_wifi_task(void* arg) {
+    (void)arg;
+
+    for (;;) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t timeout = portMAX_DELAY;
+
+        sim_wifi_consider(now, assoc_pending, assoc_at, &timeout);
+        sim_wifi_consider(now, ip_pending, ip_at, &timeout);
+        sim_wifi_consider(now, fail_pending, fail_at, &timeout);
+        sim_wifi_consider(now, next_drop < drop_ticks.size(),
+                          next_drop < drop_ticks.size() ? drop_ticks[next_drop] : 0, &timeout);
+
+        sim_wifi_cmd_t command;
+        if (xQueueReceive(command_queue, &command, timeout) == pdTRUE) {
+            sim_wifi_handle_command(&command);
+            continue;
+        }
+
+        now = xTaskGetTickCount();
+
+        if (next_drop < drop_ticks.size() && (int32_t)(drop_ticks[next_drop] - now) <= 0) {
+            next_drop++;
+            outage_until = now + outage_ticks;
+            if (associated) {
+                sim_wifi_link_down(WIFI_REASON_BEACON_TIMEOUT);
+            }
+        }
+
+        if (fail_pending && (int32_t)(fail_at - now) <= 0) {
+            fail_pending = false;
+            sim_wifi_dispatch(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+        }
+
+        if (assoc_pending && (int32_t)(assoc_at - now) <= 0) {
+            assoc_pending = false;
+            associated = true;
+            memcpy(current_bssid, sim_bssid, sizeof(current_bssid));
+            sim_wifi_dispatch(ARDUINO_EVENT_WIFI_STA_CONNECTED, 0);
+
+            ip_pending = true;
+            ip_at = now + pdMS_TO_TICKS(SIM_WIFI_DHCP_MS);
+        }
+
+        if (ip_pending && (int32_t)(ip_at - now) <= 0) {
+            ip_pending = false;
+            has_ip = true;
+            sim_wifi_dispatch(ARDUINO_EVENT_WIFI_STA_GOT_IP, 0);
+        }
+    }
+}
+
+static void sim_wifi_ensure_started(void) {
+    if (command_queue) return;
+
+    connect_ticks = sim_env_ms("SIM_WIFI_CONNECT_MS", 1500);
+    fast_connect_ticks = sim_env_ms("SIM_WIFI_FAST_CONNECT_MS", 300);
+    outage_ticks = sim_env_ms("SIM_WIFI_OUTAGE_MS", 0);
+    no_ap = getenv("SIM_WIFI_NO_AP") != NULL;
+
+    const char* drops = getenv("SIM_WIFI_DROP_AT_MS");
+    while (drops && *drops) {
+        char* end;
+        unsigned long ms = strtoul(drops, &end, 10);
+        if (end == drops) break;
+        drop_ticks.push_back(pdMS_TO_TICKS(ms));
+        drops = (*end == ',') ? end + 1 : end;
+    }
+
+    command_queue = xQueueCreate(8, sizeof(sim_wifi_cmd_t));
+    xTaskCreate(sim_wifi_task, "sim_wifi", 4096, NULL, SIM_WIFI_TASK_PRIORITY, NULL);
+}
+
+static void sim_wifi_send(sim_wifi_cmd_type_t type, bool fast) {
+    sim_wifi_ensure_started();
+
+    sim_wifi_cmd_t command = { type, fast };
+    xQueueSend(command_queue, &command, portMAX_DELAY);
+}
+
+WiFiClass WiFi;
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    (void)passphrase;
+
+    strncpy(current_ssid, ssid ? ssid : "", sizeof(current_ssid) - 1);
+    if (connect) {
+        sim_wifi_send(SIM_WIFI_CMD_BEGIN, channel != 0 && bssid != NULL);
+    }
+    return status();
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+    (void)wifioff;
+    (void)eraseap;
+
+    sim_wifi_send(SIM_WIFI_CMD_DISCONNECT, false);
+    return true;
+}
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    (void)mode;
+    sim_wifi_ensure_started();
+    return true;
+}
+
+bool WiFiClass::setAutoReconnect(bool auto_reconnect) {
+    (void)auto_reconnect;
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    return has_ip ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+String WiFiClass::SSID() const {
+    return String(associated ? current_ssid : "");
+}
+
+IPAddress WiFiClass::localIP() {
+    return has_ip ? IPAddress(192, 168, 4, 2) : IPAddress();
+}
+
+uint8_t* WiFiClass::BSSID() {
+    return associated ? current_bssid : NULL;
+}
+
+int32_t WiFiClass::channel() {
+    return associated ? SIM_WIFI_CHANNEL : 0;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb callback, arduino_event_id_t event) {
+    sim_wifi_ensure_started();
+    if (handlers.size() >= SIM_WIFI_MAX_HANDLERS) return 0;
+
+    sim_wifi_handler_t handler = { next_handler_id++, event, callback, nullptr };
+    handlers.push_back(handler);
+    return handler.id;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event) {
+    sim_wifi_ensure_started();
+    if (handlers.size() >= SIM_WIFI_MAX_HANDLERS) return 0;
+
+    sim_wifi_handler_t handler = { next_handler_id++, event, nullptr, callback };
+    handlers.push_back(handler);
+    return handler.id;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id) {
+    for (size_t i = 0; i < handlers.size(); i++) {
+        if (handlers[i].id == id) {
+            handlers.erase(handlers.begin() + i);
+            return;
+        }
+    }
+}
@@ -1,12 +1,150 @@
 #include <Arduino.h>
+#include "esp_timer.h"
 #include "modules/led_controller/led_controller.h"
 #include "modules/wifi_manager/wifi_manager.h"
 #include "modules/sensor_reader/sensor_reader.h"
+#include "modules/telemetry_log/telemetry_log.h"
+#include "modules/system_metrics/system_metrics.h"
+#include "modules/message_bus/message_bus.h"
+#include "modules/sample_log/sample_log.h"
+#include "modules/periodic_scheduler/periodic_scheduler.h"
+#ifdef SENSOR_USE_ADC
+#include "modules/sensor_reader/sensor_adc_driver.h"
+#endif
+#ifdef MQTT_BROKER_HOST
+#include "modules/mqtt_uplink/mqtt_uplink.h"
+#endif
+#ifdef SENSOR_TRACE_PATH
+#include "modules/sensor_reader/sensor_trace_driver.h"
+#endif
+#ifdef UDP_STREAM_PORT
+#include "modules/udp_streamer/udp_streamer.h"
+#endif
+#ifdef TRACE_RECORDER_ENABLED
+#include "modules/trace_recorder/trace_recorder.h"
+#endif
 
 // Module instances
 static led_controller_t* led_controller = NULL;
 static wifi_manager_t* wifi_manager = NULL;
 static sensor_reader_t* sensor_reader = NULL;
+// Runs the periodic sensor work; more readers can share it
+static periodic_scheduler_t* scheduler = NULL;
+static telemetry_log_t* telemetry_log = NULL;
+static sample_log_t* sample_log = NULL; // Owned by loop(): appends and queries
+// Windowed aggregates; a static buffer in both allocation modes
+static sensor_stats_engine_t sensor_stats;
+// Kalman-filtered estimates next to the raw sample
+static sensor_fusion_bank_t sensor_fusion;
+static int loop_metrics = SYSTEM_METRICS_INVALID_SLOT;
+static uint32_t setup_free_heap = 0;
+
+// loop() reacts to bus messages as they arrive instead of polling. WiFi
+// state has a queue of its own, read first, so a run of samples can never
+// crowd out a state change; samples may drop when loop() falls behind.
+#define MAIN_STATE_QUEUE_LENGTH 8
+#define MAIN_SAMPLE_QUEUE_LENGTH 4
+static QueueHandle_t state_queue = NULL;
+static QueueHandle_t sample_queue = NULL;
+
+#ifdef MODULES_STATIC_ALLOCATION
+// Build with -DMODULES_STATIC_ALLOCATION to place every module, its task
+// stack and its kernel objects here instead of on the heap
+static led_controller_storage_t led_controller_storage;
+static wifi_manager_storage_t wifi_manager_storage;
+static sensor_reader_storage_t sensor_reader_storage;
+static periodic_scheduler_storage_t scheduler_storage;
+static telemetry_log_storage_t telemetry_log_storage;
+static sample_log_t sample_log_storage;
+static StaticQueue_t state_queue_buffer;
+static uint8_t state_queue_storage[MAIN_STATE_QUEUE_LENGTH * sizeof(message_t)];
+static StaticQueue_t sample_queue_buffer;
+static uint8_t sample_queue_storage[MAIN_SAMPLE_QUEUE_LENGTH * sizeof(message_t)];
+#endif
+
+#ifdef MQTT_BROKER_HOST
+// Build with -DMQTT_BROKER_HOST=\"broker.local\" to publish samples in
+// batches; -DMQTT_SPILL_PATH=\"/spiffs/uplink.bin\" keeps overflow during
+// outages on a mounted filesystem instead of dropping it
+static mqtt_uplink_t* mqtt_uplink = NULL;
+#ifdef MODULES_STATIC_ALLOCATION
+static mqtt_uplink_storage_t mqtt_uplink_storage;
+#endif
+#endif
+
+#ifdef UDP_STREAM_PORT
+// Build with -DUDP_STREAM_PORT=4950 to stream live samples to hosts running
+// tools/udp_stream_client.py
+static udp_streamer_t* udp_streamer = NULL;
+#ifdef MODULES_STATIC_ALLOCATION
+static udp_streamer_storage_t udp_streamer_storage;
+#endif
+#endif
+
+#ifdef SENSOR_USE_ADC
+// ADC1 channels 0-2 (GPIO1-3), 11 dB attenuation: raw 0..4095 ~ 0..3.1V.
+// 1.2 kHz aggregate / 3 channels / 800 per output = a sample roughly every 2 s
+// (reads complete on 256-result DMA frame boundaries).
+static const sensor_adc_config_t sensor_adc_config = {
+  SENSOR_ADC_CALIBRATION(0, 3.1 / 4095, 0.0, SENSOR_VOLTAGE_SCALE),          // Voltage (V)
+  SENSOR_ADC_CALIBRATION(1, 100.0 / 4095, -20.0, SENSOR_TEMPERATURE_SCALE),  // Temperature (C)
+  SENSOR_ADC_CALIBRATION(2, 100.0 / 4095, 0.0, SENSOR_HUMIDITY_SCALE),       // Humidity (%)
+  1200,
+  800
+};
+static sensor_adc_driver_t* sensor_adc = NULL;
+#ifdef MODULES_STATIC_ALLOCATION
+static sensor_adc_driver_t sensor_adc_storage;
+#endif
+#endif
+
+#ifdef SENSOR_TRACE_PATH
+// -DSENSOR_TRACE_PATH=\"trace.csv\" replays a decode_telemetry.py CSV
+// instead of sampling; with -DSENSOR_ADAPTIVE this compares adaptive
+// sampling against the fixed rate on recorded data
+static sensor_trace_driver_t sensor_trace;
+#endif
+
+#ifndef SENSOR_PERIOD_MS
+// e.g. -DSENSOR_PERIOD_MS=1 to load the UDP stream
+#define SENSOR_PERIOD_MS 2000
+#endif
+
+#ifndef SAMPLE_LOG_FLUSH_INTERVAL_MS
+// A flush programs the samples since the last one into the head page's
+// erased tail, so the page is still erased once. At the default 2 s period
+// a page fills in 504 s, about 9 flushes, within SAMPLE_LOG_COMMIT_SLOTS;
+// flushing more often than that per page costs an extra erase.
+#define SAMPLE_LOG_FLUSH_INTERVAL_MS 60000
+#endif
+
+#ifdef SENSOR_ADAPTIVE
+// 2 s while the signal moves, stretching to 32 s while it is flat
+static const sensor_adaptive_config_t adaptive_config = SENSOR_ADAPTIVE_DEFAULT_CONFIG;
+// Rough cost of one wakeup for the awake-time estimate; calibrate on hardware
+#define SAMPLE_AWAKE_US 1500 // Leave light sleep, read the sensor
+#define EMIT_AWAKE_US 800    // Consumers woken by an emitted sample
+#endif
+
+static unsigned task_priority(TaskHandle_t task) {
+  return task ? (unsigned)uxTaskPriorityGet(task) : 0;
+}
+
+// As configured at start; without a task of its own the sensor samples on
+// the scheduler's
+static void log_task_priorities() {
+  unsigned scheduler_priority = scheduler ? task_priority(scheduler->task_handle) : 0;
+  unsigned led_priority = led_controller ? task_priority(led_controller->task_handle) : 0;
+  unsigned wifi_priority = wifi_manager ? task_priority(wifi_manager->task_handle) : 0;
+
+  if (sensor_reader && sensor_reader->task_handle) {
+    ESP_LOGI("Main", "Task priorities - Sensor %u, Scheduler %u, LED %u, WiFi %u",
+             task_priority(sensor_reader->task_handle), scheduler_priority, led_priority, wifi_priority);
+  } else {
+    ESP_LOGI("Main", "Task priorities - Scheduler %u (sensor job), LED %u, WiFi %u",
+             scheduler_priority, led_priority, wifi_priority);
+  }
+}
 
 void setup() {
   Serial.begin(115200);
@@ -16,9 +154,88 @@ void setup() {
   ESP_LOGI("Main", "Using FreeRTOS for tasks, Arduino for hardware APIs");
 
   // Initialize modules
+#ifdef MODULES_STATIC_ALLOCATION
+  led_controller = led_controller_create_static(&led_controller_storage, LED_BUILTIN);
+  wifi_manager = wifi_manager_create_static(&wifi_manager_storage, "YOUR_SSID", "YOUR_PASSWORD");
+  sensor_reader = sensor_reader_create_static(&sensor_reader_storage, pdMS_TO_TICKS(SENSOR_PERIOD_MS));
+  scheduler = periodic_scheduler_create_static(&scheduler_storage);
+  telemetry_log = telemetry_log_create_static(&telemetry_log_storage, NULL, NULL);
+  sample_log = sample_log_create_static(&sample_log_storage, "samples");
+#else
   led_controller = led_controller_create(LED_BUILTIN);
   wifi_manager = wifi_manager_create("YOUR_SSID", "YOUR_PASSWORD");
-  sensor_reader = sensor_reader_create();
+  sensor_reader = sensor_reader_create(pdMS_TO_TICKS(SENSOR_PERIOD_MS));
+  scheduler = periodic_scheduler_create();
+  telemetry_log = telemetry_log_create(NULL, NULL); // Binary records on stdout
+  sample_log = sample_log_create("samples");         // partitions.csv
+#endif
+
+#ifdef SENSOR_USE_ADC
+#ifdef MODULES_STATIC_ALLOCATION
+  sensor_adc = sensor_adc_driver_create_static(&sensor_adc_storage, &sensor_adc_config);
+#else
+  sensor_adc = sensor_adc_driver_create(&sensor_adc_config);
+#endif
+  if (sensor_reader && sensor_adc) {
+    sensor_reader_set_driver(sensor_reader, &sensor_adc->driver);
+  }
+#endif
+
+#ifdef SENSOR_TRACE_PATH
+  sensor_trace_driver_init(&sensor_trace, SENSOR_TRACE_PATH);
+  if (sensor_reader) {
+    sensor_reader_set_driver(sensor_reader, &sensor_trace.driver);
+  }
+#endif
+
+#ifdef SENSOR_ADAPTIVE
+  if (sensor_reader) {
+    sensor_reader_set_adaptive(sensor_reader, &adaptive_config);
+  }
+#endif
+
+  // Subscribe before starting the publishers so no state change is missed
+#ifdef MODULES_STATIC_ALLOCATION
+  state_queue = xQueueCreateStatic(MAIN_STATE_QUEUE_LENGTH, sizeof(message_t), state_queue_storage, &state_queue_buffer);
+  sample_queue = xQueueCreateStatic(MAIN_SAMPLE_QUEUE_LENGTH, sizeof(message_t), sample_queue_storage,
+                                    &sample_queue_buffer);
+#else
+  state_queue = xQueueCreate(MAIN_STATE_QUEUE_LENGTH, sizeof(message_t));
+  sample_queue = xQueueCreate(MAIN_SAMPLE_QUEUE_LENGTH, sizeof(message_t));
+#endif
+  message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_WIFI_STATE), state_queue);
+  message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE), sample_queue);
+
+#ifdef MQTT_BROKER_HOST
+  mqtt_uplink_config_t uplink_config = MQTT_UPLINK_DEFAULT_CONFIG;
+  uplink_config.broker_host = MQTT_BROKER_HOST;
+#ifdef MQTT_SPILL_PATH
+  uplink_config.spill_path = MQTT_SPILL_PATH;
+#endif
+#ifdef MODULES_STATIC_ALLOCATION
+  mqtt_uplink = mqtt_uplink_create_static(&mqtt_uplink_storage, &uplink_config);
+#else
+  mqtt_uplink = mqtt_uplink_create(&uplink_config);
+#endif
+  // Also a subscriber: start it before WiFi and the sensor
+  if (mqtt_uplink) {
+    mqtt_uplink_start(mqtt_uplink);
+  }
+#endif
+
+#ifdef UDP_STREAM_PORT
+  udp_streamer_config_t streamer_config = UDP_STREAMER_DEFAULT_CONFIG;
+  streamer_config.port = UDP_STREAM_PORT;
+#ifdef MODULES_STATIC_ALLOCATION
+  udp_streamer = udp_streamer_create_static(&udp_streamer_storage, &streamer_config);
+#else
+  udp_streamer = udp_streamer_create(&streamer_config);
+#endif
+  // Also a subscriber: start it before WiFi and the sensor
+  if (udp_streamer) {
+    udp_streamer_start(udp_streamer);
+  }
+#endif
 
   // Start modules
   if (led_controller) {
@@ -31,33 +248,263 @@ void setup() {
     wifi_manager_connect(wifi_manager);
   }
 
+  if (telemetry_log) {
+    telemetry_log_start(telemetry_log);
+  }
+
+#ifdef SENSOR_READER_CORE
+  // e.g. -DSENSOR_READER_CORE=1 keeps sampling off the WiFi core; compare
+  // the scheduler (or sensor_reader) jitter in the metrics log across placements
+  if (scheduler) {
+    task_config_t scheduler_task = PERIODIC_SCHEDULER_DEFAULT_TASK_CONFIG;
+    scheduler_task.core = SENSOR_READER_CORE;
+    periodic_scheduler_configure_task(scheduler, &scheduler_task);
+  }
+#endif
+
+  if (scheduler) {
+    periodic_scheduler_start(scheduler);
+  }
+
   if (sensor_reader) {
+#ifdef SENSOR_READER_CORE
+    task_config_t sensor_task = SENSOR_READER_DEFAULT_TASK_CONFIG;
+    sensor_task.core = SENSOR_READER_CORE;
+    sensor_task.period = pdMS_TO_TICKS(SENSOR_PERIOD_MS);
+    sensor_reader_configure_task(sensor_reader, &sensor_task);
+#endif
+#ifndef SENSOR_USE_ADC
+    // The ADC driver paces itself and keeps the reader's own task
+    sensor_reader_attach_scheduler(sensor_reader, scheduler);
+#endif
+    sensor_reader_attach_telemetry(sensor_reader, telemetry_log);
+    sensor_stats_config_t stats_config = SENSOR_STATS_DEFAULT_CONFIG;
+    sensor_stats_init(&sensor_stats, &stats_config);
+    sensor_reader_attach_stats(sensor_reader, &sensor_stats);
+    // Fed from loop() in the batches it drains, not per sample by the reader
+    sensor_fusion_config_t fusion_config = SENSOR_FUSION_DEFAULT_CONFIG;
+    sensor_fusion_init(&sensor_fusion, &fusion_config);
     sensor_reader_start(sensor_reader);
   }
 
+  // setup() and loop() share the Arduino loop task
+  loop_metrics = system_metrics_register("loop", 0);
+
+  // Baseline for spotting runtime heap use by the modules
+  setup_free_heap = esp_get_free_heap_size();
+  ESP_LOGI("Main", "Free heap after setup: %lu bytes", (unsigned long)setup_free_heap);
+
   ESP_LOGI("Main", "All modules initialized and tasks started");
-  ESP_LOGI("Main", "FreeRTOS task priorities: Sensor(6) > LED(5) > WiFi(4)");
+  log_task_priorities();
+}
+
+static void show_wifi_state(wifi_state_t wifi_state) {
+  if (!led_controller) return;
+
+  switch (wifi_state) {
+    case WIFI_STATE_CONNECTED:
+      led_controller_set_pattern(led_controller, LED_PATTERN_SOLID);
+      break;
+    case WIFI_STATE_CONNECTING:
+      led_controller_set_pattern(led_controller, LED_PATTERN_BLINK_FAST);
+      break;
+    case WIFI_STATE_DISCONNECTED:
+    case WIFI_STATE_FAILED:
+      led_controller_set_pattern(led_controller, LED_PATTERN_BLINK_SLOW);
+      break;
+  }
+}
+
+static bool count_sample(const sample_log_record_t* record, void* context) {
+  return true;
 }
 
 void loop() {
   static TickType_t last_status_time = 0;
   const TickType_t status_interval = pdMS_TO_TICKS(10000); // 10 seconds
 
+  // A pending WiFi state first; otherwise wait for a sample, or at most
+  // 100 ms so the status print (and a state change behind the wait) stays
+  // on time
+  message_t message;
+  bool received = state_queue && xQueueReceive(state_queue, &message, 0) == pdTRUE;
+  if (!received) {
+    received = sample_queue && xQueueReceive(sample_queue, &message, pdMS_TO_TICKS(100)) == pdTRUE;
+  }
+  system_metrics_wake(loop_metrics);
+
+  if (received && message.topic == MESSAGE_TOPIC_WIFI_STATE) {
+    system_metrics_event(loop_metrics, 1);
+    show_wifi_state((wifi_state_t)message.wifi_state);
+#ifdef TRACE_RECORDER_ENABLED
+    // -DTRACE_RECORDER_ENABLED: once a connect attempt resolves, the rings
+    // hold how the tasks interleaved around WiFi.begin(); convert the dump
+    // with tools/trace_to_chrome.py
+    if (message.wifi_state == WIFI_STATE_CONNECTED || message.wifi_state == WIFI_STATE_FAILED) {
+      trace_recorder_dump(NULL);
+    }
+#endif
+  } else if (received && message.topic == MESSAGE_TOPIC_SENSOR_SAMPLE && sample_log) {
+    system_metrics_event(loop_metrics, 1);
+    sample_log_append(sample_log, &message.sample);
+  }
+
   TickType_t current_time = xTaskGetTickCount();
+
+  // Program the partial page now and then, so an unplanned reset loses at
+  // most SAMPLE_LOG_FLUSH_INTERVAL_MS of samples instead of a whole page
+  static TickType_t last_flush_time = 0;
+  if (sample_log && current_time - last_flush_time >= pdMS_TO_TICKS(SAMPLE_LOG_FLUSH_INTERVAL_MS)) {
+    last_flush_time = current_time;
+    sample_log_flush(sample_log);
+  }
+
   if (current_time - last_status_time >= status_interval) {
     last_status_time = current_time;
 
     ESP_LOGI("Main", "=== System Status ===");
 
-    // Sensor
+    // Sensor: drain everything buffered since the last status print
     if (sensor_reader) {
-      sensor_data_t data;
-      if (sensor_reader_get_latest_data(sensor_reader, &data)) {
-        ESP_LOGI("Main", "Sensor - Temp: %.1fC, Hum: %.1f%%, Volt: %.2fV",
-                 data.temperature, data.humidity, data.voltage);
+      sensor_data_t batch[SENSOR_READER_HISTORY_CAPACITY];
+      size_t count = sensor_reader_drain(sensor_reader, batch, SENSOR_READER_HISTORY_CAPACITY);
+      // Sample values go out as binary telemetry records (tools/decode_telemetry.py)
+      ESP_LOGI("Main", "Sensor - %u new samples", (unsigned)count);
+
+      static bool first_sample_seen = false;
+      if (count > 0 && !first_sample_seen) {
+        first_sample_seen = true;
+        ESP_LOGI("Main", "Sensor - first sample %lu ms after boot",
+                 (unsigned long)(batch[0].timestamp * portTICK_PERIOD_MS));
       }
+
+      // One line of aggregates per channel replaces the raw points
+      sensor_stats_t summary;
+      if (sensor_stats_get(&sensor_stats, &summary)) {
+        static const char* const channel_names[SENSOR_CHANNEL_COUNT] = { "Temp", "Hum", "Volt", "Raw" };
+        for (int i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+          const sensor_channel_summary_t* channel = &summary.channel[i];
+          ESP_LOGI("Main", "Sensor - %-4s mean %.2f sd %.2f min %.2f max %.2f ewma %.2f (window %u)",
+                   channel_names[i], channel->mean, channel->stddev, channel->min, channel->max,
+                   channel->ewma, (unsigned)summary.window_fill);
+        }
+
+        // Bits accumulate until checked here
+        EventBits_t events = xEventGroupClearBits(sensor_reader->event_group, SENSOR_EVENT_ANOMALY);
+        if (events & SENSOR_EVENT_ANOMALY) {
+          ESP_LOGW("Main", "Sensor - anomalies flagged, %lu samples in total",
+                   (unsigned long)summary.anomalies);
+        }
+      }
+
+      // Filter the whole drained batch in one pass of the lane-wise block loop
+      sensor_fusion_process(&sensor_fusion, batch, count, NULL);
+      sensor_fused_t fused;
+      if (sensor_fusion_get(&sensor_fusion, &fused)) {
+        ESP_LOGI("Main", "Sensor - filtered Temp %.2f C (sd %.3f), Hum %.2f %% (sd %.3f), Volt %.3f V (sd %.4f)",
+                 fused.estimate[SENSOR_CHANNEL_TEMPERATURE], sqrtf(fused.variance[SENSOR_CHANNEL_TEMPERATURE]),
+                 fused.estimate[SENSOR_CHANNEL_HUMIDITY], sqrtf(fused.variance[SENSOR_CHANNEL_HUMIDITY]),
+                 fused.estimate[SENSOR_CHANNEL_VOLTAGE], sqrtf(fused.variance[SENSOR_CHANNEL_VOLTAGE]));
+      }
+
+      sensor_history_stats_t stats;
+      if (sensor_reader_get_history_stats(sensor_reader, &stats) && stats.dropped > 0) {
+        ESP_LOGW("Main", "Sensor - %lu samples dropped (history capacity %lu)",
+                 (unsigned long)stats.dropped, (unsigned long)stats.capacity);
+      }
+
+#ifdef SENSOR_ADAPTIVE
+      // Against sampling and emitting every min_period since boot
+      sensor_adaptive_stats_t adaptive;
+      if (sensor_reader_get_adaptive_stats(sensor_reader, &adaptive)) {
+        uint32_t fixed_samples = current_time / adaptive_config.min_period;
+        uint32_t awake_ms = (adaptive.taken * SAMPLE_AWAKE_US + adaptive.emitted * EMIT_AWAKE_US) / 1000;
+        uint32_t fixed_awake_ms = fixed_samples * (SAMPLE_AWAKE_US + EMIT_AWAKE_US) / 1000;
+        ESP_LOGI("Main", "Sensor - adaptive: %lu taken, %lu emitted, period %lu ms, est. awake %lu ms (fixed rate: %lu samples, %lu ms)",
+                 (unsigned long)adaptive.taken, (unsigned long)adaptive.emitted,
+                 (unsigned long)(adaptive.period * portTICK_PERIOD_MS), (unsigned long)awake_ms,
+                 (unsigned long)fixed_samples, (unsigned long)fixed_awake_ms);
+      }
+#endif
     }
 
+    // Flash log: what survives a reset, and a replay of the last minute
+    if (sample_log) {
+      sample_log_stats_t stats;
+      if (sample_log_get_stats(sample_log, &stats)) {
+        ESP_LOGI("Main", "Sample log - %lu samples in %lu/%lu pages, %lu page writes, %lu erases, %lu errors",
+                 (unsigned long)stats.samples, (unsigned long)stats.pages_used, (unsigned long)stats.page_count,
+                 (unsigned long)stats.page_writes, (unsigned long)stats.erases, (unsigned long)stats.write_errors);
+      }
+
+      uint64_t now_ms = sample_log_time_ms(sample_log, current_time);
+      uint64_t from_ms = now_ms > 60000 ? now_ms - 60000 : 0;
+      int64_t query_start_us = esp_timer_get_time();
+      size_t replayed = sample_log_query(sample_log, from_ms, now_ms, count_sample, NULL);
+      ESP_LOGI("Main", "Sample log - %u samples in the last 60 s (query %ld us)",
+               (unsigned)replayed, (long)(esp_timer_get_time() - query_start_us));
+    }
+
+    // Scheduler: how late the periodic jobs ran
+    if (scheduler) {
+      periodic_scheduler_stats_t stats;
+      if (periodic_scheduler_get_stats(scheduler, &stats)) {
+        ESP_LOGI("Main", "Scheduler - %lu jobs, %lu runs, %lu overruns, max lateness %lu us",
+                 (unsigned long)stats.jobs, (unsigned long)stats.runs, (unsigned long)stats.overruns,
+                 (unsigned long)stats.max_lateness_us);
+      }
+      // Jitter is per job; the scheduler task has no period of its own
+      periodic_job_stats_t job_stats;
+      if (sensor_reader && sensor_reader_get_job_stats(sensor_reader, &job_stats)) {
+        ESP_LOGI("Main", "Scheduler - sensor job %lu runs, %lu overruns, jitter avg/max %lu/%lu us",
+                 (unsigned long)job_stats.runs, (unsigned long)job_stats.overruns,
+                 (unsigned long)job_stats.jitter_avg_us, (unsigned long)job_stats.jitter_max_us);
+      }
+    }
+
+    // Telemetry
+    if (telemetry_log) {
+      telemetry_log_stats_t stats;
+      if (telemetry_log_get_stats(telemetry_log, &stats)) {
+        ESP_LOGI("Main", "Telemetry - %lu records, %lu bytes out, %lu dropped",
+                 (unsigned long)stats.written, (unsigned long)stats.bytes_out, (unsigned long)stats.dropped);
+      }
+    }
+
+#ifdef MQTT_BROKER_HOST
+    // Uplink: samples and bytes per sample delivered to the broker
+    if (mqtt_uplink) {
+      mqtt_uplink_stats_t stats;
+      if (mqtt_uplink_get_stats(mqtt_uplink, &stats)) {
+        ESP_LOGI("Main", "Uplink - %lu samples in %lu batches (%lu bytes/sample), backlog %lu, spilled %lu (%lu bytes), dropped %lu, failures %lu",
+                 (unsigned long)stats.uplinked, (unsigned long)stats.batches,
+                 (unsigned long)(stats.uplinked ? stats.payload_bytes / stats.uplinked : 0),
+                 (unsigned long)stats.backlog, (unsigned long)stats.spilled, (unsigned long)stats.spill_bytes,
+                 (unsigned long)stats.dropped, (unsigned long)stats.publish_failures);
+      }
+    }
+#endif
+
+#ifdef UDP_STREAM_PORT
+    // Stream: loss shows up as seq gaps on the client side
+    if (udp_streamer) {
+      udp_streamer_stats_t stats;
+      if (udp_streamer_get_stats(udp_streamer, &stats)) {
+        ESP_LOGI("Main", "Stream - %lu of %lu samples in %lu datagrams, %lu subscribers, max latency %lu ms, %lu send errors",
+                 (unsigned long)stats.streamed, (unsigned long)stats.received, (unsigned long)stats.datagrams,
+                 (unsigned long)stats.subscribers, (unsigned long)stats.max_latency_ms,
+                 (unsigned long)stats.send_errors);
+      }
+    }
+#endif
+
+#ifdef TRACE_RECORDER_ENABLED
+    trace_recorder_stats_t trace_stats;
+    trace_recorder_get_stats(&trace_stats);
+    ESP_LOGI("Main", "Trace - %lu events since the last dump, %lu overwritten",
+             (unsigned long)trace_stats.recorded, (unsigned long)trace_stats.lost);
+#endif
+
     // WiFi
     if (wifi_manager) {
       wifi_state_t state = wifi_manager_get_state(wifi_manager);
@@ -71,27 +518,10 @@ void loop() {
       ESP_LOGI("Main", "WiFi - State: %s", state_str);
     }
 
-    // LED
-    if (led_controller && wifi_manager) {
-      wifi_state_t wifi_state = wifi_manager_get_state(wifi_manager);
-      switch (wifi_state) {
-        case WIFI_STATE_CONNECTED:
-          led_controller_set_pattern(led_controller, LED_PATTERN_SOLID);
-          break;
-        case WIFI_STATE_CONNECTING:
-          led_controller_set_pattern(led_controller, LED_PATTERN_BLINK_FAST);
-          break;
-        case WIFI_STATE_DISCONNECTED:
-        case WIFI_STATE_FAILED:
-          led_controller_set_pattern(led_controller, LED_PATTERN_BLINK_SLOW);
-          break;
-      }
-    }
-
-    ESP_LOGI("Main", "Free Heap: %d bytes", esp_get_free_heap_size());
-    ESP_LOGI("Main", "Min Heap: %d bytes", esp_get_minimum_free_heap_size());
+    // Heap, per-task stack high-water marks, wakeups and loop jitter
+    system_metrics_log();
+    ESP_LOGI("Main", "Heap used since setup: %ld bytes",
+             (long)setup_free_heap - (long)esp_get_free_heap_size());
     ESP_LOGI("Main", "=====================");
   }
-
-  vTaskDelay(pdMS_TO_TICKS(100));
 }
@@ -0,0 +1,28 @@
+#include "task_config.h"
+
+// max_stack_size bounds the stack of statically allocated tasks; 0 means unbounded
+bool task_config_valid(const task_config_t* config, uint32_t max_stack_size) {
+    if (!config || config->stack_size == 0 || config->priority >= configMAX_PRIORITIES) {
+        return false;
+    }
+    
+    if (config->core != tskNO_AFFINITY && (config->core < 0 || config->core >= portNUM_PROCESSORS)) {
+        return false;
+    }
+    
+    return max_stack_size == 0 || config->stack_size <= max_stack_size;
+}
+
+// Creates the task pinned to config->core, in task_buffer/task_stack when
+// given, otherwise on the heap
+bool task_config_create(TaskFunction_t function, const char* name, const task_config_t* config, void* arg,
+                        StaticTask_t* task_buffer, StackType_t* task_stack, TaskHandle_t* handle) {
+    if (task_buffer) {
+        *handle = xTaskCreateStaticPinnedToCore(function, name, config->stack_size, arg, config->priority,
+                                                task_stack, task_buffer, config->core);
+        return *handle != NULL;
+    }
+    
+    return xTaskCreatePinnedToCore(function, name, config->stack_size, arg, config->priority,
+                                   handle, config->core) == pdPASS;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scheduling parameters for a module task. Each module has a
+// *_DEFAULT_TASK_CONFIG and a *_configure_task() to override it before
+// *_start().
+typedef struct {
+    uint32_t stack_size;  // Bytes
+    UBaseType_t priority;
+    BaseType_t core;      // 0 (PRO_CPU, shared with WiFi), 1 (APP_CPU) or tskNO_AFFINITY
+    TickType_t period;    // Loop period for periodic tasks, 0 for event-driven ones
+} task_config_t;
+
+bool task_config_valid(const task_config_t* config, uint32_t max_stack_size);
+bool task_config_create(TaskFunction_t function, const char* name, const task_config_t* config, void* arg,
+                        StaticTask_t* task_buffer, StackType_t* task_stack, TaskHandle_t* handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
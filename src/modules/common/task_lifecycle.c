@@ -0,0 +1,43 @@
+#include "task_lifecycle.h"
+
+// Task side: sleep for ticks unless a stop is requested first.
+// Returns true if the task should stop.
+bool task_lifecycle_wait(EventGroupHandle_t events, TickType_t ticks) {
+    EventBits_t bits = xEventGroupWaitBits(events, TASK_EVENT_STOP, pdFALSE, pdFALSE, ticks);
+    return (bits & TASK_EVENT_STOP) != 0;
+}
+
+// Interruptible vTaskDelayUntil(): same drift-free deadline, but a stop
+// request ends the wait early. Returns true if the task should stop.
+bool task_lifecycle_wait_until(EventGroupHandle_t events, TickType_t* previous_wake_time, TickType_t period) {
+    TickType_t deadline = *previous_wake_time + period;
+    int32_t remaining = (int32_t)(deadline - xTaskGetTickCount());
+    
+    *previous_wake_time = deadline;
+    return task_lifecycle_wait(events, remaining > 0 ? (TickType_t)remaining : 0);
+}
+
+// Last call of a module task: report the exit and park until
+// task_lifecycle_stop() deletes this task. Never returns.
+void task_lifecycle_exit(EventGroupHandle_t events) {
+    xEventGroupSetBits(events, TASK_EVENT_EXITED);
+    
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+// Owner side: request a stop and join. The task is deleted either way;
+// returns false if it had not exited within timeout, in which case it was
+// deleted wherever it was blocked.
+bool task_lifecycle_stop(EventGroupHandle_t events, TaskHandle_t* task, TickType_t timeout) {
+    if (!*task) return true;
+    
+    xEventGroupSetBits(events, TASK_EVENT_STOP);
+    EventBits_t bits = xEventGroupWaitBits(events, TASK_EVENT_EXITED, pdFALSE, pdTRUE, timeout);
+    
+    vTaskDelete(*task);
+    *task = NULL;
+    xEventGroupClearBits(events, TASK_EVENT_STOP | TASK_EVENT_EXITED);
+    return (bits & TASK_EVENT_EXITED) != 0;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef TASK_LIFECYCLE_H
+#define TASK_LIFECYCLE_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cooperative stop/join for module tasks, through two bits reserved in the
+// module's event group (24 usable bits with 32-bit ticks).
+//
+// The task ends with task_lifecycle_exit(), which sets TASK_EVENT_EXITED
+// and parks. *_stop() clears task_running, wakes the task if it blocks on
+// something other than the event group, and calls task_lifecycle_stop().
+// That sets TASK_EVENT_STOP, waits for TASK_EVENT_EXITED, and only then
+// deletes the parked task. stop() therefore returns as soon as the task is
+// done, and the task never touches the module after stop() returns.
+#define TASK_EVENT_STOP   (1 << 22)
+#define TASK_EVENT_EXITED (1 << 23)
+
+// Upper bound for a task to notice the stop request and clean up
+#define TASK_LIFECYCLE_JOIN_TIMEOUT pdMS_TO_TICKS(2000)
+
+bool task_lifecycle_wait(EventGroupHandle_t events, TickType_t ticks);
+bool task_lifecycle_wait_until(EventGroupHandle_t events, TickType_t* previous_wake_time, TickType_t period);
+void task_lifecycle_exit(EventGroupHandle_t events);
+bool task_lifecycle_stop(EventGroupHandle_t events, TaskHandle_t* task, TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,71 +1,196 @@
 #include "led_controller.h"
+#include "../system_metrics/system_metrics.h"
+#include "../trace_recorder/trace_recorder.h"
 
 static const char* TAG = "LedController";
 
+// Built-in patterns as flash-resident step tables
+static const led_step_t off_steps[] = {
+    LED_STEP_SET(0, 0)
+};
+
+static const led_step_t solid_steps[] = {
+    LED_STEP_SET(LED_OUTPUT_DUTY_MAX, 0)
+};
+
+static const led_step_t blink_slow_steps[] = {
+    LED_STEP_SET(LED_OUTPUT_DUTY_MAX, 1000), // 1 second interval
+    LED_STEP_SET(0, 1000)
+};
+
+static const led_step_t blink_fast_steps[] = {
+    LED_STEP_SET(LED_OUTPUT_DUTY_MAX, 200), // 200ms interval
+    LED_STEP_SET(0, 200)
+};
+
+// Breathe: one hardware fade per gamma curve segment, up then down, 2 s
+// per cycle. Built from the curve's constants, so it is flash-resident
+// like the others and never written.
+#define BREATHE_CYCLE_MS 2000
+#define BREATHE_FADE(i) LED_STEP_FADE_TO(LED_OUTPUT_GAMMA(i), BREATHE_CYCLE_MS / (2 * LED_OUTPUT_CURVE_STEPS))
+
+static const led_step_t breathe_steps[] = {
+    BREATHE_FADE(1), BREATHE_FADE(2), BREATHE_FADE(3), BREATHE_FADE(4),
+    BREATHE_FADE(5), BREATHE_FADE(6), BREATHE_FADE(7), BREATHE_FADE(8),
+    BREATHE_FADE(7), BREATHE_FADE(6), BREATHE_FADE(5), BREATHE_FADE(4),
+    BREATHE_FADE(3), BREATHE_FADE(2), BREATHE_FADE(1), BREATHE_FADE(0)
+};
+_Static_assert(sizeof(breathe_steps) / sizeof(breathe_steps[0]) == 2 * LED_OUTPUT_CURVE_STEPS,
+               "breathe_steps must cover the gamma curve up and down");
+
+#define PROGRAM(steps, loop) { steps, sizeof(steps) / sizeof(steps[0]), loop }
+
+static const led_program_t builtin_programs[LED_PATTERN_SEQUENCE] = {
+    [LED_PATTERN_OFF] = PROGRAM(off_steps, false),
+    [LED_PATTERN_SOLID] = PROGRAM(solid_steps, false),
+    [LED_PATTERN_BLINK_SLOW] = PROGRAM(blink_slow_steps, true),
+    [LED_PATTERN_BLINK_FAST] = PROGRAM(blink_fast_steps, true),
+    [LED_PATTERN_BREATHE] = PROGRAM(breathe_steps, true)
+};
+
+static led_pattern_t program_pattern(const led_program_t* program) {
+    if (program >= &builtin_programs[0] && program < &builtin_programs[LED_PATTERN_SEQUENCE]) {
+        return (led_pattern_t)(program - builtin_programs);
+    }
+    return LED_PATTERN_SEQUENCE;
+}
+
+static void led_channel_init(led_channel_t* channel, uint8_t pin) {
+    channel->output.ops = &led_output_ledc_ops;
+    channel->output.pin = pin;
+    channel->output.channel = 0;
+    channel->output.duty = 0;
+    channel->pattern = LED_PATTERN_OFF;
+    channel->requested = &builtin_programs[LED_PATTERN_OFF];
+    channel->active = NULL;
+    channel->step_index = 0;
+    channel->holding = true;
+    channel->deadline = 0;
+    channel->pattern_since = 0;
+}
+
+// Drive the current step and schedule the next transition. The final step
+// of a non-looping program is held until the program changes.
+static void led_channel_apply(led_channel_t* channel, TickType_t start) {
+    const led_step_t* step = &channel->active->steps[channel->step_index];
+    uint16_t duty = step->duty_flags & LED_STEP_DUTY_MASK;
+    
+    if (step->duty_flags & LED_STEP_FADE) {
+        channel->output.ops->fade_to(&channel->output, duty, step->duration_ms);
+    } else {
+        channel->output.ops->set_duty(&channel->output, duty);
+    }
+    
+    channel->holding = !channel->active->loop &&
+                       channel->step_index + 1 >= channel->active->step_count;
+    channel->deadline = start + pdMS_TO_TICKS(step->duration_ms);
+}
+
+static void led_controller_account(led_controller_t* controller, led_channel_t* channel, TickType_t now) {
+    controller->wake_stats[channel->pattern].active_ticks += now - channel->pattern_since;
+    channel->pattern_since = now;
+}
+
 static void led_controller_task(void* arg) {
     led_controller_t* controller = (led_controller_t*)arg;
-    bool led_state = false;
-    uint32_t blink_counter = 0;
     
-    ESP_LOGI(TAG, "LED controller task started on pin %d", controller->pin);
+    ESP_LOGI(TAG, "LED controller task started with %d channel(s)", controller->channel_count);
+    
+    TickType_t now = xTaskGetTickCount();
     
-    pinMode(controller->pin, OUTPUT);
-    digitalWrite(controller->pin, LOW);
+    for (uint8_t i = 0; i < controller->channel_count; i++) {
+        led_channel_t* channel = &controller->channels[i];
+        
+        if (!channel->output.ops->begin(&channel->output, channel->output.pin)) {
+            ESP_LOGW(TAG, "%s output unavailable on pin %d, using gpio",
+                     channel->output.ops->name, channel->output.pin);
+            channel->output.ops = &led_output_gpio_ops;
+            channel->output.ops->begin(&channel->output, channel->output.pin);
+        }
+        
+        channel->active = NULL;
+        channel->pattern_since = now;
+    }
     
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t frequency = pdMS_TO_TICKS(100);
+    // Pick up the programs requested before start
+    EventBits_t events = LED_EVENT_PATTERN_CHANGED;
+    int metrics = system_metrics_register("led_controller", 0);
     
     while (controller->task_running) {
-        // Update LED based on current pattern
-        switch (controller->current_pattern) {
-            case LED_PATTERN_OFF:
-                digitalWrite(controller->pin, LOW);
-                break;
-                
-            case LED_PATTERN_SOLID:
-                digitalWrite(controller->pin, HIGH);
-                break;
-                
-            case LED_PATTERN_BLINK_SLOW:
-                if (blink_counter % 10 == 0) { // 1 second interval
-                    led_state = !led_state;
-                    digitalWrite(controller->pin, led_state ? HIGH : LOW);
-                }
-                break;
-                
-            case LED_PATTERN_BLINK_FAST:
-                if (blink_counter % 2 == 0) { // 200ms interval
-                    led_state = !led_state;
-                    digitalWrite(controller->pin, led_state ? HIGH : LOW);
-                }
-                break;
-                
-            case LED_PATTERN_BREATHE:
-                // Simple breathe pattern using PWM (simulated)
-                {
-                    uint8_t breathe_value = (blink_counter % 20) * 12;
-                    digitalWrite(controller->pin, (breathe_value > 100) ? HIGH : LOW);
-                }
-                break;
+        now = xTaskGetTickCount();
+        system_metrics_wake(metrics);
+        
+        if (events & LED_EVENT_STOP) {
+            break;
         }
         
-        blink_counter++;
+        for (uint8_t i = 0; i < controller->channel_count; i++) {
+            led_channel_t* channel = &controller->channels[i];
+            const led_program_t* requested = channel->requested;
+            
+            if ((events & LED_EVENT_PATTERN_CHANGED) && requested != channel->active) {
+                // Switch immediately, restarting the new program's phase
+                TRACE_SPAN_BEGIN(TRACE_SPAN_LED_PATTERN);
+                led_controller_account(controller, channel, now);
+                channel->active = requested;
+                channel->pattern = program_pattern(requested);
+                channel->step_index = 0;
+                controller->wake_stats[channel->pattern].wakeups++;
+                system_metrics_event(metrics, 1);
+                led_channel_apply(channel, now);
+                TRACE_SPAN_END(TRACE_SPAN_LED_PATTERN);
+            } else if (!channel->holding && (int32_t)(channel->deadline - now) <= 0) {
+                channel->step_index = (channel->step_index + 1) % channel->active->step_count;
+                controller->wake_stats[channel->pattern].wakeups++;
+                led_channel_apply(channel, channel->deadline); // Drift-free, like vTaskDelayUntil
+            }
+        }
+        
+        // Sleep until the earliest transition, or indefinitely if every
+        // channel is holding a static level
+        TickType_t timeout = portMAX_DELAY;
+        for (uint8_t i = 0; i < controller->channel_count; i++) {
+            led_channel_t* channel = &controller->channels[i];
+            if (!channel->holding) {
+                int32_t remaining = (int32_t)(channel->deadline - now);
+                TickType_t wait = (remaining > 0) ? (TickType_t)remaining : 0;
+                if (wait < timeout) {
+                    timeout = wait;
+                }
+            }
+        }
         
-        // Wait for next cycle or event
-        EventBits_t events = xEventGroupWaitBits(
+        events = xEventGroupWaitBits(
             controller->event_group,
-            LED_EVENT_PATTERN_CHANGED,
+            LED_EVENT_PATTERN_CHANGED | LED_EVENT_STOP,
             pdTRUE,  // Clear on exit
             pdFALSE, // Don't wait for all bits
-            frequency
+            timeout
         );
-        
-        vTaskDelayUntil(&last_wake_time, frequency);
     }
     
-    digitalWrite(controller->pin, LOW);
+    now = xTaskGetTickCount();
+    for (uint8_t i = 0; i < controller->channel_count; i++) {
+        led_channel_t* channel = &controller->channels[i];
+        led_controller_account(controller, channel, now);
+        channel->output.ops->end(&channel->output);
+    }
+    
+    system_metrics_unregister(metrics);
     ESP_LOGI(TAG, "LED controller task exiting");
-    vTaskDelete(NULL);
+    task_lifecycle_exit(controller->event_group);
+}
+
+static void led_controller_init(led_controller_t* controller, uint8_t led_pin) {
+    led_channel_init(&controller->channels[0], led_pin);
+    controller->channel_count = 1;
+    controller->task_handle = NULL;
+    controller->task_running = false;
+    memset(controller->wake_stats, 0, sizeof(controller->wake_stats));
+    task_config_t task_config = LED_CONTROLLER_DEFAULT_TASK_CONFIG;
+    controller->task_config = task_config;
+    controller->task_buffer = NULL;
+    controller->task_stack = NULL;
 }
 
 led_controller_t* led_controller_create(uint8_t led_pin) {
@@ -75,10 +200,7 @@ led_controller_t* led_controller_create(uint8_t led_pin) {
         return NULL;
     }
     
-    controller->pin = led_pin;
-    controller->current_pattern = LED_PATTERN_OFF;
-    controller->task_handle = NULL;
-    controller->task_running = false;
+    led_controller_init(controller, led_pin);
     
     // Create event group
     controller->event_group = xEventGroupCreate();
@@ -92,6 +214,21 @@ led_controller_t* led_controller_create(uint8_t led_pin) {
     return controller;
 }
 
+// Same as led_controller_create(), but the controller, its event group and
+// its task live in storage and nothing is taken from the heap
+led_controller_t* led_controller_create_static(led_controller_storage_t* storage, uint8_t led_pin) {
+    if (!storage) return NULL;
+    
+    led_controller_t* controller = &storage->controller;
+    led_controller_init(controller, led_pin);
+    controller->task_buffer = &storage->task;
+    controller->task_stack = storage->stack;
+    controller->event_group = xEventGroupCreateStatic(&storage->event_group);
+    
+    ESP_LOGI(TAG, "LED controller created for pin %d (static)", led_pin);
+    return controller;
+}
+
 void led_controller_destroy(led_controller_t* controller) {
     if (!controller) return;
     
@@ -101,30 +238,72 @@ void led_controller_destroy(led_controller_t* controller) {
         vEventGroupDelete(controller->event_group);
     }
     
-    free(controller);
+    if (!controller->task_buffer) {
+        free(controller);
+    }
     ESP_LOGI(TAG, "LED controller destroyed");
 }
 
+int led_controller_add_channel(led_controller_t* controller, uint8_t led_pin) {
+    // Channels can only be added while the task is not running
+    if (!controller || controller->task_running ||
+        controller->channel_count >= LED_CONTROLLER_MAX_CHANNELS) {
+        return -1;
+    }
+    
+    int index = controller->channel_count;
+    led_channel_init(&controller->channels[index], led_pin);
+    controller->channels[index].output.ops = controller->channels[0].output.ops;
+    controller->channel_count++;
+    
+    ESP_LOGI(TAG, "LED channel %d added for pin %d", index, led_pin);
+    return index;
+}
+
+bool led_controller_set_output(led_controller_t* controller, const led_output_ops_t* ops) {
+    // The backend can only be swapped while the task is not driving it
+    if (!controller || !ops || controller->task_running) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < controller->channel_count; i++) {
+        controller->channels[i].output.ops = ops;
+    }
+    return true;
+}
+
+// Stack size, priority, core and period used by the next led_controller_start().
+// Statically allocated controllers cannot grow their stack beyond LED_CONTROLLER_STACK_SIZE.
+bool led_controller_configure_task(led_controller_t* controller, const task_config_t* config) {
+    if (!controller || controller->task_running) {
+        return false;
+    }
+    
+    if (!task_config_valid(config, controller->task_buffer ? LED_CONTROLLER_STACK_SIZE : 0)) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    controller->task_config = *config;
+    return true;
+}
+
 bool led_controller_start(led_controller_t* controller) {
     if (!controller || controller->task_running) {
         return false;
     }
     
-    BaseType_t result = xTaskCreate(
-        led_controller_task,
-        "led_controller",
-        2048,
-        controller,
-        5,
-        &controller->task_handle
-    );
+    // Set before creating the task: a higher-priority task runs immediately
+    // and would otherwise see task_running == false and exit
+    controller->task_running = true;
     
-    if (result == pdPASS) {
-        controller->task_running = true;
+    if (task_config_create(led_controller_task, "led_controller", &controller->task_config, controller,
+                           controller->task_buffer, controller->task_stack, &controller->task_handle)) {
         ESP_LOGI(TAG, "LED controller task started successfully");
         return true;
     }
     
+    controller->task_running = false;
     ESP_LOGE(TAG, "Failed to start LED controller task");
     return false;
 }
@@ -135,21 +314,64 @@ void led_controller_stop(led_controller_t* controller) {
     }
     
     controller->task_running = false;
-    
-    if (controller->task_handle) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        vTaskDelete(controller->task_handle);
-        controller->task_handle = NULL;
+    if (!task_lifecycle_stop(controller->event_group, &controller->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "LED controller task did not exit in time, deleted");
     }
     
     ESP_LOGI(TAG, "LED controller stopped");
 }
 
-void led_controller_set_pattern(led_controller_t* controller, led_pattern_t pattern) {
-    if (!controller) return;
+bool led_controller_set_program(led_controller_t* controller, uint8_t channel, const led_program_t* program) {
+    if (!controller || !program || channel >= controller->channel_count ||
+        !program->steps || program->step_count == 0) {
+        return false;
+    }
     
-    controller->current_pattern = pattern;
+    // A looping program made only of zero-length steps would never sleep
+    if (program->loop) {
+        uint32_t total_ms = 0;
+        for (uint16_t i = 0; i < program->step_count; i++) {
+            total_ms += program->steps[i].duration_ms;
+        }
+        if (total_ms == 0) return false;
+    }
+    
+    // Re-applying the active program would only restart its phase
+    if (controller->channels[channel].requested == program) return true;
+    
+    controller->channels[channel].requested = program;
     xEventGroupSetBits(controller->event_group, LED_EVENT_PATTERN_CHANGED);
+    return true;
+}
+
+void led_controller_set_channel_pattern(led_controller_t* controller, uint8_t channel, led_pattern_t pattern) {
+    if (!controller || pattern >= LED_PATTERN_SEQUENCE || channel >= controller->channel_count) return;
     
-    ESP_LOGI(TAG, "LED pattern changed to: %d", pattern);
+    if (controller->channels[channel].requested == &builtin_programs[pattern]) return;
+    
+    led_controller_set_program(controller, channel, &builtin_programs[pattern]);
+    
+    ESP_LOGI(TAG, "LED pattern on channel %d changed to: %d", channel, pattern);
+}
+
+void led_controller_set_pattern(led_controller_t* controller, led_pattern_t pattern) {
+    led_controller_set_channel_pattern(controller, 0, pattern);
+}
+
+bool led_controller_get_wake_stats(led_controller_t* controller, led_pattern_t pattern, led_wake_stats_t* stats) {
+    if (!controller || !stats || pattern >= LED_PATTERN_COUNT) return false;
+    
+    *stats = controller->wake_stats[pattern];
+    
+    // Include time spent so far by channels currently running the pattern
+    if (controller->task_running) {
+        TickType_t now = xTaskGetTickCount();
+        for (uint8_t i = 0; i < controller->channel_count; i++) {
+            const led_channel_t* channel = &controller->channels[i];
+            if (channel->active && channel->pattern == pattern) {
+                stats->active_ticks += now - channel->pattern_since;
+            }
+        }
+    }
+    return true;
 }
\ No newline at end of file
@@ -6,6 +6,10 @@
 #include "freertos/event_groups.h"
 #include "Arduino.h"
 #include "esp_log.h"
+#include "led_output.h"
+#include "led_sequence.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,25 +20,78 @@ typedef enum {
     LED_PATTERN_SOLID,
     LED_PATTERN_BLINK_SLOW,
     LED_PATTERN_BLINK_FAST,
-    LED_PATTERN_BREATHE
+    LED_PATTERN_BREATHE,
+    LED_PATTERN_SEQUENCE, // Custom program set via led_controller_set_program()
+    LED_PATTERN_COUNT
 } led_pattern_t;
 
+// One task drives every channel of a controller
+#ifndef LED_CONTROLLER_MAX_CHANNELS
+#define LED_CONTROLLER_MAX_CHANNELS 4
+#endif
+
+#define LED_CONTROLLER_STACK_SIZE 2048
+// Event/deadline driven, no fixed period
+#define LED_CONTROLLER_DEFAULT_TASK_CONFIG { LED_CONTROLLER_STACK_SIZE, 5, tskNO_AFFINITY, 0 }
+
+// Per-pattern wakeup instrumentation; wakeups per minute for a pattern is
+// wakeups * 60000 / (active_ticks * portTICK_PERIOD_MS).
+typedef struct {
+    uint32_t wakeups;
+    TickType_t active_ticks;
+} led_wake_stats_t;
+
 typedef struct {
-    uint8_t pin;
-    led_pattern_t current_pattern;
+    led_output_t output;
+    led_pattern_t pattern;
+    // Written by callers, picked up by the task on LED_EVENT_PATTERN_CHANGED
+    const led_program_t* volatile requested;
+    // Task-owned execution state
+    const led_program_t* active;
+    uint16_t step_index;
+    bool holding;
+    TickType_t deadline;
+    TickType_t pattern_since;
+} led_channel_t;
+
+typedef struct {
+    led_channel_t channels[LED_CONTROLLER_MAX_CHANNELS];
+    uint8_t channel_count;
     TaskHandle_t task_handle;
     EventGroupHandle_t event_group;
     bool task_running;
+    led_wake_stats_t wake_stats[LED_PATTERN_COUNT];
+    task_config_t task_config;
+    // Set by led_controller_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
 } led_controller_t;
 
+// Caller-provided storage for led_controller_create_static(); must outlive
+// the controller
+typedef struct {
+    led_controller_t controller;
+    StaticEventGroup_t event_group;
+    StaticTask_t task;
+    StackType_t stack[LED_CONTROLLER_STACK_SIZE];
+} led_controller_storage_t;
+
 // Events
 #define LED_EVENT_PATTERN_CHANGED (1 << 0)
+#define LED_EVENT_STOP            TASK_EVENT_STOP
 
 led_controller_t* led_controller_create(uint8_t led_pin);
+led_controller_t* led_controller_create_static(led_controller_storage_t* storage, uint8_t led_pin);
 void led_controller_destroy(led_controller_t* controller);
+int led_controller_add_channel(led_controller_t* controller, uint8_t led_pin);
 void led_controller_set_pattern(led_controller_t* controller, led_pattern_t pattern);
+void led_controller_set_channel_pattern(led_controller_t* controller, uint8_t channel, led_pattern_t pattern);
+bool led_controller_set_program(led_controller_t* controller, uint8_t channel, const led_program_t* program);
+bool led_controller_set_output(led_controller_t* controller, const led_output_ops_t* ops);
+bool led_controller_configure_task(led_controller_t* controller, const task_config_t* config);
 bool led_controller_start(led_controller_t* controller);
 void led_controller_stop(led_controller_t* controller);
+bool led_controller_get_wake_stats(led_controller_t* controller, led_pattern_t pattern, led_wake_stats_t* stats);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,279 @@
+#include "led_output.h"
+#include "Arduino.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+
+static const char* TAG = "LedOutput";
+
+const uint16_t led_output_gamma_curve[LED_OUTPUT_CURVE_STEPS + 1] = {
+    LED_OUTPUT_GAMMA(0), LED_OUTPUT_GAMMA(1), LED_OUTPUT_GAMMA(2), LED_OUTPUT_GAMMA(3), LED_OUTPUT_GAMMA(4),
+    LED_OUTPUT_GAMMA(5), LED_OUTPUT_GAMMA(6), LED_OUTPUT_GAMMA(7), LED_OUTPUT_GAMMA(8)
+};
+
+// GPIO backend
+
+static portMUX_TYPE soft_pwm_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Start of a period: advance the fade and return how long to stay high
+static uint32_t soft_pwm_period_start(led_output_t* output) {
+    if (output->pwm_frame < output->pwm_frames) {
+        output->pwm_frame++;
+        int32_t span = (int32_t)output->pwm_target - (int32_t)output->pwm_from;
+        output->duty = (uint16_t)(output->pwm_from + span * output->pwm_frame / output->pwm_frames);
+    }
+    return (uint32_t)output->duty * LED_OUTPUT_SOFT_PWM_PERIOD_US / LED_OUTPUT_DUTY_MAX;
+}
+
+// Runs at the start of each period and where it goes low. Alarms are set
+// from the period's start, so callback latency does not stretch periods.
+static void soft_pwm_timer(void* arg) {
+    led_output_t* output = (led_output_t*)arg;
+    int64_t now_us = esp_timer_get_time();
+    uint8_t level = LOW;
+    int64_t next_us;
+    
+    portENTER_CRITICAL(&soft_pwm_lock);
+    bool period_start = !output->pwm_high;
+    if (!period_start) {
+        output->pwm_high = false;
+        next_us = output->pwm_period_us + LED_OUTPUT_SOFT_PWM_PERIOD_US;
+    } else {
+        // Resume on schedule, or from now after an idle spell
+        int64_t start_us = output->pwm_period_us + LED_OUTPUT_SOFT_PWM_PERIOD_US;
+        output->pwm_period_us = (now_us - start_us < LED_OUTPUT_SOFT_PWM_PERIOD_US) ? start_us : now_us;
+        next_us = output->pwm_period_us + LED_OUTPUT_SOFT_PWM_PERIOD_US;
+        
+        uint32_t high_us = soft_pwm_period_start(output);
+        if (high_us) {
+            level = HIGH;
+        }
+        if (high_us && high_us < LED_OUTPUT_SOFT_PWM_PERIOD_US) {
+            output->pwm_high = true;
+            next_us = output->pwm_period_us + high_us;
+        }
+    }
+    portEXIT_CRITICAL(&soft_pwm_lock);
+    
+    // Outside the lock: on the RGB LED_BUILTIN this is an RMT transfer
+    digitalWrite(output->pin, level);
+    
+    TaskHandle_t closer = NULL;
+    portENTER_CRITICAL(&soft_pwm_lock);
+    bool steady = period_start && output->pwm_frame >= output->pwm_frames &&
+                  (output->duty == 0 || output->duty == LED_OUTPUT_DUTY_MAX);
+    if (output->pwm_closing) {
+        closer = output->pwm_closer;
+        output->pwm_running = false;
+    } else if (steady) {
+        output->pwm_running = false; // Restarted by the next duty change
+    } else {
+        int64_t delay_us = next_us - esp_timer_get_time();
+        esp_timer_start_once(output->pwm_timer, delay_us > 0 ? (uint64_t)delay_us : 0);
+    }
+    portEXIT_CRITICAL(&soft_pwm_lock);
+    
+    if (closer) {
+        xTaskNotifyGive(closer);
+    }
+}
+
+static bool gpio_output_begin(led_output_t* output, uint8_t pin) {
+    output->pin = pin;
+    output->duty = 0;
+    output->pwm_closer = NULL;
+    output->pwm_from = 0;
+    output->pwm_target = 0;
+    output->pwm_frames = 0;
+    output->pwm_frame = 0;
+    output->pwm_period_us = 0;
+    output->pwm_high = false;
+    output->pwm_running = false;
+    output->pwm_closing = false;
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    
+    esp_timer_create_args_t timer_args = {
+        .callback = soft_pwm_timer,
+        .arg = output,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led_pwm",
+        .skip_unhandled_events = false
+    };
+    if (esp_timer_create(&timer_args, &output->pwm_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create PWM timer for pin %d", pin);
+        output->pwm_timer = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Takes effect at the start of the next period
+static void gpio_output_fade_to(led_output_t* output, uint16_t duty, uint32_t duration_ms) {
+    if (!output->pwm_timer) {
+        // No timer: plain on/off
+        output->duty = duty;
+        digitalWrite(output->pin, (duty >= LED_OUTPUT_DUTY_MAX / 2) ? HIGH : LOW);
+        return;
+    }
+    
+    uint32_t frames = duration_ms * 1000 / LED_OUTPUT_SOFT_PWM_PERIOD_US;
+    
+    portENTER_CRITICAL(&soft_pwm_lock);
+    output->pwm_from = output->duty;
+    output->pwm_target = duty;
+    output->pwm_frames = (uint16_t)(frames > UINT16_MAX ? UINT16_MAX : frames);
+    output->pwm_frame = 0;
+    if (output->pwm_frames == 0) {
+        output->duty = duty;
+    }
+    if (!output->pwm_running) {
+        output->pwm_running = true;
+        esp_timer_start_once(output->pwm_timer, 0);
+    }
+    portEXIT_CRITICAL(&soft_pwm_lock);
+}
+
+static void gpio_output_set_duty(led_output_t* output, uint16_t duty) {
+    gpio_output_fade_to(output, duty, 0);
+}
+
+static void gpio_output_end(led_output_t* output) {
+    if (output->pwm_timer) {
+        portENTER_CRITICAL(&soft_pwm_lock);
+        output->pwm_closing = true;
+        output->pwm_closer = xTaskGetCurrentTaskHandle();
+        // Stopping an armed timer means its callback will not run
+        if (output->pwm_running && esp_timer_stop(output->pwm_timer) == ESP_OK) {
+            output->pwm_running = false;
+        }
+        bool in_callback = output->pwm_running;
+        portEXIT_CRITICAL(&soft_pwm_lock);
+        
+        // It notifies once it no longer touches the output
+        if (in_callback) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        esp_timer_delete(output->pwm_timer);
+        output->pwm_timer = NULL;
+    }
+    digitalWrite(output->pin, LOW);
+}
+
+const led_output_ops_t led_output_gpio_ops = {
+    "gpio",
+    gpio_output_begin,
+    gpio_output_set_duty,
+    gpio_output_fade_to,
+    gpio_output_end
+};
+
+// LEDC backend
+
+#define LEDC_OUTPUT_MODE  LEDC_LOW_SPEED_MODE
+#define LEDC_OUTPUT_TIMER LEDC_TIMER_0
+#define LEDC_OUTPUT_FREQ  5000
+
+static bool ledc_ready = false;
+// Channels held between begin() and end(), across all controllers
+static portMUX_TYPE ledc_channel_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t ledc_channels_used = 0;
+
+// Lowest free channel, or LEDC_CHANNEL_MAX if all are taken
+static uint8_t ledc_channel_take(void) {
+    uint8_t channel = LEDC_CHANNEL_MAX;
+    
+    portENTER_CRITICAL(&ledc_channel_lock);
+    uint32_t free_channels = ~ledc_channels_used & ((1u << LEDC_CHANNEL_MAX) - 1);
+    if (free_channels) {
+        channel = (uint8_t)__builtin_ctz(free_channels);
+        ledc_channels_used |= 1u << channel;
+    }
+    portEXIT_CRITICAL(&ledc_channel_lock);
+    return channel;
+}
+
+static void ledc_channel_give(uint8_t channel) {
+    portENTER_CRITICAL(&ledc_channel_lock);
+    ledc_channels_used &= ~(1u << channel);
+    portEXIT_CRITICAL(&ledc_channel_lock);
+}
+
+static bool ledc_output_begin(led_output_t* output, uint8_t pin) {
+    // Pins such as the RGB LED_BUILTIN are not real GPIOs
+    if (!GPIO_IS_VALID_OUTPUT_GPIO(pin)) {
+        return false;
+    }
+    
+    if (!ledc_ready) {
+        ledc_timer_config_t timer_config = {
+            .speed_mode = LEDC_OUTPUT_MODE,
+            .duty_resolution = (ledc_timer_bit_t)LED_OUTPUT_DUTY_BITS,
+            .timer_num = LEDC_OUTPUT_TIMER,
+            .freq_hz = LEDC_OUTPUT_FREQ,
+            .clk_cfg = LEDC_AUTO_CLK
+        };
+        if (ledc_timer_config(&timer_config) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure LEDC timer");
+            return false;
+        }
+        
+        esp_err_t err = ledc_fade_func_install(0);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "Failed to install LEDC fade service");
+            return false;
+        }
+        ledc_ready = true;
+    }
+    
+    uint8_t channel = ledc_channel_take();
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return false;
+    }
+    
+    ledc_channel_config_t channel_config = {
+        .gpio_num = pin,
+        .speed_mode = LEDC_OUTPUT_MODE,
+        .channel = (ledc_channel_t)channel,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = LEDC_OUTPUT_TIMER,
+        .duty = 0,
+        .hpoint = 0
+    };
+    if (ledc_channel_config(&channel_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure LEDC channel for pin %d", pin);
+        ledc_channel_give(channel);
+        return false;
+    }
+    
+    output->pin = pin;
+    output->channel = channel;
+    output->duty = 0;
+    return true;
+}
+
+static void ledc_output_set_duty(led_output_t* output, uint16_t duty) {
+    output->duty = duty;
+    ledc_set_duty_and_update(LEDC_OUTPUT_MODE, (ledc_channel_t)output->channel, duty, 0);
+}
+
+static void ledc_output_fade_to(led_output_t* output, uint16_t duty, uint32_t duration_ms) {
+    output->duty = duty;
+    ledc_set_fade_time_and_start(LEDC_OUTPUT_MODE, (ledc_channel_t)output->channel,
+                                 duty, duration_ms, LEDC_FADE_NO_WAIT);
+}
+
+// Gives the channel back, so a controller can be started and stopped any
+// number of times without running out
+static void ledc_output_end(led_output_t* output) {
+    ledc_stop(LEDC_OUTPUT_MODE, (ledc_channel_t)output->channel, 0);
+    ledc_channel_give(output->channel);
+}
+
+const led_output_ops_t led_output_ledc_ops = {
+    "ledc",
+    ledc_output_begin,
+    ledc_output_set_duty,
+    ledc_output_fade_to,
+    ledc_output_end
+};
@@ -0,0 +1,80 @@
+#ifndef LED_OUTPUT_H
+#define LED_OUTPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Duty cycles are expressed at 13-bit resolution across all backends
+#define LED_OUTPUT_DUTY_BITS 13
+#define LED_OUTPUT_DUTY_MAX  ((1 << LED_OUTPUT_DUTY_BITS) - 1)
+
+// Software PWM period of the gpio backend: 100 Hz, above visible flicker
+#define LED_OUTPUT_SOFT_PWM_PERIOD_US 10000
+
+typedef struct led_output led_output_t;
+
+// Output backend. fade_to() starts a transition from the current duty to
+// the target over duration_ms and returns immediately; backends without
+// hardware fading may jump straight to the target.
+typedef struct {
+    const char* name;
+    bool (*begin)(led_output_t* output, uint8_t pin);
+    void (*set_duty)(led_output_t* output, uint16_t duty);
+    void (*fade_to)(led_output_t* output, uint16_t duty, uint32_t duration_ms);
+    void (*end)(led_output_t* output);
+} led_output_ops_t;
+
+struct led_output {
+    const led_output_ops_t* ops;
+    uint8_t pin;
+    uint8_t channel;
+    uint16_t duty;
+    // gpio backend: software PWM state, shared with its timer callback
+    esp_timer_handle_t pwm_timer;
+    TaskHandle_t pwm_closer; // end() waiting for a callback in progress
+    uint16_t pwm_from;       // Fade from pwm_from to pwm_target
+    uint16_t pwm_target;
+    uint16_t pwm_frames;     // Fade length in PWM periods
+    uint16_t pwm_frame;      // Periods of the fade done
+    int64_t pwm_period_us;   // Start of the current period
+    bool pwm_high;           // In the high part, before the edge
+    bool pwm_running;        // Timer armed or callback in progress
+    bool pwm_closing;
+};
+
+// digitalWrite() backend for pins LEDC cannot drive, such as the RGB
+// LED_BUILTIN: software PWM from an esp_timer, with fades stepped once per
+// period. The timer stops while the duty is 0 or full.
+extern const led_output_ops_t led_output_gpio_ops;
+// LEDC PWM backend with hardware fades
+extern const led_output_ops_t led_output_ledc_ops;
+
+// Gamma-corrected (2.2) duty curve, LED_OUTPUT_CURVE_STEPS segments from
+// off to full brightness, used for breathe and fade transitions. The
+// points are constants, so step tables built from them can be const too.
+#define LED_OUTPUT_CURVE_STEPS 8
+// round(8191 * (i / 8)^2.2)
+#define LED_OUTPUT_GAMMA_0 0
+#define LED_OUTPUT_GAMMA_1 84
+#define LED_OUTPUT_GAMMA_2 388
+#define LED_OUTPUT_GAMMA_3 947
+#define LED_OUTPUT_GAMMA_4 1783
+#define LED_OUTPUT_GAMMA_5 2913
+#define LED_OUTPUT_GAMMA_6 4350
+#define LED_OUTPUT_GAMMA_7 6106
+#define LED_OUTPUT_GAMMA_8 8191
+#define LED_OUTPUT_GAMMA(i) LED_OUTPUT_GAMMA_##i
+extern const uint16_t led_output_gamma_curve[LED_OUTPUT_CURVE_STEPS + 1];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+#include "led_sequence.h"
+#include "esp_log.h"
+
+static const char* TAG = "LedSequence";
+
+uint16_t led_sequence_level_to_duty(uint8_t level) {
+    // Piecewise-linear interpolation of the gamma curve
+    uint32_t scaled = (uint32_t)level * LED_OUTPUT_CURVE_STEPS;
+    uint32_t index = scaled / 255;
+    uint32_t frac = scaled % 255;
+    
+    if (index >= LED_OUTPUT_CURVE_STEPS) {
+        return led_output_gamma_curve[LED_OUTPUT_CURVE_STEPS];
+    }
+    
+    uint32_t low = led_output_gamma_curve[index];
+    uint32_t high = led_output_gamma_curve[index + 1];
+    return (uint16_t)(low + ((high - low) * frac) / 255);
+}
+
+size_t led_sequence_compiled_size(const led_sequence_t* sequence) {
+    if (!sequence || !sequence->frames) return 0;
+    
+    size_t count = 0;
+    for (uint16_t i = 0; i < sequence->frame_count; i++) {
+        count += (sequence->frames[i].easing == LED_EASE_SMOOTH) ? LED_SEQUENCE_SMOOTH_STEPS : 1;
+    }
+    return count;
+}
+
+size_t led_sequence_compile(const led_sequence_t* sequence, led_step_t* steps, size_t max_steps, led_program_t* program) {
+    if (!sequence || !steps || !program || sequence->frame_count == 0) {
+        return 0;
+    }
+    
+    size_t needed = led_sequence_compiled_size(sequence);
+    if (needed > max_steps || needed > UINT16_MAX) {
+        ESP_LOGE(TAG, "Sequence needs %u steps, buffer holds %u", (unsigned)needed, (unsigned)max_steps);
+        return 0;
+    }
+    
+    // Looping sequences ease in from their own last level
+    uint8_t previous = sequence->loop ? sequence->frames[sequence->frame_count - 1].level : 0;
+    size_t count = 0;
+    
+    for (uint16_t i = 0; i < sequence->frame_count; i++) {
+        const led_keyframe_t* frame = &sequence->frames[i];
+        
+        switch (frame->easing) {
+            case LED_EASE_LINEAR:
+                steps[count].duty_flags = led_sequence_level_to_duty(frame->level) | LED_STEP_FADE;
+                steps[count].duration_ms = frame->duration_ms;
+                count++;
+                break;
+                
+            case LED_EASE_SMOOTH:
+                {
+                    uint16_t elapsed = 0;
+                    for (uint16_t k = 1; k <= LED_SEQUENCE_SMOOTH_STEPS; k++) {
+                        int32_t level = previous + ((int32_t)(frame->level - previous) * k) / LED_SEQUENCE_SMOOTH_STEPS;
+                        uint16_t until = (uint16_t)(((uint32_t)frame->duration_ms * k) / LED_SEQUENCE_SMOOTH_STEPS);
+                        
+                        steps[count].duty_flags = led_sequence_level_to_duty((uint8_t)level) | LED_STEP_FADE;
+                        steps[count].duration_ms = until - elapsed;
+                        elapsed = until;
+                        count++;
+                    }
+                }
+                break;
+                
+            case LED_EASE_STEP:
+            default:
+                steps[count].duty_flags = led_sequence_level_to_duty(frame->level);
+                steps[count].duration_ms = frame->duration_ms;
+                count++;
+                break;
+        }
+        
+        previous = frame->level;
+    }
+    
+    program->steps = steps;
+    program->step_count = (uint16_t)count;
+    program->loop = sequence->loop;
+    return count;
+}
@@ -0,0 +1,65 @@
+#ifndef LED_SEQUENCE_H
+#define LED_SEQUENCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_output.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compiled step: 4 bytes, duty in the low 13 bits of duty_flags and
+// LED_STEP_FADE set when the output should fade to duty instead of jumping.
+typedef struct {
+    uint16_t duty_flags;
+    uint16_t duration_ms;
+} led_step_t;
+
+#define LED_STEP_FADE      0x8000
+#define LED_STEP_DUTY_MASK LED_OUTPUT_DUTY_MAX
+
+#define LED_STEP_SET(duty, ms)  { (uint16_t)(duty), (uint16_t)(ms) }
+#define LED_STEP_FADE_TO(duty, ms) { (uint16_t)((duty) | LED_STEP_FADE), (uint16_t)(ms) }
+
+// A step table executed by the controller task. Non-looping programs hold
+// their final step indefinitely. Programs can be declared const so both the
+// steps and the descriptor stay in flash.
+typedef struct {
+    const led_step_t* steps;
+    uint16_t step_count;
+    bool loop;
+} led_program_t;
+
+typedef enum {
+    LED_EASE_STEP = 0,  // Jump to the level and hold it
+    LED_EASE_LINEAR,    // One hardware fade, linear in duty
+    LED_EASE_SMOOTH     // Perceptually linear fade along the gamma curve
+} led_easing_t;
+
+// Keyframe: reach level (0-255, perceptual) over duration_ms using easing
+typedef struct {
+    uint16_t duration_ms;
+    uint8_t level;
+    uint8_t easing;
+} led_keyframe_t;
+
+typedef struct {
+    const led_keyframe_t* frames;
+    uint16_t frame_count;
+    bool loop;
+} led_sequence_t;
+
+// Sub-fades emitted per LED_EASE_SMOOTH keyframe
+#define LED_SEQUENCE_SMOOTH_STEPS 4
+
+uint16_t led_sequence_level_to_duty(uint8_t level);
+size_t led_sequence_compiled_size(const led_sequence_t* sequence);
+size_t led_sequence_compile(const led_sequence_t* sequence, led_step_t* steps, size_t max_steps, led_program_t* program);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
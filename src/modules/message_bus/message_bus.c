@@ -0,0 +1,134 @@
+#include "message_bus.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+static const char* TAG = "MessageBus";
+
+// One event bit per slot for unsubscribe to wait on
+_Static_assert(MESSAGE_BUS_MAX_SUBSCRIBERS <= 24, "slots must fit the event group's bits");
+
+typedef struct {
+    volatile uint32_t topics; // 0 while the slot is free
+    QueueHandle_t queue;
+    message_bus_stats_t stats;
+    // Publishers between looking at topics and done with queue. Once it
+    // drops to 0 with draining set, the publisher that gets to clear
+    // draining wakes unsubscribe().
+    volatile uint32_t publishing;
+    volatile bool draining;
+} message_bus_slot_t;
+
+static message_bus_slot_t bus_slots[MESSAGE_BUS_MAX_SUBSCRIBERS];
+static portMUX_TYPE bus_mux = portMUX_INITIALIZER_UNLOCKED;
+static StaticEventGroup_t bus_events_buffer;
+static EventGroupHandle_t bus_events = NULL;
+
+// queue must hold message_t items. Unsubscribe before deleting it.
+int message_bus_subscribe(uint32_t topics, QueueHandle_t queue) {
+    if (topics == 0 || !queue) return MESSAGE_BUS_INVALID_SLOT;
+    
+    int slot = MESSAGE_BUS_INVALID_SLOT;
+    
+    // Subscribers are set up from setup() and task start-up, before anyone
+    // can be waiting in unsubscribe()
+    if (!bus_events) {
+        bus_events = xEventGroupCreateStatic(&bus_events_buffer);
+    }
+    
+    portENTER_CRITICAL(&bus_mux);
+    for (int i = 0; i < MESSAGE_BUS_MAX_SUBSCRIBERS; i++) {
+        if (bus_slots[i].topics == 0 && bus_slots[i].queue == NULL) {
+            bus_slots[i].queue = queue;
+            bus_slots[i].stats.delivered = 0;
+            bus_slots[i].stats.dropped = 0;
+            // Publishers only look at slots with topics set, so the queue
+            // must be visible first
+            __atomic_store_n(&bus_slots[i].topics, topics, __ATOMIC_RELEASE);
+            slot = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&bus_mux);
+    
+    if (slot == MESSAGE_BUS_INVALID_SLOT) {
+        ESP_LOGW(TAG, "No free subscriber slot");
+    }
+    return slot;
+}
+
+// Publisher done with a slot's queue
+static void message_bus_release(message_bus_slot_t* slot, int index) {
+    if (__atomic_sub_fetch(&slot->publishing, 1, __ATOMIC_SEQ_CST) == 0 &&
+        __atomic_exchange_n(&slot->draining, false, __ATOMIC_SEQ_CST)) {
+        xEventGroupSetBits(bus_events, 1 << index);
+    }
+}
+
+// Returns once no publisher can still send to the slot's queue, so the
+// caller may delete it. Publishers never block, so the wait is for one
+// that was preempted mid-publish.
+void message_bus_unsubscribe(int slot) {
+    if (slot < 0 || slot >= MESSAGE_BUS_MAX_SUBSCRIBERS) return;
+    
+    message_bus_slot_t* entry = &bus_slots[slot];
+    
+    xEventGroupClearBits(bus_events, 1 << slot);
+    portENTER_CRITICAL(&bus_mux);
+    __atomic_store_n(&entry->topics, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&entry->draining, true, __ATOMIC_SEQ_CST);
+    portEXIT_CRITICAL(&bus_mux);
+    
+    // Publishers that saw the old topics have already counted themselves
+    // in; the last one out (or this check, if none is left) clears draining
+    if (__atomic_load_n(&entry->publishing, __ATOMIC_SEQ_CST) != 0 ||
+        !__atomic_exchange_n(&entry->draining, false, __ATOMIC_SEQ_CST)) {
+        xEventGroupWaitBits(bus_events, 1 << slot, pdTRUE, pdTRUE, portMAX_DELAY);
+    }
+    
+    // Only now may subscribe() hand the slot out again
+    portENTER_CRITICAL(&bus_mux);
+    entry->queue = NULL;
+    portEXIT_CRITICAL(&bus_mux);
+}
+
+// Stamps the message and copies it to every subscriber of its topic.
+// Never blocks; returns the number of queues it reached.
+uint32_t message_bus_publish(message_t* message) {
+    if (!message || message->topic >= MESSAGE_TOPIC_COUNT) return 0;
+    
+    uint32_t bit = MESSAGE_TOPIC_BIT(message->topic);
+    uint32_t delivered = 0;
+    
+    message->timestamp = xTaskGetTickCount();
+    
+    for (int i = 0; i < MESSAGE_BUS_MAX_SUBSCRIBERS; i++) {
+        message_bus_slot_t* slot = &bus_slots[i];
+        if (!(__atomic_load_n(&slot->topics, __ATOMIC_RELAXED) & bit)) continue;
+        
+        // Count in before the real check: unsubscribe() clears topics and
+        // then waits for the count, so either it sees us or we see it
+        __atomic_add_fetch(&slot->publishing, 1, __ATOMIC_SEQ_CST);
+        if (!(__atomic_load_n(&slot->topics, __ATOMIC_SEQ_CST) & bit)) {
+            message_bus_release(slot, i); // Unsubscribed meanwhile
+            continue;
+        }
+        
+        if (xQueueSend(slot->queue, message, 0) == pdTRUE) {
+            __atomic_fetch_add(&slot->stats.delivered, 1, __ATOMIC_RELAXED);
+            delivered++;
+        } else {
+            __atomic_fetch_add(&slot->stats.dropped, 1, __ATOMIC_RELAXED);
+        }
+        message_bus_release(slot, i);
+    }
+    
+    return delivered;
+}
+
+bool message_bus_get_stats(int slot, message_bus_stats_t* stats) {
+    if (slot < 0 || slot >= MESSAGE_BUS_MAX_SUBSCRIBERS || !stats) return false;
+    
+    stats->delivered = __atomic_load_n(&bus_slots[slot].stats.delivered, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&bus_slots[slot].stats.dropped, __ATOMIC_RELAXED);
+    return true;
+}
\ No newline at end of file
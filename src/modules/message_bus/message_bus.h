@@ -0,0 +1,56 @@
+#ifndef MESSAGE_BUS_H
+#define MESSAGE_BUS_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "../sensor_reader/sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// In-process publish/subscribe. Each subscriber owns a FreeRTOS queue of
+// message_t and a topic mask; message_bus_publish() copies the message into
+// every matching queue without blocking, so a slow subscriber only loses
+// its own messages.
+#ifndef MESSAGE_BUS_MAX_SUBSCRIBERS
+#define MESSAGE_BUS_MAX_SUBSCRIBERS 8
+#endif
+
+#define MESSAGE_BUS_INVALID_SLOT (-1)
+
+typedef enum {
+    MESSAGE_TOPIC_WIFI_STATE = 0, // wifi_state: new wifi_state_t
+    MESSAGE_TOPIC_SENSOR_SAMPLE,  // sample: published sensor_data_t
+    MESSAGE_TOPIC_COUNT
+} message_topic_t;
+
+#define MESSAGE_TOPIC_BIT(topic) (1u << (topic))
+
+typedef struct {
+    message_topic_t topic;
+    TickType_t timestamp; // When published
+    union {
+        uint8_t wifi_state;
+        sensor_data_t sample;
+    };
+} message_t;
+
+typedef struct {
+    uint32_t delivered;
+    uint32_t dropped; // Subscriber queue was full
+} message_bus_stats_t;
+
+int message_bus_subscribe(uint32_t topics, QueueHandle_t queue);
+// Waits for publishers still sending to the slot's queue; the queue may be
+// deleted once it returns
+void message_bus_unsubscribe(int slot);
+uint32_t message_bus_publish(message_t* message);
+bool message_bus_get_stats(int slot, message_bus_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "mqtt_packet.h"
+#include <string.h>
+
+static size_t mqtt_encode_remaining_length(uint8_t* out, uint32_t length) {
+    size_t used = 0;
+    
+    do {
+        uint8_t byte = length % 128;
+        length /= 128;
+        if (length > 0) {
+            byte |= 0x80;
+        }
+        out[used++] = byte;
+    } while (length > 0);
+    
+    return used;
+}
+
+static size_t mqtt_encode_string(uint8_t* out, const char* value, size_t length) {
+    out[0] = (uint8_t)(length >> 8);
+    out[1] = (uint8_t)length;
+    memcpy(out + 2, value, length);
+    return 2 + length;
+}
+
+size_t mqtt_encode_connect(uint8_t* out, size_t size, const char* client_id, uint16_t keepalive_s) {
+    size_t id_length = strlen(client_id);
+    // Protocol name, level, flags, keepalive, client id
+    uint32_t remaining = 6 + 1 + 1 + 2 + 2 + (uint32_t)id_length;
+    
+    if (id_length > UINT16_MAX || size < MQTT_PACKET_MAX_HEADER + remaining) return 0;
+    
+    size_t used = 0;
+    out[used++] = MQTT_PACKET_CONNECT;
+    used += mqtt_encode_remaining_length(out + used, remaining);
+    used += mqtt_encode_string(out + used, "MQTT", 4);
+    out[used++] = 4;    // Protocol level 3.1.1
+    out[used++] = 0x02; // Clean session
+    out[used++] = (uint8_t)(keepalive_s >> 8);
+    out[used++] = (uint8_t)keepalive_s;
+    used += mqtt_encode_string(out + used, client_id, id_length);
+    return used;
+}
+
+// Everything up to the payload of a QoS 1 PUBLISH; the caller sends the
+// payload bytes straight after it
+size_t mqtt_encode_publish_header(uint8_t* out, size_t size, const char* topic, uint16_t packet_id,
+                                  size_t payload_length) {
+    size_t topic_length = strlen(topic);
+    uint64_t remaining = 2 + topic_length + 2 + payload_length;
+    
+    // 268435455 is the largest remaining length MQTT can express
+    if (topic_length > UINT16_MAX || remaining > 268435455u) return 0;
+    if (size < MQTT_PACKET_MAX_HEADER + 2 + topic_length + 2) return 0;
+    
+    size_t used = 0;
+    out[used++] = MQTT_PACKET_PUBLISH | 0x02; // QoS 1
+    used += mqtt_encode_remaining_length(out + used, (uint32_t)remaining);
+    used += mqtt_encode_string(out + used, topic, topic_length);
+    out[used++] = (uint8_t)(packet_id >> 8);
+    out[used++] = (uint8_t)packet_id;
+    return used;
+}
+
+size_t mqtt_encode_pingreq(uint8_t* out, size_t size) {
+    if (size < 2) return 0;
+    
+    out[0] = MQTT_PACKET_PINGREQ;
+    out[1] = 0;
+    return 2;
+}
+
+size_t mqtt_encode_disconnect(uint8_t* out, size_t size) {
+    if (size < 2) return 0;
+    
+    out[0] = MQTT_PACKET_DISCONNECT;
+    out[1] = 0;
+    return 2;
+}
+
+int mqtt_decode_remaining_length(const uint8_t* data, size_t available, uint32_t* length) {
+    uint32_t value = 0;
+    
+    for (size_t i = 0; i < 4; i++) {
+        if (i >= available) return 0;
+        
+        value |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *length = value;
+            return (int)(i + 1);
+        }
+    }
+    return -1;
+}
\ No newline at end of file
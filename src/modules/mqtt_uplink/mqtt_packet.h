@@ -0,0 +1,42 @@
+#ifndef MQTT_PACKET_H
+#define MQTT_PACKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimal MQTT 3.1.1 codec: just the packets a QoS 1 publisher needs.
+// Encoders return the packet length, or 0 if it does not fit in out.
+
+#define MQTT_PACKET_CONNECT    0x10
+#define MQTT_PACKET_CONNACK    0x20
+#define MQTT_PACKET_PUBLISH    0x30
+#define MQTT_PACKET_PUBACK     0x40
+#define MQTT_PACKET_PINGREQ    0xC0
+#define MQTT_PACKET_PINGRESP   0xD0
+#define MQTT_PACKET_DISCONNECT 0xE0
+
+#define MQTT_PACKET_TYPE(header) ((header) & 0xF0)
+
+// Fixed header (1) + longest remaining-length field (4)
+#define MQTT_PACKET_MAX_HEADER 5
+
+size_t mqtt_encode_connect(uint8_t* out, size_t size, const char* client_id, uint16_t keepalive_s);
+size_t mqtt_encode_publish_header(uint8_t* out, size_t size, const char* topic, uint16_t packet_id,
+                                  size_t payload_length);
+size_t mqtt_encode_pingreq(uint8_t* out, size_t size);
+size_t mqtt_encode_disconnect(uint8_t* out, size_t size);
+
+// Decodes the variable-length "remaining length" field. Returns the number
+// of bytes consumed (1-4), 0 if more bytes are needed, -1 if malformed.
+int mqtt_decode_remaining_length(const uint8_t* data, size_t available, uint32_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,644 @@
+#include "mqtt_uplink.h"
+#include "mqtt_packet.h"
+#include "../system_metrics/system_metrics.h"
+#include "../wifi_manager/wifi_state.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+static const char* TAG = "MqttUplink";
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define UPLINK_IO_TIMEOUT_MS 5000
+#define UPLINK_NO_SOCKET (-1)
+
+// Sentinel posted to the uplink's own queue by mqtt_uplink_stop()
+#define UPLINK_WAKE_TOPIC MESSAGE_TOPIC_COUNT
+
+// A stop can land mid-publish (send, then wait for PUBACK) and is followed
+// by DISCONNECT, each bounded by UPLINK_IO_TIMEOUT_MS
+#define UPLINK_JOIN_TIMEOUT pdMS_TO_TICKS(3 * UPLINK_IO_TIMEOUT_MS)
+
+// Socket I/O
+
+static bool uplink_send_all(mqtt_uplink_t* uplink, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(uplink->socket, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    
+    uplink->last_send = xTaskGetTickCount();
+    return true;
+}
+
+static bool uplink_recv_all(mqtt_uplink_t* uplink, uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(uplink->socket, data, length, 0);
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        length -= (size_t)received;
+    }
+    return true;
+}
+
+// Reads one packet into body (truncated to body_size). Returns the fixed
+// header byte, or -1 on timeout or error.
+static int uplink_read_packet(mqtt_uplink_t* uplink, uint8_t* body, size_t body_size, uint32_t* body_length) {
+    uint8_t header[MQTT_PACKET_MAX_HEADER];
+    uint32_t remaining = 0;
+    int consumed = 0;
+    
+    if (!uplink_recv_all(uplink, header, 1)) return -1;
+    
+    for (size_t i = 1; i < sizeof(header) && consumed == 0; i++) {
+        if (!uplink_recv_all(uplink, &header[i], 1)) return -1;
+        consumed = mqtt_decode_remaining_length(&header[1], i, &remaining);
+    }
+    if (consumed <= 0) return -1;
+    
+    // Keep what fits, discard the rest
+    uint32_t kept = remaining < body_size ? remaining : (uint32_t)body_size;
+    if (!uplink_recv_all(uplink, body, kept)) return -1;
+    
+    for (uint32_t skipped = kept; skipped < remaining; skipped++) {
+        uint8_t discard;
+        if (!uplink_recv_all(uplink, &discard, 1)) return -1;
+    }
+    
+    *body_length = kept;
+    return header[0];
+}
+
+static void uplink_disconnect(mqtt_uplink_t* uplink, bool graceful) {
+    if (uplink->socket == UPLINK_NO_SOCKET) return;
+    
+    if (graceful) {
+        uint8_t packet[2];
+        uplink_send_all(uplink, packet, mqtt_encode_disconnect(packet, sizeof(packet)));
+    }
+    
+    close(uplink->socket);
+    uplink->socket = UPLINK_NO_SOCKET;
+}
+
+static bool uplink_connect(mqtt_uplink_t* uplink) {
+    struct addrinfo hints;
+    struct addrinfo* result = NULL;
+    char port[8];
+    
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%u", uplink->config.broker_port);
+    
+    if (getaddrinfo(uplink->config.broker_host, port, &hints, &result) != 0 || !result) {
+        ESP_LOGW(TAG, "Cannot resolve %s", uplink->config.broker_host);
+        return false;
+    }
+    
+    uplink->socket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (uplink->socket < 0) {
+        uplink->socket = UPLINK_NO_SOCKET;
+        freeaddrinfo(result);
+        return false;
+    }
+    
+    struct timeval timeout = { UPLINK_IO_TIMEOUT_MS / 1000, (UPLINK_IO_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(uplink->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(uplink->socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    
+    int connected = connect(uplink->socket, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (connected != 0) {
+        ESP_LOGW(TAG, "Connect to %s:%u failed (errno %d)",
+                 uplink->config.broker_host, uplink->config.broker_port, errno);
+        uplink_disconnect(uplink, false);
+        return false;
+    }
+    
+    size_t length = mqtt_encode_connect(uplink->packet, sizeof(uplink->packet),
+                                        uplink->config.client_id, uplink->config.keepalive_s);
+    uint32_t body_length = 0;
+    
+    // CONNACK body: session-present flag, return code (0 = accepted)
+    if (length == 0 || !uplink_send_all(uplink, uplink->packet, length) ||
+        uplink_read_packet(uplink, uplink->packet, sizeof(uplink->packet), &body_length) != MQTT_PACKET_CONNACK ||
+        body_length < 2 || uplink->packet[1] != 0) {
+        ESP_LOGW(TAG, "MQTT session refused by %s", uplink->config.broker_host);
+        uplink_disconnect(uplink, false);
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Connected to %s:%u", uplink->config.broker_host, uplink->config.broker_port);
+    return true;
+}
+
+// Backlog: spill file holds the oldest samples, the RAM ring the newest
+
+static uint32_t uplink_ram_count(const mqtt_uplink_t* uplink) {
+    return uplink->ram_head - uplink->ram_tail;
+}
+
+static uint32_t uplink_backlog(const mqtt_uplink_t* uplink) {
+    return uplink->spill_count + uplink_ram_count(uplink);
+}
+
+static void uplink_spill_reset(mqtt_uplink_t* uplink) {
+    // Reopening with "w+b" truncates the file once everything in it is sent
+    uplink->spill_file = freopen(uplink->config.spill_path, "w+b", uplink->spill_file);
+    uplink->spill_count = 0;
+    uplink->spill_offset = 0;
+}
+
+// Move the oldest RAM batch to the end of the spill file, compressed into
+// one block; a steady sample stream takes a few bytes per sample there
+// instead of sizeof(sensor_data_t)
+static bool uplink_spill(mqtt_uplink_t* uplink) {
+    uint32_t count = uplink->config.batch_size;
+    sample_encoder_t encoder;
+    
+    if (!uplink->spill_file || uplink->spill_count + count > uplink->config.spill_max_samples) {
+        return false;
+    }
+    
+    sample_encoder_init(&encoder, uplink->spill_block, sizeof(uplink->spill_block));
+    for (uint32_t i = 0; i < count; i++) {
+        const sensor_data_t* sample = &uplink->ram[(uplink->ram_tail + i) % MQTT_UPLINK_RAM_CAPACITY];
+        if (!sample_encoder_append(&encoder, sample)) {
+            return false; // Cannot happen: the block is sized for the worst case
+        }
+    }
+    
+    size_t length = sample_encoder_finish(&encoder);
+    uint8_t prefix[2] = { (uint8_t)length, (uint8_t)(length >> 8) };
+    
+    if (fseek(uplink->spill_file, 0, SEEK_END) != 0 ||
+        fwrite(prefix, sizeof(prefix), 1, uplink->spill_file) != 1 ||
+        fwrite(uplink->spill_block, length, 1, uplink->spill_file) != 1) {
+        return false;
+    }
+    fflush(uplink->spill_file);
+    
+    uplink->ram_tail += count;
+    uplink->spill_count += count;
+    uplink->stats.spilled += count;
+    uplink->stats.spill_bytes += (uint32_t)(sizeof(prefix) + length);
+    return true;
+}
+
+// Decode the spill block at spill_offset into uplink->batch; it holds the
+// batch_size samples one uplink_spill() wrote
+static uint32_t uplink_read_spill_block(mqtt_uplink_t* uplink) {
+    uint8_t prefix[2];
+    sample_decoder_t decoder;
+    uint32_t count = 0;
+    
+    if (fseek(uplink->spill_file, uplink->spill_offset, SEEK_SET) != 0 ||
+        fread(prefix, sizeof(prefix), 1, uplink->spill_file) != 1) {
+        return 0;
+    }
+    
+    size_t length = (size_t)(prefix[0] | (prefix[1] << 8));
+    if (length > sizeof(uplink->spill_block) ||
+        fread(uplink->spill_block, length, 1, uplink->spill_file) != 1 ||
+        !sample_decoder_init(&decoder, uplink->spill_block, length) ||
+        decoder.count > MQTT_UPLINK_MAX_BATCH) {
+        return 0;
+    }
+    
+    while (sample_decoder_next(&decoder, &uplink->batch[count])) {
+        count++;
+    }
+    if (decoder.error || count != decoder.count) {
+        return 0;
+    }
+    
+    uplink->spill_block_length = sizeof(prefix) + length;
+    return count;
+}
+
+static void uplink_enqueue(mqtt_uplink_t* uplink, const sensor_data_t* sample) {
+    uplink->stats.received++;
+    
+    if (uplink_ram_count(uplink) >= MQTT_UPLINK_RAM_CAPACITY && !uplink_spill(uplink)) {
+        // Nowhere left to keep it: drop the newest, like the other rings
+        uplink->stats.dropped++;
+        return;
+    }
+    
+    uplink->ram[uplink->ram_head % MQTT_UPLINK_RAM_CAPACITY] = *sample;
+    uplink->ram_head++;
+}
+
+// Copy the next batch (oldest first) into uplink->batch without consuming it
+static uint32_t uplink_peek_batch(mqtt_uplink_t* uplink, bool* from_spill) {
+    uint32_t count = uplink->config.batch_size;
+    
+    *from_spill = uplink->spill_count > 0;
+    
+    if (*from_spill) {
+        count = uplink_read_spill_block(uplink);
+        if (count == 0 || count > uplink->spill_count) {
+            ESP_LOGE(TAG, "Spill file unreadable, discarding %lu samples", (unsigned long)uplink->spill_count);
+            uplink->stats.dropped += uplink->spill_count;
+            uplink_spill_reset(uplink);
+            return 0;
+        }
+        return count;
+    }
+    
+    uint32_t available = uplink_ram_count(uplink);
+    if (count > available) count = available;
+    for (uint32_t i = 0; i < count; i++) {
+        uplink->batch[i] = uplink->ram[(uplink->ram_tail + i) % MQTT_UPLINK_RAM_CAPACITY];
+    }
+    return count;
+}
+
+static void uplink_consume_batch(mqtt_uplink_t* uplink, uint32_t count, bool from_spill) {
+    if (!from_spill) {
+        uplink->ram_tail += count;
+        return;
+    }
+    
+    uplink->spill_count -= count;
+    uplink->spill_offset += (long)uplink->spill_block_length;
+    if (uplink->spill_count == 0) {
+        uplink_spill_reset(uplink);
+    }
+}
+
+// Publishing
+
+// Encodes a batch as a timebase record followed by one record per sample,
+// with another timebase ahead of any sample whose gap is too long for a
+// record's 16-bit delta. Returns the record count; with records NULL it
+// only counts them.
+static uint32_t uplink_encode_batch(const sensor_data_t* batch, uint32_t count, telemetry_record_t* records) {
+    telemetry_encoder_t encoder;
+    telemetry_record_t scratch;
+    uint32_t written = 0;
+    
+    telemetry_encoder_init(&encoder);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t time_ms = (uint32_t)(batch[i].timestamp * portTICK_PERIOD_MS);
+        if (telemetry_encoder_needs_timebase(&encoder, time_ms)) {
+            telemetry_encode_timebase(&encoder, time_ms, records ? &records[written] : &scratch);
+            written++;
+        }
+        telemetry_encode_sample(&encoder, &batch[i], time_ms, records ? &records[written] : &scratch);
+        written++;
+    }
+    return written;
+}
+
+// One QoS 1 PUBLISH of a batch, so every payload decodes on its own with
+// tools/decode_telemetry.py
+static bool uplink_publish_batch(mqtt_uplink_t* uplink) {
+    bool from_spill;
+    uint32_t count = uplink_peek_batch(uplink, &from_spill);
+    if (count == 0) return true;
+    
+    size_t payload_length = uplink_encode_batch(uplink->batch, count, NULL) * sizeof(telemetry_record_t);
+    uint16_t packet_id = uplink->packet_id;
+    size_t header_length = mqtt_encode_publish_header(uplink->packet, sizeof(uplink->packet),
+                                                      uplink->config.topic, packet_id, payload_length);
+    if (header_length == 0 || header_length + payload_length > sizeof(uplink->packet)) {
+        ESP_LOGE(TAG, "Topic too long for the packet buffer");
+        return false;
+    }
+    
+    uplink_encode_batch(uplink->batch, count, (telemetry_record_t*)(uplink->packet + header_length));
+    
+    if (!uplink_send_all(uplink, uplink->packet, header_length + payload_length)) {
+        return false;
+    }
+    
+    // Wait for the matching PUBACK; anything else (PINGRESP) is skipped
+    for (;;) {
+        uint8_t body[4];
+        uint32_t body_length = 0;
+        int header = uplink_read_packet(uplink, body, sizeof(body), &body_length);
+        
+        if (header < 0) return false;
+        if (MQTT_PACKET_TYPE(header) == MQTT_PACKET_PUBACK && body_length >= 2 &&
+            ((uint16_t)(body[0] << 8) | body[1]) == packet_id) {
+            break;
+        }
+    }
+    
+    uplink->packet_id = (packet_id == UINT16_MAX) ? 1 : packet_id + 1;
+    uplink_consume_batch(uplink, count, from_spill);
+    uplink->stats.uplinked += count;
+    uplink->stats.batches++;
+    uplink->stats.payload_bytes += (uint32_t)payload_length;
+    return true;
+}
+
+static bool uplink_ping(mqtt_uplink_t* uplink) {
+    uint8_t packet[2];
+    uint32_t body_length = 0;
+    
+    if (!uplink_send_all(uplink, packet, mqtt_encode_pingreq(packet, sizeof(packet)))) {
+        return false;
+    }
+    return uplink_read_packet(uplink, packet, sizeof(packet), &body_length) == MQTT_PACKET_PINGRESP;
+}
+
+// Ticks until a batch is due (0 = now), or portMAX_DELAY if nothing is queued
+static TickType_t uplink_batch_due_in(mqtt_uplink_t* uplink, TickType_t now) {
+    uint32_t backlog = uplink_backlog(uplink);
+    if (backlog == 0) return portMAX_DELAY;
+    
+    TickType_t wait = 0;
+    
+    // Rate limit applies to full batches too, so a long backlog drains evenly
+    int32_t limit = (int32_t)(uplink->last_publish + pdMS_TO_TICKS(uplink->config.min_publish_interval_ms) - now);
+    if (limit > 0) wait = (TickType_t)limit;
+    
+    if (backlog < uplink->config.batch_size && uplink->spill_count == 0) {
+        // Partial batch: wait until its oldest sample is old enough
+        const sensor_data_t* oldest = &uplink->ram[uplink->ram_tail % MQTT_UPLINK_RAM_CAPACITY];
+        int32_t age_left = (int32_t)(oldest->timestamp + pdMS_TO_TICKS(uplink->config.max_batch_age_ms) - now);
+        if (age_left > 0 && (TickType_t)age_left > wait) wait = (TickType_t)age_left;
+    }
+    
+    return wait;
+}
+
+static TickType_t uplink_service(mqtt_uplink_t* uplink) {
+    TickType_t now = xTaskGetTickCount();
+    
+    if (!uplink->network_up) {
+        uplink_disconnect(uplink, false);
+        return portMAX_DELAY;
+    }
+    
+    int32_t retry_left = (int32_t)(uplink->retry_at - now);
+    if (retry_left > 0) {
+        return (TickType_t)retry_left;
+    }
+    
+    TickType_t due = uplink_batch_due_in(uplink, now);
+    
+    if (due == 0) {
+        if (uplink->socket == UPLINK_NO_SOCKET && !uplink_connect(uplink)) {
+            uplink->retry_at = now + pdMS_TO_TICKS(uplink->config.retry_delay_ms);
+            return pdMS_TO_TICKS(uplink->config.retry_delay_ms);
+        }
+        
+        uplink->last_publish = xTaskGetTickCount();
+        if (!uplink_publish_batch(uplink)) {
+            ESP_LOGW(TAG, "Publish failed, %lu samples kept", (unsigned long)uplink_backlog(uplink));
+            uplink->stats.publish_failures++;
+            uplink_disconnect(uplink, false);
+            uplink->retry_at = xTaskGetTickCount() + pdMS_TO_TICKS(uplink->config.retry_delay_ms);
+        }
+        
+        uplink->stats.backlog = uplink_backlog(uplink);
+        return 0; // Re-evaluate right away
+    }
+    
+    // Keep an idle session alive
+    if (uplink->socket != UPLINK_NO_SOCKET && uplink->config.keepalive_s > 0) {
+        TickType_t ping_every = pdMS_TO_TICKS(uplink->config.keepalive_s * 1000u / 2);
+        int32_t ping_left = (int32_t)(uplink->last_send + ping_every - now);
+        
+        if (ping_left <= 0) {
+            if (!uplink_ping(uplink)) {
+                uplink_disconnect(uplink, false);
+            }
+            return 0;
+        }
+        if ((TickType_t)ping_left < due) due = (TickType_t)ping_left;
+    }
+    
+    return due;
+}
+
+static void mqtt_uplink_task(void* arg) {
+    mqtt_uplink_t* uplink = (mqtt_uplink_t*)arg;
+    
+    ESP_LOGI(TAG, "MQTT uplink task started");
+    
+    // The spill file only holds this boot's samples; tick timestamps from an
+    // earlier boot would be meaningless
+    if (uplink->config.spill_path) {
+        uplink->spill_file = fopen(uplink->config.spill_path, "w+b");
+        if (!uplink->spill_file) {
+            ESP_LOGW(TAG, "Cannot open spill file %s, overflow will be dropped", uplink->config.spill_path);
+        }
+    }
+    
+    int metrics = system_metrics_register("mqtt_uplink", 0);
+    TickType_t timeout = 0;
+    
+    while (uplink->task_running) {
+        message_t message;
+        
+        if (xQueueReceive(uplink->queue, &message, timeout) == pdTRUE) {
+            if (message.topic == MESSAGE_TOPIC_SENSOR_SAMPLE) {
+                uplink_enqueue(uplink, &message.sample);
+            } else if (message.topic == MESSAGE_TOPIC_WIFI_STATE) {
+                uplink->network_up = message.wifi_state == WIFI_STATE_CONNECTED;
+            }
+            system_metrics_event(metrics, 1);
+        }
+        
+        system_metrics_wake(metrics);
+        timeout = uplink_service(uplink);
+        uplink->stats.backlog = uplink_backlog(uplink);
+    }
+    
+    uplink_disconnect(uplink, true);
+    if (uplink->spill_file) {
+        fclose(uplink->spill_file);
+        uplink->spill_file = NULL;
+    }
+    
+    system_metrics_unregister(metrics);
+    ESP_LOGI(TAG, "MQTT uplink task exiting");
+    task_lifecycle_exit(uplink->event_group);
+}
+
+static void mqtt_uplink_init(mqtt_uplink_t* uplink, const mqtt_uplink_config_t* config) {
+    memset(uplink, 0, sizeof(*uplink));
+    uplink->config = *config;
+    
+    // Keep private copies so the caller's strings need not outlive the uplink
+    strncpy(uplink->broker_host, config->broker_host, sizeof(uplink->broker_host) - 1);
+    strncpy(uplink->client_id, config->client_id, sizeof(uplink->client_id) - 1);
+    strncpy(uplink->topic, config->topic, sizeof(uplink->topic) - 1);
+    uplink->config.broker_host = uplink->broker_host;
+    uplink->config.client_id = uplink->client_id;
+    uplink->config.topic = uplink->topic;
+    if (config->spill_path) {
+        strncpy(uplink->spill_path, config->spill_path, sizeof(uplink->spill_path) - 1);
+        uplink->config.spill_path = uplink->spill_path;
+    }
+    
+    if (uplink->config.batch_size == 0 || uplink->config.batch_size > MQTT_UPLINK_MAX_BATCH) {
+        uplink->config.batch_size = MQTT_UPLINK_MAX_BATCH;
+    }
+    
+    uplink->socket = UPLINK_NO_SOCKET;
+    uplink->packet_id = 1;
+    uplink->subscription = MESSAGE_BUS_INVALID_SLOT;
+    task_config_t task_config = MQTT_UPLINK_DEFAULT_TASK_CONFIG;
+    uplink->task_config = task_config;
+}
+
+mqtt_uplink_t* mqtt_uplink_create(const mqtt_uplink_config_t* config) {
+    if (!config) return NULL;
+    
+    mqtt_uplink_t* uplink = (mqtt_uplink_t*)malloc(sizeof(mqtt_uplink_t));
+    if (!uplink) {
+        ESP_LOGE(TAG, "Failed to allocate MQTT uplink");
+        return NULL;
+    }
+    
+    mqtt_uplink_init(uplink, config);
+    
+    uplink->queue = xQueueCreate(MQTT_UPLINK_QUEUE_LENGTH, sizeof(message_t));
+    if (!uplink->queue) {
+        ESP_LOGE(TAG, "Failed to create message queue");
+        free(uplink);
+        return NULL;
+    }
+    
+    uplink->event_group = xEventGroupCreate();
+    if (!uplink->event_group) {
+        ESP_LOGE(TAG, "Failed to create event group");
+        vQueueDelete(uplink->queue);
+        free(uplink);
+        return NULL;
+    }
+    
+    ESP_LOGI(TAG, "MQTT uplink created for %s:%u", uplink->config.broker_host, uplink->config.broker_port);
+    return uplink;
+}
+
+// Same as mqtt_uplink_create(), but the uplink, its queue, event group and
+// task live in storage and nothing is taken from the heap
+mqtt_uplink_t* mqtt_uplink_create_static(mqtt_uplink_storage_t* storage, const mqtt_uplink_config_t* config) {
+    if (!storage || !config) return NULL;
+    
+    mqtt_uplink_t* uplink = &storage->uplink;
+    mqtt_uplink_init(uplink, config);
+    uplink->task_buffer = &storage->task;
+    uplink->task_stack = storage->stack;
+    uplink->queue = xQueueCreateStatic(MQTT_UPLINK_QUEUE_LENGTH, sizeof(message_t),
+                                       storage->queue_storage, &storage->queue);
+    uplink->event_group = xEventGroupCreateStatic(&storage->event_group);
+    
+    ESP_LOGI(TAG, "MQTT uplink created for %s:%u (static)", uplink->config.broker_host, uplink->config.broker_port);
+    return uplink;
+}
+
+void mqtt_uplink_destroy(mqtt_uplink_t* uplink) {
+    if (!uplink) return;
+    
+    mqtt_uplink_stop(uplink);
+    
+    if (uplink->queue) {
+        vQueueDelete(uplink->queue);
+    }
+    
+    if (uplink->event_group) {
+        vEventGroupDelete(uplink->event_group);
+    }
+    
+    if (!uplink->task_buffer) {
+        free(uplink);
+    }
+    ESP_LOGI(TAG, "MQTT uplink destroyed");
+}
+
+bool mqtt_uplink_get_stats(mqtt_uplink_t* uplink, mqtt_uplink_stats_t* stats) {
+    if (!uplink || !stats) return false;
+    
+    // Plain 32-bit fields written by the task; each is read atomically
+    *stats = uplink->stats;
+    return true;
+}
+
+// Stack size, priority and core used by the next mqtt_uplink_start().
+// Statically allocated uplinks cannot grow their stack beyond MQTT_UPLINK_STACK_SIZE.
+bool mqtt_uplink_configure_task(mqtt_uplink_t* uplink, const task_config_t* config) {
+    if (!uplink || uplink->task_running) {
+        return false;
+    }
+    
+    if (!task_config_valid(config, uplink->task_buffer ? MQTT_UPLINK_STACK_SIZE : 0)) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    uplink->task_config = *config;
+    return true;
+}
+
+// Start before the WiFi manager so the first WIFI_STATE message is seen
+bool mqtt_uplink_start(mqtt_uplink_t* uplink) {
+    if (!uplink || uplink->task_running) {
+        return false;
+    }
+    
+    uplink->subscription = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_WIFI_STATE) |
+                                                 MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE),
+                                                 uplink->queue);
+    if (uplink->subscription == MESSAGE_BUS_INVALID_SLOT) {
+        ESP_LOGE(TAG, "No message bus slot left");
+        return false;
+    }
+    
+    // Set before creating the task: a higher-priority task runs immediately
+    // and would otherwise see task_running == false and exit
+    uplink->task_running = true;
+    
+    if (task_config_create(mqtt_uplink_task, "mqtt_uplink", &uplink->task_config, uplink,
+                           uplink->task_buffer, uplink->task_stack, &uplink->task_handle)) {
+        ESP_LOGI(TAG, "MQTT uplink task started successfully");
+        return true;
+    }
+    
+    uplink->task_running = false;
+    message_bus_unsubscribe(uplink->subscription);
+    uplink->subscription = MESSAGE_BUS_INVALID_SLOT;
+    ESP_LOGE(TAG, "Failed to start MQTT uplink task");
+    return false;
+}
+
+void mqtt_uplink_stop(mqtt_uplink_t* uplink) {
+    if (!uplink || !uplink->task_running) {
+        return;
+    }
+    
+    message_bus_unsubscribe(uplink->subscription);
+    uplink->subscription = MESSAGE_BUS_INVALID_SLOT;
+    uplink->task_running = false;
+    
+    // Wake the task if it is idle in xQueueReceive
+    message_t wake;
+    wake.topic = (message_topic_t)UPLINK_WAKE_TOPIC;
+    xQueueSend(uplink->queue, &wake, 0);
+    
+    if (!task_lifecycle_stop(uplink->event_group, &uplink->task_handle, UPLINK_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "MQTT uplink task did not exit in time, deleted");
+    }
+    
+    ESP_LOGI(TAG, "MQTT uplink stopped");
+}
\ No newline at end of file
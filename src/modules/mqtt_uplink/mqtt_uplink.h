@@ -0,0 +1,125 @@
+#ifndef MQTT_UPLINK_H
+#define MQTT_UPLINK_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include "../sensor_reader/sensor_driver.h"
+#include "../message_bus/message_bus.h"
+#include "../telemetry_log/telemetry_record.h"
+#include "../sample_codec/sample_codec.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Samples held in RAM while waiting to be published; overflow spills to
+// the spill file (oldest first) when one is configured
+#ifndef MQTT_UPLINK_RAM_CAPACITY
+#define MQTT_UPLINK_RAM_CAPACITY 64
+#endif
+
+#define MQTT_UPLINK_MAX_BATCH 32
+
+// Each spilled batch is one sample_codec block behind a 16-bit length
+#define MQTT_UPLINK_SPILL_BLOCK_BYTES \
+    (SAMPLE_CODEC_HEADER_BYTES + (MQTT_UPLINK_MAX_BATCH * SAMPLE_CODEC_MAX_SAMPLE_BITS + 7) / 8)
+#define MQTT_UPLINK_QUEUE_LENGTH 8
+#define MQTT_UPLINK_STACK_SIZE 4096
+
+// Between WiFi (4) and the telemetry drain (2)
+#define MQTT_UPLINK_DEFAULT_TASK_CONFIG { MQTT_UPLINK_STACK_SIZE, 3, tskNO_AFFINITY, 0 }
+
+typedef struct {
+    const char* broker_host;
+    uint16_t broker_port;
+    const char* client_id;
+    const char* topic;
+    uint16_t keepalive_s;
+    uint16_t batch_size;              // Samples per PUBLISH, up to MQTT_UPLINK_MAX_BATCH
+    uint32_t max_batch_age_ms;        // Publish a partial batch once its oldest sample is this old
+    uint32_t min_publish_interval_ms; // Rate limit while draining a backlog
+    uint32_t retry_delay_ms;          // After a failed connect or publish
+    const char* spill_path;           // Overflow file; NULL drops samples when RAM is full
+    uint32_t spill_max_samples;
+} mqtt_uplink_config_t;
+
+#define MQTT_UPLINK_DEFAULT_CONFIG { "localhost", 1883, "esp32-sensor", "sensors/telemetry", \
+                                     60, 10, 30000, 250, 5000, NULL, 8192 }
+
+typedef struct {
+    uint32_t received;
+    uint32_t uplinked;
+    uint32_t batches;
+    uint32_t payload_bytes;   // Telemetry records sent, excluding MQTT framing
+    uint32_t spilled;
+    uint32_t spill_bytes;     // Written to the spill file, compressed
+    uint32_t dropped;
+    uint32_t publish_failures;
+    uint32_t backlog;         // Samples in RAM + spill file
+} mqtt_uplink_stats_t;
+
+typedef struct {
+    mqtt_uplink_config_t config; // Strings point at the copies below
+    char broker_host[64];
+    char client_id[32];
+    char topic[64];
+    char spill_path[64];
+    // Task-owned state
+    sensor_data_t ram[MQTT_UPLINK_RAM_CAPACITY];
+    uint32_t ram_head;
+    uint32_t ram_tail;
+    FILE* spill_file;
+    uint32_t spill_count;
+    long spill_offset;
+    size_t spill_block_length; // Of the block last read by a peek
+    uint8_t spill_block[MQTT_UPLINK_SPILL_BLOCK_BYTES];
+    sensor_data_t batch[MQTT_UPLINK_MAX_BATCH];
+    uint8_t packet[2 * MQTT_UPLINK_MAX_BATCH * sizeof(telemetry_record_t) + 128]; // Worst case a timebase per sample
+    int socket;
+    uint16_t packet_id;
+    bool network_up;
+    TickType_t retry_at;
+    TickType_t last_publish;
+    TickType_t last_send;
+    mqtt_uplink_stats_t stats;
+    QueueHandle_t queue;
+    EventGroupHandle_t event_group; // Task lifecycle bits only
+    int subscription;
+    TaskHandle_t task_handle;
+    bool task_running;
+    task_config_t task_config;
+    // Set by mqtt_uplink_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
+} mqtt_uplink_t;
+
+// Caller-provided storage for mqtt_uplink_create_static(); must outlive
+// the uplink
+typedef struct {
+    mqtt_uplink_t uplink;
+    StaticQueue_t queue;
+    uint8_t queue_storage[MQTT_UPLINK_QUEUE_LENGTH * sizeof(message_t)];
+    StaticEventGroup_t event_group;
+    StaticTask_t task;
+    StackType_t stack[MQTT_UPLINK_STACK_SIZE];
+} mqtt_uplink_storage_t;
+
+mqtt_uplink_t* mqtt_uplink_create(const mqtt_uplink_config_t* config);
+mqtt_uplink_t* mqtt_uplink_create_static(mqtt_uplink_storage_t* storage, const mqtt_uplink_config_t* config);
+void mqtt_uplink_destroy(mqtt_uplink_t* uplink);
+bool mqtt_uplink_get_stats(mqtt_uplink_t* uplink, mqtt_uplink_stats_t* stats);
+bool mqtt_uplink_configure_task(mqtt_uplink_t* uplink, const task_config_t* config);
+bool mqtt_uplink_start(mqtt_uplink_t* uplink);
+void mqtt_uplink_stop(mqtt_uplink_t* uplink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "periodic_scheduler.h"
+#include "../system_metrics/system_metrics.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+
+static const char* TAG = "Scheduler";
+
+// Under the lock. Jitter is the change in lateness from the previous run:
+// the start-to-start interval less the deadline-to-deadline interval.
+static void periodic_scheduler_account(periodic_job_t* job, int64_t lateness_us, uint32_t missed) {
+    if (job->runs > 0) {
+        int64_t change = lateness_us - job->last_lateness_us;
+        uint32_t jitter = (uint32_t)(change < 0 ? -change : change);
+        
+        if (jitter > job->jitter_max_us) {
+            job->jitter_max_us = jitter;
+        }
+        job->jitter_sum_us += jitter;
+    }
+    if (lateness_us > (int64_t)job->max_lateness_us) {
+        job->max_lateness_us = (uint32_t)lateness_us;
+    }
+    job->last_lateness_us = lateness_us;
+    job->runs++;
+    job->overruns += missed;
+}
+
+// Runs one expired job and re-arms it from its deadline, so periods do not
+// drift. wake_tick and wake_us were taken together when the batch started.
+static void periodic_scheduler_run(periodic_scheduler_t* scheduler, periodic_job_t* job,
+                                   TickType_t wake_tick, int64_t wake_us) {
+    TickType_t deadline = job->entry.expires;
+    int64_t lateness_us = (int64_t)(int32_t)(wake_tick - deadline) * portTICK_PERIOD_MS * 1000 +
+                          (esp_timer_get_time() - wake_us);
+    
+    if (lateness_us > (int64_t)scheduler->stats.max_lateness_us) {
+        scheduler->stats.max_lateness_us = (uint32_t)lateness_us;
+    }
+    
+    TickType_t period = job->function(job->context);
+    scheduler->stats.runs++;
+    
+    TickType_t next = deadline + period;
+    uint32_t missed = 0;
+    if (period != PERIODIC_JOB_STOP) {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(next - now) < 0) {
+            // A whole period late: skip the missed deadlines instead of
+            // running them back to back
+            missed = (now - next) / period + 1;
+            next += missed * period;
+            scheduler->stats.overruns += missed;
+        }
+    }
+    
+    portENTER_CRITICAL(&scheduler->lock);
+    periodic_scheduler_account(job, lateness_us, missed);
+    if (job->scheduler == scheduler) { // Not removed while it ran
+        if (period != PERIODIC_JOB_STOP) {
+            timer_wheel_insert(&scheduler->wheel, &job->entry, next);
+        } else {
+            job->scheduler = NULL;
+            scheduler->stats.jobs--;
+        }
+    }
+    scheduler->running = NULL;
+    bool joined = scheduler->join_waiting;
+    scheduler->join_waiting = false;
+    portEXIT_CRITICAL(&scheduler->lock);
+    
+    if (joined) {
+        xEventGroupSetBits(scheduler->event_group, PERIODIC_SCHEDULER_EVENT_JOB_DONE);
+    }
+}
+
+static void periodic_scheduler_task(void* arg) {
+    periodic_scheduler_t* scheduler = (periodic_scheduler_t*)arg;
+    
+    ESP_LOGI(TAG, "Scheduler task started");
+    
+    // Woken for whichever job is due, so the task has no period to check
+    // its wakeups against; each job's jitter is kept with the job instead
+    int metrics = system_metrics_register("scheduler", 0);
+    
+    while (scheduler->task_running) {
+        // Cleared before looking at the wheel: an add() from here on ends the wait below
+        xEventGroupClearBits(scheduler->event_group, PERIODIC_SCHEDULER_EVENT_WAKE);
+        system_metrics_wake(metrics);
+        
+        TickType_t wake_tick = xTaskGetTickCount();
+        int64_t wake_us = esp_timer_get_time();
+        
+        for (;;) {
+            // One entry or one batch of a cascade per critical section, so
+            // the time interrupts stay masked does not grow with the jobs
+            portENTER_CRITICAL(&scheduler->lock);
+            periodic_job_t* job = (periodic_job_t*)timer_wheel_expire(&scheduler->wheel, wake_tick);
+            bool cascading = timer_wheel_cascading(&scheduler->wheel);
+            scheduler->running = job;
+            portEXIT_CRITICAL(&scheduler->lock);
+            
+            if (!job) {
+                if (cascading) continue;
+                break;
+            }
+            
+            periodic_scheduler_run(scheduler, job, wake_tick, wake_us);
+            system_metrics_event(metrics, 1);
+        }
+        
+        TickType_t next;
+        portENTER_CRITICAL(&scheduler->lock);
+        bool pending = timer_wheel_next(&scheduler->wheel, &next);
+        portEXIT_CRITICAL(&scheduler->lock);
+        
+        // Sleep until the next deadline, a new job or a stop request
+        TickType_t wait = portMAX_DELAY;
+        if (pending) {
+            int32_t remaining = (int32_t)(next - xTaskGetTickCount());
+            wait = remaining > 0 ? (TickType_t)remaining : 0;
+        }
+        xEventGroupWaitBits(scheduler->event_group, TASK_EVENT_STOP | PERIODIC_SCHEDULER_EVENT_WAKE,
+                            pdFALSE, pdFALSE, wait);
+    }
+    
+    system_metrics_unregister(metrics);
+    ESP_LOGI(TAG, "Scheduler task exiting");
+    task_lifecycle_exit(scheduler->event_group);
+}
+
+static void periodic_scheduler_init(periodic_scheduler_t* scheduler) {
+    timer_wheel_init(&scheduler->wheel, xTaskGetTickCount());
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    scheduler->lock = lock;
+    scheduler->running = NULL;
+    scheduler->join_waiting = false;
+    scheduler->stats.jobs = 0;
+    scheduler->stats.runs = 0;
+    scheduler->stats.overruns = 0;
+    scheduler->stats.max_lateness_us = 0;
+    scheduler->task_handle = NULL;
+    scheduler->task_running = false;
+    task_config_t task_config = PERIODIC_SCHEDULER_DEFAULT_TASK_CONFIG;
+    scheduler->task_config = task_config;
+    scheduler->task_buffer = NULL;
+    scheduler->task_stack = NULL;
+}
+
+periodic_scheduler_t* periodic_scheduler_create() {
+    periodic_scheduler_t* scheduler = (periodic_scheduler_t*)malloc(sizeof(periodic_scheduler_t));
+    if (!scheduler) {
+        ESP_LOGE(TAG, "Failed to allocate scheduler");
+        return NULL;
+    }
+    
+    periodic_scheduler_init(scheduler);
+    
+    // Create event group
+    scheduler->event_group = xEventGroupCreate();
+    if (!scheduler->event_group) {
+        ESP_LOGE(TAG, "Failed to create event group");
+        free(scheduler);
+        return NULL;
+    }
+    
+    ESP_LOGI(TAG, "Scheduler created");
+    return scheduler;
+}
+
+// Same as periodic_scheduler_create(), but the scheduler, its event group
+// and its task live in storage and nothing is taken from the heap
+periodic_scheduler_t* periodic_scheduler_create_static(periodic_scheduler_storage_t* storage) {
+    if (!storage) return NULL;
+    
+    periodic_scheduler_t* scheduler = &storage->scheduler;
+    periodic_scheduler_init(scheduler);
+    scheduler->task_buffer = &storage->task;
+    scheduler->task_stack = storage->stack;
+    scheduler->event_group = xEventGroupCreateStatic(&storage->event_group);
+    
+    ESP_LOGI(TAG, "Scheduler created (static)");
+    return scheduler;
+}
+
+// Jobs still added stay caller-owned; remove them first
+void periodic_scheduler_destroy(periodic_scheduler_t* scheduler) {
+    if (!scheduler) return;
+    
+    periodic_scheduler_stop(scheduler);
+    
+    if (scheduler->event_group) {
+        vEventGroupDelete(scheduler->event_group);
+    }
+    
+    if (!scheduler->task_buffer) {
+        free(scheduler);
+    }
+    ESP_LOGI(TAG, "Scheduler destroyed");
+}
+
+// Stack size, priority and core used by the next periodic_scheduler_start().
+// Statically allocated schedulers cannot grow their stack beyond PERIODIC_SCHEDULER_STACK_SIZE.
+bool periodic_scheduler_configure_task(periodic_scheduler_t* scheduler, const task_config_t* config) {
+    if (!scheduler || scheduler->task_running) {
+        return false;
+    }
+    
+    if (!task_config_valid(config, scheduler->task_buffer ? PERIODIC_SCHEDULER_STACK_SIZE : 0)) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    scheduler->task_config = *config;
+    return true;
+}
+
+bool periodic_scheduler_start(periodic_scheduler_t* scheduler) {
+    if (!scheduler || scheduler->task_running) {
+        return false;
+    }
+    
+    scheduler->task_running = true;
+    
+    if (task_config_create(periodic_scheduler_task, "scheduler", &scheduler->task_config, scheduler,
+                           scheduler->task_buffer, scheduler->task_stack, &scheduler->task_handle)) {
+        ESP_LOGI(TAG, "Scheduler task started successfully");
+        return true;
+    }
+    
+    scheduler->task_running = false;
+    ESP_LOGE(TAG, "Failed to start scheduler task");
+    return false;
+}
+
+// Jobs stay added and resume on the next start; deadlines missed meanwhile
+// count as overruns
+void periodic_scheduler_stop(periodic_scheduler_t* scheduler) {
+    if (!scheduler || !scheduler->task_running) {
+        return;
+    }
+    
+    scheduler->task_running = false;
+    if (!task_lifecycle_stop(scheduler->event_group, &scheduler->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "Scheduler task did not exit in time, deleted");
+    }
+    // In case it was deleted mid-job: nothing runs now, so release a remove()
+    scheduler->running = NULL;
+    scheduler->join_waiting = false;
+    xEventGroupSetBits(scheduler->event_group, PERIODIC_SCHEDULER_EVENT_JOB_DONE);
+    
+    ESP_LOGI(TAG, "Scheduler stopped");
+}
+
+bool periodic_scheduler_add(periodic_scheduler_t* scheduler, periodic_job_t* job, periodic_job_fn_t function,
+                            void* context, TickType_t delay) {
+    if (!scheduler || !job || !function || job->scheduler) {
+        return false;
+    }
+    
+    job->entry.pprev = NULL;
+    job->function = function;
+    job->context = context;
+    job->runs = 0;
+    job->overruns = 0;
+    job->last_lateness_us = 0;
+    job->max_lateness_us = 0;
+    job->jitter_max_us = 0;
+    job->jitter_sum_us = 0;
+    
+    portENTER_CRITICAL(&scheduler->lock);
+    job->scheduler = scheduler;
+    timer_wheel_insert(&scheduler->wheel, &job->entry, xTaskGetTickCount() + delay);
+    scheduler->stats.jobs++;
+    portEXIT_CRITICAL(&scheduler->lock);
+    
+    // The task may be sleeping towards a later deadline
+    xEventGroupSetBits(scheduler->event_group, PERIODIC_SCHEDULER_EVENT_WAKE);
+    return true;
+}
+
+void periodic_scheduler_remove(periodic_scheduler_t* scheduler, periodic_job_t* job) {
+    if (!scheduler || !job) return;
+    
+    portENTER_CRITICAL(&scheduler->lock);
+    if (job->scheduler == scheduler) {
+        timer_wheel_remove(&scheduler->wheel, &job->entry);
+        job->scheduler = NULL; // Also keeps a running job from being re-armed
+        scheduler->stats.jobs--;
+    }
+    portEXIT_CRITICAL(&scheduler->lock);
+    
+    // Let a run in progress finish, so the caller can release what the job
+    // uses. The bit is cleared before looking, so only the end of a run
+    // seen here (or a stop) can set it again.
+    if (xTaskGetCurrentTaskHandle() == scheduler->task_handle) return;
+    for (;;) {
+        xEventGroupClearBits(scheduler->event_group, PERIODIC_SCHEDULER_EVENT_JOB_DONE);
+        portENTER_CRITICAL(&scheduler->lock);
+        bool running = scheduler->running == job;
+        if (running) {
+            scheduler->join_waiting = true;
+        }
+        portEXIT_CRITICAL(&scheduler->lock);
+        
+        if (!running) return;
+        xEventGroupWaitBits(scheduler->event_group, PERIODIC_SCHEDULER_EVENT_JOB_DONE, pdFALSE, pdFALSE,
+                            portMAX_DELAY);
+    }
+}
+
+bool periodic_scheduler_get_stats(periodic_scheduler_t* scheduler, periodic_scheduler_stats_t* stats) {
+    if (!scheduler || !stats) return false;
+    
+    // Counters other than jobs are written by the task alone; each read is atomic
+    portENTER_CRITICAL(&scheduler->lock);
+    *stats = scheduler->stats;
+    portEXIT_CRITICAL(&scheduler->lock);
+    return true;
+}
+
+bool periodic_scheduler_get_job_stats(periodic_scheduler_t* scheduler, const periodic_job_t* job,
+                                      periodic_job_stats_t* stats) {
+    if (!scheduler || !job || !stats) return false;
+    
+    portENTER_CRITICAL(&scheduler->lock);
+    uint32_t intervals = job->runs > 1 ? job->runs - 1 : 0;
+    stats->runs = job->runs;
+    stats->overruns = job->overruns;
+    stats->max_lateness_us = job->max_lateness_us;
+    stats->jitter_max_us = job->jitter_max_us;
+    stats->jitter_avg_us = intervals ? (uint32_t)(job->jitter_sum_us / intervals) : 0;
+    portEXIT_CRITICAL(&scheduler->lock);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef PERIODIC_SCHEDULER_H
+#define PERIODIC_SCHEDULER_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "timer_wheel.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One task running many periodic jobs, each at its own period. Deadlines
+// live in a timer wheel, so adding, re-arming and expiring a job cost the
+// same with 1 job or 1000, and the task sleeps until the next deadline.
+// Jobs run one after another on the scheduler's stack: each must return
+// quickly and never block on another job.
+#define PERIODIC_SCHEDULER_STACK_SIZE 4096 // Jobs run on it
+// Same priority as the sensor reader task it replaces
+#define PERIODIC_SCHEDULER_DEFAULT_TASK_CONFIG { PERIODIC_SCHEDULER_STACK_SIZE, 6, tskNO_AFFINITY, 0 }
+
+// Returned by a job to stop it; it is then no longer scheduled
+#define PERIODIC_JOB_STOP 0
+
+// Runs once per deadline; returns the ticks until the next one
+typedef TickType_t (*periodic_job_fn_t)(void* context);
+
+struct periodic_scheduler;
+
+typedef struct {
+    timer_wheel_entry_t entry; // First member: the wheel hands entries back as jobs
+    periodic_job_fn_t function;
+    void* context;
+    struct periodic_scheduler* scheduler; // NULL while not added
+    uint32_t runs;
+    uint32_t overruns; // Deadlines skipped because the job ran too late
+    // Timing, written under the scheduler's lock; see periodic_job_stats_t
+    int64_t last_lateness_us;
+    uint32_t max_lateness_us;
+    uint32_t jitter_max_us;
+    uint64_t jitter_sum_us;
+} periodic_job_t;
+
+// One job's timing. The scheduler task wakes for whichever job is due, so
+// jitter is measured per job, the way system_metrics measures it for a task
+// of its own: how far each start-to-start interval is from the interval
+// between the two deadlines.
+typedef struct {
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t max_lateness_us; // Worst deadline-to-start delay
+    uint32_t jitter_avg_us;
+    uint32_t jitter_max_us;
+} periodic_job_stats_t;
+
+typedef struct {
+    uint32_t jobs;
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t max_lateness_us; // Worst deadline-to-start delay, queueing behind other jobs included
+} periodic_scheduler_stats_t;
+
+typedef struct periodic_scheduler {
+    timer_wheel_t wheel; // Under lock, like running and stats.jobs
+    portMUX_TYPE lock;
+    periodic_job_t* volatile running; // Job being run, NULL between jobs
+    bool join_waiting;                // A remove() waits for running to end
+    periodic_scheduler_stats_t stats;
+    TaskHandle_t task_handle;
+    EventGroupHandle_t event_group;
+    bool task_running;
+    task_config_t task_config;
+    // Set by periodic_scheduler_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
+} periodic_scheduler_t;
+
+// Caller-provided storage for periodic_scheduler_create_static(); must
+// outlive the scheduler
+typedef struct {
+    periodic_scheduler_t scheduler;
+    StaticEventGroup_t event_group;
+    StaticTask_t task;
+    StackType_t stack[PERIODIC_SCHEDULER_STACK_SIZE];
+} periodic_scheduler_storage_t;
+
+// Events
+#define PERIODIC_SCHEDULER_EVENT_WAKE (1 << 0) // Jobs changed; recompute the next deadline
+#define PERIODIC_SCHEDULER_EVENT_JOB_DONE (1 << 1) // The run a remove() waits for has ended
+
+periodic_scheduler_t* periodic_scheduler_create();
+periodic_scheduler_t* periodic_scheduler_create_static(periodic_scheduler_storage_t* storage);
+void periodic_scheduler_destroy(periodic_scheduler_t* scheduler);
+bool periodic_scheduler_configure_task(periodic_scheduler_t* scheduler, const task_config_t* config);
+bool periodic_scheduler_start(periodic_scheduler_t* scheduler);
+void periodic_scheduler_stop(periodic_scheduler_t* scheduler);
+// First run after delay ticks (0: as soon as the task gets to it). job is
+// caller-owned, zero-initialised or removed, and must stay valid until
+// removed; a job may be added to one scheduler at a time
+bool periodic_scheduler_add(periodic_scheduler_t* scheduler, periodic_job_t* job, periodic_job_fn_t function,
+                            void* context, TickType_t delay);
+// Returns once the job is not running, unless called from the job itself
+void periodic_scheduler_remove(periodic_scheduler_t* scheduler, periodic_job_t* job);
+bool periodic_scheduler_get_stats(periodic_scheduler_t* scheduler, periodic_scheduler_stats_t* stats);
+// Counts since job was last added; still readable after it is removed
+bool periodic_scheduler_get_job_stats(periodic_scheduler_t* scheduler, const periodic_job_t* job,
+                                      periodic_job_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
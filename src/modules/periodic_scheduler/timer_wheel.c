@@ -0,0 +1,219 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// log2 of the ticks one slot of the level spans
+static inline unsigned timer_wheel_shift(int level) {
+    return (unsigned)level * TIMER_WHEEL_SLOT_BITS;
+}
+
+void timer_wheel_init(timer_wheel_t* wheel, TickType_t now) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now;
+}
+
+static void timer_wheel_link(timer_wheel_t* wheel, timer_wheel_entry_t* entry, int level, unsigned slot) {
+    uint16_t bucket = (uint16_t)(level * TIMER_WHEEL_SLOTS + slot);
+    timer_wheel_entry_t** head = &wheel->slots[bucket];
+    
+    entry->next = *head;
+    if (*head) {
+        (*head)->pprev = &entry->next;
+    }
+    *head = entry;
+    entry->pprev = head;
+    entry->bucket = bucket;
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+static void timer_wheel_unlink(timer_wheel_t* wheel, timer_wheel_entry_t* entry) {
+    *entry->pprev = entry->next;
+    if (entry->next) {
+        entry->next->pprev = entry->pprev;
+    }
+    if (!wheel->slots[entry->bucket]) {
+        wheel->occupied[entry->bucket / TIMER_WHEEL_SLOTS] &= ~(1ULL << (entry->bucket & SLOT_MASK));
+    }
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+// Lowest level whose span covers the distance to the expiry. Slots above
+// level 0 are emptied at the start of their span, before any entry in them
+// is due.
+static void timer_wheel_file(timer_wheel_t* wheel, timer_wheel_entry_t* entry) {
+    int32_t delta = (int32_t)(entry->expires - wheel->now);
+    
+    if (delta <= 0) {
+        timer_wheel_link(wheel, entry, 0, wheel->now & SLOT_MASK); // Overdue: expire right away
+        return;
+    }
+    
+    TickType_t when = entry->expires;
+    if ((TickType_t)delta >= TIMER_WHEEL_RANGE) {
+        when = wheel->now + TIMER_WHEEL_RANGE - 1; // Re-filed from there
+        delta = (int32_t)(TIMER_WHEEL_RANGE - 1);
+    }
+    
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && (TickType_t)delta >= ((TickType_t)1 << timer_wheel_shift(level + 1))) {
+        level++;
+    }
+    timer_wheel_link(wheel, entry, level, (when >> timer_wheel_shift(level)) & SLOT_MASK);
+}
+
+void timer_wheel_insert(timer_wheel_t* wheel, timer_wheel_entry_t* entry, TickType_t expires) {
+    timer_wheel_remove(wheel, entry);
+    
+    entry->expires = expires;
+    timer_wheel_file(wheel, entry);
+    wheel->count++;
+}
+
+void timer_wheel_remove(timer_wheel_t* wheel, timer_wheel_entry_t* entry) {
+    if (!timer_wheel_pending(entry)) return;
+    
+    timer_wheel_unlink(wheel, entry);
+    wheel->count--;
+}
+
+// First occupied slot of a level at or after wheel->now, and the tick its
+// span starts at. Level 0's current slot is due now; above it, the current
+// slot was emptied when its span began, so a bit there means next round.
+static bool timer_wheel_first_slot(const timer_wheel_t* wheel, int level, unsigned* slot, TickType_t* start) {
+    uint64_t bits = wheel->occupied[level];
+    if (!bits) return false;
+    
+    unsigned shift = timer_wheel_shift(level);
+    unsigned index = (wheel->now >> shift) & SLOT_MASK;
+    TickType_t span = (TickType_t)1 << (shift + TIMER_WHEEL_SLOT_BITS);
+    TickType_t base = wheel->now & ~(span - 1);
+    
+    unsigned first = level == 0 ? index : index + 1;
+    uint64_t ahead = first < TIMER_WHEEL_SLOTS ? bits & (~0ULL << first) : 0;
+    if (ahead) {
+        *slot = (unsigned)__builtin_ctzll(ahead);
+    } else {
+        *slot = (unsigned)__builtin_ctzll(bits);
+        base += span;
+    }
+    *start = base + ((TickType_t)*slot << shift);
+    return true;
+}
+
+// Next tick at which an entry expires or a slot cascades
+static TickType_t timer_wheel_step(const timer_wheel_t* wheel) {
+    int32_t best = INT32_MAX;
+    
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        unsigned slot;
+        TickType_t start;
+        if (timer_wheel_first_slot(wheel, level, &slot, &start) && (int32_t)(start - wheel->now) < best) {
+            best = (int32_t)(start - wheel->now);
+        }
+    }
+    return wheel->now + (TickType_t)best;
+}
+
+// Exact, so a sleeping owner does not wake for cascades: above level 0 the
+// earliest entry of each level is in its first occupied slot. Parked
+// timeouts count as due at the end of their slot, when they get re-filed.
+bool timer_wheel_next(const timer_wheel_t* wheel, TickType_t* tick) {
+    if (wheel->count == 0) return false;
+    if (timer_wheel_cascading(wheel)) {
+        *tick = wheel->now; // Not done with now yet
+        return true;
+    }
+    
+    int32_t best = INT32_MAX;
+    
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        unsigned slot;
+        TickType_t start;
+        if (!timer_wheel_first_slot(wheel, level, &slot, &start)) continue;
+        
+        if (level == 0) {
+            best = (int32_t)(start - wheel->now);
+            continue;
+        }
+        int32_t last = (int32_t)(start - wheel->now) + (1 << timer_wheel_shift(level)) - 1;
+        for (const timer_wheel_entry_t* entry = wheel->slots[level * TIMER_WHEEL_SLOTS + slot]; entry; entry = entry->next) {
+            int32_t distance = (int32_t)(entry->expires - wheel->now);
+            if (distance > last) {
+                distance = last;
+            }
+            if (distance < best) {
+                best = distance;
+            }
+        }
+    }
+    
+    *tick = wheel->now + (TickType_t)best;
+    return true;
+}
+
+// Continue the cascade at wheel->now: take the slots whose span starts
+// here, top level first so entries can fall more than one level in one
+// go, and re-file at most budget of their entries. Returns the budget left.
+static unsigned timer_wheel_cascade(timer_wheel_t* wheel, unsigned budget) {
+    for (;;) {
+        while (wheel->cascading) {
+            if (budget == 0) return 0;
+            
+            timer_wheel_entry_t* entry = wheel->cascading;
+            wheel->cascading = entry->next;
+            if (entry->next) {
+                entry->next->pprev = &wheel->cascading;
+            }
+            timer_wheel_file(wheel, entry);
+            budget--;
+        }
+        if (wheel->cascade_level == 0) return budget;
+        
+        int level = wheel->cascade_level--;
+        unsigned shift = timer_wheel_shift(level);
+        if (wheel->now & (((TickType_t)1 << shift) - 1)) continue;
+        
+        // No entry is filed into the slot of the span that has begun, so
+        // it stays empty while its entries wait in the cascading list
+        unsigned slot = (wheel->now >> shift) & SLOT_MASK;
+        uint16_t bucket = (uint16_t)(level * TIMER_WHEEL_SLOTS + slot);
+        wheel->cascading = wheel->slots[bucket];
+        if (wheel->cascading) {
+            wheel->cascading->pprev = &wheel->cascading;
+        }
+        wheel->slots[bucket] = NULL;
+        wheel->occupied[level] &= ~(1ULL << slot);
+    }
+}
+
+timer_wheel_entry_t* timer_wheel_expire(timer_wheel_t* wheel, TickType_t now) {
+    unsigned budget = TIMER_WHEEL_CASCADE_BATCH;
+    
+    for (;;) {
+        // Every step either returns an entry or re-files at least one, so
+        // the budget bounds the whole call
+        budget = timer_wheel_cascade(wheel, budget);
+        if (timer_wheel_cascading(wheel)) return NULL;
+        
+        timer_wheel_entry_t* entry = wheel->slots[wheel->now & SLOT_MASK];
+        if (entry) {
+            timer_wheel_unlink(wheel, entry);
+            wheel->count--;
+            return entry;
+        }
+        
+        if ((int32_t)(now - wheel->now) <= 0) return NULL;
+        
+        // Jump straight to the next expiry or cascade; nothing happens on
+        // the ticks in between
+        TickType_t next = wheel->count ? timer_wheel_step(wheel) : now;
+        if ((int32_t)(next - now) > 0) {
+            wheel->now = now;
+            return NULL;
+        }
+        wheel->now = next;
+        wheel->cascade_level = TIMER_WHEEL_LEVELS - 1;
+    }
+}
\ No newline at end of file
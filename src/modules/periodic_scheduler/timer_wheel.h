@@ -0,0 +1,76 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hierarchical timer wheel over FreeRTOS ticks. Level 0 has one slot per
+// tick for the next 64 ticks; each level above covers 64 times the span of
+// the one below, so 4 levels reach 2^24 ticks (4.6 h at 1 kHz). Longer
+// timeouts are parked at the far end and re-filed when they get there.
+//
+// Entries are intrusive and doubly linked, so insert and remove are O(1).
+// An entry moves down a level at most 3 times before it expires. Per-level
+// occupancy bitmaps find the next expiry without walking empty slots, so
+// the owner can sleep until then. The wheel does no locking; a cascade is
+// split across timer_wheel_expire() calls, so an owner that holds its lock
+// per call holds it for bounded work whatever the number of entries.
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_RANGE ((TickType_t)1 << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS))
+
+// Entries one timer_wheel_expire() call moves down a level at most
+#ifndef TIMER_WHEEL_CASCADE_BATCH
+#define TIMER_WHEEL_CASCADE_BATCH 16
+#endif
+
+typedef struct timer_wheel_entry {
+    struct timer_wheel_entry* next;
+    struct timer_wheel_entry** pprev; // NULL while not in the wheel
+    TickType_t expires;
+    uint16_t bucket;                  // level * TIMER_WHEEL_SLOTS + slot
+} timer_wheel_entry_t;
+
+typedef struct {
+    TickType_t now; // Every entry due up to here has been returned
+    uint32_t count;
+    uint64_t occupied[TIMER_WHEEL_LEVELS];
+    timer_wheel_entry_t* slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+    // Cascade in progress at now: entries taken out of their slot and not
+    // yet re-filed (they keep their old bucket, which stays empty), and the
+    // next level whose slot is still to be taken; 0 once done
+    timer_wheel_entry_t* cascading;
+    int cascade_level;
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t* wheel, TickType_t now);
+// Times at or before wheel->now expire on the next timer_wheel_expire()
+void timer_wheel_insert(timer_wheel_t* wheel, timer_wheel_entry_t* entry, TickType_t expires);
+void timer_wheel_remove(timer_wheel_t* wheel, timer_wheel_entry_t* entry);
+// Removes and returns one entry due at or before now, or NULL once none is
+// left or after moving TIMER_WHEEL_CASCADE_BATCH entries down a level;
+// timer_wheel_cascading() tells the two apart. Call until NULL with no
+// cascade left; entries may be inserted and removed in between.
+timer_wheel_entry_t* timer_wheel_expire(timer_wheel_t* wheel, TickType_t now);
+// Earliest expiry (wheel->now if one is overdue); false if the wheel is
+// empty. Early once per TIMER_WHEEL_RANGE ticks for each longer timeout
+// pending. Looks at the entries of one slot per level.
+bool timer_wheel_next(const timer_wheel_t* wheel, TickType_t* tick);
+
+static inline bool timer_wheel_pending(const timer_wheel_entry_t* entry) {
+    return entry->pprev != NULL;
+}
+
+static inline bool timer_wheel_cascading(const timer_wheel_t* wheel) {
+    return wheel->cascading != NULL || wheel->cascade_level > 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "sample_codec.h"
+#include <string.h>
+
+#ifdef SENSOR_DATA_FIXED_POINT
+#define VALUE_BITS 16
+#define FIELD_BITS 4 // Leading zeros and length-1, 0..15
+#else
+#define VALUE_BITS 32
+#define FIELD_BITS 5 // Leading zeros and length-1, 0..31
+#endif
+
+_Static_assert(sizeof(sensor_value_t) * 8 == VALUE_BITS, "VALUE_BITS must match sensor_value_t");
+
+#define NO_WINDOW 0xFF
+
+static uint32_t codec_value_bits(sensor_value_t value) {
+#ifdef SENSOR_DATA_FIXED_POINT
+    return (uint16_t)value;
+#else
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+#endif
+}
+
+static sensor_value_t codec_value_from_bits(uint32_t bits) {
+#ifdef SENSOR_DATA_FIXED_POINT
+    return (sensor_value_t)(int16_t)(uint16_t)bits;
+#else
+    sensor_value_t value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+#endif
+}
+
+static void codec_state_init(sample_codec_state_t* state) {
+    memset(state, 0, sizeof(*state));
+    for (int i = 0; i < 3; i++) {
+        state->channels[i].leading = NO_WINDOW;
+    }
+}
+
+static sensor_value_t codec_channel_get(const sensor_data_t* sample, int channel) {
+    switch (channel) {
+        case 0: return sample->voltage;
+        case 1: return sample->temperature;
+        default: return sample->humidity;
+    }
+}
+
+static void codec_channel_set(sensor_data_t* sample, int channel, sensor_value_t value) {
+    switch (channel) {
+        case 0: sample->voltage = value; break;
+        case 1: sample->temperature = value; break;
+        default: sample->humidity = value; break;
+    }
+}
+
+// Bit writer, MSB first. Bytes are cleared as they are entered, so the
+// buffer need not be zeroed up front.
+
+static void codec_put(sample_encoder_t* encoder, uint32_t value, uint8_t bits) {
+    if (encoder->bit_pos + bits > encoder->capacity_bits) {
+        encoder->overflow = true;
+        return;
+    }
+    
+    while (bits > 0) {
+        uint8_t* byte = &encoder->buffer[encoder->bit_pos >> 3];
+        uint8_t used = encoder->bit_pos & 7;
+        uint8_t room = 8 - used;
+        uint8_t take = bits < room ? bits : room;
+        uint8_t chunk = (uint8_t)((value >> (bits - take)) & ((1u << take) - 1));
+        
+        if (used == 0) {
+            *byte = 0;
+        }
+        *byte |= (uint8_t)(chunk << (room - take));
+        encoder->bit_pos += take;
+        bits -= take;
+    }
+}
+
+static void codec_put_varint(sample_encoder_t* encoder, uint32_t value) {
+    while (value >= 0x80) {
+        codec_put(encoder, 0x80 | (value & 0x7F), 8);
+        value >>= 7;
+    }
+    codec_put(encoder, value, 8);
+}
+
+static uint32_t codec_get(sample_decoder_t* decoder, uint8_t bits) {
+    if (decoder->bit_pos + bits > decoder->length_bits) {
+        decoder->error = true;
+        return 0;
+    }
+    
+    uint32_t value = 0;
+    while (bits > 0) {
+        uint8_t byte = decoder->buffer[decoder->bit_pos >> 3];
+        uint8_t used = decoder->bit_pos & 7;
+        uint8_t room = 8 - used;
+        uint8_t take = bits < room ? bits : room;
+        
+        value = (value << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        decoder->bit_pos += take;
+        bits -= take;
+    }
+    return value;
+}
+
+static uint32_t codec_get_varint(sample_decoder_t* decoder) {
+    uint32_t value = 0;
+    for (uint8_t shift = 0; shift < 35 && !decoder->error; shift += 7) {
+        uint32_t group = codec_get(decoder, 8);
+        value |= (group & 0x7F) << shift;
+        if (!(group & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+static uint32_t codec_zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t codec_unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static int32_t codec_sign_extend(uint32_t value, uint8_t bits) {
+    uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+// Encoding
+
+static void codec_put_timestamp(sample_encoder_t* encoder, uint32_t timestamp) {
+    sample_codec_state_t* state = &encoder->state;
+    int32_t delta = (int32_t)(timestamp - state->timestamp);
+    int32_t dod = (int32_t)((uint32_t)delta - (uint32_t)state->delta);
+    
+    if (dod == 0) {
+        codec_put(encoder, 0x0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        codec_put(encoder, 0x2, 2);
+        codec_put(encoder, (uint32_t)dod & 0x7F, 7);
+    } else if (dod >= -256 && dod <= 255) {
+        codec_put(encoder, 0x6, 3);
+        codec_put(encoder, (uint32_t)dod & 0x1FF, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        codec_put(encoder, 0xE, 4);
+        codec_put(encoder, (uint32_t)dod & 0xFFF, 12);
+    } else {
+        codec_put(encoder, 0xF, 4);
+        codec_put(encoder, (uint32_t)dod, 32);
+    }
+    
+    state->timestamp = timestamp;
+    state->delta = delta;
+}
+
+static void codec_put_value(sample_encoder_t* encoder, sample_codec_channel_t* channel, uint32_t bits) {
+    uint32_t x = bits ^ channel->bits;
+    channel->bits = bits;
+    
+    if (x == 0) {
+        codec_put(encoder, 0x0, 1);
+        return;
+    }
+    
+    uint8_t leading = (uint8_t)(__builtin_clz(x) - (32 - VALUE_BITS));
+    uint8_t trailing = (uint8_t)__builtin_ctz(x);
+    
+    if (channel->leading != NO_WINDOW && leading >= channel->leading && trailing >= channel->trailing) {
+        // Fits the previous window: no need to repeat its position
+        codec_put(encoder, 0x2, 2);
+        codec_put(encoder, x >> channel->trailing, VALUE_BITS - channel->leading - channel->trailing);
+        return;
+    }
+    
+    uint8_t length = VALUE_BITS - leading - trailing;
+    codec_put(encoder, 0x3, 2);
+    codec_put(encoder, leading, FIELD_BITS);
+    codec_put(encoder, length - 1, FIELD_BITS);
+    codec_put(encoder, x >> trailing, length);
+    channel->leading = leading;
+    channel->trailing = trailing;
+}
+
+void sample_encoder_init(sample_encoder_t* encoder, uint8_t* buffer, size_t capacity) {
+    encoder->buffer = buffer;
+    encoder->capacity_bits = capacity * 8;
+    encoder->bit_pos = SAMPLE_CODEC_HEADER_BYTES * 8;
+    encoder->count = 0;
+    encoder->overflow = capacity < SAMPLE_CODEC_HEADER_BYTES;
+    codec_state_init(&encoder->state);
+}
+
+// Returns false, leaving the block as it was, when the sample does not fit;
+// finish the block and start a new one.
+bool sample_encoder_append(sample_encoder_t* encoder, const sensor_data_t* sample) {
+    if (encoder->overflow || encoder->count == SAMPLE_CODEC_MAX_SAMPLES) {
+        return false;
+    }
+    
+    size_t start = encoder->bit_pos;
+    sample_codec_state_t saved = encoder->state;
+    sample_codec_state_t* state = &encoder->state;
+    
+    if (encoder->count == 0) {
+        codec_put(encoder, sample->timestamp, 32);
+        codec_put(encoder, sample->raw_value, 32);
+        for (int i = 0; i < 3; i++) {
+            uint32_t bits = codec_value_bits(codec_channel_get(sample, i));
+            codec_put(encoder, bits, VALUE_BITS);
+            state->channels[i].bits = bits;
+        }
+        state->timestamp = sample->timestamp;
+    } else {
+        codec_put_timestamp(encoder, sample->timestamp);
+        codec_put_varint(encoder, codec_zigzag((int32_t)(sample->raw_value - state->raw_value)));
+        for (int i = 0; i < 3; i++) {
+            codec_put_value(encoder, &state->channels[i], codec_value_bits(codec_channel_get(sample, i)));
+        }
+    }
+    state->raw_value = sample->raw_value;
+    
+    if (encoder->overflow) {
+        // Roll back, clearing the tail of the partly written byte
+        encoder->bit_pos = start;
+        encoder->state = saved;
+        encoder->overflow = false;
+        if (start & 7) {
+            encoder->buffer[start >> 3] &= (uint8_t)(0xFF00 >> (start & 7));
+        }
+        return false;
+    }
+    
+    encoder->count++;
+    return true;
+}
+
+// Writes the header and returns the block size in bytes. Appending may
+// continue afterwards; call again for the new size.
+size_t sample_encoder_finish(sample_encoder_t* encoder) {
+    if (encoder->capacity_bits < SAMPLE_CODEC_HEADER_BYTES * 8) {
+        return 0;
+    }
+    
+    encoder->buffer[0] = (uint8_t)encoder->count;
+    encoder->buffer[1] = (uint8_t)(encoder->count >> 8);
+    return (encoder->bit_pos + 7) / 8;
+}
+
+// Decoding
+
+bool sample_decoder_init(sample_decoder_t* decoder, const uint8_t* block, size_t length) {
+    decoder->buffer = block;
+    decoder->length_bits = length * 8;
+    decoder->bit_pos = SAMPLE_CODEC_HEADER_BYTES * 8;
+    decoder->count = 0;
+    decoder->decoded = 0;
+    decoder->error = length < SAMPLE_CODEC_HEADER_BYTES;
+    codec_state_init(&decoder->state);
+    
+    if (!decoder->error) {
+        decoder->count = (uint16_t)(block[0] | (block[1] << 8));
+    }
+    return !decoder->error;
+}
+
+static uint32_t codec_get_timestamp(sample_decoder_t* decoder) {
+    sample_codec_state_t* state = &decoder->state;
+    int32_t dod;
+    
+    if (codec_get(decoder, 1) == 0) {
+        dod = 0;
+    } else if (codec_get(decoder, 1) == 0) {
+        dod = codec_sign_extend(codec_get(decoder, 7), 7);
+    } else if (codec_get(decoder, 1) == 0) {
+        dod = codec_sign_extend(codec_get(decoder, 9), 9);
+    } else if (codec_get(decoder, 1) == 0) {
+        dod = codec_sign_extend(codec_get(decoder, 12), 12);
+    } else {
+        dod = (int32_t)codec_get(decoder, 32);
+    }
+    
+    state->delta = (int32_t)((uint32_t)state->delta + (uint32_t)dod);
+    state->timestamp += (uint32_t)state->delta;
+    return state->timestamp;
+}
+
+static uint32_t codec_get_value(sample_decoder_t* decoder, sample_codec_channel_t* channel) {
+    if (codec_get(decoder, 1) == 0) {
+        return channel->bits;
+    }
+    
+    if (codec_get(decoder, 1) == 0) {
+        if (channel->leading == NO_WINDOW) {
+            decoder->error = true;
+            return channel->bits;
+        }
+    } else {
+        channel->leading = (uint8_t)codec_get(decoder, FIELD_BITS);
+        uint8_t length = (uint8_t)codec_get(decoder, FIELD_BITS) + 1;
+        if (channel->leading + length > VALUE_BITS) {
+            decoder->error = true;
+            return channel->bits;
+        }
+        channel->trailing = VALUE_BITS - channel->leading - length;
+    }
+    
+    uint8_t length = VALUE_BITS - channel->leading - channel->trailing;
+    channel->bits ^= codec_get(decoder, length) << channel->trailing;
+    return channel->bits;
+}
+
+// Returns false at the end of the block or on corrupt data (decoder->error)
+bool sample_decoder_next(sample_decoder_t* decoder, sensor_data_t* sample) {
+    if (decoder->error || decoder->decoded >= decoder->count) {
+        return false;
+    }
+    
+    sample_codec_state_t* state = &decoder->state;
+    
+    if (decoder->decoded == 0) {
+        state->timestamp = codec_get(decoder, 32);
+        state->raw_value = codec_get(decoder, 32);
+        for (int i = 0; i < 3; i++) {
+            state->channels[i].bits = codec_get(decoder, VALUE_BITS);
+        }
+    } else {
+        codec_get_timestamp(decoder);
+        state->raw_value += (uint32_t)codec_unzigzag(codec_get_varint(decoder));
+        for (int i = 0; i < 3; i++) {
+            codec_get_value(decoder, &state->channels[i]);
+        }
+    }
+    
+    if (decoder->error) {
+        return false;
+    }
+    
+    sample->timestamp = state->timestamp;
+    sample->raw_value = state->raw_value;
+    for (int i = 0; i < 3; i++) {
+        codec_channel_set(sample, i, codec_value_from_bits(state->channels[i].bits));
+    }
+    decoder->decoded++;
+    return true;
+}
\ No newline at end of file
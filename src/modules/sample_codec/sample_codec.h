@@ -0,0 +1,77 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../sensor_reader/sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming Gorilla-style compression of sensor_data_t sequences into a
+// caller-provided block. Neither side allocates.
+//
+// Block: sample count (uint16, little-endian), then an MSB-first bit
+// stream. The first sample is stored verbatim; after that, per sample:
+//   timestamp    delta-of-delta: '0' (same delta), '10'+7, '110'+9,
+//                '1110'+12 or '1111'+32 bits, two's complement
+//   raw_value    zig-zag delta as a varint of 8-bit groups (7 data bits)
+//   each value   XOR with the previous value's bits (the float, or the
+//                scaled integer with SENSOR_DATA_FIXED_POINT): '0' if equal,
+//                '10' + bits inside the previous leading/trailing-zero
+//                window, or '11' + leading zeros + length + bits
+// At a fixed period with slowly moving values most samples take a few
+// bytes instead of sizeof(sensor_data_t).
+#define SAMPLE_CODEC_HEADER_BYTES 2
+#define SAMPLE_CODEC_MAX_SAMPLES UINT16_MAX
+
+// Worst case for one sample, for sizing blocks
+#define SAMPLE_CODEC_MAX_SAMPLE_BITS (36 + 40 + 3 * (2 + 2 * 5 + 32))
+
+typedef struct {
+    uint32_t bits;    // Previous value's bit pattern
+    uint8_t leading;  // Previous XOR window; leading > width until one is set
+    uint8_t trailing;
+} sample_codec_channel_t;
+
+// History shared by the encoder and the decoder
+typedef struct {
+    uint32_t timestamp;
+    int32_t delta;
+    uint32_t raw_value;
+    sample_codec_channel_t channels[3]; // voltage, temperature, humidity
+} sample_codec_state_t;
+
+typedef struct {
+    uint8_t* buffer;
+    size_t capacity_bits;
+    size_t bit_pos;
+    uint16_t count;
+    bool overflow;
+    sample_codec_state_t state;
+} sample_encoder_t;
+
+typedef struct {
+    const uint8_t* buffer;
+    size_t length_bits;
+    size_t bit_pos;
+    uint16_t count;     // Samples in the block
+    uint16_t decoded;
+    bool error;
+    sample_codec_state_t state;
+} sample_decoder_t;
+
+void sample_encoder_init(sample_encoder_t* encoder, uint8_t* buffer, size_t capacity);
+bool sample_encoder_append(sample_encoder_t* encoder, const sensor_data_t* sample);
+size_t sample_encoder_finish(sample_encoder_t* encoder);
+
+bool sample_decoder_init(sample_decoder_t* decoder, const uint8_t* block, size_t length);
+bool sample_decoder_next(sample_decoder_t* decoder, sensor_data_t* sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,449 @@
+#include "sample_log.h"
+#include "../telemetry_log/telemetry_record.h"
+#include "esp_timer.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "SampleLog";
+
+_Static_assert(sizeof(sample_log_page_header_t) == 64, "sample_log_page_header_t must be 64 bytes");
+_Static_assert(sizeof(sample_log_record_t) == 16, "sample_log_record_t must be 16 bytes");
+_Static_assert(SAMPLE_LOG_RECORDS_PER_PAGE <= UINT8_MAX, "commit slots hold an 8-bit record count");
+
+#define OPEN_BYTES offsetof(sample_log_page_header_t, last_ms)
+#define SEAL_BYTES (offsetof(sample_log_page_header_t, commits) - OPEN_BYTES)
+
+// A page header as recovery and queries see it. count is the sealed count
+// or that of the last valid commit slot; last_ms is only known when sealed.
+typedef struct {
+    uint32_t sequence;
+    uint64_t first_ms;
+    uint64_t last_ms;
+    uint32_t count;
+    uint32_t commits; // Slots up to and including the last valid one
+    bool sealed;
+} page_info_t;
+
+// Pages: physical slot in the partition. Logical index 0 is the oldest full page.
+
+static size_t page_offset(uint32_t page) {
+    return (size_t)page * SAMPLE_LOG_PAGE_SIZE;
+}
+
+static size_t record_offset(uint32_t page, uint32_t index) {
+    return page_offset(page) + sizeof(sample_log_page_header_t) + (size_t)index * sizeof(sample_log_record_t);
+}
+
+static uint32_t logical_page(const sample_log_t* log, uint32_t index) {
+    return (log->head_page + log->page_count - log->full_pages + index) % log->page_count;
+}
+
+static uint16_t header_crc(const sample_log_page_header_t* header, size_t length) {
+    return telemetry_crc16((const uint8_t*)header, length);
+}
+
+static bool is_erased(const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    
+    for (size_t i = 0; i < length; i++) {
+        if (bytes[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// Erased pages and pages torn before their first commit fail here; a torn
+// seal or commit slot falls back to the last count that made it
+static bool parse_header(const sample_log_page_header_t* header, page_info_t* info) {
+    if (header->magic != SAMPLE_LOG_MAGIC || header->record_size != sizeof(sample_log_record_t) ||
+        header->open_crc != header_crc(header, offsetof(sample_log_page_header_t, open_crc))) {
+        return false;
+    }
+    
+    info->sequence = header->sequence;
+    info->first_ms = header->first_ms;
+    info->last_ms = header->last_ms;
+    info->count = 0;
+    info->commits = 0;
+    info->sealed = header->count == SAMPLE_LOG_RECORDS_PER_PAGE &&
+                   header->seal_crc == header_crc(header, offsetof(sample_log_page_header_t, seal_crc));
+    
+    for (uint32_t slot = 0; slot < SAMPLE_LOG_COMMIT_SLOTS; slot++) {
+        const sample_log_commit_t* commit = &header->commits[slot];
+        if ((uint8_t)(commit->check ^ commit->count) == 0xFF && commit->count > 0 &&
+            commit->count <= SAMPLE_LOG_RECORDS_PER_PAGE) {
+            info->count = commit->count;
+            info->commits = slot + 1;
+        }
+    }
+    if (info->sealed) {
+        info->count = SAMPLE_LOG_RECORDS_PER_PAGE;
+    }
+    return info->count > 0;
+}
+
+static bool read_header(const sample_log_t* log, uint32_t page, page_info_t* info) {
+    sample_log_page_header_t header;
+    
+    return esp_partition_read(log->partition, page_offset(page), &header, sizeof(header)) == ESP_OK &&
+           parse_header(&header, info);
+}
+
+// Program the buffered records not yet on flash into the head page, then
+// the header bytes that count them: the seal once the page is full, the
+// next commit slot otherwise. The sector is erased (and everything
+// programmed again) only when the page is not open yet or is out of commit
+// slots, so filling a page costs one erase however often it is flushed.
+static bool program_head_page(sample_log_t* log) {
+    sample_log_page_header_t header;
+    size_t offset = page_offset(log->head_page);
+    bool full = log->buffer_count == SAMPLE_LOG_RECORDS_PER_PAGE;
+    bool fresh = !log->head_open || (!full && log->commits == SAMPLE_LOG_COMMIT_SLOTS);
+    uint32_t from = fresh ? 0 : log->flushed_count;
+    
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = SAMPLE_LOG_MAGIC;
+    header.sequence = log->head_sequence;
+    header.first_ms = sample_log_record_time_ms(&log->buffer[0]);
+    header.record_size = sizeof(sample_log_record_t);
+    header.open_crc = header_crc(&header, offsetof(sample_log_page_header_t, open_crc));
+    
+    if (fresh) {
+        log->commits = 0;
+        log->stats.erases++;
+        if (esp_partition_erase_range(log->partition, offset, SAMPLE_LOG_PAGE_SIZE) != ESP_OK) return false;
+    }
+    
+    if (esp_partition_write(log->partition, offset + sizeof(header) + from * sizeof(sample_log_record_t),
+                            &log->buffer[from], (log->buffer_count - from) * sizeof(sample_log_record_t)) != ESP_OK ||
+        (fresh && esp_partition_write(log->partition, offset, &header, OPEN_BYTES) != ESP_OK)) {
+        return false;
+    }
+    
+    if (full) {
+        header.last_ms = sample_log_record_time_ms(&log->buffer[log->buffer_count - 1]);
+        header.count = (uint16_t)log->buffer_count;
+        header.seal_crc = header_crc(&header, offsetof(sample_log_page_header_t, seal_crc));
+        return esp_partition_write(log->partition, offset + OPEN_BYTES, &header.last_ms, SEAL_BYTES) == ESP_OK;
+    }
+    
+    sample_log_commit_t commit = { (uint8_t)log->buffer_count, (uint8_t)~log->buffer_count };
+    size_t slot = offsetof(sample_log_page_header_t, commits) + log->commits * sizeof(commit);
+    log->commits++;
+    return esp_partition_write(log->partition, offset + slot, &commit, sizeof(commit)) == ESP_OK;
+}
+
+static bool write_head_page(sample_log_t* log) {
+    log->stats.page_writes++;
+    
+    // Open again only once this write is through
+    log->head_open = program_head_page(log);
+    if (!log->head_open) {
+        log->stats.write_errors++;
+        ESP_LOGE(TAG, "Failed to write page %lu", (unsigned long)log->head_page);
+        return false;
+    }
+    return true;
+}
+
+// Whether a recovered partial page can take more records in place: its
+// seal, unused commit slots and records past the committed ones must all
+// still be erased. A reset mid-flush can leave records programmed past the
+// last commit, and then the page is rewritten from a fresh erase instead.
+static bool head_tail_erased(sample_log_t* log, const sample_log_page_header_t* header, const page_info_t* info) {
+    if (!is_erased(&header->last_ms, SEAL_BYTES) ||
+        !is_erased(&header->commits[info->commits], (SAMPLE_LOG_COMMIT_SLOTS - info->commits) * sizeof(sample_log_commit_t))) {
+        return false;
+    }
+    
+    for (uint32_t record = info->count; record < SAMPLE_LOG_RECORDS_PER_PAGE; record += SAMPLE_LOG_QUERY_CHUNK) {
+        uint32_t chunk = SAMPLE_LOG_RECORDS_PER_PAGE - record;
+        if (chunk > SAMPLE_LOG_QUERY_CHUNK) chunk = SAMPLE_LOG_QUERY_CHUNK;
+        
+        if (esp_partition_read(log->partition, record_offset(log->head_page, record), log->chunk,
+                               chunk * sizeof(sample_log_record_t)) != ESP_OK ||
+            !is_erased(log->chunk, chunk * sizeof(sample_log_record_t))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Scan page headers only: the newest valid page becomes the head, and the
+// run of consecutive sequence numbers before it is the log. Neither wraps:
+// sequence would need 4G page writes, far past the flash's erase endurance,
+// and log times are 64-bit.
+static void recover(sample_log_t* log) {
+    sample_log_page_header_t header;
+    page_info_t info;
+    uint32_t newest_page = 0;
+    uint32_t newest_sequence = 0;
+    
+    for (uint32_t page = 0; page < log->page_count; page++) {
+        if (read_header(log, page, &info) && info.sequence >= newest_sequence) {
+            newest_sequence = info.sequence;
+            newest_page = page;
+        }
+    }
+    
+    if (newest_sequence == 0) {
+        ESP_LOGI(TAG, "Empty log, %lu pages", (unsigned long)log->page_count);
+        return;
+    }
+    
+    esp_partition_read(log->partition, page_offset(newest_page), &header, sizeof(header));
+    parse_header(&header, &info);
+    
+    if (!info.sealed) {
+        // Flushed partial page: keep filling it
+        log->head_page = newest_page;
+        log->head_sequence = info.sequence;
+        log->buffer_count = info.count;
+        log->flushed_count = info.count;
+        log->commits = info.commits;
+        esp_partition_read(log->partition, record_offset(newest_page, 0), log->buffer,
+                           info.count * sizeof(sample_log_record_t));
+        log->head_open = head_tail_erased(log, &header, &info);
+        log->newest_ms = sample_log_record_time_ms(&log->buffer[info.count - 1]);
+    } else {
+        log->head_page = (newest_page + 1) % log->page_count;
+        log->head_sequence = info.sequence + 1;
+        log->full_pages = 1;
+        log->newest_ms = info.last_ms;
+    }
+    log->anchor_ms = log->newest_ms + 1; // Tick 0 of this boot
+    
+    // Walk back over older full pages
+    uint32_t expected = log->head_sequence - 1;
+    while (log->full_pages < log->page_count - 1) {
+        uint32_t page = logical_page(log, log->page_count - 1); // One before the oldest so far
+        if (!read_header(log, page, &info) || info.sequence != expected - log->full_pages || !info.sealed) {
+            break;
+        }
+        log->full_pages++;
+    }
+}
+
+static bool sample_log_init(sample_log_t* log, const char* label) {
+    memset(log, 0, sizeof(*log));
+    
+    log->partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!log->partition) {
+        ESP_LOGE(TAG, "No data partition '%s'", label);
+        return false;
+    }
+    
+    log->page_count = log->partition->size / SAMPLE_LOG_PAGE_SIZE;
+    if (log->page_count < 2) {
+        ESP_LOGE(TAG, "Partition '%s' needs at least two pages", label);
+        return false;
+    }
+    
+    log->head_sequence = 1;
+    
+    int64_t start_us = esp_timer_get_time();
+    recover(log);
+    log->stats.recovery_us = (uint32_t)(esp_timer_get_time() - start_us);
+    
+    ESP_LOGI(TAG, "Recovered %lu pages + %lu buffered samples in %lu us",
+             (unsigned long)log->full_pages, (unsigned long)log->buffer_count,
+             (unsigned long)log->stats.recovery_us);
+    return true;
+}
+
+sample_log_t* sample_log_create(const char* label) {
+    if (!label) return NULL;
+    
+    sample_log_t* log = (sample_log_t*)malloc(sizeof(sample_log_t));
+    if (!log) {
+        ESP_LOGE(TAG, "Failed to allocate sample log");
+        return NULL;
+    }
+    
+    if (!sample_log_init(log, label)) {
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+sample_log_t* sample_log_create_static(sample_log_t* storage, const char* label) {
+    if (!storage || !label) return NULL;
+    
+    if (!sample_log_init(storage, label)) {
+        return NULL;
+    }
+    storage->is_static = true;
+    return storage;
+}
+
+void sample_log_destroy(sample_log_t* log) {
+    if (!log) return;
+    
+    sample_log_flush(log);
+    if (!log->is_static) {
+        free(log);
+    }
+}
+
+uint64_t sample_log_time_ms(sample_log_t* log, TickType_t ticks) {
+    if (!log) return 0;
+    
+    int32_t delta = (int32_t)(ticks - log->anchor_ticks);
+    return (uint64_t)((int64_t)log->anchor_ms + (int64_t)delta * portTICK_PERIOD_MS);
+}
+
+bool sample_log_append(sample_log_t* log, const sensor_data_t* sample) {
+    if (!log || !sample) return false;
+    
+    sample_log_record_t* record = &log->buffer[log->buffer_count];
+    
+    uint64_t time_ms = sample_log_time_ms(log, sample->timestamp);
+    log->anchor_ms = time_ms;
+    log->anchor_ticks = sample->timestamp;
+    
+    // Keep times non-decreasing so queries can binary-search
+    if (time_ms < log->newest_ms) {
+        time_ms = log->newest_ms;
+    }
+    record->time_ms = (uint32_t)time_ms;
+    record->time_ms_high = (uint16_t)(time_ms >> 32);
+    record->raw_value = sample->raw_value;
+    record->voltage_mv = (int16_t)sensor_voltage_mv(sample);
+    record->temperature_cdeg = (int16_t)sensor_temperature_cdeg(sample);
+    record->humidity_cpct = (uint16_t)sensor_humidity_cpct(sample);
+    
+    log->newest_ms = time_ms;
+    log->buffer_count++;
+    
+    if (log->buffer_count < SAMPLE_LOG_RECORDS_PER_PAGE) {
+        return true;
+    }
+    
+    bool written = write_head_page(log);
+    
+    // Advance even on a write error so one bad sector does not stall the log
+    log->head_page = (log->head_page + 1) % log->page_count;
+    log->head_sequence++;
+    log->buffer_count = 0;
+    log->flushed_count = 0;
+    log->commits = 0;
+    log->head_open = false;
+    if (written && log->full_pages < log->page_count - 1) {
+        log->full_pages++;
+    } else if (!written) {
+        log->full_pages = 0; // Older pages no longer chain to the head
+    }
+    return written;
+}
+
+// Program the samples appended since the last flush so a reset does not
+// lose them. They go into the head page's erased tail behind a commit
+// slot, without another erase; only a page flushed more than
+// SAMPLE_LOG_COMMIT_SLOTS times is erased and rewritten.
+bool sample_log_flush(sample_log_t* log) {
+    if (!log) return false;
+    if (log->buffer_count == log->flushed_count) return true;
+    
+    if (!write_head_page(log)) return false;
+    log->flushed_count = log->buffer_count;
+    return true;
+}
+
+// Index of the first record in page whose time is >= from_ms (count if none)
+static uint32_t find_in_page(sample_log_t* log, uint32_t page, uint32_t count, uint64_t from_ms) {
+    uint32_t low = 0;
+    uint32_t high = count;
+    
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        sample_log_record_t record;
+        
+        if (esp_partition_read(log->partition, record_offset(page, mid), &record, sizeof(record)) != ESP_OK) {
+            return count;
+        }
+        if (sample_log_record_time_ms(&record) < from_ms) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Visit every record with from_ms <= time_ms <= to_ms, oldest first.
+// Returns the number of records visited.
+size_t sample_log_query(sample_log_t* log, uint64_t from_ms, uint64_t to_ms,
+                        sample_log_visitor_t visitor, void* context) {
+    if (!log || !visitor || from_ms > to_ms) return 0;
+    
+    page_info_t header;
+    size_t visited = 0;
+    
+    // First full page whose last sample is not before from_ms
+    uint32_t low = 0;
+    uint32_t high = log->full_pages;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (read_header(log, logical_page(log, mid), &header) && header.last_ms < from_ms) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    for (uint32_t index = low; index < log->full_pages; index++) {
+        uint32_t page = logical_page(log, index);
+        
+        if (!read_header(log, page, &header)) continue;
+        if (header.first_ms > to_ms) return visited;
+        
+        uint32_t record = (header.first_ms < from_ms) ? find_in_page(log, page, header.count, from_ms) : 0;
+        
+        while (record < header.count) {
+            uint32_t chunk = header.count - record;
+            if (chunk > SAMPLE_LOG_QUERY_CHUNK) chunk = SAMPLE_LOG_QUERY_CHUNK;
+            
+            if (esp_partition_read(log->partition, record_offset(page, record), log->chunk,
+                                   chunk * sizeof(sample_log_record_t)) != ESP_OK) {
+                break;
+            }
+            
+            for (uint32_t i = 0; i < chunk; i++) {
+                if (sample_log_record_time_ms(&log->chunk[i]) > to_ms) return visited;
+                visited++;
+                if (!visitor(&log->chunk[i], context)) return visited;
+            }
+            record += chunk;
+        }
+    }
+    
+    // Newest samples, still in the write buffer
+    for (uint32_t i = 0; i < log->buffer_count; i++) {
+        uint64_t time_ms = sample_log_record_time_ms(&log->buffer[i]);
+        if (time_ms < from_ms) continue;
+        if (time_ms > to_ms) break;
+        visited++;
+        if (!visitor(&log->buffer[i], context)) break;
+    }
+    return visited;
+}
+
+bool sample_log_get_stats(sample_log_t* log, sample_log_stats_t* stats) {
+    if (!log || !stats) return false;
+    
+    *stats = log->stats;
+    stats->samples = log->full_pages * SAMPLE_LOG_RECORDS_PER_PAGE + log->buffer_count;
+    stats->pages_used = log->full_pages + (log->buffer_count > 0 ? 1 : 0);
+    stats->page_count = log->page_count;
+    stats->newest_ms = log->newest_ms;
+    stats->oldest_ms = log->newest_ms;
+    
+    page_info_t header;
+    if (log->full_pages > 0 && read_header(log, logical_page(log, 0), &header)) {
+        stats->oldest_ms = header.first_ms;
+    } else if (log->buffer_count > 0) {
+        stats->oldest_ms = sample_log_record_time_ms(&log->buffer[0]);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include "freertos/FreeRTOS.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+#include "../sensor_reader/sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Append-only sample log on a raw data partition. The partition is a ring
+// of erase-sector-sized pages written in order, so every sector wears at
+// the same rate. Samples collect in a one-page RAM buffer. Each page is
+// erased once, when its first records are programmed; NOR programming only
+// clears bits, so a flush after that programs just the new records into
+// the erased rest of the page plus a commit slot in the header, and the
+// seal goes in once the page is full. Records always go in before the
+// header bytes that count them. Page headers carry the page's first/last
+// log time, so recovery reads only headers and a time query
+// binary-searches them. Log times are 64-bit milliseconds and never wrap.
+//
+// Not thread-safe: append, flush and query from a single task.
+
+#define SAMPLE_LOG_PAGE_SIZE SPI_FLASH_SEC_SIZE
+#define SAMPLE_LOG_MAGIC 0x534C4733 // "SLG3"; older layouts read as erased
+
+// Flushes of one page before the next one erases and rewrites it instead
+#define SAMPLE_LOG_COMMIT_SLOTS 16
+
+typedef struct __attribute__((packed)) {
+    uint8_t count;  // Records on flash as of this flush
+    uint8_t check;  // ~count; an erased or torn slot fails it
+} sample_log_commit_t;
+
+typedef struct __attribute__((packed)) {
+    // Programmed with the page's first records
+    uint32_t magic;
+    uint32_t sequence; // Page write order, starts at 1
+    uint64_t first_ms;
+    uint16_t record_size;
+    uint16_t open_crc; // CRC-16/CCITT-FALSE over the bytes above
+    // Programmed once the page is full
+    uint64_t last_ms;
+    uint16_t count;
+    uint16_t seal_crc; // Over all the bytes above, so a seal is its page's
+    // One per flush while the page is partial
+    sample_log_commit_t commits[SAMPLE_LOG_COMMIT_SLOTS];
+} sample_log_page_header_t;
+
+// Times are log time: milliseconds since the first boot that wrote the log.
+// Each boot continues after the newest recovered sample, so log time never
+// goes backwards across resets.
+// Values use the sensor_data_t scales whatever SENSOR_DATA_FIXED_POINT
+// says, so logs stay readable across builds.
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;      // Low 32 bits of the log time
+    uint32_t raw_value;
+    int16_t voltage_mv;
+    int16_t temperature_cdeg;
+    uint16_t humidity_cpct;
+    uint16_t time_ms_high; // Bits 32-47: 8900 years before it wraps
+} sample_log_record_t;
+
+static inline uint64_t sample_log_record_time_ms(const sample_log_record_t* record) {
+    return (uint64_t)record->time_ms_high << 32 | record->time_ms;
+}
+
+#define SAMPLE_LOG_RECORDS_PER_PAGE \
+    ((SAMPLE_LOG_PAGE_SIZE - sizeof(sample_log_page_header_t)) / sizeof(sample_log_record_t))
+
+// Records read per flash access while streaming a query
+#define SAMPLE_LOG_QUERY_CHUNK 16
+
+// Return false to stop the query early
+typedef bool (*sample_log_visitor_t)(const sample_log_record_t* record, void* context);
+
+typedef struct {
+    uint32_t samples;      // On flash plus in the write buffer
+    uint32_t pages_used;
+    uint32_t page_count;
+    uint32_t page_writes;  // Full pages and flushes programmed since boot
+    uint32_t erases;       // Sectors erased since boot: one per page unless
+                           // flushes outrun SAMPLE_LOG_COMMIT_SLOTS
+    uint32_t write_errors;
+    uint64_t oldest_ms;
+    uint64_t newest_ms;
+    uint32_t recovery_us;
+} sample_log_stats_t;
+
+typedef struct {
+    const esp_partition_t* partition;
+    uint32_t page_count;
+    // The page being filled lives in buffer and belongs at head_page.
+    // full_pages complete pages precede it in the ring, oldest first.
+    uint32_t head_page;
+    uint32_t head_sequence;
+    uint32_t full_pages;
+    // Log time of anchor_ticks; times of other ticks are taken relative to
+    // it, so the 32-bit tick count wrapping (49.7 days at 1 kHz) carries on
+    // into the upper bits instead of sending log time backwards
+    uint64_t anchor_ms;
+    TickType_t anchor_ticks;
+    uint64_t newest_ms;
+    sample_log_stats_t stats;
+    sample_log_record_t buffer[SAMPLE_LOG_RECORDS_PER_PAGE];
+    uint32_t buffer_count;
+    uint32_t flushed_count; // Samples of buffer already programmed at head_page
+    uint32_t commits;       // Commit slots used at head_page
+    // head_page is erased past flushed_count records and its used commit
+    // slots, and its header's first part is programmed, so a flush can
+    // program in place
+    bool head_open;
+    sample_log_record_t chunk[SAMPLE_LOG_QUERY_CHUNK];
+    bool is_static;
+} sample_log_t;
+
+// label names a data partition in partitions.csv
+sample_log_t* sample_log_create(const char* label);
+sample_log_t* sample_log_create_static(sample_log_t* storage, const char* label);
+void sample_log_destroy(sample_log_t* log);
+bool sample_log_append(sample_log_t* log, const sensor_data_t* sample);
+bool sample_log_flush(sample_log_t* log);
+// ticks must be within 2^31 ticks (24.8 days at 1 kHz) of the last appended
+// sample's timestamp
+uint64_t sample_log_time_ms(sample_log_t* log, TickType_t ticks);
+size_t sample_log_query(sample_log_t* log, uint64_t from_ms, uint64_t to_ms,
+                        sample_log_visitor_t visitor, void* context);
+bool sample_log_get_stats(sample_log_t* log, sample_log_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "sensor_adaptive.h"
+#include <string.h>
+
+void sensor_adaptive_init(sensor_adaptive_t* adaptive, const sensor_adaptive_config_t* config) {
+    memset(adaptive, 0, sizeof(*adaptive));
+    adaptive->config = *config;
+    
+    if (adaptive->config.min_period == 0) {
+        adaptive->config.min_period = 1;
+    }
+    if (adaptive->config.max_period < adaptive->config.min_period) {
+        adaptive->config.max_period = adaptive->config.min_period;
+    }
+    adaptive->period = adaptive->config.min_period;
+}
+
+static bool sensor_adaptive_unchanged(const sensor_adaptive_t* adaptive, const sensor_data_t* sample) {
+    const sensor_data_t* last = &adaptive->last_emitted;
+    
+    return SENSOR_VALUE_ABS(sample->temperature - last->temperature) <= adaptive->config.temperature_delta &&
+           SENSOR_VALUE_ABS(sample->humidity - last->humidity) <= adaptive->config.humidity_delta &&
+           SENSOR_VALUE_ABS(sample->voltage - last->voltage) <= adaptive->config.voltage_delta;
+}
+
+// Feed one sample (timestamp set). Returns true if it should be emitted
+// and updates the period until the next sample.
+bool sensor_adaptive_update(sensor_adaptive_t* adaptive, const sensor_data_t* sample) {
+    adaptive->taken++;
+    
+    if (adaptive->has_emitted && sensor_adaptive_unchanged(adaptive, sample)) {
+        // Stretch: double after every stretch_after quiet samples
+        if (++adaptive->unchanged >= adaptive->config.stretch_after) {
+            adaptive->unchanged = 0;
+            TickType_t doubled = adaptive->period * 2;
+            adaptive->period = doubled < adaptive->config.max_period ? doubled : adaptive->config.max_period;
+        }
+        
+        TickType_t since = sample->timestamp - adaptive->last_emitted.timestamp;
+        if (adaptive->config.heartbeat == 0 || since < adaptive->config.heartbeat) {
+            return false;
+        }
+    } else {
+        // Snap back on change
+        adaptive->unchanged = 0;
+        adaptive->period = adaptive->config.min_period;
+    }
+    
+    adaptive->last_emitted = *sample;
+    adaptive->has_emitted = true;
+    adaptive->emitted++;
+    return true;
+}
+
+TickType_t sensor_adaptive_period(const sensor_adaptive_t* adaptive) {
+    return adaptive->period;
+}
\ No newline at end of file
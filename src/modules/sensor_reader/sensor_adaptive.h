@@ -0,0 +1,58 @@
+#ifndef SENSOR_ADAPTIVE_H
+#define SENSOR_ADAPTIVE_H
+
+#include "freertos/FreeRTOS.h"
+#include "sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Adaptive sampling policy. A sample is "unchanged" when every field is
+// within its delta of the last emitted sample. Unchanged samples are
+// suppressed, and after stretch_after of them in a row the period doubles,
+// up to max_period. Any change is emitted and snaps the period back to
+// min_period. A heartbeat sample is emitted at least every heartbeat ticks
+// so consumers can tell a flat signal from a dead sensor.
+
+typedef struct {
+    TickType_t min_period;
+    TickType_t max_period;
+    TickType_t heartbeat;     // 0 = never emit unchanged samples
+    uint8_t stretch_after;    // Unchanged samples before each doubling
+    sensor_value_t temperature_delta; // Same representation as sensor_data_t
+    sensor_value_t humidity_delta;
+    sensor_value_t voltage_delta;
+} sensor_adaptive_config_t;
+
+// Deltas: 0.2 C, 1 %RH, 0.05 V
+#define SENSOR_ADAPTIVE_DEFAULT_CONFIG { pdMS_TO_TICKS(2000), pdMS_TO_TICKS(32000), pdMS_TO_TICKS(300000), 3, \
+                                         SENSOR_VALUE(0.2, SENSOR_TEMPERATURE_SCALE),                    \
+                                         SENSOR_VALUE(1.0, SENSOR_HUMIDITY_SCALE),                       \
+                                         SENSOR_VALUE(0.05, SENSOR_VOLTAGE_SCALE) }
+
+typedef struct {
+    uint32_t taken;
+    uint32_t emitted;
+    TickType_t period;        // Current sampling period
+} sensor_adaptive_stats_t;
+
+typedef struct {
+    sensor_adaptive_config_t config;
+    sensor_data_t last_emitted;
+    bool has_emitted;
+    uint8_t unchanged;
+    TickType_t period;
+    uint32_t taken;
+    uint32_t emitted;
+} sensor_adaptive_t;
+
+void sensor_adaptive_init(sensor_adaptive_t* adaptive, const sensor_adaptive_config_t* config);
+bool sensor_adaptive_update(sensor_adaptive_t* adaptive, const sensor_data_t* sample);
+TickType_t sensor_adaptive_period(const sensor_adaptive_t* adaptive);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "sensor_adc_driver.h"
+#include "driver/adc.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "SensorAdc";
+
+#define ADC_CHANNEL_COUNT 3
+
+static bool adc_driver_init(sensor_driver_t* driver) {
+    sensor_adc_driver_t* adc = (sensor_adc_driver_t*)driver->context;
+    const uint8_t channels[ADC_CHANNEL_COUNT] = {
+        adc->config.voltage.channel,
+        adc->config.temperature.channel,
+        adc->config.humidity.channel
+    };
+    
+    adc_digi_init_config_t init_config = {
+        .max_store_buf_size = 4 * SENSOR_ADC_FRAME_BYTES,
+        .conv_num_each_intr = SENSOR_ADC_FRAME_BYTES,
+        .adc1_chan_mask = 0,
+        .adc2_chan_mask = 0
+    };
+    
+    adc_digi_pattern_config_t pattern[ADC_CHANNEL_COUNT];
+    for (int i = 0; i < ADC_CHANNEL_COUNT; i++) {
+        init_config.adc1_chan_mask |= 1u << channels[i];
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = channels[i];
+        pattern[i].unit = 0; // ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+    
+    if (adc_digi_initialize(&init_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize continuous ADC");
+        return false;
+    }
+    
+    adc_digi_configuration_t digi_config = {
+        .conv_limit_en = false,
+        .conv_limit_num = 250,
+        .pattern_num = ADC_CHANNEL_COUNT,
+        .adc_pattern = pattern,
+        .sample_freq_hz = adc->config.sample_freq_hz,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2
+    };
+    
+    if (adc_digi_controller_configure(&digi_config) != ESP_OK || adc_digi_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start continuous ADC");
+        adc_digi_deinitialize();
+        return false;
+    }
+    
+    sensor_decimator_init(&adc->decimator, channels, ADC_CHANNEL_COUNT, adc->config.samples_per_output);
+    adc->running = true;
+    
+    ESP_LOGI(TAG, "Continuous ADC at %lu Hz, %lu samples per output",
+             (unsigned long)adc->config.sample_freq_hz, (unsigned long)adc->config.samples_per_output);
+    return true;
+}
+
+// Q4 mean x Q16 gain, rounded back to scaled units
+static int32_t adc_channel_value(const sensor_adc_channel_t* channel, uint32_t mean_q4) {
+    const int shift = SENSOR_DECIMATOR_FRAC_BITS + SENSOR_ADC_GAIN_FRAC_BITS;
+    int64_t scaled = (int64_t)mean_q4 * channel->gain_q16 + ((int64_t)1 << (shift - 1));
+    return (int32_t)(scaled >> shift) + channel->offset;
+}
+
+static bool adc_driver_read(sensor_driver_t* driver, sensor_data_t* data, TickType_t timeout) {
+    sensor_adc_driver_t* adc = (sensor_adc_driver_t*)driver->context;
+    uint32_t timeout_ms = (timeout == portMAX_DELAY) ? UINT32_MAX : timeout * portTICK_PERIOD_MS;
+    
+    while (!sensor_decimator_ready(&adc->decimator)) {
+        uint32_t length = 0;
+        esp_err_t err = adc_digi_read_bytes((uint8_t*)adc->frame, sizeof(adc->frame), &length, timeout_ms);
+        
+        if (err == ESP_ERR_TIMEOUT) {
+            return false;
+        }
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // INVALID_STATE: DMA overrun, data still valid
+            ESP_LOGE(TAG, "ADC read failed: %d", err);
+            return false;
+        }
+        
+        sensor_decimator_accumulate(&adc->decimator, adc->frame, length / sizeof(uint32_t));
+    }
+    
+    uint32_t mean_q4[ADC_CHANNEL_COUNT];
+    sensor_decimator_output(&adc->decimator, mean_q4);
+    
+    data->raw_value = mean_q4[0] >> SENSOR_DECIMATOR_FRAC_BITS;
+    sensor_set_voltage_mv(data, adc_channel_value(&adc->config.voltage, mean_q4[0]));
+    sensor_set_temperature_cdeg(data, adc_channel_value(&adc->config.temperature, mean_q4[1]));
+    sensor_set_humidity_cpct(data, adc_channel_value(&adc->config.humidity, mean_q4[2]));
+    return true;
+}
+
+static void adc_driver_deinit(sensor_driver_t* driver) {
+    sensor_adc_driver_t* adc = (sensor_adc_driver_t*)driver->context;
+    
+    if (adc->running) {
+        adc_digi_stop();
+        adc_digi_deinitialize();
+        adc->running = false;
+    }
+}
+
+static const sensor_driver_ops_t adc_driver_ops = {
+    "adc",
+    true,
+    adc_driver_init,
+    adc_driver_read,
+    adc_driver_deinit
+};
+
+static void adc_driver_setup(sensor_adc_driver_t* adc, const sensor_adc_config_t* config) {
+    memset(adc, 0, sizeof(*adc));
+    adc->config = *config;
+    adc->driver.ops = &adc_driver_ops;
+    adc->driver.context = adc;
+}
+
+sensor_adc_driver_t* sensor_adc_driver_create(const sensor_adc_config_t* config) {
+    if (!config) return NULL;
+    
+    sensor_adc_driver_t* adc = (sensor_adc_driver_t*)malloc(sizeof(sensor_adc_driver_t));
+    if (!adc) {
+        ESP_LOGE(TAG, "Failed to allocate ADC driver");
+        return NULL;
+    }
+    
+    adc_driver_setup(adc, config);
+    return adc;
+}
+
+sensor_adc_driver_t* sensor_adc_driver_create_static(sensor_adc_driver_t* storage, const sensor_adc_config_t* config) {
+    if (!storage || !config) return NULL;
+    
+    adc_driver_setup(storage, config);
+    storage->is_static = true;
+    return storage;
+}
+
+void sensor_adc_driver_destroy(sensor_adc_driver_t* adc) {
+    if (!adc) return;
+    
+    adc_driver_deinit(&adc->driver);
+    if (!adc->is_static) {
+        free(adc);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef SENSOR_ADC_DRIVER_H
+#define SENSOR_ADC_DRIVER_H
+
+#include "sensor_driver.h"
+#include "sensor_decimator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Continuous (DMA) ADC1 driver. The ADC samples every configured channel in
+// the background; read() wakes once per DMA frame, integrates it, and
+// returns a sample once samples_per_output results per channel have been
+// averaged.
+//
+// Calibration is integer-only: output = mean_raw * gain + offset in the
+// channel's scaled units (mV, 0.01 C, 0.01 %RH), with gain in Q16. Build
+// coefficients from engineering units with SENSOR_ADC_CALIBRATION().
+typedef struct {
+    uint8_t channel;  // ADC1 channel number
+    int32_t gain_q16; // Scaled units per raw LSB, Q16
+    int32_t offset;   // Scaled units
+} sensor_adc_channel_t;
+
+#define SENSOR_ADC_GAIN_FRAC_BITS 16
+
+// e.g. SENSOR_ADC_CALIBRATION(0, 3.1 / 4095, 0.0, SENSOR_VOLTAGE_SCALE) for V
+#define SENSOR_ADC_CALIBRATION(channel, units_per_lsb, offset_units, scale) \
+    { (channel), \
+      (int32_t)((units_per_lsb) * (scale) * (1 << SENSOR_ADC_GAIN_FRAC_BITS) + 0.5), \
+      (int32_t)((offset_units) * (scale) + ((offset_units) >= 0 ? 0.5 : -0.5)) }
+
+typedef struct {
+    sensor_adc_channel_t voltage;
+    sensor_adc_channel_t temperature;
+    sensor_adc_channel_t humidity;
+    uint32_t sample_freq_hz;     // Aggregate conversion rate
+    uint32_t samples_per_output; // Per channel
+} sensor_adc_config_t;
+
+// Bytes per DMA frame; each read() wake processes one frame
+#define SENSOR_ADC_FRAME_BYTES 1024
+
+typedef struct {
+    sensor_driver_t driver;
+    sensor_adc_config_t config;
+    sensor_decimator_t decimator;
+    uint32_t frame[SENSOR_ADC_FRAME_BYTES / sizeof(uint32_t)];
+    bool running;
+    bool is_static;
+} sensor_adc_driver_t;
+
+sensor_adc_driver_t* sensor_adc_driver_create(const sensor_adc_config_t* config);
+sensor_adc_driver_t* sensor_adc_driver_create_static(sensor_adc_driver_t* storage, const sensor_adc_config_t* config);
+void sensor_adc_driver_destroy(sensor_adc_driver_t* adc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "sensor_decimator.h"
+#include <string.h>
+
+// ADC_DIGI_OUTPUT_FORMAT_TYPE2 result word: data[11:0], channel[16:13]
+#define RESULT_DATA(word)    ((word) & 0xFFF)
+#define RESULT_CHANNEL(word) (((word) >> 13) & 0xF)
+
+void sensor_decimator_init(sensor_decimator_t* decimator, const uint8_t* channels, uint8_t count, uint32_t factor) {
+    memset(decimator, 0, sizeof(*decimator));
+    memset(decimator->slot_of_channel, SENSOR_DECIMATOR_NO_SLOT, sizeof(decimator->slot_of_channel));
+    
+    if (count > SENSOR_DECIMATOR_MAX_CHANNELS) {
+        count = SENSOR_DECIMATOR_MAX_CHANNELS;
+    }
+    
+    for (uint8_t i = 0; i < count; i++) {
+        decimator->slot_of_channel[channels[i] & 0xF] = i;
+    }
+    decimator->slots = count;
+    
+    // 12-bit samples: keep the 32-bit integrators from overflowing
+    if (factor > SENSOR_DECIMATOR_MAX_FACTOR) {
+        factor = SENSOR_DECIMATOR_MAX_FACTOR;
+    }
+    decimator->factor = factor ? factor : 1;
+}
+
+// Integrate a block of raw DMA results. Samples beyond the decimation
+// factor for a channel are discarded until the output is taken, so every
+// output averages exactly factor samples.
+void sensor_decimator_accumulate(sensor_decimator_t* decimator, const uint32_t* results, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t word = results[i];
+        uint8_t slot = decimator->slot_of_channel[RESULT_CHANNEL(word)];
+        
+        if (slot != SENSOR_DECIMATOR_NO_SLOT && decimator->count[slot] < decimator->factor) {
+            decimator->sum[slot] += RESULT_DATA(word);
+            decimator->count[slot]++;
+        }
+    }
+}
+
+bool sensor_decimator_ready(const sensor_decimator_t* decimator) {
+    for (uint8_t i = 0; i < decimator->slots; i++) {
+        if (decimator->count[i] < decimator->factor) {
+            return false;
+        }
+    }
+    return decimator->slots > 0;
+}
+
+// Dump: write each slot's mean in Q4 and reset the integrators
+void sensor_decimator_output(sensor_decimator_t* decimator, uint32_t* out_q4) {
+    for (uint8_t i = 0; i < decimator->slots; i++) {
+        uint32_t count = decimator->count[i] ? decimator->count[i] : 1;
+        out_q4[i] = (uint32_t)(((uint64_t)decimator->sum[i] << SENSOR_DECIMATOR_FRAC_BITS) / count);
+        decimator->sum[i] = 0;
+        decimator->count[i] = 0;
+    }
+}
\ No newline at end of file
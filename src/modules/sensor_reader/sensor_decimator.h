@@ -0,0 +1,38 @@
+#ifndef SENSOR_DECIMATOR_H
+#define SENSOR_DECIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// First-order CIC (integrate-and-dump) decimator over interleaved ADC DMA
+// results. Integer-only; each channel's output is its mean over the block
+// in Q4 fixed point, i.e. 4 extra fractional bits recovered by averaging.
+
+#define SENSOR_DECIMATOR_MAX_CHANNELS 4
+#define SENSOR_DECIMATOR_FRAC_BITS 4
+#define SENSOR_DECIMATOR_NO_SLOT 0xFF
+#define SENSOR_DECIMATOR_MAX_FACTOR 65536
+
+typedef struct {
+    uint32_t sum[SENSOR_DECIMATOR_MAX_CHANNELS];
+    uint32_t count[SENSOR_DECIMATOR_MAX_CHANNELS];
+    uint8_t slot_of_channel[16]; // ADC channel -> output slot
+    uint8_t slots;
+    uint32_t factor;             // Samples per channel per output
+} sensor_decimator_t;
+
+void sensor_decimator_init(sensor_decimator_t* decimator, const uint8_t* channels, uint8_t count, uint32_t factor);
+void sensor_decimator_accumulate(sensor_decimator_t* decimator, const uint32_t* results, size_t count);
+bool sensor_decimator_ready(const sensor_decimator_t* decimator);
+void sensor_decimator_output(sensor_decimator_t* decimator, uint32_t* out_q4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef SENSOR_DRIVER_H
+#define SENSOR_DRIVER_H
+
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Engineering values are fixed scales: millivolts, 0.01 C and 0.01 %RH
+// (the telemetry record units). Building with -DSENSOR_DATA_FIXED_POINT
+// stores them as those scaled integers, so drivers and the sampling task
+// do no float work and every buffered sample shrinks from 20 to 16 bytes.
+// Otherwise they are floats in V, C and %RH. Use the accessors below to
+// stay independent of the representation; floats are meant for the
+// presentation edge (logs, stats, tools).
+#define SENSOR_VOLTAGE_SCALE 1000
+#define SENSOR_TEMPERATURE_SCALE 100
+#define SENSOR_HUMIDITY_SCALE 100
+
+#ifdef SENSOR_DATA_FIXED_POINT
+typedef int16_t sensor_value_t;
+// Compile-time conversion of a constant in engineering units
+#define SENSOR_VALUE(units, scale) \
+    ((sensor_value_t)((units) * (scale) + ((units) >= 0 ? 0.5 : -0.5)))
+#else
+typedef float sensor_value_t;
+#define SENSOR_VALUE(units, scale) ((sensor_value_t)(units))
+#endif
+
+#define SENSOR_VALUE_ABS(value) ((value) < 0 ? -(value) : (value))
+
+typedef struct {
+    uint32_t raw_value;
+    sensor_value_t voltage;
+    sensor_value_t temperature;
+    sensor_value_t humidity;
+    TickType_t timestamp;
+} sensor_data_t;
+
+#ifdef SENSOR_DATA_FIXED_POINT
+static inline int32_t sensor_to_scaled(sensor_value_t value, int32_t scale) {
+    return value;
+}
+
+static inline sensor_value_t sensor_from_scaled(int32_t scaled, int32_t scale) {
+    if (scaled < INT16_MIN) return INT16_MIN;
+    if (scaled > INT16_MAX) return INT16_MAX;
+    return (sensor_value_t)scaled;
+}
+
+static inline float sensor_to_float(sensor_value_t value, int32_t scale) {
+    return (float)value / (float)scale;
+}
+#else
+static inline int32_t sensor_to_scaled(sensor_value_t value, int32_t scale) {
+    float scaled = value * (float)scale;
+    return (int32_t)(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+static inline sensor_value_t sensor_from_scaled(int32_t scaled, int32_t scale) {
+    return (float)scaled / (float)scale;
+}
+
+static inline float sensor_to_float(sensor_value_t value, int32_t scale) {
+    return value;
+}
+#endif
+
+// Scaled integers: mV, 0.01 C, 0.01 %RH
+static inline int32_t sensor_voltage_mv(const sensor_data_t* data) {
+    return sensor_to_scaled(data->voltage, SENSOR_VOLTAGE_SCALE);
+}
+
+static inline int32_t sensor_temperature_cdeg(const sensor_data_t* data) {
+    return sensor_to_scaled(data->temperature, SENSOR_TEMPERATURE_SCALE);
+}
+
+static inline int32_t sensor_humidity_cpct(const sensor_data_t* data) {
+    return sensor_to_scaled(data->humidity, SENSOR_HUMIDITY_SCALE);
+}
+
+static inline void sensor_set_voltage_mv(sensor_data_t* data, int32_t mv) {
+    data->voltage = sensor_from_scaled(mv, SENSOR_VOLTAGE_SCALE);
+}
+
+static inline void sensor_set_temperature_cdeg(sensor_data_t* data, int32_t cdeg) {
+    data->temperature = sensor_from_scaled(cdeg, SENSOR_TEMPERATURE_SCALE);
+}
+
+static inline void sensor_set_humidity_cpct(sensor_data_t* data, int32_t cpct) {
+    data->humidity = sensor_from_scaled(cpct, SENSOR_HUMIDITY_SCALE);
+}
+
+// Floats for presentation: V, C, %RH
+static inline float sensor_voltage_v(const sensor_data_t* data) {
+    return sensor_to_float(data->voltage, SENSOR_VOLTAGE_SCALE);
+}
+
+static inline float sensor_temperature_c(const sensor_data_t* data) {
+    return sensor_to_float(data->temperature, SENSOR_TEMPERATURE_SCALE);
+}
+
+static inline float sensor_humidity_pct(const sensor_data_t* data) {
+    return sensor_to_float(data->humidity, SENSOR_HUMIDITY_SCALE);
+}
+
+typedef struct sensor_driver sensor_driver_t;
+
+// Sensor driver interface. read() fills everything but the timestamp.
+// Self-paced drivers block in read() until their hardware has a sample
+// ready; otherwise the reader task paces reads with vTaskDelayUntil.
+typedef struct {
+    const char* name;
+    bool self_paced;
+    bool (*init)(sensor_driver_t* driver);
+    bool (*read)(sensor_driver_t* driver, sensor_data_t* data, TickType_t timeout);
+    void (*deinit)(sensor_driver_t* driver);
+} sensor_driver_ops_t;
+
+struct sensor_driver {
+    const sensor_driver_ops_t* ops;
+    void* context;
+};
+
+// rand()-based driver; context is a uint32_t sample counter
+void sensor_fake_driver_init(sensor_driver_t* driver, uint32_t* counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "sensor_driver.h"
+#include <stdlib.h>
+
+static bool fake_driver_init(sensor_driver_t* driver) {
+    *(uint32_t*)driver->context = 0;
+    return true;
+}
+
+static bool fake_driver_read(sensor_driver_t* driver, sensor_data_t* data, TickType_t timeout) {
+    // Generate fake sensor data
+    (*(uint32_t*)driver->context)++;
+    
+    // Generate somewhat realistic fake data with some variation
+    data->raw_value = 1000 + (rand() % 1000);
+    sensor_set_voltage_mv(data, 1500 + (rand() % 1000)); // 1.5-2.5V
+    sensor_set_temperature_cdeg(data, 2000 + (rand() % 200) * 10); // 20-40°C
+    sensor_set_humidity_cpct(data, 3000 + (rand() % 500) * 10); // 30-80% RH
+    return true;
+}
+
+static void fake_driver_deinit(sensor_driver_t* driver) {
+}
+
+static const sensor_driver_ops_t fake_driver_ops = {
+    "fake",
+    false,
+    fake_driver_init,
+    fake_driver_read,
+    fake_driver_deinit
+};
+
+void sensor_fake_driver_init(sensor_driver_t* driver, uint32_t* counter) {
+    driver->ops = &fake_driver_ops;
+    driver->context = counter;
+}
\ No newline at end of file
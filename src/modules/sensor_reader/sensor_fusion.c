@@ -0,0 +1,159 @@
+#include "sensor_fusion.h"
+#include <string.h>
+#ifdef SENSOR_FUSION_USE_ESP_DSP
+#include "dsps_add.h"
+#include "dsps_sub.h"
+#include "dsps_mul.h"
+#endif
+
+_Static_assert(SENSOR_FUSION_LANES == SENSOR_CHANNEL_COUNT, "one lane per channel");
+
+void sensor_fusion_init(sensor_fusion_bank_t* bank, const sensor_fusion_config_t* config) {
+    memset(bank, 0, sizeof(*bank));
+    for (int lane = 0; lane < SENSOR_FUSION_LANES; lane++) {
+        bank->q[lane] = config->process_noise[lane];
+        bank->r[lane] = config->measurement_noise[lane];
+    }
+}
+
+// One sample into lane order (sensor_channel_t)
+static void sensor_fusion_load(const sensor_data_t* sample, float* z) {
+    z[SENSOR_CHANNEL_TEMPERATURE] = sensor_temperature_c(sample);
+    z[SENSOR_CHANNEL_HUMIDITY] = sensor_humidity_pct(sample);
+    z[SENSOR_CHANNEL_VOLTAGE] = sensor_voltage_v(sample);
+    z[SENSOR_CHANNEL_RAW] = (float)sample->raw_value;
+}
+
+#ifdef SENSOR_FUSION_USE_ESP_DSP
+// x += gain * (z - x)
+static void sensor_fusion_correct(sensor_fusion_bank_t* bank, const float* z) {
+    float scratch[SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    
+    dsps_sub_f32(z, bank->x, scratch, SENSOR_FUSION_LANES, 1, 1, 1);
+    dsps_mul_f32(bank->gain, scratch, scratch, SENSOR_FUSION_LANES, 1, 1, 1);
+    dsps_add_f32(bank->x, scratch, bank->x, SENSOR_FUSION_LANES, 1, 1, 1);
+}
+
+// Returns true if no variance changed
+static bool sensor_fusion_predict(sensor_fusion_bank_t* bank) {
+    float p_pred[SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    float p_next[SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    
+    dsps_add_f32(bank->p, bank->q, p_pred, SENSOR_FUSION_LANES, 1, 1, 1);
+    dsps_add_f32(p_pred, bank->r, p_next, SENSOR_FUSION_LANES, 1, 1, 1);
+    for (int lane = 0; lane < SENSOR_FUSION_LANES; lane++) {
+        bank->gain[lane] = p_pred[lane] / p_next[lane]; // ESP-DSP has no vector divide
+    }
+    dsps_mul_f32(bank->gain, p_pred, p_next, SENSOR_FUSION_LANES, 1, 1, 1);
+    dsps_sub_f32(p_pred, p_next, p_next, SENSOR_FUSION_LANES, 1, 1, 1);
+    
+    bool unchanged = memcmp(p_next, bank->p, sizeof(p_next)) == 0;
+    memcpy(bank->p, p_next, sizeof(p_next));
+    return unchanged;
+}
+#else
+static void sensor_fusion_correct(sensor_fusion_bank_t* bank, const float* z) {
+    float* __restrict x = bank->x;
+    const float* __restrict gain = bank->gain;
+    
+    for (int lane = 0; lane < SENSOR_FUSION_LANES; lane++) {
+        x[lane] += gain[lane] * (z[lane] - x[lane]);
+    }
+}
+
+static bool sensor_fusion_predict(sensor_fusion_bank_t* bank) {
+    float* __restrict p = bank->p;
+    float* __restrict gain = bank->gain;
+    const float* __restrict q = bank->q;
+    const float* __restrict r = bank->r;
+    int changed = 0;
+    
+    for (int lane = 0; lane < SENSOR_FUSION_LANES; lane++) {
+        float p_pred = p[lane] + q[lane];
+        gain[lane] = p_pred / (p_pred + r[lane]);
+        float p_next = p_pred - gain[lane] * p_pred;
+        changed |= p_next != p[lane];
+        p[lane] = p_next;
+    }
+    return !changed;
+}
+#endif
+
+// Predict + update for every lane at once
+static void sensor_fusion_step(sensor_fusion_bank_t* bank, const float* z) {
+    if (!bank->steady) {
+        bank->steady = sensor_fusion_predict(bank);
+    }
+    sensor_fusion_correct(bank, z);
+}
+
+static void sensor_fusion_result(const sensor_fusion_bank_t* bank, const sensor_data_t* sample, sensor_fused_t* out) {
+    out->raw = *sample;
+    memcpy(out->estimate, bank->x, sizeof(out->estimate));
+    memcpy(out->variance, bank->p, sizeof(out->variance));
+    out->samples = bank->samples;
+}
+
+// Filter count samples in order. out, if not NULL, receives one result per
+// sample; the newest is also published for sensor_fusion_get().
+void sensor_fusion_process(sensor_fusion_bank_t* bank, const sensor_data_t* samples, size_t count,
+                           sensor_fused_t* out) {
+    if (!bank || !samples || count == 0) return;
+    
+    float z[SENSOR_FUSION_BLOCK][SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    
+    for (size_t start = 0; start < count; start += SENSOR_FUSION_BLOCK) {
+        size_t block = count - start < SENSOR_FUSION_BLOCK ? count - start : SENSOR_FUSION_BLOCK;
+        
+        // Transpose first, so the filter loop sees plain lane vectors
+        for (size_t i = 0; i < block; i++) {
+            sensor_fusion_load(&samples[start + i], z[i]);
+        }
+        
+        for (size_t i = 0; i < block; i++) {
+            if (bank->samples == 0) {
+                // The first reading is the best estimate there is
+                memcpy(bank->x, z[i], sizeof(bank->x));
+                memcpy(bank->p, bank->r, sizeof(bank->p));
+            } else {
+                sensor_fusion_step(bank, z[i]);
+            }
+            bank->samples++;
+            
+            if (out) {
+                sensor_fusion_result(bank, &samples[start + i], &out[start + i]);
+            }
+        }
+    }
+    
+    // Publish the newest result; same single-writer seqlock as sensor_reader
+    uint32_t seq = __atomic_load_n(&bank->latest_seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&bank->latest_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    sensor_fusion_result(bank, &samples[count - 1], &bank->latest);
+    
+    __atomic_store_n(&bank->latest_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Consistent copy of the newest result; false before the first sample
+bool sensor_fusion_get(sensor_fusion_bank_t* bank, sensor_fused_t* out) {
+    if (!bank || !out) return false;
+    
+    uint32_t seq_before;
+    uint32_t seq_after;
+    
+    do {
+        seq_before = __atomic_load_n(&bank->latest_seq, __ATOMIC_ACQUIRE);
+        if (seq_before & 1) {
+            continue; // Writer is mid-update
+        }
+        
+        *out = bank->latest;
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_after = __atomic_load_n(&bank->latest_seq, __ATOMIC_RELAXED);
+    } while ((seq_before & 1) || seq_before != seq_after);
+    
+    return out->samples > 0;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef SENSOR_FUSION_H
+#define SENSOR_FUSION_H
+
+#include "freertos/FreeRTOS.h"
+#include "sensor_driver.h"
+#include "sensor_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bank of 1-D Kalman filters, one lane per channel (random-walk model:
+// process noise q per step, measurement noise r). State is kept
+// structure-of-arrays: a batch of samples is first transposed into
+// per-step lane vectors, then each step runs the same branch-free loop
+// across all lanes, which the host compiler vectorises. Building with
+// -DSENSOR_FUSION_USE_ESP_DSP runs the lane arithmetic through ESP-DSP
+// instead (the esp-dsp component must be added to the build).
+//
+// Variance and gain do not depend on the readings. Once every lane's
+// variance reaches its fixed point, the bank switches to steady state:
+// the cached gains are reused, with bit-identical results, and each step
+// is a multiply-add per lane instead of a chain through a divide.
+//
+// Values are in the sensor_stats units: C, %RH, V and raw counts.
+// One writer calls sensor_fusion_process(); any task may read the latest
+// estimate with sensor_fusion_get().
+
+#define SENSOR_FUSION_LANES SENSOR_CHANNEL_COUNT
+
+// Samples transposed per pass
+#define SENSOR_FUSION_BLOCK 16
+
+typedef struct {
+    float process_noise[SENSOR_CHANNEL_COUNT];     // q: variance the true value drifts per sample
+    float measurement_noise[SENSOR_CHANNEL_COUNT]; // r: variance of one reading
+} sensor_fusion_config_t;
+
+// Temperature, humidity, voltage, raw
+#define SENSOR_FUSION_DEFAULT_CONFIG { { 1e-4f, 1e-2f, 1e-6f, 1.0f }, { 4e-2f, 1.0f, 1e-4f, 100.0f } }
+
+typedef struct {
+    sensor_data_t raw;                    // The sample as read
+    float estimate[SENSOR_CHANNEL_COUNT]; // Filtered value
+    float variance[SENSOR_CHANNEL_COUNT]; // Of the estimate
+    uint32_t samples;                     // Since sensor_fusion_init()
+} sensor_fused_t;
+
+typedef struct {
+    float x[SENSOR_FUSION_LANES] __attribute__((aligned(16))); // Estimates
+    float p[SENSOR_FUSION_LANES] __attribute__((aligned(16))); // Variances
+    float q[SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    float r[SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    float gain[SENSOR_FUSION_LANES] __attribute__((aligned(16)));
+    bool steady; // Variances stopped changing; gain is final
+    uint32_t samples;
+    // Seqlock-protected copy of the newest result for readers
+    sensor_fused_t latest;
+    volatile uint32_t latest_seq;
+} sensor_fusion_bank_t;
+
+void sensor_fusion_init(sensor_fusion_bank_t* bank, const sensor_fusion_config_t* config);
+void sensor_fusion_process(sensor_fusion_bank_t* bank, const sensor_data_t* samples, size_t count,
+                           sensor_fused_t* out);
+bool sensor_fusion_get(sensor_fusion_bank_t* bank, sensor_fused_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,61 +1,214 @@
 #include "sensor_reader.h"
+#include "../system_metrics/system_metrics.h"
+#include "../message_bus/message_bus.h"
+#include "../trace_recorder/trace_recorder.h"
 #include <stdlib.h>
 
 static const char* TAG = "SensorReader";
 
+_Static_assert((SENSOR_READER_HISTORY_CAPACITY & (SENSOR_READER_HISTORY_CAPACITY - 1)) == 0,
+               "SENSOR_READER_HISTORY_CAPACITY must be a power of two");
+
+#define HISTORY_MASK (SENSOR_READER_HISTORY_CAPACITY - 1)
+
+// Single-writer seqlock around latest_data. Only the reader's task or
+// scheduler job writes, so the writer never blocks; readers retry if they
+// overlap an update.
+static void sensor_reader_publish(sensor_reader_t* reader, const sensor_data_t* data) {
+    uint32_t seq = __atomic_load_n(&reader->latest_seq, __ATOMIC_RELAXED);
+    
+    __atomic_store_n(&reader->latest_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    reader->latest_data = *data;
+    
+    __atomic_store_n(&reader->latest_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Append to the history ring. When the consumer falls behind the newest
+// sample is dropped so entries it has not drained yet stay intact.
+static void sensor_reader_push_history(sensor_reader_t* reader, const sensor_data_t* data) {
+    uint32_t head = reader->history_head;
+    uint32_t tail = __atomic_load_n(&reader->history_tail, __ATOMIC_ACQUIRE);
+    
+    if (head - tail >= SENSOR_READER_HISTORY_CAPACITY) {
+        __atomic_fetch_add(&reader->history_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    reader->history[head & HISTORY_MASK] = *data;
+    __atomic_store_n(&reader->history_head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Hand a sample to every consumer: history ring, event bit, message bus
+// and telemetry stream
+static void sensor_reader_emit(sensor_reader_t* reader, const sensor_data_t* sample, int metrics) {
+    sensor_reader_push_history(reader, sample);
+    
+    // Notify new data available
+    xEventGroupSetBits(reader->event_group, SENSOR_EVENT_NEW_DATA);
+    system_metrics_event(metrics, 1);
+    
+    message_t message;
+    message.topic = MESSAGE_TOPIC_SENSOR_SAMPLE;
+    message.sample = *sample;
+    message_bus_publish(&message);
+    
+    // Binary record for the telemetry stream; text only at debug level
+    telemetry_log_write_sample(reader->telemetry, sample);
+    
+    ESP_LOGD(TAG, "Sensor Data - Raw: %lu, Temp: %.1fC, Hum: %.1f%%, Volt: %.2fV", 
+             (unsigned long)sample->raw_value, 
+             sensor_temperature_c(sample),
+             sensor_humidity_pct(sample),
+             sensor_voltage_v(sample));
+}
+
+// Fresh adaptive state for a start; returns the first sampling interval
+static TickType_t sensor_reader_first_period(sensor_reader_t* reader) {
+    if (!reader->adaptive_enabled) return reader->task_config.period;
+    
+    // Every start begins at min_period with fresh counters
+    sensor_adaptive_config_t adaptive_config = reader->adaptive.config;
+    sensor_adaptive_init(&reader->adaptive, &adaptive_config);
+    return sensor_adaptive_period(&reader->adaptive);
+}
+
+// One read and, if the driver had a sample, everything that follows it.
+// Returns the interval to the next read.
+static TickType_t sensor_reader_sample(sensor_reader_t* reader, TickType_t period, int metrics) {
+    sensor_driver_t* driver = reader->driver;
+    sensor_data_t sample;
+    
+    TRACE_SPAN_BEGIN(TRACE_SPAN_SENSOR_READ);
+    bool sampled = driver->ops->read(driver, &sample, period);
+    TRACE_SPAN_END(TRACE_SPAN_SENSOR_READ);
+    
+    if (!sampled) return period;
+    
+    TRACE_SPAN_BEGIN(TRACE_SPAN_SENSOR_PROCESS);
+    sample.timestamp = xTaskGetTickCount();
+    
+    // The snapshot is always current; it is polled, so updating it wakes nobody
+    sensor_reader_publish(reader, &sample);
+    
+    // Statistics see every sample, including ones adaptive mode suppresses
+    if (reader->stats && sensor_stats_update(reader->stats, &sample)) {
+        xEventGroupSetBits(reader->event_group, SENSOR_EVENT_ANOMALY);
+    }
+    
+    // Filtered estimates, read next to the raw sample with sensor_fusion_get()
+    if (reader->fusion) {
+        sensor_fusion_process(reader->fusion, &sample, 1, NULL);
+    }
+    
+    bool emit = true;
+    if (reader->adaptive_enabled) {
+        // Unchanged samples are suppressed so consumers stay asleep
+        emit = sensor_adaptive_update(&reader->adaptive, &sample);
+        period = sensor_adaptive_period(&reader->adaptive);
+    }
+    
+    if (emit) {
+        sensor_reader_emit(reader, &sample, metrics);
+    }
+    TRACE_SPAN_END(TRACE_SPAN_SENSOR_PROCESS);
+    return period;
+}
+
+// Scheduler job: one sample per deadline. Metrics belong to the scheduler
+// task, which counts the run.
+static TickType_t sensor_reader_job(void* context) {
+    sensor_reader_t* reader = (sensor_reader_t*)context;
+    
+    reader->job_period = sensor_reader_sample(reader, reader->job_period, SYSTEM_METRICS_INVALID_SLOT);
+    return reader->job_period;
+}
+
 static void sensor_reader_task(void* arg) {
     sensor_reader_t* reader = (sensor_reader_t*)arg;
     
     ESP_LOGI(TAG, "Sensor reader task started");
     
+    sensor_driver_t* driver = reader->driver;
+    if (!driver->ops->init(driver)) {
+        ESP_LOGE(TAG, "Sensor driver '%s' failed to initialize", driver->ops->name);
+        reader->task_running = false;
+    }
+    
     TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t frequency = pdMS_TO_TICKS(2000); // 2 second interval
+    const TickType_t frequency = reader->task_config.period;
+    
+    // A varying period would show up as jitter, so adaptive mode is not checked against one
+    bool fixed_rate = !driver->ops->self_paced && !reader->adaptive_enabled;
+    int metrics = system_metrics_register("sensor_reader", fixed_rate ? frequency : 0);
+    
+    TickType_t period = sensor_reader_first_period(reader);
     
     while (reader->task_running) {
-        // Generate fake sensor data
-        reader->fake_sensor_counter++;
-        
-        reader->latest_data.timestamp = xTaskGetTickCount();
+        system_metrics_wake(metrics);
         
-        // Generate somewhat realistic fake data with some variation
-        reader->latest_data.raw_value = 1000 + (rand() % 1000);
-        reader->latest_data.voltage = 1.5f + ((rand() % 1000) / 1000.0f); // 1.5-2.5V
-        reader->latest_data.temperature = 20.0f + ((rand() % 200) / 10.0f); // 20-40°C
-        reader->latest_data.humidity = 30.0f + ((rand() % 500) / 10.0f); // 30-80% RH
+        period = sensor_reader_sample(reader, period, metrics);
         
-        // Notify new data available
-        xEventGroupSetBits(reader->event_group, SENSOR_EVENT_NEW_DATA);
-        
-        ESP_LOGI(TAG, "Sensor Data - Raw: %lu, Temp: %.1fC, Hum: %.1f%%, Volt: %.2fV", 
-                 reader->latest_data.raw_value, 
-                 reader->latest_data.temperature,
-                 reader->latest_data.humidity,
-                 reader->latest_data.voltage);
-        
-        vTaskDelayUntil(&last_wake_time, frequency);
+        // Self-paced drivers already blocked until their data was ready.
+        // Otherwise block until the next deadline, or a stop request; the
+        // longer the period, the longer tickless idle can keep the chip in
+        // light sleep.
+        if (!driver->ops->self_paced) {
+            task_lifecycle_wait_until(reader->event_group, &last_wake_time, period);
+        }
     }
     
+    driver->ops->deinit(driver);
+    system_metrics_unregister(metrics);
     ESP_LOGI(TAG, "Sensor reader task exiting");
-    vTaskDelete(NULL);
+    task_lifecycle_exit(reader->event_group);
 }
 
-sensor_reader_t* sensor_reader_create() {
-    sensor_reader_t* reader = (sensor_reader_t*)malloc(sizeof(sensor_reader_t));
-    if (!reader) {
-        ESP_LOGE(TAG, "Failed to allocate sensor reader");
-        return NULL;
-    }
-    
+static void sensor_reader_init(sensor_reader_t* reader, TickType_t period) {
     reader->task_handle = NULL;
     reader->task_running = false;
     reader->fake_sensor_counter = 0;
+    sensor_fake_driver_init(&reader->fake_driver, &reader->fake_sensor_counter);
+    reader->driver = &reader->fake_driver;
+    reader->telemetry = NULL;
+    reader->stats = NULL;
+    reader->fusion = NULL;
+    reader->adaptive_enabled = false;
+    sensor_adaptive_config_t adaptive_config = SENSOR_ADAPTIVE_DEFAULT_CONFIG;
+    sensor_adaptive_init(&reader->adaptive, &adaptive_config);
     
     // Initialize with default data
     reader->latest_data.raw_value = 0;
-    reader->latest_data.voltage = 0.0f;
-    reader->latest_data.temperature = 0.0f;
-    reader->latest_data.humidity = 0.0f;
+    sensor_set_voltage_mv(&reader->latest_data, 0);
+    sensor_set_temperature_cdeg(&reader->latest_data, 0);
+    sensor_set_humidity_cpct(&reader->latest_data, 0);
     reader->latest_data.timestamp = 0;
+    reader->latest_seq = 0;
+    reader->history_head = 0;
+    reader->history_tail = 0;
+    reader->history_dropped = 0;
+    task_config_t task_config = SENSOR_READER_DEFAULT_TASK_CONFIG;
+    if (period != 0) {
+        task_config.period = period;
+    }
+    reader->task_config = task_config;
+    reader->scheduler = NULL;
+    reader->job.scheduler = NULL;
+    reader->job_period = 0;
+    reader->scheduled = false;
+    reader->task_buffer = NULL;
+    reader->task_stack = NULL;
+}
+
+sensor_reader_t* sensor_reader_create(TickType_t period) {
+    sensor_reader_t* reader = (sensor_reader_t*)malloc(sizeof(sensor_reader_t));
+    if (!reader) {
+        ESP_LOGE(TAG, "Failed to allocate sensor reader");
+        return NULL;
+    }
+    
+    sensor_reader_init(reader, period);
     
     // Create event group
     reader->event_group = xEventGroupCreate();
@@ -69,6 +222,21 @@ sensor_reader_t* sensor_reader_create() {
     return reader;
 }
 
+// Same as sensor_reader_create(), but the reader, its event group and its
+// task live in storage and nothing is taken from the heap
+sensor_reader_t* sensor_reader_create_static(sensor_reader_storage_t* storage, TickType_t period) {
+    if (!storage) return NULL;
+    
+    sensor_reader_t* reader = &storage->reader;
+    sensor_reader_init(reader, period);
+    reader->task_buffer = &storage->task;
+    reader->task_stack = storage->stack;
+    reader->event_group = xEventGroupCreateStatic(&storage->event_group);
+    
+    ESP_LOGI(TAG, "Sensor reader created (static)");
+    return reader;
+}
+
 void sensor_reader_destroy(sensor_reader_t* reader) {
     if (!reader) return;
     
@@ -78,52 +246,262 @@ void sensor_reader_destroy(sensor_reader_t* reader) {
         vEventGroupDelete(reader->event_group);
     }
     
-    free(reader);
+    if (!reader->task_buffer) {
+        free(reader);
+    }
     ESP_LOGI(TAG, "Sensor reader destroyed");
 }
 
 bool sensor_reader_get_latest_data(sensor_reader_t* reader, sensor_data_t* data) {
     if (!reader || !data) return false;
     
-    *data = reader->latest_data;
+    uint32_t seq_before;
+    uint32_t seq_after;
+    
+    do {
+        seq_before = __atomic_load_n(&reader->latest_seq, __ATOMIC_ACQUIRE);
+        if (seq_before & 1) {
+            continue; // Writer is mid-update
+        }
+        
+        *data = reader->latest_data;
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_after = __atomic_load_n(&reader->latest_seq, __ATOMIC_RELAXED);
+    } while ((seq_before & 1) || seq_before != seq_after);
+    
+    return true;
+}
+
+uint32_t sensor_reader_get_snapshot_seq(sensor_reader_t* reader) {
+    if (!reader) return 0;
+    
+    // Even values only; changes whenever a new sample has been published
+    return __atomic_load_n(&reader->latest_seq, __ATOMIC_ACQUIRE) & ~1u;
+}
+
+size_t sensor_reader_drain(sensor_reader_t* reader, sensor_data_t* out, size_t max) {
+    if (!reader || !out) return 0;
+    
+    // Single consumer: only the draining caller advances history_tail
+    uint32_t tail = reader->history_tail;
+    uint32_t head = __atomic_load_n(&reader->history_head, __ATOMIC_ACQUIRE);
+    size_t count = head - tail;
+    
+    if (count > max) {
+        count = max;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        out[i] = reader->history[(tail + i) & HISTORY_MASK];
+    }
+    
+    __atomic_store_n(&reader->history_tail, tail + (uint32_t)count, __ATOMIC_RELEASE);
+    return count;
+}
+
+bool sensor_reader_get_history_stats(sensor_reader_t* reader, sensor_history_stats_t* stats) {
+    if (!reader || !stats) return false;
+    
+    uint32_t head = __atomic_load_n(&reader->history_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&reader->history_tail, __ATOMIC_ACQUIRE);
+    
+    stats->pushed = head;
+    stats->dropped = __atomic_load_n(&reader->history_dropped, __ATOMIC_RELAXED);
+    stats->pending = head - tail;
+    stats->capacity = SENSOR_READER_HISTORY_CAPACITY;
     return true;
 }
 
+bool sensor_reader_set_driver(sensor_reader_t* reader, sensor_driver_t* driver) {
+    // The driver can only be swapped while the task is not using it
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    reader->driver = driver ? driver : &reader->fake_driver;
+    return true;
+}
+
+bool sensor_reader_attach_telemetry(sensor_reader_t* reader, telemetry_log_t* telemetry) {
+    // Written only while stopped so the task sees a stable pointer
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    reader->telemetry = telemetry;
+    return true;
+}
+
+// stats must be initialised with sensor_stats_init(); the reader task
+// becomes its only writer
+bool sensor_reader_attach_stats(sensor_reader_t* reader, sensor_stats_engine_t* stats) {
+    // Written only while stopped so the task sees a stable pointer
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    reader->stats = stats;
+    return true;
+}
+
+// fusion must be initialised with sensor_fusion_init(); the reader task
+// becomes its only writer
+bool sensor_reader_attach_fusion(sensor_reader_t* reader, sensor_fusion_bank_t* fusion) {
+    // Written only while stopped so the task sees a stable pointer
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    reader->fusion = fusion;
+    return true;
+}
+
+// Adaptive sampling replaces the fixed task period: it runs between
+// config->min_period and max_period and suppresses unchanged samples.
+// NULL restores fixed-rate sampling. Only while stopped.
+bool sensor_reader_set_adaptive(sensor_reader_t* reader, const sensor_adaptive_config_t* config) {
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    reader->adaptive_enabled = config != NULL;
+    if (config) {
+        sensor_adaptive_init(&reader->adaptive, config);
+    }
+    return true;
+}
+
+bool sensor_reader_get_adaptive_stats(sensor_reader_t* reader, sensor_adaptive_stats_t* stats) {
+    if (!reader || !stats || !reader->adaptive_enabled) return false;
+    
+    // Single 32-bit fields written by the task; each read is atomic
+    stats->taken = reader->adaptive.taken;
+    stats->emitted = reader->adaptive.emitted;
+    stats->period = reader->adaptive.period;
+    return true;
+}
+
+// Sample as a job of scheduler instead of in a task of the reader's own;
+// many readers can share one scheduler. NULL goes back to the own task.
+// Self-paced drivers block in read() and need their own task. Only while
+// stopped.
+bool sensor_reader_attach_scheduler(sensor_reader_t* reader, periodic_scheduler_t* scheduler) {
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    reader->scheduler = scheduler;
+    return true;
+}
+
+// Run count, lateness and jitter of the reader's scheduler job; false with
+// no scheduler attached
+bool sensor_reader_get_job_stats(sensor_reader_t* reader, periodic_job_stats_t* stats) {
+    if (!reader || !reader->scheduler) {
+        return false;
+    }
+    
+    return periodic_scheduler_get_job_stats(reader->scheduler, &reader->job, stats);
+}
+
+// Stack size, priority, core and period used by the next sensor_reader_start().
+// With a scheduler attached only the period applies.
+// Statically allocated readers cannot grow their stack beyond SENSOR_READER_STACK_SIZE.
+bool sensor_reader_configure_task(sensor_reader_t* reader, const task_config_t* config) {
+    if (!reader || reader->task_running) {
+        return false;
+    }
+    
+    // The reader is periodic, so it needs a non-zero period
+    if (!task_config_valid(config, reader->task_buffer ? SENSOR_READER_STACK_SIZE : 0) || config->period == 0) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    reader->task_config = *config;
+    return true;
+}
+
+// No task to initialize the driver in, so the caller does
+static bool sensor_reader_start_job(sensor_reader_t* reader) {
+    sensor_driver_t* driver = reader->driver;
+    
+    if (driver->ops->self_paced) {
+        ESP_LOGE(TAG, "Sensor driver '%s' is self-paced and needs the reader's own task", driver->ops->name);
+        return false;
+    }
+    
+    if (!driver->ops->init(driver)) {
+        ESP_LOGE(TAG, "Sensor driver '%s' failed to initialize", driver->ops->name);
+        driver->ops->deinit(driver);
+        return false;
+    }
+    
+    reader->job_period = sensor_reader_first_period(reader);
+    reader->task_running = true;
+    
+    if (periodic_scheduler_add(reader->scheduler, &reader->job, sensor_reader_job, reader, 0)) {
+        reader->scheduled = true;
+        ESP_LOGI(TAG, "Sensor reader scheduled every %lu ms", (unsigned long)(reader->job_period * portTICK_PERIOD_MS));
+        return true;
+    }
+    
+    reader->task_running = false;
+    driver->ops->deinit(driver);
+    ESP_LOGE(TAG, "Failed to schedule sensor reader");
+    return false;
+}
+
 bool sensor_reader_start(sensor_reader_t* reader) {
     if (!reader || reader->task_running) {
         return false;
     }
     
-    BaseType_t result = xTaskCreate(
-        sensor_reader_task,
-        "sensor_reader",
-        4096,
-        reader,
-        6,  // Higher priority than WiFi
-        &reader->task_handle
-    );
+    // Reap a task that exited on its own after a driver init failure
+    task_lifecycle_stop(reader->event_group, &reader->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT);
     
-    if (result == pdPASS) {
-        reader->task_running = true;
+    if (reader->scheduler) {
+        return sensor_reader_start_job(reader);
+    }
+    
+    // Set before creating the task: a higher-priority task runs immediately
+    // and would otherwise see task_running == false and exit
+    reader->task_running = true;
+    
+    if (task_config_create(sensor_reader_task, "sensor_reader", &reader->task_config, reader,
+                           reader->task_buffer, reader->task_stack, &reader->task_handle)) {
         ESP_LOGI(TAG, "Sensor reader task started successfully");
         return true;
     }
     
+    reader->task_running = false;
     ESP_LOGE(TAG, "Failed to start sensor reader task");
     return false;
 }
 
 void sensor_reader_stop(sensor_reader_t* reader) {
-    if (!reader || !reader->task_running) {
+    if (!reader) return;
+    
+    if (reader->scheduled) {
+        // Waits for a sample in progress, so the driver is idle after it
+        periodic_scheduler_remove(reader->scheduler, &reader->job);
+        reader->driver->ops->deinit(reader->driver);
+        reader->scheduled = false;
+        reader->task_running = false;
+        ESP_LOGI(TAG, "Sensor reader stopped");
         return;
     }
     
-    reader->task_running = false;
+    // Keyed on the handle: the task clears task_running itself if the
+    // driver fails to initialize, and still has to be joined
+    if (!reader->task_handle) {
+        return;
+    }
     
-    if (reader->task_handle) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        vTaskDelete(reader->task_handle);
-        reader->task_handle = NULL;
+    reader->task_running = false;
+    if (!task_lifecycle_stop(reader->event_group, &reader->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "Sensor reader task did not exit in time, deleted");
     }
     
     ESP_LOGI(TAG, "Sensor reader stopped");
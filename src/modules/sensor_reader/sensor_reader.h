@@ -5,33 +5,102 @@
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "esp_log.h"
+#include "sensor_driver.h"
+#include "sensor_adaptive.h"
+#include "sensor_stats.h"
+#include "sensor_fusion.h"
+#include "../telemetry_log/telemetry_log.h"
+#include "../periodic_scheduler/periodic_scheduler.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Number of samples buffered for sensor_reader_drain(); must be a power of two
+#ifndef SENSOR_READER_HISTORY_CAPACITY
+#define SENSOR_READER_HISTORY_CAPACITY 16
+#endif
+
+#define SENSOR_READER_STACK_SIZE 4096
+// Sampling interval when sensor_reader_create() is given 0
+#define SENSOR_READER_DEFAULT_PERIOD pdMS_TO_TICKS(2000)
+// Highest module priority; period is the sampling interval
+#define SENSOR_READER_DEFAULT_TASK_CONFIG { SENSOR_READER_STACK_SIZE, 6, tskNO_AFFINITY, SENSOR_READER_DEFAULT_PERIOD }
+
 typedef struct {
-    uint32_t raw_value;
-    float voltage;
-    float temperature;
-    float humidity;
-    TickType_t timestamp;
-} sensor_data_t;
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t pending;
+    uint32_t capacity;
+} sensor_history_stats_t;
 
 typedef struct {
+    // Seqlock-protected snapshot: odd while the task is mid-update,
+    // incremented twice per published sample.
     sensor_data_t latest_data;
+    volatile uint32_t latest_seq;
+    // SPSC ring: the task advances history_head, the draining consumer
+    // advances history_tail. Indices are free-running.
+    sensor_data_t history[SENSOR_READER_HISTORY_CAPACITY];
+    volatile uint32_t history_head;
+    volatile uint32_t history_tail;
+    volatile uint32_t history_dropped;
     TaskHandle_t task_handle;
     EventGroupHandle_t event_group;
     bool task_running;
+    sensor_driver_t* driver;
+    sensor_driver_t fake_driver;
     uint32_t fake_sensor_counter;
+    telemetry_log_t* telemetry;
+    sensor_stats_engine_t* stats;
+    sensor_fusion_bank_t* fusion;
+    // Task-owned once started; see sensor_reader_set_adaptive()
+    sensor_adaptive_t adaptive;
+    bool adaptive_enabled;
+    task_config_t task_config;
+    // With a scheduler attached the reader runs as its job instead of in
+    // its own task; see sensor_reader_attach_scheduler()
+    periodic_scheduler_t* scheduler;
+    periodic_job_t job;
+    TickType_t job_period; // Job-owned once started
+    bool scheduled;
+    // Set by sensor_reader_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
 } sensor_reader_t;
 
+// Caller-provided storage for sensor_reader_create_static(); must outlive
+// the reader
+typedef struct {
+    sensor_reader_t reader;
+    StaticEventGroup_t event_group;
+    StaticTask_t task;
+    StackType_t stack[SENSOR_READER_STACK_SIZE];
+} sensor_reader_storage_t;
+
 // Events
 #define SENSOR_EVENT_NEW_DATA (1 << 0)
+#define SENSOR_EVENT_ANOMALY (1 << 1) // See sensor_stats_get() for which channels
 
-sensor_reader_t* sensor_reader_create();
+// period is the sampling interval in ticks; 0 for SENSOR_READER_DEFAULT_PERIOD
+sensor_reader_t* sensor_reader_create(TickType_t period);
+sensor_reader_t* sensor_reader_create_static(sensor_reader_storage_t* storage, TickType_t period);
 void sensor_reader_destroy(sensor_reader_t* reader);
 bool sensor_reader_get_latest_data(sensor_reader_t* reader, sensor_data_t* data);
+uint32_t sensor_reader_get_snapshot_seq(sensor_reader_t* reader);
+size_t sensor_reader_drain(sensor_reader_t* reader, sensor_data_t* out, size_t max);
+bool sensor_reader_get_history_stats(sensor_reader_t* reader, sensor_history_stats_t* stats);
+bool sensor_reader_set_driver(sensor_reader_t* reader, sensor_driver_t* driver);
+bool sensor_reader_attach_telemetry(sensor_reader_t* reader, telemetry_log_t* telemetry);
+bool sensor_reader_attach_stats(sensor_reader_t* reader, sensor_stats_engine_t* stats);
+bool sensor_reader_attach_fusion(sensor_reader_t* reader, sensor_fusion_bank_t* fusion);
+bool sensor_reader_set_adaptive(sensor_reader_t* reader, const sensor_adaptive_config_t* config);
+bool sensor_reader_get_adaptive_stats(sensor_reader_t* reader, sensor_adaptive_stats_t* stats);
+bool sensor_reader_attach_scheduler(sensor_reader_t* reader, periodic_scheduler_t* scheduler);
+bool sensor_reader_get_job_stats(sensor_reader_t* reader, periodic_job_stats_t* stats);
+bool sensor_reader_configure_task(sensor_reader_t* reader, const task_config_t* config);
 bool sensor_reader_start(sensor_reader_t* reader);
 void sensor_reader_stop(sensor_reader_t* reader);
 
@@ -0,0 +1,171 @@
+#include "sensor_stats.h"
+#include <math.h>
+#include <string.h>
+
+void sensor_stats_init(sensor_stats_engine_t* stats, const sensor_stats_config_t* config) {
+    memset(stats, 0, sizeof(*stats));
+    stats->config = *config;
+    
+    if (stats->config.window < 2) {
+        stats->config.window = 2;
+    }
+    if (stats->config.window > SENSOR_STATS_MAX_WINDOW) {
+        stats->config.window = SENSOR_STATS_MAX_WINDOW;
+    }
+}
+
+static bool sensor_stats_anomalous(const sensor_stats_engine_t* stats, sensor_channel_t channel,
+                                   float value, uint32_t fill) {
+    const sensor_stats_limits_t* limits = &stats->config.limits[channel];
+    const sensor_channel_state_t* state = &stats->channel[channel];
+    
+    if (limits->low < limits->high && (value < limits->low || value > limits->high)) {
+        return true;
+    }
+    
+    // z-score against the window before this sample, once the window is full
+    if (stats->config.z_threshold > 0.0f && fill == stats->config.window) {
+        float stddev = sqrtf(state->m2 / (float)(fill - 1));
+        return stddev > 0.0f && fabsf(value - state->mean) > stats->config.z_threshold * stddev;
+    }
+    return false;
+}
+
+static void sensor_stats_add(sensor_stats_engine_t* stats, sensor_channel_state_t* state, float value) {
+    const uint32_t window = stats->config.window;
+    const uint32_t n = stats->samples;
+    const uint32_t slot = n % window;
+    
+    // Windowed Welford: add, and once full also remove the sample leaving
+    if (n < window) {
+        float delta = value - state->mean;
+        state->mean += delta / (float)(n + 1);
+        state->m2 += delta * (value - state->mean);
+    } else {
+        float old = state->values[slot];
+        float old_mean = state->mean;
+        state->mean += (value - old) / (float)window;
+        state->m2 += (value - old) * (value - state->mean + old - old_mean);
+        if (state->m2 < 0.0f) {
+            state->m2 = 0.0f; // Rounding
+        }
+    }
+    
+    // Drop deque entries that left the window before their ring slots are reused
+    if (state->min_head != state->min_tail && state->min_deque[state->min_head % window] + window <= n) {
+        state->min_head++;
+    }
+    if (state->max_head != state->max_tail && state->max_deque[state->max_head % window] + window <= n) {
+        state->max_head++;
+    }
+    
+    // Entries the new sample dominates can never be the min/max again
+    while (state->min_tail != state->min_head &&
+           state->values[state->min_deque[(state->min_tail - 1) % window] % window] >= value) {
+        state->min_tail--;
+    }
+    state->min_deque[state->min_tail++ % window] = n;
+    
+    while (state->max_tail != state->max_head &&
+           state->values[state->max_deque[(state->max_tail - 1) % window] % window] <= value) {
+        state->max_tail--;
+    }
+    state->max_deque[state->max_tail++ % window] = n;
+    
+    state->values[slot] = value;
+    
+    // Sliding updates accumulate float rounding; recompute exactly once per
+    // pass over the ring, which keeps the amortised cost O(1)
+    if (slot == window - 1) {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < window; i++) {
+            sum += state->values[i];
+        }
+        state->mean = sum / (float)window;
+        state->m2 = 0.0f;
+        for (uint32_t i = 0; i < window; i++) {
+            float delta = state->values[i] - state->mean;
+            state->m2 += delta * delta;
+        }
+    }
+    state->ewma = (n == 0) ? value : state->ewma + stats->config.ewma_alpha * (value - state->ewma);
+}
+
+static void sensor_stats_summarise(const sensor_stats_engine_t* stats, sensor_channel_t channel,
+                                   uint32_t fill, sensor_channel_summary_t* summary) {
+    const uint32_t window = stats->config.window;
+    const sensor_channel_state_t* state = &stats->channel[channel];
+    
+    summary->last = state->values[(stats->samples - 1) % window];
+    summary->mean = state->mean;
+    summary->stddev = fill > 1 ? sqrtf(state->m2 / (float)(fill - 1)) : 0.0f;
+    summary->min = state->values[state->min_deque[state->min_head % window] % window];
+    summary->max = state->values[state->max_deque[state->max_head % window] % window];
+    summary->ewma = state->ewma;
+}
+
+// Feed one sample. Returns the SENSOR_CHANNEL_BIT()s it was anomalous on.
+uint8_t sensor_stats_update(sensor_stats_engine_t* stats, const sensor_data_t* sample) {
+    const float values[SENSOR_CHANNEL_COUNT] = {
+        sensor_temperature_c(sample),
+        sensor_humidity_pct(sample),
+        sensor_voltage_v(sample),
+        (float)sample->raw_value
+    };
+    uint32_t fill = stats->samples < stats->config.window ? stats->samples : stats->config.window;
+    uint8_t anomalies = 0;
+    
+    for (int channel = 0; channel < SENSOR_CHANNEL_COUNT; channel++) {
+        if (sensor_stats_anomalous(stats, (sensor_channel_t)channel, values[channel], fill)) {
+            anomalies |= SENSOR_CHANNEL_BIT(channel);
+        }
+        sensor_stats_add(stats, &stats->channel[channel], values[channel]);
+    }
+    
+    stats->samples++;
+    if (anomalies) {
+        stats->anomalies++;
+    }
+    if (fill < stats->config.window) {
+        fill++;
+    }
+    
+    // Publish the summary; same single-writer seqlock as sensor_reader
+    uint32_t seq = __atomic_load_n(&stats->summary_seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->summary_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    stats->summary.samples = stats->samples;
+    stats->summary.window_fill = (uint16_t)fill;
+    stats->summary.anomaly_channels = anomalies;
+    stats->summary.anomalies = stats->anomalies;
+    stats->summary.timestamp = sample->timestamp;
+    for (int channel = 0; channel < SENSOR_CHANNEL_COUNT; channel++) {
+        sensor_stats_summarise(stats, (sensor_channel_t)channel, fill, &stats->summary.channel[channel]);
+    }
+    
+    __atomic_store_n(&stats->summary_seq, seq + 2, __ATOMIC_RELEASE);
+    return anomalies;
+}
+
+// Consistent copy of the latest summary; false before the first sample
+bool sensor_stats_get(sensor_stats_engine_t* stats, sensor_stats_t* out) {
+    if (!stats || !out) return false;
+    
+    uint32_t seq_before;
+    uint32_t seq_after;
+    
+    do {
+        seq_before = __atomic_load_n(&stats->summary_seq, __ATOMIC_ACQUIRE);
+        if (seq_before & 1) {
+            continue; // Writer is mid-update
+        }
+        
+        *out = stats->summary;
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_after = __atomic_load_n(&stats->summary_seq, __ATOMIC_RELAXED);
+    } while ((seq_before & 1) || seq_before != seq_after);
+    
+    return out->samples > 0;
+}
\ No newline at end of file
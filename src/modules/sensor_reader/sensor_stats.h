@@ -0,0 +1,95 @@
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include "freertos/FreeRTOS.h"
+#include "sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Incremental per-channel statistics over a sliding window of the last
+// `window` samples, O(1) amortised per sample: windowed Welford
+// mean/variance, monotonic-deque min/max and an EWMA. Each update also
+// checks the sample against fixed limits and a z-score threshold.
+//
+// One writer (the sensor reader task) calls sensor_stats_update(); any
+// task may read a consistent summary with sensor_stats_get().
+
+#ifndef SENSOR_STATS_MAX_WINDOW
+#define SENSOR_STATS_MAX_WINDOW 64
+#endif
+
+typedef enum {
+    SENSOR_CHANNEL_TEMPERATURE = 0,
+    SENSOR_CHANNEL_HUMIDITY,
+    SENSOR_CHANNEL_VOLTAGE,
+    SENSOR_CHANNEL_RAW,
+    SENSOR_CHANNEL_COUNT
+} sensor_channel_t;
+
+#define SENSOR_CHANNEL_BIT(channel) (1u << (channel))
+
+typedef struct {
+    float low;  // Anomalous outside [low, high]; low >= high disables
+    float high;
+} sensor_stats_limits_t;
+
+typedef struct {
+    uint16_t window;       // Samples, 2..SENSOR_STATS_MAX_WINDOW
+    float ewma_alpha;      // Weight of the newest sample, 0..1
+    float z_threshold;     // Anomalous beyond this many stddevs; 0 disables
+    sensor_stats_limits_t limits[SENSOR_CHANNEL_COUNT];
+} sensor_stats_config_t;
+
+#define SENSOR_STATS_DEFAULT_CONFIG { 30, 0.1f, 4.0f, { { -10.0f, 60.0f }, { 0.0f, 100.0f }, { 1.0f, 3.0f }, { 0.0f, 0.0f } } }
+
+typedef struct {
+    float last;
+    float mean;
+    float stddev;
+    float min;
+    float max;
+    float ewma;
+} sensor_channel_summary_t;
+
+typedef struct {
+    uint32_t samples;         // Since sensor_stats_init()
+    uint16_t window_fill;     // Samples currently in the window
+    uint8_t anomaly_channels; // SENSOR_CHANNEL_BIT()s flagged by the last sample
+    uint32_t anomalies;       // Samples with any flagged channel
+    TickType_t timestamp;     // Of the last sample
+    sensor_channel_summary_t channel[SENSOR_CHANNEL_COUNT];
+} sensor_stats_t;
+
+typedef struct {
+    float values[SENSOR_STATS_MAX_WINDOW]; // Ring indexed by sample number
+    float mean;
+    float m2;
+    float ewma;
+    // Monotonic deques of sample numbers; fronts hold the window min/max
+    uint32_t min_deque[SENSOR_STATS_MAX_WINDOW];
+    uint32_t max_deque[SENSOR_STATS_MAX_WINDOW];
+    uint32_t min_head, min_tail;
+    uint32_t max_head, max_tail;
+} sensor_channel_state_t;
+
+typedef struct {
+    sensor_stats_config_t config;
+    sensor_channel_state_t channel[SENSOR_CHANNEL_COUNT];
+    uint32_t samples;
+    uint32_t anomalies;
+    // Seqlock-protected summary for readers
+    sensor_stats_t summary;
+    volatile uint32_t summary_seq;
+} sensor_stats_engine_t;
+
+void sensor_stats_init(sensor_stats_engine_t* stats, const sensor_stats_config_t* config);
+uint8_t sensor_stats_update(sensor_stats_engine_t* stats, const sensor_data_t* sample);
+bool sensor_stats_get(sensor_stats_engine_t* stats, sensor_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
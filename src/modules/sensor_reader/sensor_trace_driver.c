@@ -0,0 +1,93 @@
+#include "sensor_trace_driver.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <math.h>
+#include <string.h>
+
+static const char* TAG = "SensorTrace";
+
+// Next data row into trace->next; skips the header and malformed lines
+static bool trace_read_row(sensor_trace_driver_t* trace, uint32_t* time_ms) {
+    char line[128];
+    
+    while (fgets(line, sizeof(line), trace->file)) {
+        unsigned long row_ms, seq, raw;
+        float temperature, humidity, voltage;
+        
+        if (sscanf(line, "%lu,%lu,%lu,%f,%f,%f", &row_ms, &seq, &raw, &temperature, &humidity, &voltage) == 6) {
+            trace->next.raw_value = (uint32_t)raw;
+            sensor_set_temperature_cdeg(&trace->next, lroundf(temperature * SENSOR_TEMPERATURE_SCALE));
+            sensor_set_humidity_cpct(&trace->next, lroundf(humidity * SENSOR_HUMIDITY_SCALE));
+            sensor_set_voltage_mv(&trace->next, lroundf(voltage * SENSOR_VOLTAGE_SCALE));
+            *time_ms = (uint32_t)row_ms;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool trace_driver_init(sensor_driver_t* driver) {
+    sensor_trace_driver_t* trace = (sensor_trace_driver_t*)driver->context;
+    
+    trace->file = fopen(trace->path, "r");
+    if (!trace->file || !trace_read_row(trace, &trace->first_ms)) {
+        ESP_LOGE(TAG, "Cannot read trace %s", trace->path);
+        if (trace->file) fclose(trace->file);
+        trace->file = NULL;
+        return false;
+    }
+    
+    trace->current = trace->next;
+    trace->start = xTaskGetTickCount();
+    
+    uint32_t time_ms = 0;
+    trace->has_next = trace_read_row(trace, &time_ms);
+    trace->next_ms = time_ms - trace->first_ms;
+    
+    ESP_LOGI(TAG, "Replaying %s", trace->path);
+    return true;
+}
+
+static bool trace_driver_read(sensor_driver_t* driver, sensor_data_t* data, TickType_t timeout) {
+    sensor_trace_driver_t* trace = (sensor_trace_driver_t*)driver->context;
+    uint32_t elapsed_ms = (xTaskGetTickCount() - trace->start) * portTICK_PERIOD_MS;
+    
+    // Skip every row that has already come into effect
+    while (trace->has_next && trace->next_ms <= elapsed_ms) {
+        uint32_t time_ms = 0;
+        
+        trace->current = trace->next;
+        trace->has_next = trace_read_row(trace, &time_ms);
+        trace->next_ms = time_ms - trace->first_ms;
+    }
+    
+    data->raw_value = trace->current.raw_value;
+    data->temperature = trace->current.temperature;
+    data->humidity = trace->current.humidity;
+    data->voltage = trace->current.voltage;
+    return true;
+}
+
+static void trace_driver_deinit(sensor_driver_t* driver) {
+    sensor_trace_driver_t* trace = (sensor_trace_driver_t*)driver->context;
+    
+    if (trace->file) {
+        fclose(trace->file);
+        trace->file = NULL;
+    }
+}
+
+static const sensor_driver_ops_t trace_driver_ops = {
+    "trace",
+    false,
+    trace_driver_init,
+    trace_driver_read,
+    trace_driver_deinit
+};
+
+void sensor_trace_driver_init(sensor_trace_driver_t* trace, const char* path) {
+    memset(trace, 0, sizeof(*trace));
+    trace->path = path;
+    trace->driver.ops = &trace_driver_ops;
+    trace->driver.context = trace;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef SENSOR_TRACE_DRIVER_H
+#define SENSOR_TRACE_DRIVER_H
+
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include "sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Replays a recorded trace: the CSV written by tools/decode_telemetry.py
+// (time_ms,seq,raw,temperature_c,humidity_pct,voltage_v). A read returns
+// the row in effect at the current time, measured from when the driver
+// started, so the reader sees the signal it would have seen live at
+// whatever rate it samples. The last row holds once the trace ends.
+
+typedef struct {
+    sensor_driver_t driver;
+    const char* path;
+    FILE* file;
+    TickType_t start;
+    uint32_t first_ms;
+    sensor_data_t current;
+    sensor_data_t next;
+    uint32_t next_ms;   // Trace time of next, relative to the first row
+    bool has_next;
+} sensor_trace_driver_t;
+
+void sensor_trace_driver_init(sensor_trace_driver_t* trace, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "system_metrics.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include <stdio.h>
+
+static const char* TAG = "Metrics";
+
+static system_metrics_entry_t metrics_table[SYSTEM_METRICS_MAX_TASKS];
+static portMUX_TYPE metrics_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+// Scratch space for uxTaskGetSystemState(); the system has well under this many tasks
+#define METRICS_STATUS_CAPACITY 24
+static TaskStatus_t metrics_status[METRICS_STATUS_CAPACITY];
+#endif
+
+static bool system_metrics_valid(int slot) {
+    return slot >= 0 && slot < SYSTEM_METRICS_MAX_TASKS && metrics_table[slot].task != NULL;
+}
+
+// Registers the calling task. period is the nominal vTaskDelayUntil period,
+// or 0 for tasks that block on events.
+int system_metrics_register(const char* name, TickType_t period) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    int slot = SYSTEM_METRICS_INVALID_SLOT;
+    
+    portENTER_CRITICAL(&metrics_mux);
+    for (int i = 0; i < SYSTEM_METRICS_MAX_TASKS; i++) {
+        if (metrics_table[i].task == NULL) {
+            metrics_table[i].name = name;
+            metrics_table[i].task = task;
+            metrics_table[i].period_us = (int64_t)period * portTICK_PERIOD_MS * 1000;
+            metrics_table[i].last_wake_us = 0;
+            metrics_table[i].wakeups = 0;
+            metrics_table[i].events = 0;
+            metrics_table[i].jitter_max_us = 0;
+            metrics_table[i].jitter_sum_us = 0;
+            slot = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&metrics_mux);
+    
+    if (slot == SYSTEM_METRICS_INVALID_SLOT) {
+        ESP_LOGW(TAG, "No metrics slot for %s", name);
+    }
+    return slot;
+}
+
+void system_metrics_unregister(int slot) {
+    if (!system_metrics_valid(slot)) return;
+    
+    portENTER_CRITICAL(&metrics_mux);
+    metrics_table[slot].task = NULL;
+    portEXIT_CRITICAL(&metrics_mux);
+}
+
+// Call once per loop iteration, right after the task unblocks
+void system_metrics_wake(int slot) {
+    if (!system_metrics_valid(slot)) return;
+    
+    system_metrics_entry_t* entry = &metrics_table[slot];
+    int64_t now = esp_timer_get_time();
+    
+    if (entry->period_us > 0 && entry->wakeups > 0) {
+        int64_t deviation = (now - entry->last_wake_us) - entry->period_us;
+        uint32_t jitter = (uint32_t)(deviation < 0 ? -deviation : deviation);
+        
+        if (jitter > entry->jitter_max_us) {
+            entry->jitter_max_us = jitter;
+        }
+        entry->jitter_sum_us += jitter;
+    }
+    
+    entry->last_wake_us = now;
+    entry->wakeups++;
+}
+
+void system_metrics_event(int slot, uint32_t count) {
+    if (!system_metrics_valid(slot)) return;
+    
+    metrics_table[slot].events += count;
+}
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+static void system_metrics_fill_cpu(system_metrics_snapshot_t* snapshot, const TaskHandle_t* handles) {
+    uint32_t total_runtime = 0;
+    UBaseType_t count = uxTaskGetSystemState(metrics_status, METRICS_STATUS_CAPACITY, &total_runtime);
+    
+    // Percent of the run-time counter since boot
+    total_runtime /= 100;
+    if (count == 0 || total_runtime == 0) return;
+    
+    for (uint8_t i = 0; i < snapshot->task_count; i++) {
+        for (UBaseType_t j = 0; j < count; j++) {
+            if (metrics_status[j].xHandle == handles[i]) {
+                snapshot->tasks[i].cpu_percent = (uint8_t)(metrics_status[j].ulRunTimeCounter / total_runtime);
+                break;
+            }
+        }
+    }
+}
+#endif
+
+void system_metrics_snapshot(system_metrics_snapshot_t* snapshot) {
+    if (!snapshot) return;
+    
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    TaskHandle_t handles[SYSTEM_METRICS_MAX_TASKS];
+#endif
+    
+    snapshot->uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    snapshot->free_heap = esp_get_free_heap_size();
+    snapshot->min_free_heap = esp_get_minimum_free_heap_size();
+    snapshot->task_count = 0;
+    
+    // Hold the lock so no task can unregister (and be deleted) while its
+    // stack is inspected
+    portENTER_CRITICAL(&metrics_mux);
+    for (int i = 0; i < SYSTEM_METRICS_MAX_TASKS; i++) {
+        const system_metrics_entry_t* entry = &metrics_table[i];
+        if (entry->task == NULL) continue;
+        
+        system_metrics_task_snapshot_t* task = &snapshot->tasks[snapshot->task_count];
+        uint32_t intervals = entry->wakeups > 1 ? entry->wakeups - 1 : 1;
+        
+        task->name = entry->name;
+        task->wakeups = entry->wakeups;
+        task->events = entry->events;
+        task->jitter_max_us = entry->jitter_max_us;
+        task->jitter_avg_us = (uint32_t)(entry->jitter_sum_us / intervals);
+        task->cpu_percent = SYSTEM_METRICS_CPU_UNKNOWN;
+        task->stack_free_min = uxTaskGetStackHighWaterMark(entry->task);
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+        handles[snapshot->task_count] = entry->task;
+#endif
+        snapshot->task_count++;
+    }
+    portEXIT_CRITICAL(&metrics_mux);
+    
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    system_metrics_fill_cpu(snapshot, handles);
+#endif
+}
+
+void system_metrics_log(void) {
+    system_metrics_snapshot_t snapshot;
+    system_metrics_snapshot(&snapshot);
+    
+    ESP_LOGI(TAG, "Heap free %lu, min %lu bytes, uptime %lu ms",
+             (unsigned long)snapshot.free_heap, (unsigned long)snapshot.min_free_heap,
+             (unsigned long)snapshot.uptime_ms);
+    
+    for (uint8_t i = 0; i < snapshot.task_count; i++) {
+        const system_metrics_task_snapshot_t* task = &snapshot.tasks[i];
+        char cpu[8] = "-";
+        
+        if (task->cpu_percent != SYSTEM_METRICS_CPU_UNKNOWN) {
+            snprintf(cpu, sizeof(cpu), "%u%%", task->cpu_percent);
+        }
+        
+        ESP_LOGI(TAG, "%-14s stack free %5lu  wakes %6lu  events %6lu  jitter avg/max %lu/%lu us  cpu %s",
+                 task->name, (unsigned long)task->stack_free_min, (unsigned long)task->wakeups,
+                 (unsigned long)task->events, (unsigned long)task->jitter_avg_us,
+                 (unsigned long)task->jitter_max_us, cpu);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef SYSTEM_METRICS_H
+#define SYSTEM_METRICS_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-size registry of module tasks. Each task registers itself from its
+// task function, reports wakeups and events while it runs, and unregisters
+// before deleting itself. Counters are written only by the owning task.
+#ifndef SYSTEM_METRICS_MAX_TASKS
+#define SYSTEM_METRICS_MAX_TASKS 8
+#endif
+
+#define SYSTEM_METRICS_INVALID_SLOT (-1)
+#define SYSTEM_METRICS_CPU_UNKNOWN 0xFF
+
+typedef struct {
+    const char* name;
+    TaskHandle_t task;
+    int64_t period_us;      // 0 for event-driven tasks (no jitter tracking)
+    int64_t last_wake_us;
+    uint32_t wakeups;
+    uint32_t events;
+    uint32_t jitter_max_us; // Worst |wake-to-wake interval - period|
+    uint64_t jitter_sum_us;
+} system_metrics_entry_t;
+
+typedef struct {
+    const char* name;
+    uint32_t stack_free_min; // Stack high-water mark (bytes never used)
+    uint32_t wakeups;
+    uint32_t events;
+    uint32_t jitter_max_us;
+    uint32_t jitter_avg_us;
+    uint8_t cpu_percent;     // SYSTEM_METRICS_CPU_UNKNOWN without run-time stats
+} system_metrics_task_snapshot_t;
+
+typedef struct {
+    uint32_t uptime_ms;
+    uint32_t free_heap;
+    uint32_t min_free_heap;
+    uint8_t task_count;
+    system_metrics_task_snapshot_t tasks[SYSTEM_METRICS_MAX_TASKS];
+} system_metrics_snapshot_t;
+
+int system_metrics_register(const char* name, TickType_t period);
+void system_metrics_unregister(int slot);
+void system_metrics_wake(int slot);
+void system_metrics_event(int slot, uint32_t count);
+void system_metrics_snapshot(system_metrics_snapshot_t* snapshot);
+void system_metrics_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "telemetry_log.h"
+#include "../system_metrics/system_metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char* TAG = "TelemetryLog";
+
+_Static_assert((TELEMETRY_LOG_CAPACITY & (TELEMETRY_LOG_CAPACITY - 1)) == 0,
+               "TELEMETRY_LOG_CAPACITY must be a power of two");
+
+#define RECORD_MASK (TELEMETRY_LOG_CAPACITY - 1)
+
+static bool telemetry_stdout_sink(const uint8_t* data, size_t length, void* context) {
+    size_t written = fwrite(data, 1, length, stdout);
+    fflush(stdout);
+    return written == length;
+}
+
+// Hand every pending record to the sink, one contiguous run of the ring at a
+// time. Returns the number of records flushed.
+static uint32_t telemetry_log_flush(telemetry_log_t* log) {
+    uint32_t start = log->tail;
+    uint32_t tail = start;
+    uint32_t head = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE);
+    
+    while (tail != head) {
+        uint32_t index = tail & RECORD_MASK;
+        uint32_t run = head - tail;
+        if (run > TELEMETRY_LOG_CAPACITY - index) {
+            run = TELEMETRY_LOG_CAPACITY - index;
+        }
+        
+        size_t length = run * sizeof(telemetry_record_t);
+        if (log->sink((const uint8_t*)&log->records[index], length, log->sink_context)) {
+            log->stats.bytes_out += length;
+        } else {
+            log->stats.sink_errors++;
+        }
+        
+        tail += run;
+        __atomic_store_n(&log->tail, tail, __ATOMIC_RELEASE);
+    }
+    
+    return tail - start;
+}
+
+static void telemetry_log_task(void* arg) {
+    telemetry_log_t* log = (telemetry_log_t*)arg;
+    
+    ESP_LOGI(TAG, "Telemetry log task started");
+    
+    int metrics = system_metrics_register("telemetry_log", 0);
+    
+    while (log->task_running) {
+        EventBits_t bits = xEventGroupWaitBits(
+            log->event_group,
+            TELEMETRY_EVENT_DATA | TELEMETRY_EVENT_STOP,
+            pdTRUE,  // Clear on exit
+            pdFALSE, // Wait for any bit
+            portMAX_DELAY
+        );
+        
+        system_metrics_wake(metrics);
+        system_metrics_event(metrics, telemetry_log_flush(log));
+        
+        if (bits & TELEMETRY_EVENT_STOP) {
+            break;
+        }
+    }
+    
+    system_metrics_unregister(metrics);
+    ESP_LOGI(TAG, "Telemetry log task exiting");
+    task_lifecycle_exit(log->event_group);
+}
+
+static void telemetry_log_init(telemetry_log_t* log, telemetry_sink_t sink, void* sink_context) {
+    log->head = 0;
+    log->tail = 0;
+    telemetry_encoder_init(&log->encoder);
+    log->stats.written = 0;
+    log->stats.dropped = 0;
+    log->stats.sink_errors = 0;
+    log->stats.bytes_out = 0;
+    log->sink = sink ? sink : telemetry_stdout_sink;
+    log->sink_context = sink_context;
+    log->task_handle = NULL;
+    log->task_running = false;
+    task_config_t task_config = TELEMETRY_LOG_DEFAULT_TASK_CONFIG;
+    log->task_config = task_config;
+    log->task_buffer = NULL;
+    log->task_stack = NULL;
+}
+
+telemetry_log_t* telemetry_log_create(telemetry_sink_t sink, void* sink_context) {
+    telemetry_log_t* log = (telemetry_log_t*)malloc(sizeof(telemetry_log_t));
+    if (!log) {
+        ESP_LOGE(TAG, "Failed to allocate telemetry log");
+        return NULL;
+    }
+    
+    telemetry_log_init(log, sink, sink_context);
+    
+    // Create event group
+    log->event_group = xEventGroupCreate();
+    if (!log->event_group) {
+        ESP_LOGE(TAG, "Failed to create event group");
+        free(log);
+        return NULL;
+    }
+    
+    ESP_LOGI(TAG, "Telemetry log created (%u records)", (unsigned)TELEMETRY_LOG_CAPACITY);
+    return log;
+}
+
+// Same as telemetry_log_create(), but the log, its event group and its task
+// live in storage and nothing is taken from the heap
+telemetry_log_t* telemetry_log_create_static(telemetry_log_storage_t* storage, telemetry_sink_t sink, void* sink_context) {
+    if (!storage) return NULL;
+    
+    telemetry_log_t* log = &storage->log;
+    telemetry_log_init(log, sink, sink_context);
+    log->task_buffer = &storage->task;
+    log->task_stack = storage->stack;
+    log->event_group = xEventGroupCreateStatic(&storage->event_group);
+    
+    ESP_LOGI(TAG, "Telemetry log created (%u records, static)", (unsigned)TELEMETRY_LOG_CAPACITY);
+    return log;
+}
+
+void telemetry_log_destroy(telemetry_log_t* log) {
+    if (!log) return;
+    
+    telemetry_log_stop(log);
+    
+    if (log->event_group) {
+        vEventGroupDelete(log->event_group);
+    }
+    
+    if (!log->task_buffer) {
+        free(log);
+    }
+    ESP_LOGI(TAG, "Telemetry log destroyed");
+}
+
+// Single producer. Encodes straight into the ring and never blocks; when the
+// drain task falls behind the new record is dropped (and counted).
+bool telemetry_log_write_sample(telemetry_log_t* log, const sensor_data_t* data) {
+    if (!log || !data) return false;
+    
+    uint32_t time_ms = (uint32_t)(data->timestamp * portTICK_PERIOD_MS);
+    uint32_t head = log->head;
+    uint32_t tail = __atomic_load_n(&log->tail, __ATOMIC_ACQUIRE);
+    bool timebase = telemetry_encoder_needs_timebase(&log->encoder, time_ms);
+    uint32_t needed = timebase ? 2 : 1;
+    
+    if (TELEMETRY_LOG_CAPACITY - (head - tail) < needed) {
+        __atomic_fetch_add(&log->stats.dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    
+    if (timebase) {
+        telemetry_encode_timebase(&log->encoder, time_ms, &log->records[head & RECORD_MASK]);
+        head++;
+    }
+    telemetry_encode_sample(&log->encoder, data, time_ms, &log->records[head & RECORD_MASK]);
+    head++;
+    
+    __atomic_store_n(&log->head, head, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&log->stats.written, 1, __ATOMIC_RELAXED);
+    
+    xEventGroupSetBits(log->event_group, TELEMETRY_EVENT_DATA);
+    return true;
+}
+
+bool telemetry_log_get_stats(telemetry_log_t* log, telemetry_log_stats_t* stats) {
+    if (!log || !stats) return false;
+    
+    stats->written = __atomic_load_n(&log->stats.written, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&log->stats.dropped, __ATOMIC_RELAXED);
+    stats->sink_errors = log->stats.sink_errors;
+    stats->bytes_out = log->stats.bytes_out;
+    return true;
+}
+
+// Stack size, priority, core and period used by the next telemetry_log_start().
+// Statically allocated logs cannot grow their stack beyond TELEMETRY_LOG_STACK_SIZE.
+bool telemetry_log_configure_task(telemetry_log_t* log, const task_config_t* config) {
+    if (!log || log->task_running) {
+        return false;
+    }
+    
+    if (!task_config_valid(config, log->task_buffer ? TELEMETRY_LOG_STACK_SIZE : 0)) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    log->task_config = *config;
+    return true;
+}
+
+bool telemetry_log_start(telemetry_log_t* log) {
+    if (!log || log->task_running) {
+        return false;
+    }
+    
+    log->task_running = true;
+    
+    if (task_config_create(telemetry_log_task, "telemetry_log", &log->task_config, log,
+                           log->task_buffer, log->task_stack, &log->task_handle)) {
+        ESP_LOGI(TAG, "Telemetry log task started successfully");
+        return true;
+    }
+    
+    log->task_running = false;
+    ESP_LOGE(TAG, "Failed to start telemetry log task");
+    return false;
+}
+
+void telemetry_log_stop(telemetry_log_t* log) {
+    if (!log || !log->task_running) {
+        return;
+    }
+    
+    log->task_running = false;
+    if (!task_lifecycle_stop(log->event_group, &log->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "Telemetry log task did not exit in time, deleted");
+    }
+    
+    ESP_LOGI(TAG, "Telemetry log stopped");
+}
\ No newline at end of file
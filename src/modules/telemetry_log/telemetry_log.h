@@ -0,0 +1,81 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "telemetry_record.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Records buffered between the producer and the drain task; must be a power of two
+#ifndef TELEMETRY_LOG_CAPACITY
+#define TELEMETRY_LOG_CAPACITY 32
+#endif
+
+#define TELEMETRY_LOG_STACK_SIZE 2048
+// Background: below every producer
+#define TELEMETRY_LOG_DEFAULT_TASK_CONFIG { TELEMETRY_LOG_STACK_SIZE, 2, tskNO_AFFINITY, 0 }
+
+// Receives drained records; returns false if the bytes could not be written
+typedef bool (*telemetry_sink_t)(const uint8_t* data, size_t length, void* context);
+
+typedef struct {
+    uint32_t written;
+    uint32_t dropped;
+    uint32_t sink_errors;
+    uint32_t bytes_out;
+} telemetry_log_stats_t;
+
+typedef struct {
+    // SPSC ring: telemetry_log_write_sample() advances head, the drain task
+    // advances tail. Indices are free-running.
+    telemetry_record_t records[TELEMETRY_LOG_CAPACITY];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    telemetry_encoder_t encoder; // Producer-owned
+    telemetry_log_stats_t stats;
+    telemetry_sink_t sink;
+    void* sink_context;
+    TaskHandle_t task_handle;
+    EventGroupHandle_t event_group;
+    bool task_running;
+    task_config_t task_config;
+    // Set by telemetry_log_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
+} telemetry_log_t;
+
+// Caller-provided storage for telemetry_log_create_static(); must outlive
+// the log
+typedef struct {
+    telemetry_log_t log;
+    StaticEventGroup_t event_group;
+    StaticTask_t task;
+    StackType_t stack[TELEMETRY_LOG_STACK_SIZE];
+} telemetry_log_storage_t;
+
+// Events
+#define TELEMETRY_EVENT_DATA (1 << 0)
+#define TELEMETRY_EVENT_STOP TASK_EVENT_STOP
+
+// A NULL sink writes records to stdout (UART0 on the target)
+telemetry_log_t* telemetry_log_create(telemetry_sink_t sink, void* sink_context);
+telemetry_log_t* telemetry_log_create_static(telemetry_log_storage_t* storage, telemetry_sink_t sink, void* sink_context);
+void telemetry_log_destroy(telemetry_log_t* log);
+bool telemetry_log_write_sample(telemetry_log_t* log, const sensor_data_t* data);
+bool telemetry_log_get_stats(telemetry_log_t* log, telemetry_log_stats_t* stats);
+bool telemetry_log_configure_task(telemetry_log_t* log, const task_config_t* config);
+bool telemetry_log_start(telemetry_log_t* log);
+void telemetry_log_stop(telemetry_log_t* log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
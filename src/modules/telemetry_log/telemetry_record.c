@@ -0,0 +1,69 @@
+#include "telemetry_record.h"
+#include <stddef.h>
+
+_Static_assert(sizeof(telemetry_record_t) == 16, "telemetry_record_t must stay 16 bytes");
+
+#define CRC_START offsetof(telemetry_record_t, type)
+#define CRC_END   offsetof(telemetry_record_t, crc)
+
+void telemetry_encoder_init(telemetry_encoder_t* encoder) {
+    encoder->last_ms = 0;
+    encoder->seq = 0;
+    encoder->has_timebase = false;
+}
+
+// A timebase goes out first, whenever the delta no longer fits in 16 bits,
+// and each time seq wraps so a decoder joining mid-stream can anchor time.
+bool telemetry_encoder_needs_timebase(const telemetry_encoder_t* encoder, uint32_t time_ms) {
+    return !encoder->has_timebase || encoder->seq == 0 || (time_ms - encoder->last_ms) > UINT16_MAX;
+}
+
+static void telemetry_record_seal(telemetry_encoder_t* encoder, telemetry_record_t* record, uint8_t type) {
+    record->sync[0] = TELEMETRY_SYNC_0;
+    record->sync[1] = TELEMETRY_SYNC_1;
+    record->type = type;
+    record->seq = encoder->seq++;
+    record->crc = telemetry_crc16((const uint8_t*)record + CRC_START, CRC_END - CRC_START);
+}
+
+void telemetry_encode_timebase(telemetry_encoder_t* encoder, uint32_t time_ms, telemetry_record_t* record) {
+    record->dt_ms = 0;
+    record->timebase.time_ms = time_ms;
+    record->timebase.reserved = 0;
+    
+    encoder->last_ms = time_ms;
+    encoder->has_timebase = true;
+    telemetry_record_seal(encoder, record, TELEMETRY_RECORD_TIMEBASE);
+}
+
+// Saturate a scaled value to the field range
+static int32_t telemetry_fixed(int32_t fixed, int32_t min, int32_t max) {
+    if (fixed < min) return min;
+    if (fixed > max) return max;
+    return fixed;
+}
+
+void telemetry_encode_sample(telemetry_encoder_t* encoder, const sensor_data_t* data, uint32_t time_ms,
+                             telemetry_record_t* record) {
+    record->dt_ms = (uint16_t)(time_ms - encoder->last_ms);
+    record->sample.raw = data->raw_value > UINT16_MAX ? UINT16_MAX : (uint16_t)data->raw_value;
+    record->sample.temperature_cdeg = (int16_t)telemetry_fixed(sensor_temperature_cdeg(data), INT16_MIN, INT16_MAX);
+    record->sample.humidity_cpct = (uint16_t)telemetry_fixed(sensor_humidity_cpct(data), 0, UINT16_MAX);
+    record->sample.voltage_mv = (uint16_t)telemetry_fixed(sensor_voltage_mv(data), 0, UINT16_MAX);
+    
+    encoder->last_ms = time_ms;
+    telemetry_record_seal(encoder, record, TELEMETRY_RECORD_SAMPLE);
+}
+
+// CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, no reflection
+uint16_t telemetry_crc16(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
\ No newline at end of file
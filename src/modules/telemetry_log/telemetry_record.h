@@ -0,0 +1,60 @@
+#ifndef TELEMETRY_RECORD_H
+#define TELEMETRY_RECORD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../sensor_reader/sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-size 16-byte little-endian record, decoded by tools/decode_telemetry.py.
+// A decoder resynchronises on the sync bytes and rejects records whose CRC
+// (CRC-16/CCITT-FALSE over type..payload) does not match, so records can
+// share a UART with text logs.
+#define TELEMETRY_SYNC_0 0xA5
+#define TELEMETRY_SYNC_1 0x5A
+
+#define TELEMETRY_RECORD_SAMPLE   0x01
+#define TELEMETRY_RECORD_TIMEBASE 0x02 // Absolute time for the following deltas
+
+typedef struct __attribute__((packed)) {
+    uint8_t sync[2];
+    uint8_t type;
+    uint8_t seq;    // Wraps; gaps in seq reveal dropped records
+    uint16_t dt_ms; // Time since the previous record
+    union {
+        struct __attribute__((packed)) {
+            uint16_t raw;
+            int16_t temperature_cdeg; // 0.01 C
+            uint16_t humidity_cpct;   // 0.01 %RH
+            uint16_t voltage_mv;
+        } sample;
+        struct __attribute__((packed)) {
+            uint32_t time_ms;
+            uint32_t reserved;
+        } timebase;
+    };
+    uint16_t crc;
+} telemetry_record_t;
+
+// Encoder state for one record stream
+typedef struct {
+    uint32_t last_ms;
+    uint8_t seq;
+    bool has_timebase;
+} telemetry_encoder_t;
+
+void telemetry_encoder_init(telemetry_encoder_t* encoder);
+bool telemetry_encoder_needs_timebase(const telemetry_encoder_t* encoder, uint32_t time_ms);
+void telemetry_encode_timebase(telemetry_encoder_t* encoder, uint32_t time_ms, telemetry_record_t* record);
+void telemetry_encode_sample(telemetry_encoder_t* encoder, const sensor_data_t* data, uint32_t time_ms,
+                             telemetry_record_t* record);
+uint16_t telemetry_crc16(const uint8_t* data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "trace_recorder.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+
+#ifdef TRACE_RECORDER_ENABLED
+
+_Static_assert((TRACE_RECORDER_RING_EVENTS & (TRACE_RECORDER_RING_EVENTS - 1)) == 0,
+               "TRACE_RECORDER_RING_EVENTS must be a power of two");
+_Static_assert(TRACE_RECORDER_RING_EVENTS <= 0x4000, "ring positions must fit trace_event_t.seq");
+_Static_assert(sizeof(trace_event_t) == 16, "trace_event_t must stay 16 bytes");
+
+#define EVENT_MASK (TRACE_RECORDER_RING_EVENTS - 1)
+// Parked in seq while a writer fills the slot; matches neither the slot's
+// previous position nor its new one
+#define SEQ_BUSY(position) ((uint16_t)((position) + 0x8000))
+
+typedef struct {
+    uint32_t head;   // Free-running; each writer reserves one position
+    uint32_t dumped; // head at the end of the last dump
+    trace_event_t events[TRACE_RECORDER_RING_EVENTS];
+} trace_ring_t;
+
+static trace_ring_t trace_rings[portNUM_PROCESSORS];
+static volatile bool trace_paused = false;
+
+// Each dump times this many writes into a scratch ring and reports the cost
+#define TRACE_COST_EVENTS 64
+static trace_event_t trace_cost_events[TRACE_COST_EVENTS];
+
+static const char* const trace_span_names[TRACE_SPAN_COUNT] = {
+    "none", "sensor_read", "sensor_process", "led_pattern", "wifi_begin", "wifi_event", "wifi_state"
+};
+
+#if configUSE_TRACE_FACILITY
+// Scratch space for naming tasks in a dump
+#define TRACE_STATUS_CAPACITY 24
+static TaskStatus_t trace_status[TRACE_STATUS_CAPACITY];
+#endif
+
+static inline void IRAM_ATTR trace_recorder_write(uint32_t* head, trace_event_t* events, uint32_t mask,
+                                                  trace_event_type_t type, trace_span_t span, uint32_t arg) {
+    uint32_t position = __atomic_fetch_add(head, 1, __ATOMIC_RELAXED);
+    trace_event_t* event = &events[position & mask];
+
+    __atomic_store_n(&event->seq, SEQ_BUSY(position), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event->time = TRACE_RECORDER_CLOCK();
+    event->task = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+    event->arg = arg;
+    event->type = (uint8_t)type;
+    event->span = (uint8_t)span;
+    __atomic_store_n(&event->seq, (uint16_t)position, __ATOMIC_RELEASE);
+}
+
+// Also runs from the scheduler's trace hooks, so it stays in IRAM and
+// touches only the calling core's ring
+void IRAM_ATTR trace_recorder_record(trace_event_type_t type, trace_span_t span, uint32_t arg) {
+    if (trace_paused) return;
+    
+    trace_ring_t* ring = &trace_rings[xPortGetCoreID()];
+    trace_recorder_write(&ring->head, ring->events, EVENT_MASK, type, span, arg);
+}
+
+void IRAM_ATTR trace_recorder_task_switched_in(void) {
+    trace_recorder_record(TRACE_EVENT_TASK_IN, TRACE_SPAN_NONE, 0);
+}
+
+void IRAM_ATTR trace_recorder_task_switched_out(void) {
+    trace_recorder_record(TRACE_EVENT_TASK_OUT, TRACE_SPAN_NONE, 0);
+}
+
+void trace_recorder_get_stats(trace_recorder_stats_t* stats) {
+    if (!stats) return;
+    
+    stats->recorded = 0;
+    stats->lost = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const trace_ring_t* ring = &trace_rings[core];
+        uint32_t pending = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - ring->dumped;
+    
+        stats->recorded += pending;
+        if (pending > TRACE_RECORDER_RING_EVENTS) {
+            stats->lost += pending - TRACE_RECORDER_RING_EVENTS;
+        }
+    }
+}
+
+// Nanoseconds per recorded event on this core, clock read included
+static uint32_t trace_recorder_measure_cost(void) {
+    uint32_t head = 0;
+    int64_t start_us = esp_timer_get_time();
+    
+    for (int i = 0; i < TRACE_COST_EVENTS; i++) {
+        trace_recorder_write(&head, trace_cost_events, TRACE_COST_EVENTS - 1,
+                             TRACE_EVENT_INSTANT, TRACE_SPAN_NONE, i);
+    }
+    return (uint32_t)((esp_timer_get_time() - start_us) * 1000 / TRACE_COST_EVENTS);
+}
+
+// Copies the event at position, or returns false if it was overwritten or
+// is still being written
+static bool trace_recorder_read(const trace_ring_t* ring, uint32_t position, trace_event_t* out) {
+    const trace_event_t* event = &ring->events[position & EVENT_MASK];
+    
+    if (__atomic_load_n(&event->seq, __ATOMIC_ACQUIRE) != (uint16_t)position) return false;
+    *out = *event;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&event->seq, __ATOMIC_RELAXED) == (uint16_t)position;
+}
+
+// Call from one task at a time
+void trace_recorder_dump(FILE* out) {
+    out = out ? out : stdout;
+    trace_paused = true;
+    
+    uint32_t written = 0;
+    uint32_t lost = 0;
+    
+    // Header, then the names the events refer to
+    fprintf(out, "TRACE begin 1 %lu %d\n", (unsigned long)TRACE_RECORDER_CLOCK_HZ, portNUM_PROCESSORS);
+    for (int span = 1; span < TRACE_SPAN_COUNT; span++) {
+        fprintf(out, "TRACE span %d %s\n", span, trace_span_names[span]);
+    }
+#if configUSE_TRACE_FACILITY
+    // Live tasks only; deleted ones show up as bare handles
+    UBaseType_t task_count = uxTaskGetSystemState(trace_status, TRACE_STATUS_CAPACITY, NULL);
+    for (UBaseType_t i = 0; i < task_count; i++) {
+        fprintf(out, "TRACE task %08lx %u %s\n", (unsigned long)(uint32_t)(uintptr_t)trace_status[i].xHandle,
+                (unsigned)trace_status[i].uxCurrentPriority, trace_status[i].pcTaskName);
+    }
+#endif
+    
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_ring_t* ring = &trace_rings[core];
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t start = ring->dumped;
+    
+        if (head - start > TRACE_RECORDER_RING_EVENTS) {
+            lost += head - start - TRACE_RECORDER_RING_EVENTS;
+            start = head - TRACE_RECORDER_RING_EVENTS;
+        }
+    
+        for (uint32_t position = start; position != head; position++) {
+            trace_event_t event;
+            if (!trace_recorder_read(ring, position, &event)) {
+                lost++;
+                continue;
+            }
+            fprintf(out, "TRACE ev %d %lu %u %08lx %u %lu\n", core, (unsigned long)event.time,
+                    (unsigned)event.type, (unsigned long)event.task, (unsigned)event.span,
+                    (unsigned long)event.arg);
+            written++;
+        }
+        ring->dumped = head;
+    }
+    
+    fprintf(out, "TRACE cost %lu\n", (unsigned long)trace_recorder_measure_cost());
+    fprintf(out, "TRACE end %lu %lu\n", (unsigned long)written, (unsigned long)lost);
+    fflush(out);
+    trace_paused = false;
+}
+
+#else
+
+void trace_recorder_record(trace_event_type_t type, trace_span_t span, uint32_t arg) {
+}
+
+void trace_recorder_get_stats(trace_recorder_stats_t* stats) {
+    if (!stats) return;
+    
+    stats->recorded = 0;
+    stats->lost = 0;
+}
+
+void trace_recorder_dump(FILE* out) {
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timeline recorder for tools/trace_to_chrome.py. Build with
+// -DTRACE_RECORDER_ENABLED; otherwise the macros below compile to nothing.
+//
+// Each core records fixed-size events into its own ring, overwriting the
+// oldest, so a dump holds the last TRACE_RECORDER_RING_EVENTS events per
+// core. A writer reserves its slot with one atomic add and takes no lock,
+// so spans are safe from any task or ISR. Scheduling events come from the
+// FreeRTOS trace hooks in trace_recorder_hooks.h.
+#ifndef TRACE_RECORDER_RING_EVENTS
+#define TRACE_RECORDER_RING_EVENTS 512 // Per core; must be a power of two
+#endif
+
+// Event timestamps; 32 bits, wrapping (the converter unwraps them)
+#ifndef TRACE_RECORDER_CLOCK
+#define TRACE_RECORDER_CLOCK() ((uint32_t)esp_timer_get_time())
+#define TRACE_RECORDER_CLOCK_HZ 1000000
+#endif
+
+typedef enum {
+    TRACE_EVENT_TASK_IN = 1, // Task switched in on this core
+    TRACE_EVENT_TASK_OUT,    // Task switched out on this core
+    TRACE_EVENT_SPAN_BEGIN,
+    TRACE_EVENT_SPAN_END,
+    TRACE_EVENT_INSTANT
+} trace_event_type_t;
+
+// Span and instant names; keep trace_span_names in trace_recorder.c in step
+typedef enum {
+    TRACE_SPAN_NONE = 0,
+    TRACE_SPAN_SENSOR_READ,    // Driver read (sample generation for the fake driver)
+    TRACE_SPAN_SENSOR_PROCESS, // Publish, statistics, fusion and emit
+    TRACE_SPAN_LED_PATTERN,    // Pattern switch
+    TRACE_SPAN_WIFI_BEGIN,     // WiFi.begin()
+    TRACE_SPAN_WIFI_EVENT,     // Handling one status event
+    TRACE_SPAN_WIFI_STATE,     // Instant; arg is the new wifi_state_t
+    TRACE_SPAN_COUNT
+} trace_span_t;
+
+typedef struct {
+    uint32_t time;  // TRACE_RECORDER_CLOCK()
+    uint32_t task;  // Running task handle (low 32 bits)
+    uint32_t arg;
+    uint8_t type;   // trace_event_type_t
+    uint8_t span;   // trace_span_t
+    uint16_t seq;   // Low bits of the ring position; written last, so a
+                    // mismatch marks a slot still being filled
+} trace_event_t;
+
+typedef struct {
+    uint32_t recorded; // Events since the last dump, all cores
+    uint32_t lost;     // Of those, overwritten before a dump
+} trace_recorder_stats_t;
+
+#ifdef TRACE_RECORDER_ENABLED
+#define TRACE_SPAN_BEGIN(span) trace_recorder_record(TRACE_EVENT_SPAN_BEGIN, (span), 0)
+#define TRACE_SPAN_END(span) trace_recorder_record(TRACE_EVENT_SPAN_END, (span), 0)
+#define TRACE_INSTANT(span, arg) trace_recorder_record(TRACE_EVENT_INSTANT, (span), (arg))
+#else
+#define TRACE_SPAN_BEGIN(span) ((void)0)
+#define TRACE_SPAN_END(span) ((void)0)
+#define TRACE_INSTANT(span, arg) ((void)0)
+#endif
+
+void trace_recorder_record(trace_event_type_t type, trace_span_t span, uint32_t arg);
+// Called by the hooks in trace_recorder_hooks.h
+void trace_recorder_task_switched_in(void);
+void trace_recorder_task_switched_out(void);
+void trace_recorder_get_stats(trace_recorder_stats_t* stats);
+// Writes the rings as "TRACE ..." text lines (stdout if out is NULL), then
+// clears them. Recording pauses while the dump runs. The dump ends with the
+// measured cost of one event on the calling core.
+void trace_recorder_dump(FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef TRACE_RECORDER_HOOKS_H
+#define TRACE_RECORDER_HOOKS_H
+
+// FreeRTOS trace hooks feeding trace_recorder. FreeRTOS.h only defines the
+// hooks left undefined, so this header has to reach the kernel's own
+// sources ahead of it, and it includes nothing itself. Force-include it in
+// builds that compile the kernel, together with -DTRACE_RECORDER_ENABLED:
+//
+//   native:  build_flags = -DTRACE_RECORDER_ENABLED
+//                          -include src/modules/trace_recorder/trace_recorder_hooks.h
+//   ESP-IDF: idf_component_get_property(freertos freertos COMPONENT_LIB)
+//            target_compile_options(${freertos} PRIVATE -include <this file>)
+//
+// The Arduino core links a prebuilt kernel, so there only the spans are
+// recorded.
+#ifdef TRACE_RECORDER_ENABLED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void trace_recorder_task_switched_in(void);
+void trace_recorder_task_switched_out(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define traceTASK_SWITCHED_IN() trace_recorder_task_switched_in()
+#define traceTASK_SWITCHED_OUT() trace_recorder_task_switched_out()
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "udp_streamer.h"
+#include "../system_metrics/system_metrics.h"
+#include "../wifi_manager/wifi_state.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+static const char* TAG = "UdpStreamer";
+
+#define STREAMER_NO_SOCKET (-1)
+
+// Sentinel posted to the streamer's own queue by udp_streamer_stop()
+#define STREAMER_WAKE_TOPIC MESSAGE_TOPIC_COUNT
+
+static telemetry_record_t* streamer_records(udp_streamer_t* streamer) {
+    return (telemetry_record_t*)(streamer->datagram + sizeof(udp_stream_header_t));
+}
+
+// Socket
+
+static void streamer_close(udp_streamer_t* streamer) {
+    if (streamer->socket != STREAMER_NO_SOCKET) {
+        close(streamer->socket);
+        streamer->socket = STREAMER_NO_SOCKET;
+    }
+    
+    // Addresses may not survive a reconnect; clients resubscribe
+    streamer->subscriber_count = 0;
+    streamer->batch_count = 0;
+    streamer->stats.subscribers = 0;
+}
+
+static bool streamer_open(udp_streamer_t* streamer) {
+    streamer->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (streamer->socket < 0) {
+        streamer->socket = STREAMER_NO_SOCKET;
+        return false;
+    }
+    
+    int reuse = 1;
+    setsockopt(streamer->socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(streamer->config.port);
+    
+    if (bind(streamer->socket, (struct sockaddr*)&local, sizeof(local)) != 0) {
+        // Retried at every poll; only the first failure is worth a warning
+        if (!streamer->open_failed) {
+            ESP_LOGW(TAG, "Cannot bind UDP port %u (errno %d), retrying", streamer->config.port, errno);
+        }
+        streamer->open_failed = true;
+        streamer_close(streamer);
+        return false;
+    }
+    
+    streamer->open_failed = false;
+    ESP_LOGI(TAG, "Streaming on UDP port %u", streamer->config.port);
+    return true;
+}
+
+static void streamer_set_network(udp_streamer_t* streamer, bool up) {
+    if (up == streamer->network_up) return;
+    
+    streamer->network_up = up;
+    if (up) {
+        streamer_open(streamer);
+    } else {
+        streamer_close(streamer);
+    }
+}
+
+// Subscriptions
+
+static int streamer_find(udp_streamer_t* streamer, const struct sockaddr_in* from) {
+    for (int i = 0; i < streamer->subscriber_count; i++) {
+        if (streamer->subscribers[i].address == from->sin_addr.s_addr &&
+            streamer->subscribers[i].port == from->sin_port) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void streamer_remove(udp_streamer_t* streamer, int index) {
+    streamer->subscribers[index] = streamer->subscribers[--streamer->subscriber_count];
+}
+
+static void streamer_handle_request(udp_streamer_t* streamer, const udp_stream_header_t* request,
+                                    const struct sockaddr_in* from) {
+    int index = streamer_find(streamer, from);
+    
+    if (request->type == UDP_STREAM_SUBSCRIBE) {
+        if (index < 0) {
+            if (streamer->subscriber_count == UDP_STREAMER_MAX_SUBSCRIBERS) {
+                ESP_LOGW(TAG, "Subscriber table full, request ignored");
+                return;
+            }
+            index = streamer->subscriber_count++;
+            streamer->subscribers[index].address = from->sin_addr.s_addr;
+            streamer->subscribers[index].port = from->sin_port;
+            ESP_LOGI(TAG, "Subscriber added (%u active)", streamer->subscriber_count);
+        }
+        streamer->subscribers[index].expires = xTaskGetTickCount() + pdMS_TO_TICKS(streamer->config.lease_ms);
+    } else if (request->type == UDP_STREAM_UNSUBSCRIBE && index >= 0) {
+        streamer_remove(streamer, index);
+        ESP_LOGI(TAG, "Subscriber left (%u active)", streamer->subscriber_count);
+    }
+}
+
+// Drain pending subscribe/unsubscribe requests without blocking
+static void streamer_poll_requests(udp_streamer_t* streamer) {
+    for (;;) {
+        udp_stream_header_t request;
+        struct sockaddr_in from;
+        socklen_t from_length = sizeof(from);
+        ssize_t received = recvfrom(streamer->socket, &request, sizeof(request), MSG_DONTWAIT,
+                                    (struct sockaddr*)&from, &from_length);
+        if (received < 0) {
+            break;
+        }
+        
+        if (received == (ssize_t)sizeof(request) && from.sin_family == AF_INET &&
+            request.magic[0] == UDP_STREAM_MAGIC_0 && request.magic[1] == UDP_STREAM_MAGIC_1 &&
+            request.version == UDP_STREAM_VERSION) {
+            streamer_handle_request(streamer, &request, &from);
+        }
+    }
+    
+    TickType_t now = xTaskGetTickCount();
+    for (int i = streamer->subscriber_count - 1; i >= 0; i--) {
+        if ((int32_t)(now - streamer->subscribers[i].expires) >= 0) {
+            streamer_remove(streamer, i);
+            ESP_LOGI(TAG, "Subscription expired (%u active)", streamer->subscriber_count);
+        }
+    }
+    
+    streamer->stats.subscribers = streamer->subscriber_count;
+}
+
+// Datagrams
+
+static void streamer_send(udp_streamer_t* streamer) {
+    if (streamer->batch_count == 0) return;
+    
+    TickType_t now = xTaskGetTickCount();
+    udp_stream_header_t* header = (udp_stream_header_t*)streamer->datagram;
+    header->magic[0] = UDP_STREAM_MAGIC_0;
+    header->magic[1] = UDP_STREAM_MAGIC_1;
+    header->version = UDP_STREAM_VERSION;
+    header->type = UDP_STREAM_DATA;
+    header->seq = streamer->seq++;
+    header->time_ms = (uint32_t)(now * portTICK_PERIOD_MS);
+    header->count = streamer->batch_count;
+    header->reserved = 0;
+    
+    size_t length = sizeof(udp_stream_header_t) + (streamer->batch_count + 1) * sizeof(telemetry_record_t);
+    
+    // Sent from the buffer the samples were encoded into
+    for (int i = 0; i < streamer->subscriber_count; i++) {
+        struct sockaddr_in to;
+        memset(&to, 0, sizeof(to));
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = streamer->subscribers[i].address;
+        to.sin_port = streamer->subscribers[i].port;
+        
+        if (sendto(streamer->socket, streamer->datagram, length, 0, (struct sockaddr*)&to, sizeof(to)) < 0) {
+            streamer->stats.send_errors++;
+        }
+    }
+    
+    uint32_t latency_ms = (uint32_t)((now - streamer->batch_started) * portTICK_PERIOD_MS);
+    if (latency_ms > streamer->stats.max_latency_ms) {
+        streamer->stats.max_latency_ms = latency_ms;
+    }
+    streamer->stats.streamed += streamer->batch_count;
+    streamer->stats.datagrams++;
+    streamer->batch_count = 0;
+}
+
+// Encode straight into the next record slot of the outgoing datagram
+static void streamer_add_sample(udp_streamer_t* streamer, const sensor_data_t* sample) {
+    streamer->stats.received++;
+    if (streamer->socket == STREAMER_NO_SOCKET || streamer->subscriber_count == 0) {
+        return;
+    }
+    
+    uint32_t time_ms = (uint32_t)(sample->timestamp * portTICK_PERIOD_MS);
+    telemetry_record_t* records = streamer_records(streamer);
+    
+    // A gap too long for a record's 16-bit delta starts a new datagram
+    if (streamer->batch_count > 0 && telemetry_encoder_needs_timebase(&streamer->encoder, time_ms)) {
+        streamer_send(streamer);
+    }
+    
+    if (streamer->batch_count == 0) {
+        telemetry_encoder_init(&streamer->encoder);
+        telemetry_encode_timebase(&streamer->encoder, time_ms, &records[0]);
+        streamer->batch_started = sample->timestamp;
+    }
+    
+    telemetry_encode_sample(&streamer->encoder, sample, time_ms, &records[++streamer->batch_count]);
+    
+    if (streamer->batch_count >= streamer->config.batch_size) {
+        streamer_send(streamer);
+    }
+}
+
+// Sends a partial datagram once it is old enough; returns ticks until the
+// next poll or batch deadline
+static TickType_t streamer_service(udp_streamer_t* streamer) {
+    if (!streamer->network_up) {
+        return portMAX_DELAY;
+    }
+    
+    // At high sample rates the task wakes per sample; poll at most every poll_ms
+    TickType_t now = xTaskGetTickCount();
+    TickType_t poll_every = pdMS_TO_TICKS(streamer->config.poll_ms);
+    if (now - streamer->polled_at >= poll_every) {
+        // A failed open (the port still held after a restart, say) is
+        // retried at every poll while WiFi stays up
+        if (streamer->socket != STREAMER_NO_SOCKET || streamer_open(streamer)) {
+            streamer_poll_requests(streamer);
+        }
+        streamer->polled_at = now;
+    }
+    
+    TickType_t wait = streamer->polled_at + poll_every - now;
+    if (streamer->batch_count > 0) {
+        int32_t age_left = (int32_t)(streamer->batch_started + pdMS_TO_TICKS(streamer->config.max_latency_ms) - now);
+        if (age_left <= 0) {
+            streamer_send(streamer);
+        } else if ((TickType_t)age_left < wait) {
+            wait = (TickType_t)age_left;
+        }
+    }
+    
+    return wait > 0 ? wait : 1;
+}
+
+static void udp_streamer_task(void* arg) {
+    udp_streamer_t* streamer = (udp_streamer_t*)arg;
+    
+    ESP_LOGI(TAG, "UDP streamer task started");
+    
+    int metrics = system_metrics_register("udp_streamer", 0);
+    TickType_t timeout = 0;
+    
+    // Restarted while WiFi stayed up: no state change will arrive
+    if (streamer->network_up) {
+        streamer_open(streamer);
+    }
+    
+    while (streamer->task_running) {
+        message_t message;
+        
+        if (xQueueReceive(streamer->queue, &message, timeout) == pdTRUE) {
+            if (message.topic == MESSAGE_TOPIC_SENSOR_SAMPLE) {
+                streamer_add_sample(streamer, &message.sample);
+            } else if (message.topic == MESSAGE_TOPIC_WIFI_STATE) {
+                streamer_set_network(streamer, message.wifi_state == WIFI_STATE_CONNECTED);
+            }
+            system_metrics_event(metrics, 1);
+        }
+        
+        system_metrics_wake(metrics);
+        timeout = streamer_service(streamer);
+    }
+    
+    streamer_send(streamer);
+    streamer_close(streamer);
+    
+    system_metrics_unregister(metrics);
+    ESP_LOGI(TAG, "UDP streamer task exiting");
+    task_lifecycle_exit(streamer->event_group);
+}
+
+static void udp_streamer_init(udp_streamer_t* streamer, const udp_streamer_config_t* config) {
+    memset(streamer, 0, sizeof(*streamer));
+    streamer->config = *config;
+    
+    if (streamer->config.batch_size == 0 || streamer->config.batch_size > UDP_STREAMER_MAX_BATCH) {
+        streamer->config.batch_size = UDP_STREAMER_MAX_BATCH;
+    }
+    if (streamer->config.poll_ms == 0) {
+        streamer->config.poll_ms = 1;
+    }
+    
+    streamer->socket = STREAMER_NO_SOCKET;
+    streamer->subscription = MESSAGE_BUS_INVALID_SLOT;
+    task_config_t task_config = UDP_STREAMER_DEFAULT_TASK_CONFIG;
+    streamer->task_config = task_config;
+}
+
+udp_streamer_t* udp_streamer_create(const udp_streamer_config_t* config) {
+    if (!config) return NULL;
+    
+    udp_streamer_t* streamer = (udp_streamer_t*)malloc(sizeof(udp_streamer_t));
+    if (!streamer) {
+        ESP_LOGE(TAG, "Failed to allocate UDP streamer");
+        return NULL;
+    }
+    
+    udp_streamer_init(streamer, config);
+    
+    streamer->queue = xQueueCreate(UDP_STREAMER_QUEUE_LENGTH, sizeof(message_t));
+    if (!streamer->queue) {
+        ESP_LOGE(TAG, "Failed to create message queue");
+        free(streamer);
+        return NULL;
+    }
+    
+    streamer->event_group = xEventGroupCreate();
+    if (!streamer->event_group) {
+        ESP_LOGE(TAG, "Failed to create event group");
+        vQueueDelete(streamer->queue);
+        free(streamer);
+        return NULL;
+    }
+    
+    ESP_LOGI(TAG, "UDP streamer created on port %u", streamer->config.port);
+    return streamer;
+}
+
+// Same as udp_streamer_create(), but the streamer, its queue, event group
+// and task live in storage and nothing is taken from the heap
+udp_streamer_t* udp_streamer_create_static(udp_streamer_storage_t* storage, const udp_streamer_config_t* config) {
+    if (!storage || !config) return NULL;
+    
+    udp_streamer_t* streamer = &storage->streamer;
+    udp_streamer_init(streamer, config);
+    streamer->task_buffer = &storage->task;
+    streamer->task_stack = storage->stack;
+    streamer->queue = xQueueCreateStatic(UDP_STREAMER_QUEUE_LENGTH, sizeof(message_t),
+                                         storage->queue_storage, &storage->queue);
+    streamer->event_group = xEventGroupCreateStatic(&storage->event_group);
+    
+    ESP_LOGI(TAG, "UDP streamer created on port %u (static)", streamer->config.port);
+    return streamer;
+}
+
+void udp_streamer_destroy(udp_streamer_t* streamer) {
+    if (!streamer) return;
+    
+    udp_streamer_stop(streamer);
+    
+    if (streamer->queue) {
+        vQueueDelete(streamer->queue);
+    }
+    
+    if (streamer->event_group) {
+        vEventGroupDelete(streamer->event_group);
+    }
+    
+    if (!streamer->task_buffer) {
+        free(streamer);
+    }
+    ESP_LOGI(TAG, "UDP streamer destroyed");
+}
+
+bool udp_streamer_get_stats(udp_streamer_t* streamer, udp_streamer_stats_t* stats) {
+    if (!streamer || !stats) return false;
+    
+    // Plain 32-bit fields written by the task; each is read atomically
+    *stats = streamer->stats;
+    return true;
+}
+
+// Stack size, priority and core used by the next udp_streamer_start().
+// Statically allocated streamers cannot grow their stack beyond UDP_STREAMER_STACK_SIZE.
+bool udp_streamer_configure_task(udp_streamer_t* streamer, const task_config_t* config) {
+    if (!streamer || streamer->task_running) {
+        return false;
+    }
+    
+    if (!task_config_valid(config, streamer->task_buffer ? UDP_STREAMER_STACK_SIZE : 0)) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    streamer->task_config = *config;
+    return true;
+}
+
+// Start before the WiFi manager so the first WIFI_STATE message is seen
+bool udp_streamer_start(udp_streamer_t* streamer) {
+    if (!streamer || streamer->task_running) {
+        return false;
+    }
+    
+    streamer->subscription = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_WIFI_STATE) |
+                                                   MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE),
+                                                   streamer->queue);
+    if (streamer->subscription == MESSAGE_BUS_INVALID_SLOT) {
+        ESP_LOGE(TAG, "No message bus slot left");
+        return false;
+    }
+    
+    // Set before creating the task: a higher-priority task runs immediately
+    // and would otherwise see task_running == false and exit
+    streamer->task_running = true;
+    
+    if (task_config_create(udp_streamer_task, "udp_streamer", &streamer->task_config, streamer,
+                           streamer->task_buffer, streamer->task_stack, &streamer->task_handle)) {
+        ESP_LOGI(TAG, "UDP streamer task started successfully");
+        return true;
+    }
+    
+    streamer->task_running = false;
+    message_bus_unsubscribe(streamer->subscription);
+    streamer->subscription = MESSAGE_BUS_INVALID_SLOT;
+    ESP_LOGE(TAG, "Failed to start UDP streamer task");
+    return false;
+}
+
+void udp_streamer_stop(udp_streamer_t* streamer) {
+    if (!streamer || !streamer->task_running) {
+        return;
+    }
+    
+    message_bus_unsubscribe(streamer->subscription);
+    streamer->subscription = MESSAGE_BUS_INVALID_SLOT;
+    streamer->task_running = false;
+    
+    // Wake the task if it is idle in xQueueReceive
+    message_t wake;
+    wake.topic = (message_topic_t)STREAMER_WAKE_TOPIC;
+    xQueueSend(streamer->queue, &wake, 0);
+    
+    if (!task_lifecycle_stop(streamer->event_group, &streamer->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "UDP streamer task did not exit in time, deleted");
+    }
+    
+    ESP_LOGI(TAG, "UDP streamer stopped");
+}
\ No newline at end of file
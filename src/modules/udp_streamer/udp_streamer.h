@@ -0,0 +1,129 @@
+#ifndef UDP_STREAMER_H
+#define UDP_STREAMER_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "../sensor_reader/sensor_driver.h"
+#include "../message_bus/message_bus.h"
+#include "../telemetry_log/telemetry_record.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Live sample stream over UDP, read by tools/udp_stream_client.py.
+//
+// A host subscribes by sending a udp_stream_header_t of type SUBSCRIBE to
+// the streamer's port, and renews it before lease_ms runs out. Each data
+// datagram is the header followed by telemetry records: a timebase, then
+// `count` samples, so it decodes on its own even after a lost datagram.
+// seq increments once per datagram, so gaps reveal loss.
+#define UDP_STREAM_MAGIC_0 'S'
+#define UDP_STREAM_MAGIC_1 'S'
+#define UDP_STREAM_VERSION 1
+
+#define UDP_STREAM_DATA        0x01
+#define UDP_STREAM_SUBSCRIBE   0x02
+#define UDP_STREAM_UNSUBSCRIBE 0x03
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic[2];
+    uint8_t version;
+    uint8_t type;
+    uint32_t seq;
+    uint32_t time_ms; // Device time when sent
+    uint16_t count;   // Sample records after the timebase
+    uint16_t reserved;
+} udp_stream_header_t;
+
+// 16 + 89 * 16 = 1440 bytes, inside one 1472-byte UDP payload (1500 MTU)
+#define UDP_STREAMER_MAX_BATCH 88
+#define UDP_STREAMER_MAX_DATAGRAM (sizeof(udp_stream_header_t) + \
+                                   (UDP_STREAMER_MAX_BATCH + 1) * sizeof(telemetry_record_t))
+#define UDP_STREAMER_MAX_SUBSCRIBERS 4
+#define UDP_STREAMER_QUEUE_LENGTH 16
+#define UDP_STREAMER_STACK_SIZE 3072
+
+// Same priority as the MQTT uplink, below WiFi (4)
+#define UDP_STREAMER_DEFAULT_TASK_CONFIG { UDP_STREAMER_STACK_SIZE, 3, tskNO_AFFINITY, 0 }
+
+typedef struct {
+    uint16_t port;           // Local port; subscribe requests arrive here
+    uint16_t batch_size;     // Samples per datagram, up to UDP_STREAMER_MAX_BATCH
+    uint32_t max_latency_ms; // Send a partial datagram once its oldest sample is this old
+    uint32_t lease_ms;       // Subscriptions expire unless renewed
+    uint32_t poll_ms;        // Check for subscribe requests at least this often
+} udp_streamer_config_t;
+
+#define UDP_STREAMER_DEFAULT_CONFIG { 4950, 32, 50, 30000, 100 }
+
+typedef struct {
+    uint32_t received;       // Samples from the message bus
+    uint32_t streamed;       // Samples sent in datagrams
+    uint32_t datagrams;
+    uint32_t send_errors;    // Failed sendto(), per subscriber
+    uint32_t max_latency_ms; // Oldest sample's age when its datagram went out
+    uint32_t subscribers;
+} udp_streamer_stats_t;
+
+typedef struct {
+    uint32_t address; // IPv4, network order
+    uint16_t port;    // Network order
+    TickType_t expires;
+} udp_streamer_subscriber_t;
+
+typedef struct {
+    udp_streamer_config_t config;
+    // Task-owned state
+    uint8_t datagram[UDP_STREAMER_MAX_DATAGRAM]; // Samples are encoded in place
+    telemetry_encoder_t encoder;
+    uint16_t batch_count;
+    TickType_t batch_started; // Timestamp of the batch's first sample
+    uint32_t seq;
+    udp_streamer_subscriber_t subscribers[UDP_STREAMER_MAX_SUBSCRIBERS];
+    uint8_t subscriber_count;
+    TickType_t polled_at;
+    int socket;
+    bool open_failed; // The last open failed; retried at every poll
+    bool network_up;
+    udp_streamer_stats_t stats;
+    QueueHandle_t queue;
+    EventGroupHandle_t event_group; // Task lifecycle bits only
+    int subscription;
+    TaskHandle_t task_handle;
+    bool task_running;
+    task_config_t task_config;
+    // Set by udp_streamer_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
+} udp_streamer_t;
+
+// Caller-provided storage for udp_streamer_create_static(); must outlive
+// the streamer
+typedef struct {
+    udp_streamer_t streamer;
+    StaticQueue_t queue;
+    uint8_t queue_storage[UDP_STREAMER_QUEUE_LENGTH * sizeof(message_t)];
+    StaticEventGroup_t event_group;
+    StaticTask_t task;
+    StackType_t stack[UDP_STREAMER_STACK_SIZE];
+} udp_streamer_storage_t;
+
+udp_streamer_t* udp_streamer_create(const udp_streamer_config_t* config);
+udp_streamer_t* udp_streamer_create_static(udp_streamer_storage_t* storage, const udp_streamer_config_t* config);
+void udp_streamer_destroy(udp_streamer_t* streamer);
+bool udp_streamer_get_stats(udp_streamer_t* streamer, udp_streamer_stats_t* stats);
+bool udp_streamer_configure_task(udp_streamer_t* streamer, const task_config_t* config);
+bool udp_streamer_start(udp_streamer_t* streamer);
+void udp_streamer_stop(udp_streamer_t* streamer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,96 +1,280 @@
 #include "wifi_manager.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "../system_metrics/system_metrics.h"
+#include "../message_bus/message_bus.h"
+#include "../trace_recorder/trace_recorder.h"
 
 static const char* TAG = "WiFiManager";
 
+// Last AP we got an IP from. Kept in RTC memory so a reconnect after a
+// brief drop or deep sleep can skip the full channel scan.
+typedef struct {
+    uint32_t magic;
+    char ssid[32];
+    uint8_t bssid[6];
+    int32_t channel;
+} wifi_ap_cache_t;
+
+#define WIFI_AP_CACHE_MAGIC 0x57494649
+
+static RTC_DATA_ATTR wifi_ap_cache_t ap_cache;
+
+static bool wifi_ap_cache_valid(const wifi_manager_t* manager) {
+    return ap_cache.magic == WIFI_AP_CACHE_MAGIC &&
+           strncmp(ap_cache.ssid, manager->ssid, sizeof(ap_cache.ssid)) == 0;
+}
+
+static void wifi_ap_cache_store(const wifi_manager_t* manager) {
+    const uint8_t* bssid = WiFi.BSSID();
+    if (!bssid) return;
+    
+    strncpy(ap_cache.ssid, manager->ssid, sizeof(ap_cache.ssid));
+    memcpy(ap_cache.bssid, bssid, sizeof(ap_cache.bssid));
+    ap_cache.channel = WiFi.channel();
+    ap_cache.magic = WIFI_AP_CACHE_MAGIC;
+}
+
+static void wifi_manager_set_state(wifi_manager_t* manager, wifi_state_t state) {
+    static const EventBits_t all_bits = WIFI_EVENT_CONNECTED | WIFI_EVENT_DISCONNECTED | WIFI_EVENT_FAILED;
+    EventBits_t bit = 0;
+    
+    switch (state) {
+        case WIFI_STATE_CONNECTED: bit = WIFI_EVENT_CONNECTED; break;
+        case WIFI_STATE_DISCONNECTED: bit = WIFI_EVENT_DISCONNECTED; break;
+        case WIFI_STATE_FAILED: bit = WIFI_EVENT_FAILED; break;
+        case WIFI_STATE_CONNECTING: break;
+    }
+    
+    bool changed = manager->current_state != state;
+    manager->current_state = state;
+    if (state != WIFI_STATE_CONNECTING) {
+        manager->connect_pending = false;
+    }
+    
+    // Event bits mirror the current state so waiters never see a stale one
+    xEventGroupClearBits(manager->event_group, all_bits & ~bit);
+    if (bit) {
+        xEventGroupSetBits(manager->event_group, bit);
+    }
+    
+    if (changed) {
+        TRACE_INSTANT(TRACE_SPAN_WIFI_STATE, state);
+        message_t message;
+        message.topic = MESSAGE_TOPIC_WIFI_STATE;
+        message.wifi_state = (uint8_t)state;
+        message_bus_publish(&message);
+    }
+}
+
+static void wifi_manager_begin_connect(wifi_manager_t* manager) {
+    manager->retry_pending = false;
+    manager->connection_start_time = millis();
+    
+    if (manager->current_state != WIFI_STATE_CONNECTING) {
+        wifi_manager_set_state(manager, WIFI_STATE_CONNECTING);
+    }
+    manager->connect_pending = true;
+    manager->connect_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(WIFI_MANAGER_CONNECT_TIMEOUT_MS);
+    
+    // Single place WiFi.begin() is issued from
+    bool fast = wifi_reconnect_on_attempt(&manager->reconnect, manager->connection_start_time);
+    
+    TRACE_SPAN_BEGIN(TRACE_SPAN_WIFI_BEGIN);
+    if (fast && wifi_ap_cache_valid(manager)) {
+        ESP_LOGI(TAG, "Fast reconnect to %s on channel %ld", manager->ssid, (long)ap_cache.channel);
+        WiFi.begin(manager->ssid, manager->password, ap_cache.channel, ap_cache.bssid);
+    } else {
+        ESP_LOGI(TAG, "Attempting to connect to WiFi: %s", manager->ssid);
+        WiFi.begin(manager->ssid, manager->password);
+    }
+    TRACE_SPAN_END(TRACE_SPAN_WIFI_BEGIN);
+}
+
+static void wifi_manager_schedule_retry(wifi_manager_t* manager) {
+    if (!manager->connect_requested) return;
+    
+    uint32_t delay_ms = wifi_reconnect_on_disconnect(&manager->reconnect, millis());
+    
+    manager->retry_pending = true;
+    manager->retry_at = xTaskGetTickCount() + pdMS_TO_TICKS(delay_ms);
+    ESP_LOGI(TAG, "Reconnecting in %lu ms", (unsigned long)delay_ms);
+}
+
+static void wifi_manager_handle_event(wifi_manager_t* manager, const wifi_manager_event_t* event) {
+    TRACE_SPAN_BEGIN(TRACE_SPAN_WIFI_EVENT);
+    
+    switch (event->type) {
+        case WIFI_MANAGER_EVENT_CONNECT_REQUEST:
+            manager->connect_requested = true;
+            WiFi.mode(WIFI_STA);
+            WiFi.setAutoReconnect(false); // Reconnects go through our policy
+            wifi_manager_begin_connect(manager);
+            break;
+        
+        case WIFI_MANAGER_EVENT_DISCONNECT_REQUEST:
+            manager->connect_requested = false;
+            manager->retry_pending = false;
+            wifi_reconnect_reset(&manager->reconnect);
+            WiFi.disconnect(true);
+            wifi_manager_set_state(manager, WIFI_STATE_DISCONNECTED);
+            ESP_LOGI(TAG, "WiFi disconnected");
+            break;
+        
+        case WIFI_MANAGER_EVENT_STA_CONNECTED:
+            // Associated; stay CONNECTING until an IP is assigned
+            ESP_LOGI(TAG, "WiFi associated, waiting for IP");
+            break;
+        
+        case WIFI_MANAGER_EVENT_GOT_IP:
+            manager->retry_pending = false;
+            if (manager->current_state != WIFI_STATE_CONNECTED) {
+                wifi_manager_set_state(manager, WIFI_STATE_CONNECTED);
+                wifi_reconnect_on_connected(&manager->reconnect, millis());
+                wifi_ap_cache_store(manager);
+                ESP_LOGI(TAG, "WiFi connected to: %s", WiFi.SSID().c_str());
+                ESP_LOGI(TAG, "IP Address: %s", WiFi.localIP().toString().c_str());
+            }
+            break;
+        
+        case WIFI_MANAGER_EVENT_STA_DISCONNECTED:
+            if (manager->current_state == WIFI_STATE_CONNECTED) {
+                wifi_manager_set_state(manager, WIFI_STATE_DISCONNECTED);
+                ESP_LOGI(TAG, "WiFi connection lost (reason %d)", event->reason);
+            } else if (manager->current_state == WIFI_STATE_CONNECTING) {
+                wifi_manager_set_state(manager, WIFI_STATE_FAILED);
+                ESP_LOGE(TAG, "WiFi connection failed (reason %d)", event->reason);
+            }
+        
+            if (!manager->retry_pending) {
+                wifi_manager_schedule_retry(manager);
+            }
+            break;
+        
+        case WIFI_MANAGER_EVENT_CONNECT_TIMEOUT:
+            if (manager->current_state == WIFI_STATE_CONNECTING) {
+                // The driver may still be scanning or associating
+                WiFi.disconnect();
+                wifi_manager_set_state(manager, WIFI_STATE_FAILED);
+                ESP_LOGE(TAG, "WiFi connection timed out after %d ms", WIFI_MANAGER_CONNECT_TIMEOUT_MS);
+            
+                if (!manager->retry_pending) {
+                    wifi_manager_schedule_retry(manager);
+                }
+            }
+            break;
+        
+        case WIFI_MANAGER_EVENT_STOP:
+            break;
+    }
+    
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - event->posted_us);
+    manager->last_event_latency_us = latency;
+    if (latency > manager->max_event_latency_us) {
+        manager->max_event_latency_us = latency;
+    }
+    TRACE_SPAN_END(TRACE_SPAN_WIFI_EVENT);
+}
+
+// Ticks until deadline, 0 once it has passed
+static TickType_t wifi_manager_ticks_until(TickType_t deadline) {
+    int32_t remaining = (int32_t)(deadline - xTaskGetTickCount());
+    return (remaining > 0) ? (TickType_t)remaining : 0;
+}
+
 static void wifi_manager_task(void* arg) {
     wifi_manager_t* manager = (wifi_manager_t*)arg;
     
     ESP_LOGI(TAG, "WiFi manager task started");
     
-    // Set up WiFi event handlers using Arduino callbacks
-    auto onWiFiConnected = [](arduino_event_id_t event) {
-        ESP_LOGI(TAG, "WiFi Connected (Arduino event)");
-        // We'll handle state changes in the main task loop instead
-    };
+    // Driver events are forwarded to the task queue; all state changes
+    // happen in the task
+    wifi_event_id_t connected_id = WiFi.onEvent(
+        [manager](arduino_event_id_t event, arduino_event_info_t info) {
+            wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_STA_CONNECTED, 0);
+        },
+        ARDUINO_EVENT_WIFI_STA_CONNECTED);
     
-    auto onWiFiGotIP = [](arduino_event_id_t event) {
-        ESP_LOGI(TAG, "WiFi Got IP (Arduino event)");
-    };
+    wifi_event_id_t got_ip_id = WiFi.onEvent(
+        [manager](arduino_event_id_t event, arduino_event_info_t info) {
+            wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_GOT_IP, 0);
+        },
+        ARDUINO_EVENT_WIFI_STA_GOT_IP);
     
-    auto onWiFiDisconnected = [](arduino_event_id_t event) {
-        ESP_LOGI(TAG, "WiFi Disconnected (Arduino event)");
-    };
+    wifi_event_id_t disconnected_id = WiFi.onEvent(
+        [manager](arduino_event_id_t event, arduino_event_info_t info) {
+            wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_STA_DISCONNECTED,
+                                    info.wifi_sta_disconnected.reason);
+        },
+        ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
     
-    WiFi.onEvent(onWiFiConnected, ARDUINO_EVENT_WIFI_STA_CONNECTED);
-    WiFi.onEvent(onWiFiGotIP, ARDUINO_EVENT_WIFI_STA_GOT_IP);
-    WiFi.onEvent(onWiFiDisconnected, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    int metrics = system_metrics_register("wifi_manager", 0);
     
     while (manager->task_running) {
-        // Check WiFi status using Arduino API
-        wl_status_t status = WiFi.status();
-        
-        switch (status) {
-            case WL_CONNECTED:
-                if (manager->current_state != WIFI_STATE_CONNECTED) {
-                    manager->current_state = WIFI_STATE_CONNECTED;
-                    xEventGroupSetBits(manager->event_group, WIFI_EVENT_CONNECTED);
-                    ESP_LOGI(TAG, "WiFi connected to: %s", WiFi.SSID().c_str());
-                    ESP_LOGI(TAG, "IP Address: %s", WiFi.localIP().toString().c_str());
-                }
-                break;
-                
-            case WL_IDLE_STATUS:
-            case WL_NO_SSID_AVAIL:
-            case WL_SCAN_COMPLETED:
-                if (manager->current_state != WIFI_STATE_CONNECTING) {
-                    manager->current_state = WIFI_STATE_CONNECTING;
-                    ESP_LOGI(TAG, "WiFi connecting...");
-                }
-                break;
-                
-            case WL_CONNECT_FAILED:
-            case WL_CONNECTION_LOST:
-                if (manager->current_state != WIFI_STATE_FAILED) {
-                    manager->current_state = WIFI_STATE_FAILED;
-                    xEventGroupSetBits(manager->event_group, WIFI_EVENT_FAILED);
-                    ESP_LOGE(TAG, "WiFi connection failed");
-                    
-                    // Attempt reconnection after delay
-                    vTaskDelay(pdMS_TO_TICKS(5000));
-                    WiFi.begin(manager->ssid, manager->password);
-                }
-                break;
-                
-            case WL_DISCONNECTED:
-                if (manager->current_state != WIFI_STATE_DISCONNECTED) {
-                    manager->current_state = WIFI_STATE_DISCONNECTED;
-                    xEventGroupSetBits(manager->event_group, WIFI_EVENT_DISCONNECTED);
-                    ESP_LOGI(TAG, "WiFi disconnected");
-                    
-                    // Attempt reconnection after delay
-                    vTaskDelay(pdMS_TO_TICKS(5000));
-                    WiFi.begin(manager->ssid, manager->password);
-                }
-                break;
+        // Block until the next event, a pending retry or the connect deadline
+        TickType_t timeout = portMAX_DELAY;
+        if (manager->retry_pending) {
+            timeout = wifi_manager_ticks_until(manager->retry_at);
+        }
+        if (manager->connect_pending && wifi_manager_ticks_until(manager->connect_deadline) < timeout) {
+            timeout = wifi_manager_ticks_until(manager->connect_deadline);
         }
         
-        // If we're supposed to be connected but we're not, try to reconnect
-        if (manager->current_state == WIFI_STATE_DISCONNECTED || 
-            manager->current_state == WIFI_STATE_FAILED) {
-            unsigned long now = millis();
-            if (now - manager->connection_start_time > 10000) { // Every 10 seconds
-                ESP_LOGI(TAG, "Attempting to reconnect to WiFi...");
-                WiFi.begin(manager->ssid, manager->password);
-                manager->connection_start_time = now;
+        wifi_manager_event_t event;
+        BaseType_t received = xQueueReceive(manager->event_queue, &event, timeout);
+        system_metrics_wake(metrics);
+        
+        if (received == pdTRUE) {
+            if (event.type == WIFI_MANAGER_EVENT_STOP) {
+                break;
             }
+            system_metrics_event(metrics, 1);
+            wifi_manager_handle_event(manager, &event);
+        } else if (manager->connect_pending && wifi_manager_ticks_until(manager->connect_deadline) == 0) {
+            wifi_manager_event_t timeout_event;
+            timeout_event.type = WIFI_MANAGER_EVENT_CONNECT_TIMEOUT;
+            timeout_event.reason = 0;
+            timeout_event.posted_us = esp_timer_get_time();
+            system_metrics_event(metrics, 1);
+            wifi_manager_handle_event(manager, &timeout_event);
+        } else if (manager->retry_pending && wifi_manager_ticks_until(manager->retry_at) == 0) {
+            wifi_manager_begin_connect(manager);
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
+    WiFi.removeEvent(connected_id);
+    WiFi.removeEvent(got_ip_id);
+    WiFi.removeEvent(disconnected_id);
+    
     WiFi.disconnect(true);
+    system_metrics_unregister(metrics);
     ESP_LOGI(TAG, "WiFi manager task exiting");
-    vTaskDelete(NULL);
+    task_lifecycle_exit(manager->event_group);
+}
+
+static void wifi_manager_init(wifi_manager_t* manager, const char* ssid, const char* password) {
+    strncpy(manager->ssid, ssid, sizeof(manager->ssid) - 1);
+    manager->ssid[sizeof(manager->ssid) - 1] = '\0';
+    strncpy(manager->password, password, sizeof(manager->password) - 1);
+    manager->password[sizeof(manager->password) - 1] = '\0';
+    manager->current_state = WIFI_STATE_DISCONNECTED;
+    manager->task_handle = NULL;
+    manager->task_running = false;
+    manager->connect_requested = false;
+    manager->retry_pending = false;
+    manager->retry_at = 0;
+    manager->connect_pending = false;
+    manager->connect_deadline = 0;
+    manager->connection_start_time = 0;
+    manager->last_event_latency_us = 0;
+    manager->max_event_latency_us = 0;
+    
+    wifi_reconnect_config_t reconnect_config = WIFI_RECONNECT_DEFAULT_CONFIG;
+    wifi_reconnect_init(&manager->reconnect, &reconnect_config, esp_random());
+    task_config_t task_config = WIFI_MANAGER_DEFAULT_TASK_CONFIG;
+    manager->task_config = task_config;
+    manager->task_buffer = NULL;
+    manager->task_stack = NULL;
 }
 
 wifi_manager_t* wifi_manager_create(const char* ssid, const char* password) {
@@ -100,12 +284,7 @@ wifi_manager_t* wifi_manager_create(const char* ssid, const char* password) {
         return NULL;
     }
     
-    strncpy(manager->ssid, ssid, sizeof(manager->ssid) - 1);
-    strncpy(manager->password, password, sizeof(manager->password) - 1);
-    manager->current_state = WIFI_STATE_DISCONNECTED;
-    manager->task_handle = NULL;
-    manager->task_running = false;
-    manager->connection_start_time = 0;
+    wifi_manager_init(manager, ssid, password);
     
     // Create event group
     manager->event_group = xEventGroupCreate();
@@ -115,41 +294,86 @@ wifi_manager_t* wifi_manager_create(const char* ssid, const char* password) {
         return NULL;
     }
     
+    // Create event queue
+    manager->event_queue = xQueueCreate(WIFI_MANAGER_EVENT_QUEUE_LENGTH, sizeof(wifi_manager_event_t));
+    if (!manager->event_queue) {
+        ESP_LOGE(TAG, "Failed to create event queue");
+        vEventGroupDelete(manager->event_group);
+        free(manager);
+        return NULL;
+    }
+    
     ESP_LOGI(TAG, "WiFi manager created for SSID: %s", ssid);
     return manager;
 }
 
+// Same as wifi_manager_create(), but the manager, its event group, queue
+// and task live in storage and nothing is taken from the heap
+wifi_manager_t* wifi_manager_create_static(wifi_manager_storage_t* storage, const char* ssid, const char* password) {
+    if (!storage) return NULL;
+    
+    wifi_manager_t* manager = &storage->manager;
+    wifi_manager_init(manager, ssid, password);
+    manager->task_buffer = &storage->task;
+    manager->task_stack = storage->stack;
+    manager->event_group = xEventGroupCreateStatic(&storage->event_group);
+    manager->event_queue = xQueueCreateStatic(WIFI_MANAGER_EVENT_QUEUE_LENGTH, sizeof(wifi_manager_event_t),
+                                              storage->event_queue_storage, &storage->event_queue);
+    
+    ESP_LOGI(TAG, "WiFi manager created for SSID: %s (static)", ssid);
+    return manager;
+}
+
 void wifi_manager_destroy(wifi_manager_t* manager) {
     if (!manager) return;
     
     wifi_manager_stop(manager);
     wifi_manager_disconnect(manager);
     
+    if (manager->event_queue) {
+        vQueueDelete(manager->event_queue);
+    }
+    
     if (manager->event_group) {
         vEventGroupDelete(manager->event_group);
     }
     
-    free(manager);
+    if (!manager->task_buffer) {
+        free(manager);
+    }
     ESP_LOGI(TAG, "WiFi manager destroyed");
 }
 
-bool wifi_manager_connect(wifi_manager_t* manager) {
+bool wifi_manager_post_event(wifi_manager_t* manager, wifi_manager_event_type_t type, uint8_t reason) {
     if (!manager) return false;
     
-    manager->current_state = WIFI_STATE_CONNECTING;
-    manager->connection_start_time = millis();
-    
-    // Use Arduino WiFi API
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(manager->ssid, manager->password);
+    wifi_manager_event_t event;
+    event.type = type;
+    event.reason = reason;
+    event.posted_us = esp_timer_get_time();
     
-    ESP_LOGI(TAG, "Attempting to connect to WiFi: %s", manager->ssid);
+    // Never block the WiFi driver's event task
+    if (xQueueSend(manager->event_queue, &event, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Event queue full, dropping event %d", type);
+        return false;
+    }
     return true;
 }
 
+bool wifi_manager_connect(wifi_manager_t* manager) {
+    if (!manager) return false;
+    
+    return wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_CONNECT_REQUEST, 0);
+}
+
 void wifi_manager_disconnect(wifi_manager_t* manager) {
     if (!manager) return;
     
+    if (manager->task_running) {
+        wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_DISCONNECT_REQUEST, 0);
+        return;
+    }
+    
     WiFi.disconnect(true);
     manager->current_state = WIFI_STATE_DISCONNECTED;
     
@@ -160,26 +384,53 @@ wifi_state_t wifi_manager_get_state(wifi_manager_t* manager) {
     return manager ? manager->current_state : WIFI_STATE_DISCONNECTED;
 }
 
+bool wifi_manager_get_event_latency(wifi_manager_t* manager, uint32_t* last_us, uint32_t* max_us) {
+    if (!manager) return false;
+    
+    if (last_us) *last_us = manager->last_event_latency_us;
+    if (max_us) *max_us = manager->max_event_latency_us;
+    return true;
+}
+
+bool wifi_manager_get_reconnect_stats(wifi_manager_t* manager, wifi_reconnect_stats_t* stats) {
+    if (!manager || !stats) return false;
+    
+    *stats = manager->reconnect.stats;
+    return true;
+}
+
+// Stack size, priority, core and period used by the next wifi_manager_start().
+// Statically allocated managers cannot grow their stack beyond WIFI_MANAGER_STACK_SIZE.
+bool wifi_manager_configure_task(wifi_manager_t* manager, const task_config_t* config) {
+    if (!manager || manager->task_running) {
+        return false;
+    }
+    
+    if (!task_config_valid(config, manager->task_buffer ? WIFI_MANAGER_STACK_SIZE : 0)) {
+        ESP_LOGE(TAG, "Invalid task configuration");
+        return false;
+    }
+    
+    manager->task_config = *config;
+    return true;
+}
+
 bool wifi_manager_start(wifi_manager_t* manager) {
     if (!manager || manager->task_running) {
         return false;
     }
     
-    BaseType_t result = xTaskCreate(
-        wifi_manager_task,
-        "wifi_manager",
-        8192,
-        manager,
-        4,  // Lower priority than sensor reading
-        &manager->task_handle
-    );
+    // Set before creating the task: a higher-priority task runs immediately
+    // and would otherwise see task_running == false and exit
+    manager->task_running = true;
     
-    if (result == pdPASS) {
-        manager->task_running = true;
+    if (task_config_create(wifi_manager_task, "wifi_manager", &manager->task_config, manager,
+                           manager->task_buffer, manager->task_stack, &manager->task_handle)) {
         ESP_LOGI(TAG, "WiFi manager task started successfully");
         return true;
     }
     
+    manager->task_running = false;
     ESP_LOGE(TAG, "Failed to start WiFi manager task");
     return false;
 }
@@ -189,12 +440,11 @@ void wifi_manager_stop(wifi_manager_t* manager) {
         return;
     }
     
+    // The task blocks on its event queue, not the event group
     manager->task_running = false;
-    
-    if (manager->task_handle) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        vTaskDelete(manager->task_handle);
-        manager->task_handle = NULL;
+    wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_STOP, 0);
+    if (!task_lifecycle_stop(manager->event_group, &manager->task_handle, TASK_LIFECYCLE_JOIN_TIMEOUT)) {
+        ESP_LOGW(TAG, "WiFi manager task did not exit in time, deleted");
     }
     
     ESP_LOGI(TAG, "WiFi manager stopped");
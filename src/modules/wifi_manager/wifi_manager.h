@@ -4,40 +4,95 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
 #include "WiFi.h"
 #include "esp_log.h"
+#include "wifi_reconnect.h"
+#include "wifi_state.h"
+#include "../common/task_config.h"
+#include "../common/task_lifecycle.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Inputs to the state machine, from the WiFi driver or from API calls
 typedef enum {
-    WIFI_STATE_DISCONNECTED = 0,
-    WIFI_STATE_CONNECTING,
-    WIFI_STATE_CONNECTED,
-    WIFI_STATE_FAILED
-} wifi_state_t;
+    WIFI_MANAGER_EVENT_CONNECT_REQUEST = 0,
+    WIFI_MANAGER_EVENT_DISCONNECT_REQUEST,
+    WIFI_MANAGER_EVENT_STA_CONNECTED,
+    WIFI_MANAGER_EVENT_GOT_IP,
+    WIFI_MANAGER_EVENT_STA_DISCONNECTED,
+    WIFI_MANAGER_EVENT_CONNECT_TIMEOUT, // Posted by the task at the connect deadline
+    WIFI_MANAGER_EVENT_STOP
+} wifi_manager_event_type_t;
+
+typedef struct {
+    wifi_manager_event_type_t type;
+    uint8_t reason;     // Driver disconnect reason, 0 otherwise
+    int64_t posted_us;  // esp_timer_get_time() when queued
+} wifi_manager_event_t;
+
+#define WIFI_MANAGER_EVENT_QUEUE_LENGTH 8
+// An attempt without an IP by then is abandoned and retried through the
+// reconnect policy
+#ifndef WIFI_MANAGER_CONNECT_TIMEOUT_MS
+#define WIFI_MANAGER_CONNECT_TIMEOUT_MS 10000
+#endif
+#define WIFI_MANAGER_STACK_SIZE 8192
+// Lower priority than sensor reading
+#define WIFI_MANAGER_DEFAULT_TASK_CONFIG { WIFI_MANAGER_STACK_SIZE, 4, tskNO_AFFINITY, 0 }
 
 typedef struct {
     char ssid[32];
     char password[64];
-    wifi_state_t current_state;
+    volatile wifi_state_t current_state;
     TaskHandle_t task_handle;
     EventGroupHandle_t event_group;
+    QueueHandle_t event_queue;
     bool task_running;
+    bool connect_requested;
+    bool retry_pending;
+    TickType_t retry_at;
+    bool connect_pending; // Attempt in progress, abandoned at connect_deadline
+    TickType_t connect_deadline;
     unsigned long connection_start_time;
+    wifi_reconnect_policy_t reconnect;
+    // Event-to-state latency: queued event to state and event bits updated
+    uint32_t last_event_latency_us;
+    uint32_t max_event_latency_us;
+    task_config_t task_config;
+    // Set by wifi_manager_create_static(); NULL when heap-allocated
+    StaticTask_t* task_buffer;
+    StackType_t* task_stack;
 } wifi_manager_t;
 
+// Caller-provided storage for wifi_manager_create_static(); must outlive
+// the manager
+typedef struct {
+    wifi_manager_t manager;
+    StaticEventGroup_t event_group;
+    StaticQueue_t event_queue;
+    uint8_t event_queue_storage[WIFI_MANAGER_EVENT_QUEUE_LENGTH * sizeof(wifi_manager_event_t)];
+    StaticTask_t task;
+    StackType_t stack[WIFI_MANAGER_STACK_SIZE];
+} wifi_manager_storage_t;
+
 // Events
 #define WIFI_EVENT_CONNECTED    (1 << 0)
 #define WIFI_EVENT_DISCONNECTED (1 << 1)
 #define WIFI_EVENT_FAILED       (1 << 2)
 
 wifi_manager_t* wifi_manager_create(const char* ssid, const char* password);
+wifi_manager_t* wifi_manager_create_static(wifi_manager_storage_t* storage, const char* ssid, const char* password);
 void wifi_manager_destroy(wifi_manager_t* manager);
 bool wifi_manager_connect(wifi_manager_t* manager);
 void wifi_manager_disconnect(wifi_manager_t* manager);
 wifi_state_t wifi_manager_get_state(wifi_manager_t* manager);
+bool wifi_manager_post_event(wifi_manager_t* manager, wifi_manager_event_type_t type, uint8_t reason);
+bool wifi_manager_get_event_latency(wifi_manager_t* manager, uint32_t* last_us, uint32_t* max_us);
+bool wifi_manager_get_reconnect_stats(wifi_manager_t* manager, wifi_reconnect_stats_t* stats);
+bool wifi_manager_configure_task(wifi_manager_t* manager, const task_config_t* config);
 bool wifi_manager_start(wifi_manager_t* manager);
 void wifi_manager_stop(wifi_manager_t* manager);
 
@@ -0,0 +1,92 @@
+#include "wifi_reconnect.h"
+#include <string.h>
+
+static const uint32_t histogram_limits_ms[WIFI_RECONNECT_HISTOGRAM_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 30000
+};
+
+// xorshift32; deterministic for a given seed
+static uint32_t wifi_reconnect_random(wifi_reconnect_policy_t* policy) {
+    uint32_t x = policy->rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    policy->rng_state = x;
+    return x;
+}
+
+void wifi_reconnect_init(wifi_reconnect_policy_t* policy, const wifi_reconnect_config_t* config, uint32_t seed) {
+    if (!policy || !config) return;
+    
+    memset(policy, 0, sizeof(*policy));
+    policy->config = *config;
+    policy->rng_state = seed ? seed : 0x9E3779B9u;
+}
+
+// Returns the delay before the next attempt. The cap doubles per consecutive
+// failure up to max_delay_ms; the delay is drawn from [cap/2, cap] so devices
+// dropped by the same AP spread out instead of retrying in lockstep.
+uint32_t wifi_reconnect_on_disconnect(wifi_reconnect_policy_t* policy, uint32_t now_ms) {
+    if (!policy) return 0;
+    
+    if (!policy->in_outage) {
+        policy->in_outage = true;
+        policy->outage_start_ms = now_ms;
+    }
+    
+    uint32_t cap = policy->config.base_delay_ms;
+    for (uint32_t i = 0; i < policy->failures && cap < policy->config.max_delay_ms; i++) {
+        cap *= 2;
+    }
+    if (cap > policy->config.max_delay_ms) {
+        cap = policy->config.max_delay_ms;
+    }
+    
+    uint32_t half = cap / 2;
+    return half + wifi_reconnect_random(policy) % (cap - half + 1);
+}
+
+// Records an attempt; returns true if it should use the cached BSSID/channel
+bool wifi_reconnect_on_attempt(wifi_reconnect_policy_t* policy, uint32_t now_ms) {
+    if (!policy) return false;
+    
+    if (!policy->in_outage) {
+        policy->in_outage = true;
+        policy->outage_start_ms = now_ms;
+    }
+    
+    bool fast = policy->failures < policy->config.fast_reconnect_attempts;
+    
+    policy->failures++;
+    policy->stats.attempts++;
+    if (fast) {
+        policy->stats.fast_attempts++;
+    }
+    return fast;
+}
+
+void wifi_reconnect_on_connected(wifi_reconnect_policy_t* policy, uint32_t now_ms) {
+    if (!policy) return;
+    
+    if (policy->in_outage) {
+        uint32_t elapsed = now_ms - policy->outage_start_ms;
+        uint32_t bucket = 0;
+        
+        while (bucket < WIFI_RECONNECT_HISTOGRAM_BUCKETS - 1 && elapsed >= histogram_limits_ms[bucket]) {
+            bucket++;
+        }
+        policy->stats.time_to_connect[bucket]++;
+    }
+    
+    policy->stats.successes++;
+    policy->failures = 0;
+    policy->in_outage = false;
+}
+
+// Forget the current outage (e.g. on a deliberate disconnect), keep stats
+void wifi_reconnect_reset(wifi_reconnect_policy_t* policy) {
+    if (!policy) return;
+    
+    policy->failures = 0;
+    policy->in_outage = false;
+}
\ No newline at end of file
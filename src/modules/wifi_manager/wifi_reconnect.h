@@ -0,0 +1,51 @@
+#ifndef WIFI_RECONNECT_H
+#define WIFI_RECONNECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reconnect policy: capped exponential backoff with jitter. Pure logic on a
+// caller-supplied millisecond clock so it can be driven by a simulated one.
+
+// Time-to-connect buckets: <1s, <2s, <5s, <10s, <30s, >=30s
+#define WIFI_RECONNECT_HISTOGRAM_BUCKETS 6
+
+typedef struct {
+    uint32_t base_delay_ms;         // Backoff cap for the first retry
+    uint32_t max_delay_ms;          // Upper bound on any retry delay
+    uint8_t fast_reconnect_attempts; // Attempts that may use the cached AP
+} wifi_reconnect_config_t;
+
+typedef struct {
+    uint32_t attempts;
+    uint32_t fast_attempts;
+    uint32_t successes;
+    uint32_t time_to_connect[WIFI_RECONNECT_HISTOGRAM_BUCKETS];
+} wifi_reconnect_stats_t;
+
+typedef struct {
+    wifi_reconnect_config_t config;
+    wifi_reconnect_stats_t stats;
+    uint32_t failures;      // Consecutive attempts since the last connect
+    uint32_t rng_state;
+    bool in_outage;
+    uint32_t outage_start_ms;
+} wifi_reconnect_policy_t;
+
+#define WIFI_RECONNECT_DEFAULT_CONFIG { 1000, 60000, 2 }
+
+void wifi_reconnect_init(wifi_reconnect_policy_t* policy, const wifi_reconnect_config_t* config, uint32_t seed);
+uint32_t wifi_reconnect_on_disconnect(wifi_reconnect_policy_t* policy, uint32_t now_ms);
+bool wifi_reconnect_on_attempt(wifi_reconnect_policy_t* policy, uint32_t now_ms);
+void wifi_reconnect_on_connected(wifi_reconnect_policy_t* policy, uint32_t now_ms);
+void wifi_reconnect_reset(wifi_reconnect_policy_t* policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
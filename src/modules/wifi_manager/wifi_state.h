@@ -0,0 +1,13 @@
+#ifndef WIFI_STATE_H
+#define WIFI_STATE_H
+
+// Connection state as published on MESSAGE_TOPIC_WIFI_STATE. Kept apart
+// from wifi_manager.h, which pulls in WiFi.h, so C modules can include it.
+typedef enum {
+    WIFI_STATE_DISCONNECTED = 0,
+    WIFI_STATE_CONNECTING,
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_FAILED
+} wifi_state_t;
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SIM_TEST_H
+#define SIM_TEST_H
+
+// Runs a Unity suite inside a task of the native shim's virtual-time kernel,
+// for tests that need tasks, event groups or queues. The process exits with
+// the Unity result; running out of simulated time, or every task blocking
+// forever, fails the run instead of passing it silently.
+
+#include <unity.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim_kernel.h"
+
+#define SIM_TEST_STACK_SIZE 16384
+// Simulated time available to a whole suite; pdMS_TO_TICKS() overflows
+// beyond about 71 minutes
+#define SIM_TEST_DEFAULT_DURATION_MS (60UL * 60 * 1000)
+
+static void (*sim_test_suite)(void);
+
+static void sim_test_task(void* arg) {
+    (void)arg;
+
+    UNITY_BEGIN();
+    sim_test_suite();
+    exit(UNITY_END());
+}
+
+// Runs suite, which calls RUN_TEST() for each test, at priority 1 like the
+// Arduino loopTask. Does not return.
+static inline void sim_test_run(void (*suite)(void), unsigned long duration_ms) {
+    sim_test_suite = suite;
+    sim_kernel_init(pdMS_TO_TICKS(duration_ms));
+    sim_kernel_set_finish_status(1);
+    xTaskCreatePinnedToCore(sim_test_task, "unity", SIM_TEST_STACK_SIZE, NULL, 1, NULL, 1);
+    sim_kernel_run();
+}
+
+#endif
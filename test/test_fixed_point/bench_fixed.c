@@ -0,0 +1,7 @@
+// Scaled-integer sensor_data_t values, whatever the build's flags
+#ifndef SENSOR_DATA_FIXED_POINT
+#define SENSOR_DATA_FIXED_POINT
+#endif
+#define BENCH_KERNEL bench_kernel_fixed
+#define BENCH_PREFIX(name) fixed_##name
+#include "bench_kernel.inc"
@@ -0,0 +1,5 @@
+// Float sensor_data_t values, whatever the build's flags
+#undef SENSOR_DATA_FIXED_POINT
+#define BENCH_KERNEL bench_kernel_float
+#define BENCH_PREFIX(name) float_##name
+#include "bench_kernel.inc"
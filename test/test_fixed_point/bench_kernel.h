@@ -0,0 +1,30 @@
+#ifndef BENCH_KERNEL_H
+#define BENCH_KERNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The per-sample path from decimator output to telemetry record, built
+// once per value representation (bench_float.c, bench_fixed.c)
+
+#define BENCH_INPUTS 4096
+
+typedef struct {
+    double ns_per_sample;
+    double ns_per_sample_no_record; // Calibration, copy and adaptive deltas only
+    uint32_t emitted;          // Samples adaptive mode let through
+    uint16_t record_crc;       // Over the records of the first pass
+    size_t sample_bytes;       // sizeof(sensor_data_t)
+    size_t message_bytes;      // sizeof(message_t), one message-bus queue slot
+    size_t history_bytes;      // sensor_reader_t history ring
+} bench_kernel_result_t;
+
+// Q4 decimator means for voltage, temperature and humidity, per input
+typedef struct {
+    uint32_t mean_q4[3];
+} bench_input_t;
+
+void bench_kernel_float(const bench_input_t* inputs, uint32_t passes, bench_kernel_result_t* result);
+void bench_kernel_fixed(const bench_input_t* inputs, uint32_t passes, bench_kernel_result_t* result);
+
+#endif
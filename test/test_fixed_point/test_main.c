@@ -0,0 +1,73 @@
+// Float against fixed-point sensor_data_t values in one binary: the
+// per-sample path from decimator means to telemetry record (calibration,
+// history copy, adaptive deltas, record encoding) built both ways, with
+// host time per sample and the size of a sample wherever it is buffered.
+// The host has a fast FPU, so the time ratio is only indicative; the
+// ESP32-S3's single-precision FPU is slower per operation and the sizes
+// carry over as they are.
+
+#include <unity.h>
+#include <stdio.h>
+#include "bench_kernel.h"
+
+#define BENCH_PASSES 400
+
+static bench_input_t inputs[BENCH_INPUTS];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Slow drift plus a little noise on each channel, in Q4 ADC counts, so
+// adaptive mode suppresses some samples and emits others
+static void make_inputs(void) {
+    uint32_t lcg = 1;
+
+    for (uint32_t i = 0; i < BENCH_INPUTS; i++) {
+        for (int channel = 0; channel < 3; channel++) {
+            lcg = lcg * 1664525u + 1013904223u;
+            uint32_t base = 1500 + 400 * (uint32_t)channel + (i / 8) % 200;
+            inputs[i].mean_q4[channel] = (base << 4) + (lcg >> 25);
+        }
+    }
+}
+
+static void print_result(const char* name, const bench_kernel_result_t* result) {
+    printf("%-8s %10.1f %12.1f %10u %12u %13u %13u\n", name, result->ns_per_sample,
+           result->ns_per_sample_no_record, (unsigned)result->emitted,
+           (unsigned)result->sample_bytes, (unsigned)result->message_bytes, (unsigned)result->history_bytes);
+}
+
+static void test_float_against_fixed_point(void) {
+    bench_kernel_result_t floating;
+    bench_kernel_result_t fixed;
+
+    make_inputs();
+    bench_kernel_float(inputs, BENCH_PASSES, &floating);
+    bench_kernel_fixed(inputs, BENCH_PASSES, &fixed);
+
+    printf("%-8s %10s %12s %10s %12s %13s %13s\n", "values", "ns/sample", "w/o record", "emitted", "sample (B)",
+           "message (B)", "history (B)");
+    print_result("float", &floating);
+    print_result("fixed", &fixed);
+
+    // Same records either way: calibration lands on the same scaled units
+    TEST_ASSERT_EQUAL_HEX32(floating.record_crc, fixed.record_crc);
+    // A float change of exactly one delta may round to either side of it,
+    // so adaptive mode decides a few boundary samples differently
+    TEST_ASSERT_TRUE(fixed.emitted > 0 && fixed.emitted < BENCH_INPUTS);
+    TEST_ASSERT_UINT32_WITHIN(fixed.emitted / 10, fixed.emitted, floating.emitted);
+
+    // Three 4-byte floats become three 2-byte integers
+    TEST_ASSERT_EQUAL_size_t(20, floating.sample_bytes);
+    TEST_ASSERT_EQUAL_size_t(16, fixed.sample_bytes);
+    TEST_ASSERT_TRUE(fixed.message_bytes < floating.message_bytes);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_float_against_fixed_point);
+    return UNITY_END();
+}
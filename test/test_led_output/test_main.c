@@ -0,0 +1,289 @@
+// LED output backends. A mock output records every (time, duty) command the
+// controller issues, so the breathe timeline can be checked against the
+// gamma curve and its smoothness and cost per period measured. The gpio
+// fallback is checked by sampling the pin every tick.
+
+#include <unity.h>
+#include <stdio.h>
+#include <time.h>
+#include "modules/led_controller/led_controller.h"
+#include "driver/ledc.h"
+#include "../sim_test.h"
+
+#define MOCK_CAPACITY 256
+#define BREATHE_PERIOD_MS 2000
+#define TEST_PIN 5
+
+typedef struct {
+    TickType_t tick;
+    uint16_t duty;
+    uint32_t fade_ms; // 0: set_duty
+} mock_command_t;
+
+static mock_command_t commands[MOCK_CAPACITY];
+static size_t command_count;
+
+static void mock_record(uint16_t duty, uint32_t fade_ms) {
+    if (command_count < MOCK_CAPACITY) {
+        commands[command_count].tick = xTaskGetTickCount();
+        commands[command_count].duty = duty;
+        commands[command_count].fade_ms = fade_ms;
+        command_count++;
+    }
+}
+
+static bool mock_begin(led_output_t* output, uint8_t pin) {
+    output->pin = pin;
+    output->duty = 0;
+    return true;
+}
+
+static void mock_set_duty(led_output_t* output, uint16_t duty) {
+    output->duty = duty;
+    mock_record(duty, 0);
+}
+
+static void mock_fade_to(led_output_t* output, uint16_t duty, uint32_t duration_ms) {
+    output->duty = duty;
+    mock_record(duty, duration_ms);
+}
+
+static void mock_end(led_output_t* output) {
+}
+
+static const led_output_ops_t mock_ops = { "mock", mock_begin, mock_set_duty, mock_fade_to, mock_end };
+
+// Duty the output shows at tick, fades being linear
+static uint16_t mock_duty_at(TickType_t tick) {
+    uint16_t from = 0;
+    uint16_t duty = 0;
+    
+    for (size_t i = 0; i < command_count && (int32_t)(commands[i].tick - tick) <= 0; i++) {
+        from = duty;
+        duty = commands[i].duty;
+        TickType_t elapsed = tick - commands[i].tick;
+        if (commands[i].fade_ms && elapsed < pdMS_TO_TICKS(commands[i].fade_ms)) {
+            duty = (uint16_t)(from + ((int32_t)commands[i].duty - from) * (int32_t)elapsed /
+                              (int32_t)pdMS_TO_TICKS(commands[i].fade_ms));
+        }
+    }
+    return duty;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void setUp(void) {
+    command_count = 0;
+}
+
+void tearDown(void) {
+}
+
+static void test_breathe_follows_gamma_curve_without_jumps(void) {
+    led_controller_t* controller = led_controller_create(TEST_PIN);
+    TEST_ASSERT_NOT_NULL(controller);
+    TEST_ASSERT_TRUE(led_controller_set_output(controller, &mock_ops));
+    TEST_ASSERT_TRUE(led_controller_start(controller));
+    vTaskDelay(1);
+    
+    command_count = 0;
+    TickType_t start = xTaskGetTickCount();
+    led_controller_set_pattern(controller, LED_PATTERN_BREATHE);
+    vTaskDelay(pdMS_TO_TICKS(2 * BREATHE_PERIOD_MS) - 1);
+    led_controller_stop(controller);
+    
+    // Two periods, each the curve up then down, one fade per segment
+    const size_t segments = 2 * LED_OUTPUT_CURVE_STEPS;
+    TEST_ASSERT_EQUAL_size_t(2 * segments, command_count);
+    TickType_t segment_ticks = pdMS_TO_TICKS(BREATHE_PERIOD_MS) / segments;
+    for (size_t i = 0; i < command_count; i++) {
+        size_t phase = i % segments;
+        size_t index = phase < LED_OUTPUT_CURVE_STEPS ? phase + 1 : segments - 1 - phase;
+        TEST_ASSERT_EQUAL_UINT32(start + i * segment_ticks, commands[i].tick);
+        TEST_ASSERT_EQUAL_UINT16(led_output_gamma_curve[index], commands[i].duty);
+        TEST_ASSERT_EQUAL_UINT32(BREATHE_PERIOD_MS / segments, commands[i].fade_ms);
+    }
+    
+    // Smoothness: largest duty change between consecutive milliseconds
+    uint32_t max_step = 0;
+    uint16_t previous = mock_duty_at(start);
+    for (TickType_t tick = start + 1; tick < start + pdMS_TO_TICKS(2 * BREATHE_PERIOD_MS); tick++) {
+        uint16_t duty = mock_duty_at(tick);
+        uint32_t step = (uint32_t)abs((int)duty - (int)previous);
+        if (step > max_step) {
+            max_step = step;
+        }
+        previous = duty;
+    }
+    
+    uint32_t largest_segment = 0;
+    for (int i = 0; i < LED_OUTPUT_CURVE_STEPS; i++) {
+        uint32_t span = led_output_gamma_curve[i + 1] - led_output_gamma_curve[i];
+        if (span > largest_segment) {
+            largest_segment = span;
+        }
+    }
+    printf("breathe: %u commands per %d ms period, largest duty step %lu/ms (%.2f%% of full scale)\n",
+           (unsigned)segments, BREATHE_PERIOD_MS, (unsigned long)max_step, 100.0 * max_step / LED_OUTPUT_DUTY_MAX);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(largest_segment / (segment_ticks) + 1, max_step);
+    
+    led_controller_destroy(controller);
+}
+
+static void test_breathe_cost_per_period(void) {
+    const int periods = 500;
+    led_controller_t* controller = led_controller_create(TEST_PIN);
+    TEST_ASSERT_NOT_NULL(controller);
+    TEST_ASSERT_TRUE(led_controller_set_output(controller, &mock_ops));
+    TEST_ASSERT_TRUE(led_controller_start(controller));
+    led_controller_set_pattern(controller, LED_PATTERN_BREATHE);
+    vTaskDelay(1);
+    
+    led_wake_stats_t before;
+    led_controller_get_wake_stats(controller, LED_PATTERN_BREATHE, &before);
+    uint64_t start_ns = now_ns();
+    vTaskDelay(pdMS_TO_TICKS(periods * BREATHE_PERIOD_MS));
+    uint64_t elapsed_ns = now_ns() - start_ns;
+    led_wake_stats_t after;
+    led_controller_get_wake_stats(controller, LED_PATTERN_BREATHE, &after);
+    led_controller_destroy(controller);
+    
+    uint32_t wakeups = after.wakeups - before.wakeups;
+    printf("breathe: %.1f task wakeups per period, %.0f ns host time per period (simulated "
+           "context switches included)\n", (double)wakeups / periods, (double)elapsed_ns / periods);
+    TEST_ASSERT_EQUAL_UINT32(periods * 2 * LED_OUTPUT_CURVE_STEPS, wakeups);
+}
+
+// Fraction of ticks the pin is high over ms milliseconds
+static float sample_high_fraction(uint8_t pin, uint32_t ms) {
+    uint32_t high = 0;
+    
+    for (uint32_t i = 0; i < ms; i++) {
+        vTaskDelay(1);
+        high += digitalRead(pin) == HIGH;
+    }
+    return (float)high / (float)ms;
+}
+
+static void test_gpio_fallback_is_pwm(void) {
+    led_output_t output = { 0 };
+    output.ops = &led_output_gpio_ops;
+    TEST_ASSERT_TRUE(output.ops->begin(&output, TEST_PIN));
+    
+    const uint16_t duties[] = { LED_OUTPUT_DUTY_MAX / 4, LED_OUTPUT_DUTY_MAX / 2, LED_OUTPUT_DUTY_MAX * 3 / 4 };
+    for (size_t i = 0; i < sizeof(duties) / sizeof(duties[0]); i++) {
+        output.ops->set_duty(&output, duties[i]);
+        vTaskDelay(pdMS_TO_TICKS(50));
+        float fraction = sample_high_fraction(TEST_PIN, 1000);
+        printf("gpio: duty %.2f -> high %.3f of the time\n", (float)duties[i] / LED_OUTPUT_DUTY_MAX, fraction);
+        // Tick-rounded edges in the simulation
+        TEST_ASSERT_FLOAT_WITHIN(0.06f, (float)duties[i] / LED_OUTPUT_DUTY_MAX, fraction);
+    }
+    
+    // Full and zero duty stop the timer
+    output.ops->set_duty(&output, LED_OUTPUT_DUTY_MAX);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_FALSE(output.pwm_running);
+    TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(TEST_PIN));
+    output.ops->set_duty(&output, 0);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_FALSE(output.pwm_running);
+    TEST_ASSERT_EQUAL_INT(LOW, digitalRead(TEST_PIN));
+    
+    // A fade passes through the levels in between
+    output.ops->fade_to(&output, LED_OUTPUT_DUTY_MAX, 1000);
+    float first = sample_high_fraction(TEST_PIN, 500);
+    float second = sample_high_fraction(TEST_PIN, 500);
+    TEST_ASSERT_FLOAT_WITHIN(0.06f, 0.25f, first);
+    TEST_ASSERT_FLOAT_WITHIN(0.06f, 0.75f, second);
+    
+    // Mid-fade end() leaves the pin low for good
+    output.ops->fade_to(&output, 0, 1000);
+    vTaskDelay(pdMS_TO_TICKS(333));
+    output.ops->end(&output);
+    TEST_ASSERT_NULL(output.pwm_timer);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sample_high_fraction(TEST_PIN, 100));
+}
+
+static void test_gpio_fallback_breathes(void) {
+    // Not a valid GPIO for LEDC, like the RGB LED_BUILTIN on the S3
+    const uint8_t pin = 97;
+    led_controller_t* controller = led_controller_create(pin);
+    TEST_ASSERT_NOT_NULL(controller);
+    TEST_ASSERT_TRUE(led_controller_start(controller));
+    led_controller_set_pattern(controller, LED_PATTERN_BREATHE);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL_PTR(&led_output_gpio_ops, controller->channels[0].output.ops);
+    
+    // Brightness in each 100 ms window of a period: rises to full, then falls
+    float windows[BREATHE_PERIOD_MS / 100];
+    int distinct = 0;
+    for (int i = 0; i < BREATHE_PERIOD_MS / 100; i++) {
+        windows[i] = sample_high_fraction(pin, 100);
+        if (i == 0 || fabsf(windows[i] - windows[i - 1]) > 0.02f) {
+            distinct++;
+        }
+    }
+    led_controller_destroy(controller);
+    
+    printf("gpio breathe: %d distinct brightness levels in %d windows:", distinct, BREATHE_PERIOD_MS / 100);
+    for (int i = 0; i < BREATHE_PERIOD_MS / 100; i++) {
+        printf(" %.2f", windows[i]);
+    }
+    printf("\n");
+    TEST_ASSERT_GREATER_THAN(10, distinct);
+    // Rises to full brightness and falls back. Edges are rounded up to the
+    // next tick here, so dim levels read brighter than on the device.
+    const int half = BREATHE_PERIOD_MS / 200;
+    TEST_ASSERT_TRUE(windows[0] < 0.25f && windows[2 * half - 1] < 0.25f);
+    TEST_ASSERT_TRUE(windows[half - 1] > 0.9f);
+    for (int i = 4; i < half; i++) {
+        TEST_ASSERT_TRUE(windows[i] > windows[i - 1]);
+        TEST_ASSERT_TRUE(windows[2 * half - i] > windows[2 * half - i + 1]);
+    }
+}
+
+// Each start takes an LEDC channel and each stop gives it back, so a
+// controller restarted more often than there are channels stays on LEDC,
+// and two running at once get different channels
+static void test_ledc_channels_reused_across_restarts(void) {
+    led_controller_t* controller = led_controller_create(TEST_PIN);
+    led_controller_t* other = led_controller_create(TEST_PIN + 1);
+    TEST_ASSERT_NOT_NULL(controller);
+    TEST_ASSERT_NOT_NULL(other);
+    
+    for (int cycle = 0; cycle < 3 * LEDC_CHANNEL_MAX; cycle++) {
+        TEST_ASSERT_TRUE(led_controller_start(controller));
+        vTaskDelay(1);
+        TEST_ASSERT_EQUAL_STRING("ledc", controller->channels[0].output.ops->name);
+        TEST_ASSERT_EQUAL_UINT8(0, controller->channels[0].output.channel);
+        
+        // Every other cycle with a second controller holding a channel too
+        if (cycle % 2) {
+            TEST_ASSERT_TRUE(led_controller_start(other));
+            vTaskDelay(1);
+            TEST_ASSERT_EQUAL_STRING("ledc", other->channels[0].output.ops->name);
+            TEST_ASSERT_EQUAL_UINT8(1, other->channels[0].output.channel);
+            led_controller_stop(other);
+        }
+        led_controller_stop(controller);
+    }
+    led_controller_destroy(other);
+    led_controller_destroy(controller);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_breathe_follows_gamma_curve_without_jumps);
+    RUN_TEST(test_breathe_cost_per_period);
+    RUN_TEST(test_gpio_fallback_is_pwm);
+    RUN_TEST(test_gpio_fallback_breathes);
+    RUN_TEST(test_ledc_channels_reused_across_restarts);
+}
+
+int main(int argc, char** argv) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
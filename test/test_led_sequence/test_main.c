@@ -0,0 +1,198 @@
+// Keyframe sequences: compiled step tables, the timeline one controller task
+// emits for them across several channels, and the memory of one controller
+// driving N channels against one controller (and task) per LED.
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "modules/led_controller/led_controller.h"
+#include "../sim_test.h"
+
+#define MOCK_CAPACITY 256
+
+typedef struct {
+    uint8_t pin;
+    TickType_t tick;
+    uint16_t duty;
+    uint32_t fade_ms; // 0: set_duty
+} mock_command_t;
+
+static mock_command_t commands[MOCK_CAPACITY];
+static size_t command_count;
+
+static void mock_record(led_output_t* output, uint16_t duty, uint32_t fade_ms) {
+    output->duty = duty;
+    if (command_count < MOCK_CAPACITY) {
+        mock_command_t command = { output->pin, xTaskGetTickCount(), duty, fade_ms };
+        commands[command_count++] = command;
+    }
+}
+
+static bool mock_begin(led_output_t* output, uint8_t pin) {
+    output->pin = pin;
+    output->duty = 0;
+    return true;
+}
+
+static void mock_set_duty(led_output_t* output, uint16_t duty) {
+    mock_record(output, duty, 0);
+}
+
+static void mock_fade_to(led_output_t* output, uint16_t duty, uint32_t duration_ms) {
+    mock_record(output, duty, duration_ms);
+}
+
+static void mock_end(led_output_t* output) {
+}
+
+static const led_output_ops_t mock_ops = { "mock", mock_begin, mock_set_duty, mock_fade_to, mock_end };
+
+// Commands for one pin, in order
+static size_t pin_commands(uint8_t pin, mock_command_t* out, size_t max) {
+    size_t count = 0;
+    
+    for (size_t i = 0; i < command_count && count < max; i++) {
+        if (commands[i].pin == pin) {
+            out[count++] = commands[i];
+        }
+    }
+    return count;
+}
+
+void setUp(void) {
+    command_count = 0;
+}
+
+void tearDown(void) {
+}
+
+static void test_compile_emits_one_step_per_keyframe_and_smooth_substeps(void) {
+    static const led_keyframe_t frames[] = {
+        { 100, 255, LED_EASE_STEP },
+        { 400, 0, LED_EASE_SMOOTH },
+        { 300, 128, LED_EASE_LINEAR }
+    };
+    const led_sequence_t sequence = { frames, 3, true };
+    led_step_t steps[16];
+    led_program_t program;
+    
+    TEST_ASSERT_EQUAL_size_t(2 + LED_SEQUENCE_SMOOTH_STEPS, led_sequence_compiled_size(&sequence));
+    TEST_ASSERT_EQUAL_size_t(2 + LED_SEQUENCE_SMOOTH_STEPS, led_sequence_compile(&sequence, steps, 16, &program));
+    TEST_ASSERT_EQUAL_PTR(steps, program.steps);
+    TEST_ASSERT_TRUE(program.loop);
+    
+    TEST_ASSERT_EQUAL_UINT16(LED_OUTPUT_DUTY_MAX, steps[0].duty_flags);
+    TEST_ASSERT_EQUAL_UINT16(100, steps[0].duration_ms);
+    
+    // Smooth: evenly spaced levels on the way down, durations summing exactly
+    uint32_t total_ms = 0;
+    for (int k = 1; k <= LED_SEQUENCE_SMOOTH_STEPS; k++) {
+        const led_step_t* step = &steps[k];
+        uint8_t level = (uint8_t)(255 - 255 * k / LED_SEQUENCE_SMOOTH_STEPS);
+        TEST_ASSERT_TRUE(step->duty_flags & LED_STEP_FADE);
+        TEST_ASSERT_EQUAL_UINT16(led_sequence_level_to_duty(level), step->duty_flags & LED_STEP_DUTY_MASK);
+        total_ms += step->duration_ms;
+    }
+    TEST_ASSERT_EQUAL_UINT32(400, total_ms);
+    
+    TEST_ASSERT_EQUAL_UINT16(led_sequence_level_to_duty(128) | LED_STEP_FADE, steps[5].duty_flags);
+    TEST_ASSERT_EQUAL_UINT16(300, steps[5].duration_ms);
+    
+    // Too small a buffer is rejected, not truncated
+    TEST_ASSERT_EQUAL_size_t(0, led_sequence_compile(&sequence, steps, 5, &program));
+}
+
+static void test_level_to_duty_follows_gamma_curve(void) {
+    // The curve's compile-time constants are the 2.2 gamma they stand for
+    for (int i = 0; i <= LED_OUTPUT_CURVE_STEPS; i++) {
+        double exact = LED_OUTPUT_DUTY_MAX * pow((double)i / LED_OUTPUT_CURVE_STEPS, 2.2);
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)lround(exact), led_output_gamma_curve[i]);
+    }
+    
+    TEST_ASSERT_EQUAL_UINT16(0, led_sequence_level_to_duty(0));
+    TEST_ASSERT_EQUAL_UINT16(LED_OUTPUT_DUTY_MAX, led_sequence_level_to_duty(255));
+    
+    uint16_t previous = 0;
+    for (int level = 1; level <= 255; level++) {
+        uint16_t duty = led_sequence_level_to_duty((uint8_t)level);
+        TEST_ASSERT_TRUE(duty >= previous);
+        previous = duty;
+    }
+}
+
+static void test_one_task_runs_each_channel_on_its_own_timeline(void) {
+    static const led_keyframe_t blink_frames[] = {
+        { 50, 255, LED_EASE_STEP },
+        { 150, 0, LED_EASE_STEP }
+    };
+    static const led_keyframe_t ramp_frames[] = {
+        { 300, 255, LED_EASE_LINEAR },
+        { 100, 64, LED_EASE_STEP }
+    };
+    const led_sequence_t blink = { blink_frames, 2, true };
+    const led_sequence_t ramp = { ramp_frames, 2, false };
+    led_step_t blink_steps[4];
+    led_step_t ramp_steps[4];
+    led_program_t blink_program;
+    led_program_t ramp_program;
+    TEST_ASSERT_EQUAL_size_t(2, led_sequence_compile(&blink, blink_steps, 4, &blink_program));
+    TEST_ASSERT_EQUAL_size_t(2, led_sequence_compile(&ramp, ramp_steps, 4, &ramp_program));
+    
+    led_controller_t* controller = led_controller_create(10);
+    TEST_ASSERT_NOT_NULL(controller);
+    TEST_ASSERT_EQUAL_INT(1, led_controller_add_channel(controller, 11));
+    TEST_ASSERT_TRUE(led_controller_set_output(controller, &mock_ops));
+    TEST_ASSERT_TRUE(led_controller_start(controller));
+    vTaskDelay(1);
+    
+    command_count = 0;
+    TickType_t start = xTaskGetTickCount();
+    TEST_ASSERT_TRUE(led_controller_set_program(controller, 0, &blink_program));
+    TEST_ASSERT_TRUE(led_controller_set_program(controller, 1, &ramp_program));
+    vTaskDelay(pdMS_TO_TICKS(1000) - 1);
+    led_controller_destroy(controller);
+    
+    // Looping blink: on at 0, off at 50, on at 200, ... for 1 s
+    mock_command_t timeline[32];
+    size_t count = pin_commands(10, timeline, 32);
+    TEST_ASSERT_EQUAL_size_t(10, count);
+    for (size_t i = 0; i < count; i++) {
+        TickType_t expected = start + pdMS_TO_TICKS((i / 2) * 200 + (i % 2) * 50);
+        TEST_ASSERT_EQUAL_UINT32(expected, timeline[i].tick);
+        TEST_ASSERT_EQUAL_UINT16(i % 2 ? 0 : LED_OUTPUT_DUTY_MAX, timeline[i].duty);
+        TEST_ASSERT_EQUAL_UINT32(0, timeline[i].fade_ms);
+    }
+    
+    // One-shot ramp: fade, then hold its last step with no further commands
+    count = pin_commands(11, timeline, 32);
+    TEST_ASSERT_EQUAL_size_t(2, count);
+    TEST_ASSERT_EQUAL_UINT32(start, timeline[0].tick);
+    TEST_ASSERT_EQUAL_UINT16(LED_OUTPUT_DUTY_MAX, timeline[0].duty);
+    TEST_ASSERT_EQUAL_UINT32(300, timeline[0].fade_ms);
+    TEST_ASSERT_EQUAL_UINT32(start + pdMS_TO_TICKS(300), timeline[1].tick);
+    TEST_ASSERT_EQUAL_UINT16(led_sequence_level_to_duty(64), timeline[1].duty);
+}
+
+static void test_memory_against_one_task_per_led(void) {
+    const size_t leds = LED_CONTROLLER_MAX_CHANNELS;
+    size_t shared = sizeof(led_controller_storage_t);
+    size_t separate = leds * sizeof(led_controller_storage_t);
+    
+    printf("led memory: %u LEDs on one controller %u bytes (stack %u, %u per channel), "
+           "one controller each %u bytes; %u bytes per compiled step\n",
+           (unsigned)leds, (unsigned)shared, (unsigned)(LED_CONTROLLER_STACK_SIZE * sizeof(StackType_t)),
+           (unsigned)sizeof(led_channel_t), (unsigned)separate, (unsigned)sizeof(led_step_t));
+    TEST_ASSERT_EQUAL_size_t(4, sizeof(led_step_t));
+    TEST_ASSERT_TRUE(shared < separate / 2);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_compile_emits_one_step_per_keyframe_and_smooth_substeps);
+    RUN_TEST(test_level_to_duty_follows_gamma_curve);
+    RUN_TEST(test_one_task_runs_each_channel_on_its_own_timeline);
+    RUN_TEST(test_memory_against_one_task_per_led);
+}
+
+int main(int argc, char** argv) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
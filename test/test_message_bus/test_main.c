@@ -0,0 +1,232 @@
+// Message bus: topic routing and drop accounting, unsubscribe racing
+// publishers on host threads, and publish cost and delivery latency.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "modules/message_bus/message_bus.h"
+#include "../sim_test.h"
+
+#define PUBLISHER_THREADS 3
+#define CHURN_ROUNDS 20000
+#define CHURN_QUEUE_LENGTH 64
+#define LATE_SEND_WINDOW_NS 20000 // How long an unsubscribed queue is watched for late sends
+#define BENCH_MESSAGES 20000
+#define LATENCY_SAMPLES 2000
+
+static volatile bool publishing;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static int64_t host_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static message_t sample_message(uint32_t raw) {
+    message_t message;
+    memset(&message, 0, sizeof(message));
+    message.topic = MESSAGE_TOPIC_SENSOR_SAMPLE;
+    message.sample.raw_value = raw;
+    return message;
+}
+
+static void test_routing_and_drops(void) {
+    QueueHandle_t wifi = xQueueCreate(2, sizeof(message_t));
+    QueueHandle_t samples = xQueueCreate(2, sizeof(message_t));
+    int wifi_slot = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_WIFI_STATE), wifi);
+    int sample_slot = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE), samples);
+    TEST_ASSERT_NOT_EQUAL(MESSAGE_BUS_INVALID_SLOT, wifi_slot);
+    TEST_ASSERT_NOT_EQUAL(MESSAGE_BUS_INVALID_SLOT, sample_slot);
+    
+    for (uint32_t i = 0; i < 3; i++) {
+        message_t message = sample_message(i);
+        TEST_ASSERT_EQUAL_UINT32(i < 2 ? 1 : 0, message_bus_publish(&message));
+    }
+    
+    message_bus_stats_t stats;
+    TEST_ASSERT_TRUE(message_bus_get_stats(sample_slot, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped); // Queue full: only this subscriber loses it
+    TEST_ASSERT_EQUAL_UINT32(0, uxQueueMessagesWaiting(wifi));
+    
+    message_t received;
+    TEST_ASSERT_EQUAL_INT(pdTRUE, xQueueReceive(samples, &received, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, received.sample.raw_value);
+    TEST_ASSERT_EQUAL_UINT32(xTaskGetTickCount(), received.timestamp);
+    
+    message_bus_unsubscribe(wifi_slot);
+    message_bus_unsubscribe(sample_slot);
+    vQueueDelete(wifi);
+    vQueueDelete(samples);
+}
+
+static void* publisher_thread(void* arg) {
+    uint32_t raw = 0;
+    while (publishing) {
+        message_t message = sample_message(raw++);
+        message_bus_publish(&message);
+    }
+    return NULL;
+}
+
+// Keeps a task runnable, so the kernel does not end the run while the test
+// task waits for a host publisher thread to wake it. Above the test task,
+// so a wakeup from a host thread never needs a context switch there. The
+// host sleep leaves the (unfair) kernel lock to the publisher threads.
+static void ticker_task(void* arg) {
+    for (;;) {
+        vTaskDelay(1);
+        usleep(10);
+    }
+}
+
+// Subscribes and unsubscribes a queue while host threads publish flat out.
+// Once unsubscribe() returns nothing may be written to the queue, which
+// could then be deleted.
+static void test_unsubscribe_waits_for_publishers(void) {
+    static StaticQueue_t queue_buffer;
+    static uint8_t queue_storage[CHURN_QUEUE_LENGTH * sizeof(message_t)];
+    pthread_t threads[PUBLISHER_THREADS];
+    TaskHandle_t ticker;
+    uint32_t late_sends = 0;
+    uint32_t delivered = 0;
+    
+    TEST_ASSERT_EQUAL_INT(pdPASS, xTaskCreatePinnedToCore(ticker_task, "ticker", 2048, NULL, 2, &ticker, 0));
+    publishing = true;
+    for (int i = 0; i < PUBLISHER_THREADS; i++) {
+        pthread_create(&threads[i], NULL, publisher_thread, NULL);
+    }
+    
+    for (int round = 0; round < CHURN_ROUNDS; round++) {
+        QueueHandle_t queue = xQueueCreateStatic(CHURN_QUEUE_LENGTH, sizeof(message_t), queue_storage, &queue_buffer);
+        int slot = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE), queue);
+        TEST_ASSERT_NOT_EQUAL(MESSAGE_BUS_INVALID_SLOT, slot);
+        
+        // Unsubscribe while messages are flowing into the queue
+        int64_t flowing = host_ns() + LATE_SEND_WINDOW_NS;
+        while (uxQueueMessagesWaiting(queue) < CHURN_QUEUE_LENGTH / 2 && host_ns() < flowing) {
+        }
+        message_bus_unsubscribe(slot);
+        UBaseType_t waiting = uxQueueMessagesWaiting(queue);
+        int64_t until = host_ns() + LATE_SEND_WINDOW_NS;
+        while (host_ns() < until) {
+        }
+        if (uxQueueMessagesWaiting(queue) != waiting) {
+            late_sends++;
+        }
+        delivered += waiting;
+    }
+    
+    publishing = false;
+    for (int i = 0; i < PUBLISHER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    vTaskDelete(ticker);
+    
+    printf("%d subscribe/unsubscribe rounds against %d publishing threads: %lu messages delivered, "
+           "%lu sends after unsubscribe\n", CHURN_ROUNDS, PUBLISHER_THREADS, (unsigned long)delivered,
+           (unsigned long)late_sends);
+    TEST_ASSERT_TRUE(delivered > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, late_sends);
+}
+
+static void test_publish_cost(void) {
+    QueueHandle_t queues[MESSAGE_BUS_MAX_SUBSCRIBERS];
+    int slots[MESSAGE_BUS_MAX_SUBSCRIBERS];
+    message_t drained;
+    
+    for (int subscribers = 1; subscribers <= MESSAGE_BUS_MAX_SUBSCRIBERS; subscribers *= 2) {
+        for (int i = 0; i < subscribers; i++) {
+            queues[i] = xQueueCreate(1, sizeof(message_t));
+            slots[i] = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE), queues[i]);
+            TEST_ASSERT_NOT_EQUAL(MESSAGE_BUS_INVALID_SLOT, slots[i]);
+        }
+        
+        int64_t elapsed = 0;
+        for (int n = 0; n < BENCH_MESSAGES; n++) {
+            message_t message = sample_message((uint32_t)n);
+            int64_t start = host_ns();
+            TEST_ASSERT_EQUAL_UINT32(subscribers, message_bus_publish(&message));
+            elapsed += host_ns() - start;
+            for (int i = 0; i < subscribers; i++) {
+                xQueueReceive(queues[i], &drained, 0);
+            }
+        }
+        printf("publish to %d subscribers: %.0f ns\n", subscribers, (double)elapsed / BENCH_MESSAGES);
+        
+        for (int i = 0; i < subscribers; i++) {
+            message_bus_unsubscribe(slots[i]);
+            vQueueDelete(queues[i]);
+        }
+    }
+}
+
+static QueueHandle_t latency_queue;
+static volatile int64_t published_at_ns;
+static int64_t latency_sum_ns;
+static int64_t latency_max_ns;
+static uint32_t latency_max_ticks;
+
+// Above the publisher, like loop() reacting to a sensor task's sample
+static void subscriber_task(void* arg) {
+    message_t message;
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        xQueueReceive(latency_queue, &message, portMAX_DELAY);
+        int64_t latency = host_ns() - published_at_ns;
+        uint32_t ticks = xTaskGetTickCount() - message.timestamp;
+        
+        latency_sum_ns += latency;
+        if (latency > latency_max_ns) {
+            latency_max_ns = latency;
+        }
+        if (ticks > latency_max_ticks) {
+            latency_max_ticks = ticks;
+        }
+    }
+    xTaskNotifyGive((TaskHandle_t)arg);
+    vTaskDelete(NULL);
+}
+
+static void test_delivery_latency(void) {
+    latency_queue = xQueueCreate(4, sizeof(message_t));
+    int slot = message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE), latency_queue);
+    TEST_ASSERT_EQUAL_INT(pdPASS, xTaskCreatePinnedToCore(subscriber_task, "subscriber", 4096,
+                                                          xTaskGetCurrentTaskHandle(), 5, NULL, 1));
+    
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        message_t message = sample_message((uint32_t)i);
+        published_at_ns = host_ns();
+        message_bus_publish(&message); // Switches to the subscriber before returning
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)));
+    
+    // Host time includes the shim's thread hand-over, far slower than a
+    // FreeRTOS context switch; the tick count shows nothing waits for a tick
+    printf("publish to receive: %u ticks max, host %.0f ns avg, %lld ns max\n", (unsigned)latency_max_ticks,
+           (double)latency_sum_ns / LATENCY_SAMPLES, (long long)latency_max_ns);
+    TEST_ASSERT_EQUAL_UINT32(0, latency_max_ticks);
+    
+    message_bus_unsubscribe(slot);
+    vQueueDelete(latency_queue);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_routing_and_drops);
+    RUN_TEST(test_unsubscribe_waits_for_publishers);
+    RUN_TEST(test_publish_cost);
+    RUN_TEST(test_delivery_latency);
+}
+
+int main(int argc, char** argv) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
@@ -0,0 +1,400 @@
+// MQTT uplink against a minimal broker on a host thread: each PUBLISH
+// payload must decode on its own, including a batch whose samples are
+// further apart than a record's 16-bit dt_ms can hold, and batches that
+// waited out an outage compressed in the spill file. A benchmark streams
+// samples through the loopback broker at several batch sizes and reports
+// host samples/s uplinked and bytes per sample, payload and on the wire.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "modules/mqtt_uplink/mqtt_uplink.h"
+#include "modules/wifi_manager/wifi_state.h"
+#include "../sim_test.h"
+
+#define BROKER_MAX_PUBLISHES 8
+#define BROKER_MAX_PAYLOAD 1024
+
+typedef struct {
+    uint8_t payload[BROKER_MAX_PAYLOAD];
+    size_t length;
+} publish_t;
+
+static int listen_socket = -1;
+static uint16_t broker_port;
+static pthread_t broker_thread;
+static pthread_mutex_t broker_lock = PTHREAD_MUTEX_INITIALIZER;
+static publish_t publishes[BROKER_MAX_PUBLISHES];
+static int publish_count;
+static uint32_t broker_publishes; // All PUBLISH packets, kept or not
+static uint64_t broker_wire_bytes; // Their full size, fixed header included
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static bool read_exact(int fd, uint8_t* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t got = recv(fd, buffer, length, 0);
+        if (got <= 0) return false;
+        buffer += got;
+        length -= (size_t)got;
+    }
+    return true;
+}
+
+// Accepts one client at a time and answers CONNECT, PUBLISH (QoS 1) and
+// PINGREQ; publish payloads are kept for the test to decode
+static void* broker_main(void* arg) {
+    (void)arg;
+    static uint8_t body[BROKER_MAX_PAYLOAD + 128];
+
+    for (;;) {
+        int client = accept(listen_socket, NULL, NULL);
+        if (client < 0) return NULL;
+
+        for (;;) {
+            uint8_t header;
+            uint32_t length = 0;
+            uint8_t byte;
+            int shift = 0;
+            size_t header_bytes = 1;
+
+            if (!read_exact(client, &header, 1)) break;
+            do {
+                if (!read_exact(client, &byte, 1)) goto closed;
+                length |= (uint32_t)(byte & 0x7F) << shift;
+                shift += 7;
+                header_bytes++;
+            } while (byte & 0x80);
+            if (length > sizeof(body) || !read_exact(client, body, length)) break;
+
+            switch (header >> 4) {
+            case 1: { // CONNECT
+                uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+                send(client, connack, sizeof(connack), 0);
+                break;
+            }
+            case 3: { // PUBLISH, QoS 1: topic, packet id, payload
+                size_t topic_length = (size_t)(body[0] << 8 | body[1]);
+                size_t offset = 2 + topic_length;
+                uint8_t puback[] = { 0x40, 0x02, body[offset], body[offset + 1] };
+
+                pthread_mutex_lock(&broker_lock);
+                broker_publishes++;
+                broker_wire_bytes += header_bytes + length;
+                if (publish_count < BROKER_MAX_PUBLISHES) {
+                    publish_t* publish = &publishes[publish_count++];
+                    publish->length = length - offset - 2;
+                    memcpy(publish->payload, body + offset + 2, publish->length);
+                }
+                pthread_mutex_unlock(&broker_lock);
+                send(client, puback, sizeof(puback), 0);
+                break;
+            }
+            case 12: { // PINGREQ
+                uint8_t pingresp[] = { 0xD0, 0x00 };
+                send(client, pingresp, sizeof(pingresp), 0);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    closed:
+        close(client);
+    }
+}
+
+static void broker_start(void) {
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+    int reuse = 1;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    bind(listen_socket, (struct sockaddr*)&address, sizeof(address));
+    listen(listen_socket, 1);
+    getsockname(listen_socket, (struct sockaddr*)&address, &address_length);
+    broker_port = ntohs(address.sin_port);
+    pthread_create(&broker_thread, NULL, broker_main, NULL);
+}
+
+static void publish_wifi_state(wifi_state_t state) {
+    message_t message;
+    message.topic = MESSAGE_TOPIC_WIFI_STATE;
+    message.wifi_state = (uint8_t)state;
+    message_bus_publish(&message);
+}
+
+static void publish_sample(TickType_t timestamp, uint32_t raw) {
+    message_t message;
+    memset(&message, 0, sizeof(message));
+    message.topic = MESSAGE_TOPIC_SENSOR_SAMPLE;
+    message.sample.raw_value = raw;
+    sensor_set_temperature_cdeg(&message.sample, 2200 + (int32_t)(raw % 7));
+    message.sample.timestamp = timestamp;
+    message_bus_publish(&message);
+}
+
+// Decodes one payload the way tools/decode_telemetry.py does; returns the
+// sample count, or -1 on a record the decoder would reject
+static int decode_payload(const publish_t* publish, uint32_t* times_ms, uint32_t* raws, int* timebases) {
+    const telemetry_record_t* records = (const telemetry_record_t*)publish->payload;
+    size_t count = publish->length / sizeof(telemetry_record_t);
+    bool anchored = false;
+    uint32_t time_ms = 0;
+    int samples = 0;
+
+    *timebases = 0;
+    if (publish->length % sizeof(telemetry_record_t) != 0) return -1;
+
+    for (size_t i = 0; i < count; i++) {
+        const telemetry_record_t* record = &records[i];
+        uint16_t crc = telemetry_crc16(&record->type, offsetof(telemetry_record_t, crc) - offsetof(telemetry_record_t, type));
+
+        if (record->sync[0] != TELEMETRY_SYNC_0 || record->sync[1] != TELEMETRY_SYNC_1 || record->crc != crc) {
+            return -1;
+        }
+        if (record->type == TELEMETRY_RECORD_TIMEBASE) {
+            time_ms = record->timebase.time_ms;
+            anchored = true;
+            (*timebases)++;
+        } else {
+            if (!anchored) return -1;
+            time_ms += record->dt_ms;
+            times_ms[samples] = time_ms;
+            raws[samples] = record->sample.raw;
+            if (record->sample.temperature_cdeg != 2200 + (int32_t)(record->sample.raw % 7)) return -1;
+            samples++;
+        }
+    }
+    return samples;
+}
+
+static void wait_for_publishes(mqtt_uplink_t* uplink, uint32_t batches) {
+    mqtt_uplink_stats_t stats;
+
+    for (int i = 0; i < 1000; i++) {
+        mqtt_uplink_get_stats(uplink, &stats);
+        if (stats.batches >= batches) return;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    TEST_FAIL_MESSAGE("uplink did not publish");
+}
+
+// Two batches of four: one evenly spaced, one with a 70 s gap, longer than
+// dt_ms can span, between its second and third samples
+void test_batch_with_long_gap_carries_a_second_timebase(void) {
+    mqtt_uplink_config_t config = MQTT_UPLINK_DEFAULT_CONFIG;
+    config.broker_host = "127.0.0.1";
+    config.broker_port = broker_port;
+    config.batch_size = 4;
+    config.min_publish_interval_ms = 0;
+
+    mqtt_uplink_t* uplink = mqtt_uplink_create(&config);
+    TEST_ASSERT_NOT_NULL(uplink);
+    TEST_ASSERT_TRUE(mqtt_uplink_start(uplink));
+    vTaskDelay(1); // Let the task subscribe
+
+    publish_wifi_state(WIFI_STATE_CONNECTED);
+    const TickType_t times[8] = { 1000, 1010, 1020, 1030, 2000, 2010, 72010, 72020 };
+    for (int i = 0; i < 8; i++) {
+        publish_sample(pdMS_TO_TICKS(times[i]), 100 + (uint32_t)i);
+        vTaskDelay(1);
+    }
+    wait_for_publishes(uplink, 2);
+
+    mqtt_uplink_stats_t stats;
+    mqtt_uplink_get_stats(uplink, &stats);
+    mqtt_uplink_stop(uplink);
+    mqtt_uplink_destroy(uplink);
+
+    pthread_mutex_lock(&broker_lock);
+    TEST_ASSERT_EQUAL(2, publish_count);
+
+    uint32_t decoded_ms[4];
+    uint32_t decoded_raw[4];
+    int timebases;
+    int sample = 0;
+    for (int p = 0; p < 2; p++) {
+        int samples = decode_payload(&publishes[p], decoded_ms, decoded_raw, &timebases);
+        TEST_ASSERT_EQUAL(4, samples);
+        TEST_ASSERT_EQUAL(p == 0 ? 1 : 2, timebases);
+        for (int i = 0; i < samples; i++, sample++) {
+            TEST_ASSERT_EQUAL_UINT32(times[sample], decoded_ms[i]);
+            TEST_ASSERT_EQUAL_UINT32(100 + sample, decoded_raw[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(publishes[0].length + publishes[1].length, stats.payload_bytes);
+    TEST_ASSERT_EQUAL_UINT32(11 * sizeof(telemetry_record_t), stats.payload_bytes);
+    pthread_mutex_unlock(&broker_lock);
+}
+
+// Five batches arrive while WiFi is down: three spill to the file as
+// compressed blocks once the RAM ring is full, and all five go out in
+// order on reconnect
+void test_spilled_batches_round_trip(void) {
+    char spill_path[] = "/tmp/mqtt_spillXXXXXX";
+    int fd = mkstemp(spill_path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+
+    mqtt_uplink_config_t config = MQTT_UPLINK_DEFAULT_CONFIG;
+    config.broker_host = "127.0.0.1";
+    config.broker_port = broker_port;
+    config.batch_size = MQTT_UPLINK_MAX_BATCH;
+    config.min_publish_interval_ms = 0;
+    config.spill_path = spill_path;
+
+    pthread_mutex_lock(&broker_lock);
+    publish_count = 0;
+    pthread_mutex_unlock(&broker_lock);
+
+    mqtt_uplink_t* uplink = mqtt_uplink_create(&config);
+    TEST_ASSERT_NOT_NULL(uplink);
+    TEST_ASSERT_TRUE(mqtt_uplink_start(uplink));
+    vTaskDelay(1);
+
+    publish_wifi_state(WIFI_STATE_DISCONNECTED);
+    const uint32_t total = MQTT_UPLINK_RAM_CAPACITY + 3 * MQTT_UPLINK_MAX_BATCH;
+    for (uint32_t i = 0; i < total; i++) {
+        publish_sample(pdMS_TO_TICKS(1000 + 2000 * i), i);
+        vTaskDelay(1);
+    }
+
+    mqtt_uplink_stats_t stats;
+    mqtt_uplink_get_stats(uplink, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3 * MQTT_UPLINK_MAX_BATCH, stats.spilled);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    printf("spilled %lu samples in %lu bytes (%lu uncompressed)\n", (unsigned long)stats.spilled,
+           (unsigned long)stats.spill_bytes, (unsigned long)(stats.spilled * sizeof(sensor_data_t)));
+    TEST_ASSERT_TRUE(stats.spill_bytes * 4 < stats.spilled * sizeof(sensor_data_t));
+
+    publish_wifi_state(WIFI_STATE_CONNECTED);
+    wait_for_publishes(uplink, total / MQTT_UPLINK_MAX_BATCH);
+    mqtt_uplink_get_stats(uplink, &stats);
+    mqtt_uplink_stop(uplink);
+    mqtt_uplink_destroy(uplink);
+    unlink(spill_path);
+
+    TEST_ASSERT_EQUAL_UINT32(total, stats.uplinked);
+    pthread_mutex_lock(&broker_lock);
+    TEST_ASSERT_EQUAL(total / MQTT_UPLINK_MAX_BATCH, publish_count);
+
+    uint32_t decoded_ms[MQTT_UPLINK_MAX_BATCH];
+    uint32_t decoded_raw[MQTT_UPLINK_MAX_BATCH];
+    int timebases;
+    uint32_t sample = 0;
+    for (int p = 0; p < publish_count; p++) {
+        int samples = decode_payload(&publishes[p], decoded_ms, decoded_raw, &timebases);
+        TEST_ASSERT_EQUAL(MQTT_UPLINK_MAX_BATCH, samples);
+        for (int i = 0; i < samples; i++, sample++) {
+            TEST_ASSERT_EQUAL_UINT32(1000 + 2000 * sample, decoded_ms[i]);
+            TEST_ASSERT_EQUAL_UINT32(sample, decoded_raw[i]);
+        }
+    }
+    pthread_mutex_unlock(&broker_lock);
+}
+
+static double elapsed_ms(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e3 + (double)(end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// BENCH_SAMPLES at the default 2 s spacing, one timebase per batch, fed a
+// queue's worth at a time so the bus never drops one; host time from the
+// first sample to the last PUBACK. The timestamps stay below the 32-bit
+// overflow of pdMS_TO_TICKS()
+#define BENCH_SAMPLES 1920
+
+void test_uplink_throughput(void) {
+    const uint16_t batch_sizes[] = { 1, 10, MQTT_UPLINK_MAX_BATCH };
+    double payload_per_sample[3];
+    double samples_per_s[3];
+
+    printf("%-6s %8s %9s %10s %12s %15s %12s\n", "batch", "samples", "publishes", "host ms", "samples/s",
+           "payload B/smp", "wire B/smp");
+    for (int b = 0; b < 3; b++) {
+        mqtt_uplink_config_t config = MQTT_UPLINK_DEFAULT_CONFIG;
+        config.broker_host = "127.0.0.1";
+        config.broker_port = broker_port;
+        config.batch_size = batch_sizes[b];
+        config.min_publish_interval_ms = 0;
+
+        mqtt_uplink_t* uplink = mqtt_uplink_create(&config);
+        TEST_ASSERT_NOT_NULL(uplink);
+        TEST_ASSERT_TRUE(mqtt_uplink_start(uplink));
+        vTaskDelay(1);
+        publish_wifi_state(WIFI_STATE_CONNECTED);
+        vTaskDelay(1); // Connected before the clock starts
+
+        pthread_mutex_lock(&broker_lock);
+        publish_count = 0;
+        broker_publishes = 0;
+        broker_wire_bytes = 0;
+        pthread_mutex_unlock(&broker_lock);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+            publish_sample(pdMS_TO_TICKS(1000 + 2000 * i), i);
+            if (i % MQTT_UPLINK_QUEUE_LENGTH == MQTT_UPLINK_QUEUE_LENGTH - 1) vTaskDelay(1);
+        }
+        wait_for_publishes(uplink, BENCH_SAMPLES / batch_sizes[b]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        mqtt_uplink_stats_t stats;
+        mqtt_uplink_get_stats(uplink, &stats);
+        mqtt_uplink_stop(uplink);
+        mqtt_uplink_destroy(uplink);
+
+        pthread_mutex_lock(&broker_lock);
+        uint32_t publishes = broker_publishes;
+        uint64_t wire_bytes = broker_wire_bytes;
+        pthread_mutex_unlock(&broker_lock);
+
+        double ms = elapsed_ms(&start, &end);
+        samples_per_s[b] = stats.uplinked / (ms / 1e3);
+        payload_per_sample[b] = (double)stats.payload_bytes / stats.uplinked;
+        printf("%-6u %8lu %9lu %10.1f %12.0f %15.1f %12.1f\n", (unsigned)batch_sizes[b],
+               (unsigned long)stats.uplinked, (unsigned long)publishes, ms, samples_per_s[b],
+               payload_per_sample[b], (double)wire_bytes / stats.uplinked);
+
+        TEST_ASSERT_EQUAL_UINT32(BENCH_SAMPLES, stats.received);
+        TEST_ASSERT_EQUAL_UINT32(BENCH_SAMPLES, stats.uplinked);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.dropped + stats.publish_failures);
+        TEST_ASSERT_EQUAL_UINT32(BENCH_SAMPLES / batch_sizes[b], publishes);
+        // A sample record each, plus the batch's timebase
+        TEST_ASSERT_EQUAL_UINT32((BENCH_SAMPLES + publishes) * sizeof(telemetry_record_t), stats.payload_bytes);
+    }
+
+    // One round trip per PUBLISH: larger batches share it and the timebase
+    TEST_ASSERT_TRUE(payload_per_sample[2] < payload_per_sample[1]);
+    TEST_ASSERT_TRUE(payload_per_sample[1] < payload_per_sample[0]);
+    TEST_ASSERT_TRUE(samples_per_s[2] > samples_per_s[0]);
+}
+
+static void run_tests(void) {
+    broker_start();
+    RUN_TEST(test_batch_with_long_gap_carries_a_second_timebase);
+    RUN_TEST(test_spilled_batches_round_trip);
+    RUN_TEST(test_uplink_throughput);
+}
+
+int main(void) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+    return 0;
+}
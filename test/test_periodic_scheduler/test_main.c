@@ -0,0 +1,343 @@
+// Periodic scheduler in simulated time. Removing a job waits for a run in
+// progress and returns the tick that run ends (or, for a run that never
+// ends, the tick stop() deletes the task); a job removing itself returns
+// at once. Lateness and jitter are kept per job: a job queued behind a
+// slow one every other run shows that in its own jitter, and the slow job
+// does not. A sweep over 1 to 1000 jobs at random periods reports the
+// scheduler's host time per run and the host-time lateness and jitter
+// percentiles of jobs queueing behind others due in the same tick.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "modules/periodic_scheduler/periodic_scheduler.h"
+#include "../sim_test.h"
+
+#define RUN_TICKS 50
+#define STUCK_TICKS 5000
+#define PERIOD_TICKS 100
+#define SWEEP_TICKS 10000
+#define SWEEP_MAX_JOBS 1000
+#define SWEEP_MAX_RUNS 65536
+#define SWEEP_BUSY_NS 20000 // Each run busy-waits this long in host time
+
+static periodic_scheduler_storage_t storage;
+static periodic_scheduler_t* scheduler;
+static periodic_job_t job;
+static volatile uint32_t finished_runs;
+static volatile TickType_t removed_at;
+static volatile TickType_t self_remove_ticks;
+
+typedef struct {
+    TickType_t busy;   // Ticks each run takes
+    TickType_t period;
+} timed_job_t;
+
+void setUp(void) {
+    memset(&job, 0, sizeof(job));
+    finished_runs = 0;
+    scheduler = periodic_scheduler_create_static(&storage);
+    TEST_ASSERT_NOT_NULL(scheduler);
+    TEST_ASSERT_TRUE(periodic_scheduler_start(scheduler));
+}
+
+void tearDown(void) {
+    periodic_scheduler_destroy(scheduler);
+}
+
+// Jobs must not block; these stand in for one that takes a while
+static TickType_t slow_job(void* context) {
+    vTaskDelay((TickType_t)(uintptr_t)context);
+    finished_runs++;
+    return PERIOD_TICKS;
+}
+
+static TickType_t self_removing_job(void* context) {
+    (void)context;
+
+    TickType_t before = xTaskGetTickCount();
+    periodic_scheduler_remove(scheduler, &job);
+    self_remove_ticks = xTaskGetTickCount() - before;
+    finished_runs++;
+    return PERIOD_TICKS;
+}
+
+static TickType_t timed_job(void* context) {
+    const timed_job_t* timing = (const timed_job_t*)context;
+
+    if (timing->busy) vTaskDelay(timing->busy);
+    return timing->period;
+}
+
+static void remover_task(void* arg) {
+    (void)arg;
+
+    periodic_scheduler_remove(scheduler, &job);
+    removed_at = xTaskGetTickCount();
+    vTaskDelete(NULL);
+}
+
+static void assert_removed(void) {
+    periodic_scheduler_stats_t stats;
+    TEST_ASSERT_TRUE(periodic_scheduler_get_stats(scheduler, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.jobs);
+    TEST_ASSERT_NULL(job.scheduler);
+}
+
+void test_remove_waits_for_run(void) {
+    TickType_t start = xTaskGetTickCount();
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &job, slow_job, (void*)(uintptr_t)RUN_TICKS, 10));
+    vTaskDelay(20);
+
+    periodic_scheduler_remove(scheduler, &job);
+    TEST_ASSERT_EQUAL_UINT32(start + 10 + RUN_TICKS, xTaskGetTickCount());
+    TEST_ASSERT_EQUAL_UINT32(1, finished_runs);
+    assert_removed();
+
+    // Not re-armed by the run that was in progress
+    vTaskDelay(3 * PERIOD_TICKS);
+    TEST_ASSERT_EQUAL_UINT32(1, finished_runs);
+    TEST_ASSERT_EQUAL_UINT32(1, job.runs);
+}
+
+void test_remove_between_runs(void) {
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &job, slow_job, (void*)(uintptr_t)RUN_TICKS, 0));
+    vTaskDelay(RUN_TICKS + 10);
+
+    TickType_t before = xTaskGetTickCount();
+    periodic_scheduler_remove(scheduler, &job);
+    TEST_ASSERT_EQUAL_UINT32(before, xTaskGetTickCount());
+    assert_removed();
+    vTaskDelay(3 * PERIOD_TICKS);
+    TEST_ASSERT_EQUAL_UINT32(1, finished_runs);
+}
+
+void test_remove_from_job_itself(void) {
+    self_remove_ticks = PERIOD_TICKS;
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &job, self_removing_job, NULL, 0));
+    vTaskDelay(3 * PERIOD_TICKS);
+
+    TEST_ASSERT_EQUAL_UINT32(1, finished_runs);
+    TEST_ASSERT_EQUAL_UINT32(0, self_remove_ticks);
+    assert_removed();
+}
+
+// A run that never ends: the waiting remove() returns when stop() gives up
+// on the task and deletes it
+void test_remove_released_by_stop(void) {
+    removed_at = 0;
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &job, slow_job, (void*)(uintptr_t)STUCK_TICKS, 0));
+    vTaskDelay(10);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(remover_task, "remover", 4096, NULL, 2, NULL));
+    vTaskDelay(10);
+    TEST_ASSERT_EQUAL_UINT32(0, removed_at);
+
+    TickType_t before = xTaskGetTickCount();
+    periodic_scheduler_stop(scheduler);
+    TickType_t stopped = xTaskGetTickCount();
+    TEST_ASSERT_EQUAL_UINT32(before + TASK_LIFECYCLE_JOIN_TIMEOUT, stopped);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL_UINT32(stopped, removed_at);
+    TEST_ASSERT_EQUAL_UINT32(0, finished_runs);
+    assert_removed();
+}
+
+static void print_job(const char* name, const periodic_job_stats_t* stats) {
+    printf("%-8s %6lu %9lu %14lu %11lu/%lu\n", name, (unsigned long)stats->runs, (unsigned long)stats->overruns,
+           (unsigned long)stats->max_lateness_us, (unsigned long)stats->jitter_avg_us,
+           (unsigned long)stats->jitter_max_us);
+}
+
+// A job alone starts on every deadline. Next to a slow job due every other
+// one of its deadlines, 3 ticks before it, it starts 3 ms late every other
+// run: each interval is 3 ms off its period. The slow job keeps its own
+// deadlines, so its jitter stays 0.
+void test_jitter_per_job(void) {
+    static periodic_job_t slow;
+    const timed_job_t fast_timing = { 0, 10 };
+    const timed_job_t slow_timing = { 5, 20 };
+    periodic_job_stats_t fast_stats, slow_stats;
+    periodic_scheduler_stats_t stats;
+
+    memset(&slow, 0, sizeof(slow));
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &job, timed_job, (void*)&fast_timing, 2));
+    vTaskDelay(400);
+    TEST_ASSERT_TRUE(periodic_scheduler_get_job_stats(scheduler, &job, &fast_stats));
+    printf("%-8s %6s %9s %14s %15s\n", "job", "runs", "overruns", "lateness (us)", "jitter (us)");
+    print_job("alone", &fast_stats);
+    TEST_ASSERT_EQUAL_UINT32(40, fast_stats.runs);
+    TEST_ASSERT_EQUAL_UINT32(0, fast_stats.max_lateness_us);
+    TEST_ASSERT_EQUAL_UINT32(0, fast_stats.jitter_max_us);
+    periodic_scheduler_remove(scheduler, &job);
+
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &slow, timed_job, (void*)&slow_timing, 0));
+    TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &job, timed_job, (void*)&fast_timing, 2));
+    vTaskDelay(400);
+    periodic_scheduler_remove(scheduler, &job);
+    periodic_scheduler_remove(scheduler, &slow);
+
+    TEST_ASSERT_TRUE(periodic_scheduler_get_job_stats(scheduler, &job, &fast_stats));
+    TEST_ASSERT_TRUE(periodic_scheduler_get_job_stats(scheduler, &slow, &slow_stats));
+    TEST_ASSERT_TRUE(periodic_scheduler_get_stats(scheduler, &stats));
+    print_job("shared", &fast_stats);
+    print_job("slow", &slow_stats);
+
+    TEST_ASSERT_EQUAL_UINT32(40, fast_stats.runs);
+    TEST_ASSERT_EQUAL_UINT32(3000, fast_stats.max_lateness_us);
+    TEST_ASSERT_EQUAL_UINT32(3000, fast_stats.jitter_avg_us);
+    TEST_ASSERT_EQUAL_UINT32(3000, fast_stats.jitter_max_us);
+    TEST_ASSERT_EQUAL_UINT32(21, slow_stats.runs); // Due again as the wait ends
+    TEST_ASSERT_EQUAL_UINT32(0, slow_stats.max_lateness_us);
+    TEST_ASSERT_EQUAL_UINT32(0, slow_stats.jitter_max_us);
+    TEST_ASSERT_EQUAL_UINT32(0, fast_stats.overruns + slow_stats.overruns);
+    TEST_ASSERT_EQUAL_UINT32(3000, stats.max_lateness_us);
+}
+
+typedef struct {
+    periodic_job_t job;
+    TickType_t period;
+    int64_t last_lateness_ns;
+    uint32_t runs;
+} sweep_job_t;
+
+static sweep_job_t sweep_jobs[SWEEP_MAX_JOBS];
+static int64_t lateness_ns[SWEEP_MAX_RUNS];
+static int64_t jitter_ns[SWEEP_MAX_RUNS];
+static uint32_t lateness_count;
+static uint32_t jitter_count;
+static TickType_t batch_tick;
+static int64_t batch_start_ns;
+static int64_t last_end_ns;
+static int64_t gap_ns; // Host time between runs due in one tick: the scheduler's
+static uint32_t gaps;
+static uint32_t lcg_state;
+
+static int64_t host_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static uint32_t random_below(uint32_t limit) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (uint32_t)(((uint64_t)(lcg_state >> 1) * limit) >> 31);
+}
+
+// Lateness is host time from the first run of its tick to this one; jitter
+// is how much that changed since the job's previous run
+static TickType_t sweep_job(void* context) {
+    sweep_job_t* sweep = (sweep_job_t*)context;
+    int64_t start = host_ns();
+    TickType_t tick = xTaskGetTickCount();
+
+    if (tick != batch_tick) {
+        batch_tick = tick;
+        batch_start_ns = start;
+    } else {
+        gap_ns += start - last_end_ns;
+        gaps++;
+    }
+
+    int64_t lateness = start - batch_start_ns;
+    if (lateness_count < SWEEP_MAX_RUNS) lateness_ns[lateness_count++] = lateness;
+    if (sweep->runs > 0 && jitter_count < SWEEP_MAX_RUNS) {
+        jitter_ns[jitter_count++] = llabs(lateness - sweep->last_lateness_ns);
+    }
+    sweep->last_lateness_ns = lateness;
+    sweep->runs++;
+
+    while (host_ns() - start < SWEEP_BUSY_NS) {
+    }
+    last_end_ns = host_ns();
+    return sweep->period;
+}
+
+static int compare_ns(const void* a, const void* b) {
+    int64_t left = *(const int64_t*)a;
+    int64_t right = *(const int64_t*)b;
+    return (left > right) - (left < right);
+}
+
+static double percentile_us(int64_t* values, uint32_t count, double fraction) {
+    if (count == 0) return 0.0;
+    return (double)values[(uint32_t)(fraction * (count - 1))] / 1000.0;
+}
+
+// jobs at random 10-1000 tick periods with random phases for SWEEP_TICKS.
+// In virtual time every run starts on its deadline tick; in host time a
+// run waits for those due in the same tick before it.
+static double sweep(uint32_t jobs) {
+    memset(sweep_jobs, 0, sizeof(sweep_jobs));
+    lateness_count = 0;
+    jitter_count = 0;
+    gap_ns = 0;
+    gaps = 0;
+    lcg_state = 99;
+    batch_tick = xTaskGetTickCount(); // No job runs before the next tick
+
+    for (uint32_t i = 0; i < jobs; i++) {
+        sweep_job_t* sweep = &sweep_jobs[i];
+        sweep->period = 10 + random_below(991);
+        TEST_ASSERT_TRUE(periodic_scheduler_add(scheduler, &sweep->job, sweep_job, sweep,
+                                                1 + random_below(sweep->period)));
+    }
+    vTaskDelay(SWEEP_TICKS);
+
+    uint32_t runs = 0;
+    for (uint32_t i = 0; i < jobs; i++) {
+        periodic_job_stats_t stats;
+        periodic_scheduler_remove(scheduler, &sweep_jobs[i].job);
+        TEST_ASSERT_TRUE(periodic_scheduler_get_job_stats(scheduler, &sweep_jobs[i].job, &stats));
+        TEST_ASSERT_EQUAL_UINT32(sweep_jobs[i].runs, stats.runs);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.max_lateness_us);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.jitter_max_us);
+        TEST_ASSERT_TRUE(stats.runs >= SWEEP_TICKS / sweep_jobs[i].period - 1);
+        runs += stats.runs;
+    }
+    TEST_ASSERT_TRUE(runs <= SWEEP_MAX_RUNS);
+    // A lone job never shares its tick
+    if (jobs == 1) TEST_ASSERT_EQUAL_UINT32(0, gaps);
+
+    qsort(lateness_ns, lateness_count, sizeof(lateness_ns[0]), compare_ns);
+    qsort(jitter_ns, jitter_count, sizeof(jitter_ns[0]), compare_ns);
+    double run_ns = gaps ? (double)gap_ns / gaps : 0.0;
+    printf("%5lu %7lu %9.0f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", (unsigned long)jobs, (unsigned long)runs,
+           run_ns, percentile_us(lateness_ns, lateness_count, 0.5), percentile_us(lateness_ns, lateness_count, 0.99),
+           percentile_us(lateness_ns, lateness_count, 0.999), percentile_us(jitter_ns, jitter_count, 0.5),
+           percentile_us(jitter_ns, jitter_count, 0.99), percentile_us(jitter_ns, jitter_count, 0.999));
+    return run_ns;
+}
+
+void test_sweep_job_count(void) {
+    const uint32_t counts[] = { 1, 10, 100, SWEEP_MAX_JOBS };
+    double run_ns[4];
+
+    printf("%5s %7s %9s %8s %8s %8s %8s %8s %8s\n", "jobs", "runs", "ns/run", "late p50", "p99", "p99.9",
+           "jit p50", "p99", "p99.9");
+    printf("%5s %7s %9s %26s %26s\n", "", "", "", "us after tick's first run", "us change between runs");
+    for (int i = 0; i < 4; i++) {
+        run_ns[i] = sweep(counts[i]);
+    }
+
+    // The timer wheel keeps the cost of a run flat as jobs are added; a
+    // scan of every deadline would grow about tenfold from 10 to 1000
+    TEST_ASSERT_TRUE(run_ns[3] > 0.0);
+    TEST_ASSERT_TRUE(run_ns[3] < 5 * run_ns[1]);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_remove_waits_for_run);
+    RUN_TEST(test_remove_between_runs);
+    RUN_TEST(test_remove_from_job_itself);
+    RUN_TEST(test_remove_released_by_stop);
+    RUN_TEST(test_jitter_per_job);
+    RUN_TEST(test_sweep_job_count);
+}
+
+int main(void) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+    return 0;
+}
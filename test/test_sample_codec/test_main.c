@@ -0,0 +1,274 @@
+// Sample codec on three traces: a steady 2 s stream of slowly moving
+// readings, the same with a step and tick jitter, and the fake driver's
+// uniform noise (the worst realistic case). Every trace is cut into blocks
+// of two sizes and must decode bit-exactly; the table gives the ratio
+// against sizeof(sensor_data_t) and host encode/decode throughput over
+// the uncompressed bytes. Truncated and bit-flipped blocks must stop the
+// decoder without reading past the block.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "modules/sample_codec/sample_codec.h"
+
+#define TRACE_SAMPLES 43200 // A day at 2 s
+#define PERIOD_TICKS 2000
+#define BENCH_PASSES 20
+#define CORRUPT_BLOCK_BYTES 256
+
+typedef enum {
+    TRACE_STEADY,
+    TRACE_STEP_JITTER,
+    TRACE_FAKE_DRIVER,
+    TRACE_COUNT
+} trace_kind_t;
+
+static const char* const trace_names[TRACE_COUNT] = { "steady", "step+jitter", "fake driver" };
+static const size_t block_sizes[] = { 4096, 256 };
+#define BLOCK_SIZE_COUNT (sizeof(block_sizes) / sizeof(block_sizes[0]))
+
+static sensor_data_t trace[TRACE_SAMPLES];
+static sensor_data_t decoded[TRACE_SAMPLES];
+static uint8_t blocks[TRACE_SAMPLES * sizeof(sensor_data_t)];
+static size_t block_lengths[TRACE_SAMPLES];
+static uint32_t lcg_state;
+
+void setUp(void) {
+    lcg_state = 1;
+}
+
+void tearDown(void) {
+}
+
+static uint32_t next_random(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+static void make_trace(trace_kind_t kind) {
+    uint32_t counter;
+    sensor_driver_t fake;
+    sensor_fake_driver_init(&fake, &counter);
+    fake.ops->init(&fake);
+    srand(1);
+
+    TickType_t timestamp = 1000;
+    for (uint32_t i = 0; i < TRACE_SAMPLES; i++) {
+        sensor_data_t* sample = &trace[i];
+        memset(sample, 0, sizeof(*sample));
+
+        if (kind == TRACE_FAKE_DRIVER) {
+            fake.ops->read(&fake, sample, 0);
+        } else {
+            // Daily temperature swing, humidity against it, a sagging supply;
+            // quantised to the sensor's resolution like real readings
+            double phase = 2.0 * M_PI * i / TRACE_SAMPLES;
+            int32_t step = (kind == TRACE_STEP_JITTER && i >= TRACE_SAMPLES / 2) ? 1500 : 0;
+            sensor_set_temperature_cdeg(sample, (int32_t)(2200 + 300 * sin(phase)));
+            sensor_set_humidity_cpct(sample, (int32_t)(4500 - 800 * sin(phase)) + step);
+            sensor_set_voltage_mv(sample, (int32_t)(3300 - i / 2000));
+            sample->raw_value = 2048 + (uint32_t)(200 * sin(phase)) + next_random() % 3;
+        }
+        sample->timestamp = timestamp;
+        timestamp += PERIOD_TICKS;
+        if (kind == TRACE_STEP_JITTER) {
+            timestamp += next_random() % 3 - 1; // vTaskDelayUntil wakes a tick late at times
+        }
+    }
+}
+
+// Cuts the trace into blocks of block_size; returns the total bytes
+static size_t encode_trace(size_t block_size, size_t* block_count) {
+    sample_encoder_t encoder;
+    size_t offset = 0;
+    size_t count = 0;
+
+    sample_encoder_init(&encoder, blocks, block_size);
+    for (uint32_t i = 0; i < TRACE_SAMPLES; i++) {
+        if (!sample_encoder_append(&encoder, &trace[i])) {
+            block_lengths[count] = sample_encoder_finish(&encoder);
+            offset += block_lengths[count++];
+            sample_encoder_init(&encoder, blocks + offset, block_size);
+            TEST_ASSERT_TRUE(sample_encoder_append(&encoder, &trace[i]));
+        }
+    }
+    block_lengths[count] = sample_encoder_finish(&encoder);
+    offset += block_lengths[count++];
+    *block_count = count;
+    return offset;
+}
+
+static uint32_t decode_trace(size_t block_count) {
+    sample_decoder_t decoder;
+    size_t offset = 0;
+    uint32_t samples = 0;
+
+    for (size_t b = 0; b < block_count; b++) {
+        TEST_ASSERT_TRUE(sample_decoder_init(&decoder, blocks + offset, block_lengths[b]));
+        while (samples < TRACE_SAMPLES && sample_decoder_next(&decoder, &decoded[samples])) {
+            samples++;
+        }
+        TEST_ASSERT_FALSE(decoder.error);
+        TEST_ASSERT_EQUAL(decoder.count, decoder.decoded);
+        offset += block_lengths[b];
+    }
+    return samples;
+}
+
+static double elapsed_s(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void test_round_trip_ratio_and_throughput(void) {
+    const double raw_mb = (double)TRACE_SAMPLES * sizeof(sensor_data_t) * BENCH_PASSES / 1e6;
+    double ratio[TRACE_COUNT][BLOCK_SIZE_COUNT];
+
+    printf("%-12s %8s %8s %8s %14s %14s\n", "trace", "block", "B/sample", "ratio", "encode (MB/s)",
+           "decode (MB/s)");
+    for (int kind = 0; kind < TRACE_COUNT; kind++) {
+        make_trace((trace_kind_t)kind);
+
+        for (size_t s = 0; s < BLOCK_SIZE_COUNT; s++) {
+            struct timespec start, end;
+            size_t block_count = 0;
+            size_t bytes = 0;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                bytes = encode_trace(block_sizes[s], &block_count);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double encode_mb_s = raw_mb / elapsed_s(&start, &end);
+
+            uint32_t samples = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                samples = decode_trace(block_count);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double decode_mb_s = raw_mb / elapsed_s(&start, &end);
+
+            // Bit-exact, floats included
+            TEST_ASSERT_EQUAL_UINT32(TRACE_SAMPLES, samples);
+            TEST_ASSERT_EQUAL_MEMORY(trace, decoded, sizeof(trace));
+
+            ratio[kind][s] = (double)sizeof(trace) / (double)bytes;
+            printf("%-12s %8u %8.2f %8.2f %14.1f %14.1f\n", trace_names[kind], (unsigned)block_sizes[s],
+                   (double)bytes / TRACE_SAMPLES, ratio[kind][s], encode_mb_s, decode_mb_s);
+        }
+    }
+
+    // Slow readings at a steady period compress well; the first sample of
+    // each block is verbatim, so small blocks give a little back; noise
+    // still gains from the timestamps and the narrowed raw_value
+    TEST_ASSERT_TRUE(ratio[TRACE_STEADY][0] > 2.5);
+    TEST_ASSERT_TRUE(ratio[TRACE_STEP_JITTER][0] > 2.0);
+    TEST_ASSERT_TRUE(ratio[TRACE_FAKE_DRIVER][0] > 1.2);
+    for (int kind = 0; kind < TRACE_COUNT; kind++) {
+        TEST_ASSERT_TRUE(ratio[kind][1] < ratio[kind][0]);
+    }
+}
+
+// A full block is refused once the next sample no longer fits, and the
+// block it leaves behind is unchanged by the refused sample
+void test_full_block_rolls_back(void) {
+    static uint8_t block[64];
+    static uint8_t copy[64];
+    sample_encoder_t encoder;
+    sample_decoder_t decoder;
+    uint32_t appended = 0;
+
+    make_trace(TRACE_FAKE_DRIVER);
+    sample_encoder_init(&encoder, block, sizeof(block));
+    while (sample_encoder_append(&encoder, &trace[appended])) {
+        appended++;
+    }
+    size_t length = sample_encoder_finish(&encoder);
+    memcpy(copy, block, sizeof(block));
+    TEST_ASSERT_FALSE(sample_encoder_append(&encoder, &trace[appended]));
+    TEST_ASSERT_EQUAL(length, sample_encoder_finish(&encoder));
+    TEST_ASSERT_EQUAL_MEMORY(copy, block, sizeof(block));
+
+    TEST_ASSERT_TRUE(appended > 1);
+    TEST_ASSERT_TRUE(length <= sizeof(block));
+    TEST_ASSERT_TRUE(sample_decoder_init(&decoder, block, length));
+    for (uint32_t i = 0; i < appended; i++) {
+        sensor_data_t sample;
+        TEST_ASSERT_TRUE(sample_decoder_next(&decoder, &sample));
+        TEST_ASSERT_EQUAL_MEMORY(&trace[i], &sample, sizeof(sample));
+    }
+    TEST_ASSERT_FALSE(sample_decoder_next(&decoder, &decoded[0]));
+    TEST_ASSERT_FALSE(decoder.error);
+}
+
+// Decodes block[0..length) from a copy sized exactly to it, so a read
+// past the end would land outside the allocation (caught under ASan)
+static uint16_t decode_exact(const uint8_t* block, size_t length, bool* error) {
+    uint8_t* copy = (uint8_t*)malloc(length ? length : 1);
+    sample_decoder_t decoder;
+    sensor_data_t sample;
+
+    memcpy(copy, block, length);
+    *error = !sample_decoder_init(&decoder, copy, length);
+    if (!*error) {
+        while (sample_decoder_next(&decoder, &sample)) {
+        }
+        *error = decoder.error;
+        TEST_ASSERT_TRUE(decoder.bit_pos <= decoder.length_bits || decoder.error);
+        TEST_ASSERT_TRUE(decoder.decoded <= decoder.count);
+    }
+    free(copy);
+    return *error ? 0 : decoder.decoded;
+}
+
+void test_corrupt_blocks_stop_the_decoder(void) {
+    static uint8_t block[CORRUPT_BLOCK_BYTES];
+    sample_encoder_t encoder;
+    bool error;
+    uint32_t appended = 0;
+
+    make_trace(TRACE_STEP_JITTER);
+    sample_encoder_init(&encoder, block, sizeof(block));
+    while (sample_encoder_append(&encoder, &trace[appended])) {
+        appended++;
+    }
+    size_t length = sample_encoder_finish(&encoder);
+    TEST_ASSERT_EQUAL(appended, decode_exact(block, length, &error));
+    TEST_ASSERT_FALSE(error);
+
+    // Every truncation loses bits of the last sample at least
+    for (size_t cut = 0; cut < length; cut++) {
+        decode_exact(block, cut, &error);
+        TEST_ASSERT_TRUE(error);
+    }
+
+    // A flipped bit cannot always be detected (there is no checksum; the
+    // carrier has one), but the decoder must stay inside the block
+    uint32_t detected = 0;
+    for (size_t bit = 0; bit < length * 8; bit++) {
+        block[bit / 8] ^= (uint8_t)(0x80 >> (bit % 8));
+        decode_exact(block, length, &error);
+        detected += error;
+        block[bit / 8] ^= (uint8_t)(0x80 >> (bit % 8));
+    }
+    printf("%lu of %lu single-bit flips detected\n", (unsigned long)detected, (unsigned long)(length * 8));
+
+    // Garbage of every length
+    for (size_t n = 0; n < sizeof(block); n++) {
+        for (size_t i = 0; i < n; i++) {
+            block[i] = (uint8_t)next_random();
+        }
+        decode_exact(block, n, &error);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_ratio_and_throughput);
+    RUN_TEST(test_full_block_rolls_back);
+    RUN_TEST(test_corrupt_blocks_stop_the_decoder);
+    return UNITY_END();
+}
@@ -0,0 +1,377 @@
+// Sample log times past the 32-bit range: appends across a tick-count
+// wrap, recovery after a reset, and time queries that straddle 2^32 ms.
+// A reset is simulated by creating the log again on the same partition,
+// which the shim keeps in memory for the life of the process. A time query
+// reads a logarithmic number of page headers, counted by the shim.
+// Flushes program the partial page in place, so each page is erased once,
+// and a reset in the middle of one loses nothing that was committed. A
+// benchmark over a file-backed flash image (SIM_FLASH_IMAGE) times
+// appends, recovery and queries.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "modules/sample_log/sample_log.h"
+#include "sim_flash.h"
+
+#define TWO_POW_32 (1ULL << 32)
+#define WRAP_STEP_TICKS (1UL << 28) // About 3 days at 1 kHz
+#define SAMPLE_PERIOD_MS 2000        // main.cpp's default
+#define FLUSH_EVERY 30               // SAMPLE_LOG_FLUSH_INTERVAL_MS at that period
+#define QUERY_REPEATS 200
+
+static sample_log_t storage;
+static int partition_number;
+static char label[16];
+
+typedef struct {
+    uint64_t last_ms;
+    uint32_t visited;
+    bool ordered;
+} query_result_t;
+
+void setUp(void) {
+    // A fresh, erased partition per test
+    snprintf(label, sizeof(label), "log%d", partition_number++);
+}
+
+void tearDown(void) {
+}
+
+static void append(sample_log_t* log, TickType_t timestamp, uint32_t raw) {
+    sensor_data_t sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.raw_value = raw;
+    sample.timestamp = timestamp;
+    TEST_ASSERT_TRUE(sample_log_append(log, &sample));
+}
+
+static bool check_order(const sample_log_record_t* record, void* context) {
+    query_result_t* result = (query_result_t*)context;
+    uint64_t time_ms = sample_log_record_time_ms(record);
+
+    if (result->visited > 0 && time_ms < result->last_ms) result->ordered = false;
+    result->last_ms = time_ms;
+    result->visited++;
+    return true;
+}
+
+// The tick count wraps after 49.7 days at 1 kHz; log time must keep going
+void test_times_continue_across_tick_wrap(void) {
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    TickType_t ticks = 0;
+    for (int i = 0; i < 20; i++) { // Wraps after the 16th step
+        append(log, ticks, (uint32_t)i);
+        TEST_ASSERT_EQUAL_UINT64((uint64_t)i * WRAP_STEP_TICKS, log->newest_ms);
+        ticks += WRAP_STEP_TICKS;
+    }
+    TEST_ASSERT_EQUAL_UINT64(19ULL * WRAP_STEP_TICKS, sample_log_time_ms(log, ticks - WRAP_STEP_TICKS));
+    TEST_ASSERT_TRUE(sample_log_time_ms(log, ticks) > TWO_POW_32);
+
+    query_result_t result = { 0, 0, true };
+    TEST_ASSERT_EQUAL(4, sample_log_query(log, TWO_POW_32, UINT64_MAX, check_order, &result));
+    TEST_ASSERT_TRUE(result.ordered);
+}
+
+// Pages written beyond 2^32 ms keep their times through a reset, and the
+// next boot carries on after them
+void test_recovery_keeps_64_bit_times(void) {
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    // Sparse samples up to a page's worth of seconds below 2^32 ms, then
+    // one a second across it; the tick count wraps on the way
+    const uint32_t samples = 3 * SAMPLE_LOG_RECORDS_PER_PAGE + 10;
+    const uint64_t start_ms = TWO_POW_32 - 1000ULL * SAMPLE_LOG_RECORDS_PER_PAGE;
+    uint32_t filler = 0;
+    for (uint64_t ms = WRAP_STEP_TICKS; ms < start_ms; ms += WRAP_STEP_TICKS, filler++) {
+        append(log, (TickType_t)ms, 0);
+    }
+    for (uint32_t i = 0; i < samples; i++) {
+        append(log, (TickType_t)(start_ms + i * 1000ULL), i);
+    }
+    TEST_ASSERT_TRUE(sample_log_flush(log));
+    uint64_t newest_ms = log->newest_ms;
+    TEST_ASSERT_EQUAL_UINT64(start_ms + (samples - 1) * 1000ULL, newest_ms);
+
+    // Reset: recover from flash alone
+    memset(&storage, 0, sizeof(storage));
+    log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    sample_log_stats_t stats;
+    TEST_ASSERT_TRUE(sample_log_get_stats(log, &stats));
+    TEST_ASSERT_EQUAL_UINT64(newest_ms, stats.newest_ms);
+    TEST_ASSERT_EQUAL_UINT32(filler + samples, stats.samples);
+
+    // Samples from 2^32 ms on, found by binary search over the page headers
+    query_result_t result = { 0, 0, true };
+    size_t visited = sample_log_query(log, TWO_POW_32, UINT64_MAX, check_order, &result);
+    TEST_ASSERT_EQUAL(samples - SAMPLE_LOG_RECORDS_PER_PAGE, visited);
+    TEST_ASSERT_TRUE(result.ordered);
+
+    // The new boot starts at tick 0, right after the recovered samples
+    TEST_ASSERT_EQUAL_UINT64(newest_ms + 1, sample_log_time_ms(log, 0));
+    append(log, 0, 0);
+    TEST_ASSERT_EQUAL_UINT64(newest_ms + 1, log->newest_ms);
+}
+
+static uint32_t ceil_log2(uint32_t value) {
+    uint32_t bits = 0;
+    while ((1u << bits) < value) bits++;
+    return bits;
+}
+
+static uint32_t flash_reads(const sample_log_t* log) {
+    sim_flash_stats_t stats;
+    TEST_ASSERT_TRUE(sim_flash_get_stats(log->partition, &stats));
+    return stats.reads;
+}
+
+// A sample every period_ms from tick 0; with flush_every set, a flush after
+// every flush_every samples
+static void fill(sample_log_t* log, uint32_t samples, uint32_t period_ms, uint32_t flush_every) {
+    for (uint32_t i = 0; i < samples; i++) {
+        append(log, (TickType_t)(i * period_ms), i);
+        if (flush_every && i % flush_every == flush_every - 1) {
+            TEST_ASSERT_TRUE(sample_log_flush(log));
+        }
+    }
+}
+
+// With the ring wrapped and every page but the head full, a query for a
+// single sample reads the headers of a binary search over the full pages,
+// the header of the page it lands in, a binary search over that page's
+// records and one chunk, wherever in the log the sample is
+void test_query_binary_searches_page_headers(void) {
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    const uint32_t samples = (log->page_count + 2) * SAMPLE_LOG_RECORDS_PER_PAGE + 10;
+    fill(log, samples, 1000, 0);
+    TEST_ASSERT_EQUAL_UINT32(log->page_count - 1, log->full_pages);
+
+    const uint32_t oldest = samples - 10 - log->full_pages * SAMPLE_LOG_RECORDS_PER_PAGE;
+    const uint32_t bound = ceil_log2(log->full_pages + 1) + 1 + ceil_log2(SAMPLE_LOG_RECORDS_PER_PAGE + 1) + 1;
+    const uint32_t targets[] = { oldest, oldest + 1000, (oldest + samples) / 2, samples - 11 - 7, samples - 11 };
+    uint32_t most_reads = 0;
+
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+        uint64_t time_ms = targets[t] * 1000ULL;
+        query_result_t result = { 0, 0, true };
+        uint32_t before = flash_reads(log);
+
+        TEST_ASSERT_EQUAL(1, sample_log_query(log, time_ms, time_ms, check_order, &result));
+        TEST_ASSERT_EQUAL_UINT64(time_ms, result.last_ms);
+        uint32_t reads = flash_reads(log) - before;
+        if (reads > most_reads) most_reads = reads;
+        TEST_ASSERT_TRUE(reads <= bound);
+    }
+    printf("single-sample query over %lu full pages: at most %lu flash reads (bound %lu)\n",
+           (unsigned long)log->full_pages, (unsigned long)most_reads, (unsigned long)bound);
+}
+
+static uint32_t flash_erases(const sample_log_t* log) {
+    sim_flash_stats_t stats;
+    TEST_ASSERT_TRUE(sim_flash_get_stats(log->partition, &stats));
+    return stats.erased_sectors;
+}
+
+typedef struct {
+    uint32_t next_raw;
+    bool contiguous;
+} sequence_result_t;
+
+static bool check_sequence(const sample_log_record_t* record, void* context) {
+    sequence_result_t* result = (sequence_result_t*)context;
+
+    if (record->raw_value != result->next_raw) result->contiguous = false;
+    result->next_raw = record->raw_value + 1;
+    return true;
+}
+
+// Every sample from raw 0 on, in order and without gaps
+static void assert_samples(sample_log_t* log, uint32_t samples) {
+    sequence_result_t result = { 0, true };
+    TEST_ASSERT_EQUAL(samples, sample_log_query(log, 0, UINT64_MAX, check_sequence, &result));
+    TEST_ASSERT_TRUE(result.contiguous);
+}
+
+static sample_log_t* reset(void) {
+    memset(&storage, 0, sizeof(storage));
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+    return log;
+}
+
+// main.cpp's periodic flush costs no erases: three full pages and the
+// flushed head take four, and after a reset the head keeps filling in
+// place
+void test_flushes_program_in_place(void) {
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    const uint32_t samples = 3 * SAMPLE_LOG_RECORDS_PER_PAGE + 2 * FLUSH_EVERY;
+    const uint32_t flushed = samples / FLUSH_EVERY * FLUSH_EVERY;
+    fill(log, samples, SAMPLE_PERIOD_MS, FLUSH_EVERY);
+    TEST_ASSERT_EQUAL_UINT32(4, log->stats.erases);
+    TEST_ASSERT_EQUAL_UINT32(4, flash_erases(log));
+
+    log = reset();
+    TEST_ASSERT_EQUAL_UINT32(3, log->full_pages);
+    TEST_ASSERT_EQUAL_UINT32(flushed - 3 * SAMPLE_LOG_RECORDS_PER_PAGE, log->buffer_count);
+    TEST_ASSERT_TRUE(log->head_open);
+    assert_samples(log, flushed);
+
+    for (uint32_t i = flushed; i < flushed + FLUSH_EVERY; i++) {
+        append(log, (TickType_t)(i * SAMPLE_PERIOD_MS), i);
+    }
+    TEST_ASSERT_TRUE(sample_log_flush(log));
+    TEST_ASSERT_EQUAL_UINT32(0, log->stats.erases);
+
+    log = reset();
+    assert_samples(log, flushed + FLUSH_EVERY);
+    TEST_ASSERT_EQUAL_UINT32(4, flash_erases(log));
+}
+
+// A reset after a flush programmed its records but before its commit slot:
+// recovery keeps the earlier commit, and since the page's tail is no
+// longer erased, the next flush rewrites the page from a fresh erase
+void test_reset_mid_flush_keeps_committed_samples(void) {
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    fill(log, FLUSH_EVERY + 5, SAMPLE_PERIOD_MS, FLUSH_EVERY);
+    const sample_log_record_t* torn = &log->buffer[FLUSH_EVERY];
+    size_t offset = sizeof(sample_log_page_header_t) + FLUSH_EVERY * sizeof(sample_log_record_t);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(log->partition, offset, torn, 5 * sizeof(*torn)));
+
+    log = reset();
+    TEST_ASSERT_EQUAL_UINT32(FLUSH_EVERY, log->buffer_count);
+    TEST_ASSERT_FALSE(log->head_open);
+
+    uint32_t erases = flash_erases(log);
+    for (uint32_t i = FLUSH_EVERY; i < FLUSH_EVERY + 3; i++) {
+        append(log, (TickType_t)(i * SAMPLE_PERIOD_MS), i);
+    }
+    TEST_ASSERT_TRUE(sample_log_flush(log));
+    TEST_ASSERT_EQUAL_UINT32(erases + 1, flash_erases(log));
+
+    log = reset();
+    TEST_ASSERT_TRUE(log->head_open);
+    assert_samples(log, FLUSH_EVERY + 3);
+}
+
+// A flush after every sample: once the commit slots run out the page is
+// rewritten from a fresh erase and its slots start over
+void test_flushes_beyond_commit_slots(void) {
+    sample_log_t* log = sample_log_create_static(&storage, label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    const uint32_t samples = 2 * SAMPLE_LOG_COMMIT_SLOTS + 1;
+    fill(log, samples, SAMPLE_PERIOD_MS, 1);
+    TEST_ASSERT_EQUAL_UINT32(3, log->stats.erases);
+    TEST_ASSERT_EQUAL_UINT32(1, log->commits);
+
+    log = reset();
+    assert_samples(log, samples);
+}
+
+static int64_t host_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static bool count_only(const sample_log_record_t* record, void* context) {
+    (void)record;
+    (void)context;
+    return true;
+}
+
+// Two laps of the ring at the firmware's sample period, without flushes
+// and with main.cpp's periodic flush; then a reset and queries for the
+// last minute and for the whole log, on a partition backed by an image
+// file as in the native firmware
+static void bench_row(const char* name, uint32_t flush_every) {
+    char bench_label[16];
+    snprintf(bench_label, sizeof(bench_label), "bench%s", name);
+    sample_log_t* log = sample_log_create_static(&storage, bench_label);
+    TEST_ASSERT_NOT_NULL(log);
+
+    const uint32_t samples = 2 * log->page_count * SAMPLE_LOG_RECORDS_PER_PAGE;
+    sim_flash_stats_t before, after;
+    sim_flash_get_stats(log->partition, &before);
+    int64_t start = host_ns();
+    fill(log, samples, SAMPLE_PERIOD_MS, flush_every);
+    double append_ns = (double)(host_ns() - start) / samples;
+    sim_flash_get_stats(log->partition, &after);
+    double erases_per_page = (double)(after.erased_sectors - before.erased_sectors) /
+                             (samples / SAMPLE_LOG_RECORDS_PER_PAGE);
+    TEST_ASSERT_TRUE(sample_log_flush(log));
+
+    memset(&storage, 0, sizeof(storage));
+    start = host_ns();
+    log = sample_log_create_static(&storage, bench_label);
+    double recovery_us = (double)(host_ns() - start) / 1000;
+    TEST_ASSERT_NOT_NULL(log);
+    TEST_ASSERT_EQUAL_UINT64((samples - 1) * (uint64_t)SAMPLE_PERIOD_MS, log->newest_ms);
+
+    uint64_t newest_ms = log->newest_ms;
+    size_t minute = 0;
+    size_t whole = 0;
+    start = host_ns();
+    for (int i = 0; i < QUERY_REPEATS; i++) {
+        minute = sample_log_query(log, newest_ms - 59999, newest_ms, count_only, NULL);
+    }
+    double minute_us = (double)(host_ns() - start) / 1000 / QUERY_REPEATS;
+    start = host_ns();
+    for (int i = 0; i < QUERY_REPEATS; i++) {
+        whole = sample_log_query(log, 0, UINT64_MAX, count_only, NULL);
+    }
+    double whole_us = (double)(host_ns() - start) / 1000 / QUERY_REPEATS;
+
+    printf("%-9s %12.0f %12.2f %13.1f %14.2f %14.1f\n", name, append_ns, erases_per_page, recovery_us,
+           minute_us, whole_us);
+    TEST_ASSERT_EQUAL(60000 / SAMPLE_PERIOD_MS, minute);
+    TEST_ASSERT_EQUAL(log->full_pages * SAMPLE_LOG_RECORDS_PER_PAGE + log->buffer_count, whole);
+}
+
+void test_benchmark_file_backed_image(void) {
+    char directory[] = "/tmp/sample_logXXXXXX";
+    char image[64];
+    char path[96];
+
+    TEST_ASSERT_NOT_NULL(mkdtemp(directory));
+    snprintf(image, sizeof(image), "%s/flash", directory);
+    setenv("SIM_FLASH_IMAGE", image, 1);
+
+    printf("%-9s %12s %12s %13s %14s %14s\n", "flushes", "append (ns)", "erases/page", "recovery (us)",
+           "last 60 s (us)", "whole log (us)");
+    bench_row("none", 0);
+    bench_row("periodic", FLUSH_EVERY);
+    unsetenv("SIM_FLASH_IMAGE");
+
+    snprintf(path, sizeof(path), "%s.benchnone", image);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s.benchperiodic", image);
+    unlink(path);
+    rmdir(directory);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_times_continue_across_tick_wrap);
+    RUN_TEST(test_recovery_keeps_64_bit_times);
+    RUN_TEST(test_query_binary_searches_page_headers);
+    RUN_TEST(test_flushes_program_in_place);
+    RUN_TEST(test_reset_mid_flush_keeps_committed_samples);
+    RUN_TEST(test_flushes_beyond_commit_slots);
+    RUN_TEST(test_benchmark_file_backed_image);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// Adaptive sampling against the fixed rate on the same recorded trace,
+// replayed through the trace driver in simulated time. The trace is flat,
+// ramps, holds, then steps; for each mode the test counts samples taken
+// and emitted and rebuilds the signal a consumer would see (each emitted
+// sample holds until the next) to measure how far it strays from the
+// trace and how late the step shows up.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "modules/sensor_reader/sensor_reader.h"
+#include "modules/sensor_reader/sensor_trace_driver.h"
+#include "../sim_test.h"
+
+#define TRACE_ROW_MS 500
+#define TRACE_MS (20UL * 60 * 1000)
+#define RAMP_START_MS (5UL * 60 * 1000)
+#define RAMP_END_MS (8UL * 60 * 1000)
+#define STEP_MS (12UL * 60 * 1000)
+#define FIXED_PERIOD_MS 2000
+#define MAX_EMITTED 1024
+
+typedef struct {
+    uint32_t taken;
+    uint32_t emitted;
+    float max_temperature_error; // C, against the trace, over the whole run
+    uint32_t step_latency_ms;    // Step in the trace to the first emitted sample showing it
+    uint32_t max_gap_ms;         // Longest stretch without an emitted sample
+} run_result_t;
+
+static char trace_path[64];
+static sensor_data_t emitted[MAX_EMITTED];
+static uint32_t emitted_count;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// 21 C, ramping to 25 C over three minutes, then flat; humidity steps
+// from 45 to 60 %RH at STEP_MS
+static void trace_values(uint32_t ms, float* temperature, float* humidity) {
+    if (ms < RAMP_START_MS) {
+        *temperature = 21.0f;
+    } else if (ms < RAMP_END_MS) {
+        *temperature = 21.0f + 4.0f * (float)(ms - RAMP_START_MS) / (float)(RAMP_END_MS - RAMP_START_MS);
+    } else {
+        *temperature = 25.0f;
+    }
+    *humidity = ms < STEP_MS ? 45.0f : 60.0f;
+}
+
+// Same columns as tools/decode_telemetry.py writes
+static void write_trace(void) {
+    strcpy(trace_path, "/tmp/adaptive_traceXXXXXX");
+    int fd = mkstemp(trace_path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    FILE* file = fdopen(fd, "w");
+
+    fprintf(file, "time_ms,seq,raw,temperature_c,humidity_pct,voltage_v\n");
+    for (uint32_t ms = 0, seq = 0; ms <= TRACE_MS; ms += TRACE_ROW_MS, seq++) {
+        float temperature, humidity;
+        trace_values(ms, &temperature, &humidity);
+        fprintf(file, "%lu,%lu,2048,%.3f,%.2f,3.300\n", (unsigned long)ms, (unsigned long)(seq & 0xFF),
+                temperature, humidity);
+    }
+    fclose(file);
+}
+
+static void run_trace(const sensor_adaptive_config_t* adaptive, run_result_t* result) {
+    sensor_trace_driver_t trace;
+    sensor_reader_t* reader = sensor_reader_create(pdMS_TO_TICKS(FIXED_PERIOD_MS));
+    TEST_ASSERT_NOT_NULL(reader);
+
+    sensor_trace_driver_init(&trace, trace_path);
+    sensor_reader_set_driver(reader, &trace.driver);
+    sensor_reader_set_adaptive(reader, adaptive);
+
+    emitted_count = 0;
+    TickType_t start = xTaskGetTickCount();
+    TEST_ASSERT_TRUE(sensor_reader_start(reader));
+
+    // Drain often enough that the history ring never overflows
+    while (xTaskGetTickCount() - start < pdMS_TO_TICKS(TRACE_MS)) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        emitted_count += sensor_reader_drain(reader, &emitted[emitted_count], MAX_EMITTED - emitted_count);
+    }
+
+    sensor_adaptive_stats_t stats;
+    result->taken = sensor_reader_get_adaptive_stats(reader, &stats) ? stats.taken : emitted_count;
+    result->emitted = emitted_count;
+    sensor_reader_stop(reader);
+    sensor_reader_destroy(reader);
+
+    // Replay the consumer's view against the trace, row by row
+    result->max_temperature_error = 0.0f;
+    result->step_latency_ms = UINT32_MAX;
+    result->max_gap_ms = 0;
+    uint32_t next = 0;
+    uint32_t last_emit_ms = 0;
+    const sensor_data_t* held = NULL;
+
+    for (uint32_t ms = 0; ms < TRACE_MS; ms += TRACE_ROW_MS) {
+        while (next < emitted_count && (emitted[next].timestamp - start) * portTICK_PERIOD_MS <= ms) {
+            held = &emitted[next++];
+            last_emit_ms = ms;
+        }
+        if (!held) continue;
+
+        float temperature, humidity;
+        trace_values(ms, &temperature, &humidity);
+        float error = fabsf(sensor_temperature_c(held) - temperature);
+        if (error > result->max_temperature_error) result->max_temperature_error = error;
+        if (ms - last_emit_ms > result->max_gap_ms) result->max_gap_ms = ms - last_emit_ms;
+        if (ms >= STEP_MS && result->step_latency_ms == UINT32_MAX && sensor_humidity_pct(held) > 50.0f) {
+            result->step_latency_ms = ms - STEP_MS;
+        }
+    }
+}
+
+void test_adaptive_against_fixed_rate_on_trace(void) {
+    const sensor_adaptive_config_t config = SENSOR_ADAPTIVE_DEFAULT_CONFIG;
+    run_result_t fixed;
+    run_result_t adaptive;
+
+    write_trace();
+    run_trace(NULL, &fixed);
+    run_trace(&config, &adaptive);
+    unlink(trace_path);
+
+    printf("%-10s %8s %8s %14s %12s %10s\n", "mode", "taken", "emitted", "max err (C)", "step (ms)", "gap (ms)");
+    printf("%-10s %8lu %8lu %14.3f %12lu %10lu\n", "fixed", (unsigned long)fixed.taken,
+           (unsigned long)fixed.emitted, fixed.max_temperature_error, (unsigned long)fixed.step_latency_ms,
+           (unsigned long)fixed.max_gap_ms);
+    printf("%-10s %8lu %8lu %14.3f %12lu %10lu\n", "adaptive", (unsigned long)adaptive.taken,
+           (unsigned long)adaptive.emitted, adaptive.max_temperature_error,
+           (unsigned long)adaptive.step_latency_ms, (unsigned long)adaptive.max_gap_ms);
+
+    // Fixed rate: every period, everything emitted, ramp error one period's drift
+    TEST_ASSERT_UINT32_WITHIN(1, TRACE_MS / FIXED_PERIOD_MS, fixed.taken);
+    TEST_ASSERT_EQUAL_UINT32(fixed.taken, fixed.emitted);
+    TEST_ASSERT_TRUE(fixed.step_latency_ms <= FIXED_PERIOD_MS);
+
+    // Adaptive: far fewer wakeups and emits over the flat stretches...
+    TEST_ASSERT_TRUE(adaptive.taken * 2 < fixed.taken);
+    TEST_ASSERT_TRUE(adaptive.emitted * 4 < fixed.emitted);
+    // ...while the held value stays within the temperature delta plus the
+    // ramp's drift (4 C over 180 s) across a period that stretched twice
+    // before the drift passed the delta
+    TEST_ASSERT_TRUE(adaptive.max_temperature_error <= 0.2f + 4.0f * (4 * FIXED_PERIOD_MS) / 180000.0f);
+    // A step is seen within one stretched period, and a flat signal still
+    // emits a heartbeat
+    TEST_ASSERT_TRUE(adaptive.step_latency_ms <= config.max_period * portTICK_PERIOD_MS);
+    TEST_ASSERT_TRUE(adaptive.max_gap_ms <= (config.heartbeat + config.max_period) * portTICK_PERIOD_MS);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_adaptive_against_fixed_rate_on_trace);
+}
+
+int main(void) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+    return 0;
+}
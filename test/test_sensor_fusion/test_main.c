@@ -0,0 +1,205 @@
+// Kalman filter bank against a naive array-of-structs filter: one struct
+// per channel holding its own estimate, variance and noise terms, stepped
+// channel by channel for each sample with the gain recomputed every time.
+// Both must give the same estimates; the table gives host time per sample
+// for the naive filter, for the bank fed one sample per call (as the
+// reader task would) and for the bank fed batches (as loop() does with
+// what it drains), before and after the variances settle.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "modules/sensor_reader/sensor_fusion.h"
+
+#define TRACE_SAMPLES 4096
+#define BENCH_PASSES 200
+#define STEADY_WARMUP 2000
+
+typedef struct {
+    float x;
+    float p;
+    float q;
+    float r;
+} naive_channel_t;
+
+typedef struct {
+    naive_channel_t channel[SENSOR_CHANNEL_COUNT];
+    uint32_t samples;
+} naive_filter_t;
+
+static sensor_data_t trace[TRACE_SAMPLES];
+static sensor_fused_t results[TRACE_SAMPLES];
+static uint32_t lcg_state;
+
+void setUp(void) {
+    lcg_state = 7;
+}
+
+void tearDown(void) {
+}
+
+static float noise(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (float)(lcg_state >> 8) / (float)(1u << 24) - 0.5f;
+}
+
+static void make_trace(void) {
+    for (uint32_t i = 0; i < TRACE_SAMPLES; i++) {
+        sensor_data_t* sample = &trace[i];
+        float drift = sinf(2.0f * (float)M_PI * (float)i / TRACE_SAMPLES);
+        sensor_set_temperature_cdeg(sample, (int32_t)(2200 + 150 * drift + 40 * noise()));
+        sensor_set_humidity_cpct(sample, (int32_t)(4500 - 300 * drift + 200 * noise()));
+        sensor_set_voltage_mv(sample, (int32_t)(3300 + 20 * noise()));
+        sample->raw_value = 2048 + (uint32_t)(100 * drift + 20 * noise() + 20);
+        sample->timestamp = i * 2000;
+    }
+}
+
+static void naive_init(naive_filter_t* filter, const sensor_fusion_config_t* config) {
+    memset(filter, 0, sizeof(*filter));
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        filter->channel[c].q = config->process_noise[c];
+        filter->channel[c].r = config->measurement_noise[c];
+    }
+}
+
+static float naive_reading(const sensor_data_t* sample, int channel) {
+    switch (channel) {
+    case SENSOR_CHANNEL_TEMPERATURE: return sensor_temperature_c(sample);
+    case SENSOR_CHANNEL_HUMIDITY: return sensor_humidity_pct(sample);
+    case SENSOR_CHANNEL_VOLTAGE: return sensor_voltage_v(sample);
+    default: return (float)sample->raw_value;
+    }
+}
+
+static __attribute__((noinline)) void naive_process(naive_filter_t* filter, const sensor_data_t* sample) {
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        naive_channel_t* channel = &filter->channel[c];
+        float z = naive_reading(sample, c);
+
+        if (filter->samples == 0) {
+            channel->x = z;
+            channel->p = channel->r;
+            continue;
+        }
+        float p_pred = channel->p + channel->q;
+        float gain = p_pred / (p_pred + channel->r);
+        channel->p = p_pred - gain * p_pred;
+        channel->x += gain * (z - channel->x);
+    }
+    filter->samples++;
+}
+
+static double elapsed_ns(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+// Same estimates sample by sample, whichever way the bank is fed
+void test_bank_matches_naive_filter(void) {
+    const sensor_fusion_config_t config = SENSOR_FUSION_DEFAULT_CONFIG;
+    const size_t batches[] = { 1, 5, SENSOR_FUSION_BLOCK, 3 * SENSOR_FUSION_BLOCK + 1 };
+    naive_filter_t naive;
+    sensor_fusion_bank_t bank;
+
+    make_trace();
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        naive_init(&naive, &config);
+        sensor_fusion_init(&bank, &config);
+
+        for (uint32_t start = 0; start < TRACE_SAMPLES; start += batches[b]) {
+            size_t count = TRACE_SAMPLES - start < batches[b] ? TRACE_SAMPLES - start : batches[b];
+            sensor_fusion_process(&bank, &trace[start], count, &results[start]);
+        }
+        for (uint32_t i = 0; i < TRACE_SAMPLES; i++) {
+            naive_process(&naive, &trace[i]);
+            for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+                float want = naive.channel[c].x;
+                TEST_ASSERT_TRUE(fabsf(results[i].estimate[c] - want) <= 1e-5f * (fabsf(want) + 1.0f));
+                TEST_ASSERT_TRUE(results[i].variance[c] == naive.channel[c].p);
+            }
+        }
+        TEST_ASSERT_TRUE(bank.steady);
+
+        sensor_fused_t latest;
+        TEST_ASSERT_TRUE(sensor_fusion_get(&bank, &latest));
+        TEST_ASSERT_EQUAL_UINT32(TRACE_SAMPLES, latest.samples);
+    }
+}
+
+static double time_naive(const sensor_fusion_config_t* config, uint32_t warmup) {
+    naive_filter_t filter;
+    struct timespec start, end;
+    float checksum = 0.0f;
+
+    naive_init(&filter, config);
+    for (uint32_t i = 0; i < warmup; i++) {
+        naive_process(&filter, &trace[i % TRACE_SAMPLES]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (uint32_t i = 0; i < TRACE_SAMPLES; i++) {
+            naive_process(&filter, &trace[i]);
+        }
+        checksum += filter.channel[0].x;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST_ASSERT_FALSE(isnan(checksum));
+    return elapsed_ns(&start, &end) / ((double)BENCH_PASSES * TRACE_SAMPLES);
+}
+
+static double time_bank(const sensor_fusion_config_t* config, uint32_t warmup, size_t batch) {
+    static sensor_fusion_bank_t bank;
+    struct timespec start, end;
+    float checksum = 0.0f;
+
+    sensor_fusion_init(&bank, config);
+    for (uint32_t i = 0; i < warmup; i++) {
+        sensor_fusion_process(&bank, &trace[i % TRACE_SAMPLES], 1, NULL);
+    }
+    TEST_ASSERT_EQUAL(warmup >= STEADY_WARMUP, bank.steady);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (uint32_t i = 0; i < TRACE_SAMPLES; i += batch) {
+            sensor_fusion_process(&bank, &trace[i], batch, NULL);
+        }
+        checksum += bank.x[0];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST_ASSERT_FALSE(isnan(checksum));
+    return elapsed_ns(&start, &end) / ((double)BENCH_PASSES * TRACE_SAMPLES);
+}
+
+void test_cost_per_sample(void) {
+    const sensor_fusion_config_t config = SENSOR_FUSION_DEFAULT_CONFIG;
+    const uint32_t warmups[2] = { 1, STEADY_WARMUP };
+    double naive_ns[2], single_ns[2], batch16_ns[2], batch256_ns[2];
+
+    make_trace();
+    printf("%-10s %12s %12s %12s %12s\n", "variances", "naive AoS", "bank x1", "bank x16", "bank x256");
+    for (int steady = 0; steady < 2; steady++) {
+        // A fresh bank runs the full update until the variances converge,
+        // which is only part of the first pass, then the cached gains
+        naive_ns[steady] = time_naive(&config, warmups[steady]);
+        single_ns[steady] = time_bank(&config, warmups[steady], 1);
+        batch16_ns[steady] = time_bank(&config, warmups[steady], SENSOR_FUSION_BLOCK);
+        batch256_ns[steady] = time_bank(&config, warmups[steady], 256);
+        printf("%-10s %12.1f %12.1f %12.1f %12.1f\n", steady ? "settled" : "settling", naive_ns[steady],
+               single_ns[steady], batch16_ns[steady], batch256_ns[steady]);
+    }
+
+    // Per call the bank also publishes its newest result under the
+    // seqlock; a batch pays that once
+    TEST_ASSERT_TRUE(batch16_ns[1] < single_ns[1]);
+    // Settled, a step is a multiply-add per lane with no divide
+    TEST_ASSERT_TRUE(batch16_ns[1] < naive_ns[1]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bank_matches_naive_filter);
+    RUN_TEST(test_cost_per_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+// Seqlock stress test for sensor_reader_get_latest_data(): the reader task
+// publishes a sample every tick of the simulated kernel while host threads,
+// standing in for the other core, copy the snapshot as fast as they can.
+// Every sample is self-consistent, so a torn copy shows up as fields that
+// disagree with each other.
+
+#include <unity.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include "modules/sensor_reader/sensor_reader.h"
+#include "../sim_test.h"
+
+#define READER_THREADS 4
+#define STRESS_MS 200000 // One sample per 1 ms tick
+#define TIMED_BATCH 1024
+
+typedef struct {
+    sensor_reader_t* reader;
+    volatile bool* stop;
+    uint64_t reads;
+    uint64_t torn;
+    uint64_t elapsed_ns;
+} reader_thread_t;
+
+static uint32_t counter_sample;
+
+// Every field follows from raw_value
+static bool counter_read(sensor_driver_t* driver, sensor_data_t* sample, TickType_t period) {
+    uint32_t n = ++counter_sample;
+    int32_t v = (int32_t)(n % 20000);
+    
+    sample->raw_value = n;
+    sensor_set_voltage_mv(sample, v);
+    sensor_set_temperature_cdeg(sample, v + 1);
+    sensor_set_humidity_cpct(sample, v + 2);
+    return true;
+}
+
+static bool counter_init(sensor_driver_t* driver) {
+    return true;
+}
+
+static void counter_deinit(sensor_driver_t* driver) {
+}
+
+static const sensor_driver_ops_t counter_ops = { "counter", false, counter_init, counter_read, counter_deinit };
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool consistent(const sensor_data_t* data, int64_t* tick_offset) {
+    int32_t v = (int32_t)(data->raw_value % 20000);
+    
+    if (data->raw_value == 0) return true; // Initial snapshot
+    if (sensor_voltage_mv(data) != v || sensor_temperature_cdeg(data) != v + 1 ||
+        sensor_humidity_cpct(data) != v + 2) {
+        return false;
+    }
+    
+    // One sample per tick, so timestamp and raw_value advance together
+    int64_t offset = (int64_t)data->timestamp - (int64_t)data->raw_value;
+    if (*tick_offset == INT64_MIN) {
+        *tick_offset = offset;
+    }
+    return offset == *tick_offset;
+}
+
+static void* reader_thread(void* arg) {
+    reader_thread_t* self = (reader_thread_t*)arg;
+    int64_t tick_offset = INT64_MIN;
+    
+    while (!*self->stop) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < TIMED_BATCH; i++) {
+            sensor_data_t data;
+            
+            sensor_reader_get_latest_data(self->reader, &data);
+            self->reads++;
+            if (!consistent(&data, &tick_offset)) {
+                self->torn++;
+            }
+        }
+        self->elapsed_ns += now_ns() - start;
+    }
+    return NULL;
+}
+
+void setUp(void) {
+    counter_sample = 0;
+}
+
+void tearDown(void) {
+}
+
+static void test_snapshot_never_torn_under_concurrent_readers(void) {
+    sensor_driver_t driver = { &counter_ops, NULL };
+    sensor_reader_t* reader = sensor_reader_create(1);
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_TRUE(sensor_reader_set_driver(reader, &driver));
+    
+    volatile bool stop = false;
+    reader_thread_t threads[READER_THREADS] = { 0 };
+    pthread_t handles[READER_THREADS];
+    for (int i = 0; i < READER_THREADS; i++) {
+        threads[i].reader = reader;
+        threads[i].stop = &stop;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&handles[i], NULL, reader_thread, &threads[i]));
+    }
+    
+    TEST_ASSERT_TRUE(sensor_reader_start(reader));
+    vTaskDelay(pdMS_TO_TICKS(STRESS_MS));
+    sensor_reader_stop(reader);
+    
+    stop = true;
+    uint64_t reads = 0, torn = 0, elapsed_ns = 0;
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_join(handles[i], NULL);
+        reads += threads[i].reads;
+        torn += threads[i].torn;
+        elapsed_ns += threads[i].elapsed_ns;
+    }
+    
+    printf("seqlock: %lu samples written, %llu copies by %d threads, %llu torn, %.1f ns per copy\n",
+           (unsigned long)counter_sample, (unsigned long long)reads, READER_THREADS,
+           (unsigned long long)torn, (double)elapsed_ns / (double)reads);
+    
+    sensor_reader_destroy(reader);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(STRESS_MS, counter_sample);
+    TEST_ASSERT_GREATER_THAN(0, reads);
+    TEST_ASSERT_EQUAL_UINT64(0, torn);
+}
+
+static void test_snapshot_seq_changes_once_per_sample(void) {
+    sensor_driver_t driver = { &counter_ops, NULL };
+    sensor_reader_t* reader = sensor_reader_create(pdMS_TO_TICKS(10));
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_TRUE(sensor_reader_set_driver(reader, &driver));
+    
+    uint32_t before = sensor_reader_get_snapshot_seq(reader);
+    TEST_ASSERT_TRUE(sensor_reader_start(reader));
+    vTaskDelay(pdMS_TO_TICKS(95)); // Samples at 0, 10, ..., 90 ms
+    uint32_t after = sensor_reader_get_snapshot_seq(reader);
+    sensor_reader_stop(reader);
+    
+    TEST_ASSERT_EQUAL_UINT32(0, after & 1);
+    TEST_ASSERT_EQUAL_UINT32(2 * counter_sample, after - before);
+    sensor_reader_destroy(reader);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_snapshot_never_torn_under_concurrent_readers);
+    RUN_TEST(test_snapshot_seq_changes_once_per_sample);
+}
+
+int main(int argc, char** argv) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
@@ -0,0 +1,177 @@
+// Streaming statistics: the incremental summary against a direct
+// recompute over the window, then host time per sensor_stats_update()
+// across window sizes next to that recompute, on a noisy signal and on a
+// steady ramp (each sample empties the max deque; the min deque stays full).
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "modules/sensor_reader/sensor_stats.h"
+
+#define BENCH_UPDATES 400000
+#define CHECK_UPDATES 1000
+
+static const uint16_t windows[] = { 2, 8, 16, 30, SENSOR_STATS_MAX_WINDOW };
+#define WINDOW_COUNT (sizeof(windows) / sizeof(windows[0]))
+
+static sensor_stats_engine_t engine;
+static uint32_t lcg_state;
+
+void setUp(void) {
+    lcg_state = 12345;
+}
+
+void tearDown(void) {
+}
+
+static float noise(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (float)(lcg_state >> 8) / (float)(1u << 24) - 0.5f;
+}
+
+// Sample n of the benchmark signal; ramp: rising, so every sample is a new max
+static void make_sample(sensor_data_t* sample, uint32_t n, bool ramp) {
+    float offset = ramp ? (float)(n % 100000) * 1e-4f : noise();
+    sample->raw_value = 2048 + (uint32_t)(n % 64);
+    sample->temperature = sensor_from_scaled((int32_t)((22.0f + offset) * SENSOR_TEMPERATURE_SCALE), SENSOR_TEMPERATURE_SCALE);
+    sample->humidity = sensor_from_scaled((int32_t)((45.0f + offset) * SENSOR_HUMIDITY_SCALE), SENSOR_HUMIDITY_SCALE);
+    sample->voltage = sensor_from_scaled((int32_t)((3.3f + offset * 0.1f) * SENSOR_VOLTAGE_SCALE), SENSOR_VOLTAGE_SCALE);
+    sample->timestamp = n;
+}
+
+// What an update would cost without the incremental state: mean, stddev,
+// min and max over the last window values of each channel
+typedef struct {
+    float values[SENSOR_CHANNEL_COUNT][SENSOR_STATS_MAX_WINDOW];
+    uint32_t samples;
+    uint16_t window;
+    sensor_channel_summary_t channel[SENSOR_CHANNEL_COUNT];
+} naive_stats_t;
+
+static naive_stats_t naive;
+
+static __attribute__((noinline)) void naive_update(naive_stats_t* stats, const sensor_data_t* sample) {
+    const float values[SENSOR_CHANNEL_COUNT] = {
+        sensor_temperature_c(sample), sensor_humidity_pct(sample), sensor_voltage_v(sample), (float)sample->raw_value
+    };
+    uint32_t slot = stats->samples % stats->window;
+    stats->samples++;
+    uint32_t fill = stats->samples < stats->window ? stats->samples : stats->window;
+
+    for (int channel = 0; channel < SENSOR_CHANNEL_COUNT; channel++) {
+        float* window = stats->values[channel];
+        sensor_channel_summary_t* summary = &stats->channel[channel];
+        float sum = 0.0f;
+        float m2 = 0.0f;
+
+        window[slot] = values[channel];
+        summary->min = summary->max = window[0];
+        for (uint32_t i = 0; i < fill; i++) {
+            sum += window[i];
+            if (window[i] < summary->min) summary->min = window[i];
+            if (window[i] > summary->max) summary->max = window[i];
+        }
+        summary->mean = sum / (float)fill;
+        for (uint32_t i = 0; i < fill; i++) {
+            float delta = window[i] - summary->mean;
+            m2 += delta * delta;
+        }
+        summary->stddev = fill > 1 ? sqrtf(m2 / (float)(fill - 1)) : 0.0f;
+        summary->last = values[channel];
+    }
+}
+
+static void init_both(uint16_t window) {
+    sensor_stats_config_t config = SENSOR_STATS_DEFAULT_CONFIG;
+    config.window = window;
+    sensor_stats_init(&engine, &config);
+    memset(&naive, 0, sizeof(naive));
+    naive.window = window;
+}
+
+static double elapsed_ns(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void test_summary_matches_recompute(void) {
+    for (size_t w = 0; w < WINDOW_COUNT; w++) {
+        init_both(windows[w]);
+
+        for (uint32_t n = 0; n < CHECK_UPDATES; n++) {
+            sensor_data_t sample;
+            sensor_stats_t summary;
+            make_sample(&sample, n, n % 200 >= 100); // Alternate noise and ramp
+            sensor_stats_update(&engine, &sample);
+            naive_update(&naive, &sample);
+            TEST_ASSERT_TRUE(sensor_stats_get(&engine, &summary));
+
+            for (int channel = 0; channel < SENSOR_CHANNEL_COUNT; channel++) {
+                const sensor_channel_summary_t* got = &summary.channel[channel];
+                const sensor_channel_summary_t* want = &naive.channel[channel];
+                float scale = fabsf(want->mean) + 1.0f;
+                TEST_ASSERT_TRUE(got->min == want->min);
+                TEST_ASSERT_TRUE(got->max == want->max);
+                TEST_ASSERT_TRUE(fabsf(got->mean - want->mean) <= 1e-4f * scale);
+                TEST_ASSERT_TRUE(fabsf(got->stddev - want->stddev) <= 1e-3f * scale);
+            }
+        }
+    }
+}
+
+static void test_update_cost_across_window_sizes(void) {
+    static sensor_data_t samples[2][4096];
+    double incremental_ns[2][WINDOW_COUNT];
+    double recompute_ns[2][WINDOW_COUNT];
+    float checksum = 0.0f;
+
+    for (int ramp = 0; ramp < 2; ramp++) {
+        for (uint32_t n = 0; n < 4096; n++) {
+            make_sample(&samples[ramp][n], n, ramp);
+        }
+    }
+
+    printf("%-8s %8s %16s %16s\n", "signal", "window", "update (ns)", "recompute (ns)");
+    for (int ramp = 0; ramp < 2; ramp++) {
+        for (size_t w = 0; w < WINDOW_COUNT; w++) {
+            struct timespec start, end;
+            init_both(windows[w]);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (uint32_t n = 0; n < BENCH_UPDATES; n++) {
+                sensor_stats_update(&engine, &samples[ramp][n & 4095]);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            incremental_ns[ramp][w] = elapsed_ns(&start, &end) / BENCH_UPDATES;
+            checksum += engine.summary.channel[0].mean;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (uint32_t n = 0; n < BENCH_UPDATES; n++) {
+                naive_update(&naive, &samples[ramp][n & 4095]);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            recompute_ns[ramp][w] = elapsed_ns(&start, &end) / BENCH_UPDATES;
+            checksum += naive.channel[0].mean;
+
+            printf("%-8s %8u %16.1f %16.1f\n", ramp ? "ramp" : "noise", (unsigned)windows[w],
+                   incremental_ns[ramp][w], recompute_ns[ramp][w]);
+        }
+    }
+    printf("(checksum %.3f)\n", checksum);
+
+    // Amortised O(1): the largest window costs little more than the
+    // smallest, while a recompute grows with the window
+    for (int ramp = 0; ramp < 2; ramp++) {
+        TEST_ASSERT_TRUE(incremental_ns[ramp][WINDOW_COUNT - 1] < 2.0 * incremental_ns[ramp][0]);
+        TEST_ASSERT_TRUE(incremental_ns[ramp][WINDOW_COUNT - 1] < recompute_ns[ramp][WINDOW_COUNT - 1]);
+        TEST_ASSERT_TRUE(recompute_ns[ramp][WINDOW_COUNT - 1] > 4.0 * recompute_ns[ramp][0]);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_summary_matches_recompute);
+    RUN_TEST(test_update_cost_across_window_sizes);
+    return UNITY_END();
+}
@@ -0,0 +1,115 @@
+// Runs the sketch's setup() and then loop() for several simulated minutes,
+// counting heap allocations: none may happen once setup() has returned.
+// Also reports boot-to-first-sample latency. The native env measures the
+// dynamic path and native_static the -DMODULES_STATIC_ALLOCATION one;
+// compare the two runs' output. Allocations during setup() include the
+// shim's stand-ins for flash, the WiFi driver and esp_timer in both modes.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include <time.h>
+#include "modules/message_bus/message_bus.h"
+#include "../sim_test.h"
+
+#define LOOP_DURATION_MS (5 * 60 * 1000) // 30 status prints
+#define FIRST_SAMPLE_TIMEOUT_MS 10000
+
+// glibc's allocator, behind the counting wrappers below
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+static volatile bool counting;
+static uint32_t allocations;
+static uint64_t allocated_bytes;
+
+static void count_allocation(size_t size) {
+    if (counting) {
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&allocated_bytes, size, __ATOMIC_RELAXED);
+    }
+}
+
+extern "C" void* malloc(size_t size) {
+    count_allocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+    count_allocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) {
+    __libc_free(pointer);
+}
+
+static int64_t host_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_no_heap_after_setup(void) {
+    QueueHandle_t samples = xQueueCreate(1, sizeof(message_t));
+    TEST_ASSERT_NOT_EQUAL(MESSAGE_BUS_INVALID_SLOT,
+                          message_bus_subscribe(MESSAGE_TOPIC_BIT(MESSAGE_TOPIC_SENSOR_SAMPLE), samples));
+    
+    int64_t boot_us = host_us();
+    allocations = 0;
+    allocated_bytes = 0;
+    counting = true;
+    setup();
+    counting = false;
+    int64_t setup_us = host_us() - boot_us;
+    uint32_t setup_allocations = allocations;
+    uint64_t setup_bytes = allocated_bytes;
+    
+    message_t first;
+    TEST_ASSERT_EQUAL_INT(pdTRUE, xQueueReceive(samples, &first, pdMS_TO_TICKS(FIRST_SAMPLE_TIMEOUT_MS)));
+    int64_t first_sample_us = host_us() - boot_us;
+    
+#ifdef MODULES_STATIC_ALLOCATION
+    const char* mode = "static";
+#else
+    const char* mode = "dynamic";
+#endif
+    printf("%s allocation: setup() made %lu allocations (%llu bytes) in %lld us host time; "
+           "first sample at %lu ms simulated, %lld us host time after boot\n", mode,
+           (unsigned long)setup_allocations, (unsigned long long)setup_bytes, (long long)setup_us,
+           (unsigned long)(first.sample.timestamp * portTICK_PERIOD_MS), (long long)first_sample_us);
+    
+    allocations = 0;
+    allocated_bytes = 0;
+    counting = true;
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(LOOP_DURATION_MS);
+    while ((int32_t)(end - xTaskGetTickCount()) > 0) {
+        loop();
+    }
+    counting = false;
+    
+    printf("%s allocation: %lu allocations (%llu bytes) in %d s of loop()\n", mode,
+           (unsigned long)allocations, (unsigned long long)allocated_bytes, LOOP_DURATION_MS / 1000);
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_no_heap_after_setup);
+}
+
+int main(int argc, char** argv) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
@@ -0,0 +1,261 @@
+// Stop/join in simulated time: how long *_stop() takes for a task blocked
+// on its event group, on a queue and inside a scheduler job, and that a
+// stopped task is gone for good. Every module is started and stopped
+// repeatedly at varying points of its cycle from caller-provided storage;
+// after destroy the storage is poisoned and the simulation kept running,
+// so a task still alive (or woken by a stale timer or message) that wrote
+// to its module would show up as a changed byte.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "modules/common/task_lifecycle.h"
+#include "modules/led_controller/led_controller.h"
+#include "modules/sensor_reader/sensor_reader.h"
+#include "modules/telemetry_log/telemetry_log.h"
+#include "modules/mqtt_uplink/mqtt_uplink.h"
+#include "modules/periodic_scheduler/periodic_scheduler.h"
+#include "../sim_test.h"
+
+#define ROUNDS 6
+#define CYCLES_PER_ROUND 4
+#define POISON 0xA5
+#define POISON_CHECK_MS 3000
+#define MAX_TASKS 32
+
+// A task blocked on its event group or a queue is woken by stop() itself,
+// so the join completes without the tick moving
+#define STOP_LATENCY_TICKS 0
+
+typedef struct {
+    const char* name;
+    const char* task;     // Its task's name; NULL when it runs as a scheduler job
+    void* storage;
+    size_t storage_size;
+    void* (*create)(void* storage);
+    bool (*start)(void* module);
+    void (*stop)(void* module);
+    void (*destroy)(void* module);
+} module_ops_t;
+
+static led_controller_storage_t led_storage;
+static sensor_reader_storage_t reader_storage;
+static telemetry_log_storage_t log_storage;
+static mqtt_uplink_storage_t uplink_storage;
+static periodic_scheduler_storage_t scheduler_storage;
+static periodic_scheduler_t* scheduler;
+static volatile uint32_t stubborn_ticks;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static bool discard_sink(const uint8_t* data, size_t length, void* context) {
+    (void)data;
+    (void)length;
+    (void)context;
+    return true;
+}
+
+static void* led_create(void* storage) {
+    return led_controller_create_static((led_controller_storage_t*)storage, 2);
+}
+
+static void* reader_create(void* storage) {
+    return sensor_reader_create_static((sensor_reader_storage_t*)storage, pdMS_TO_TICKS(100));
+}
+
+static void* scheduled_reader_create(void* storage) {
+    sensor_reader_t* reader = sensor_reader_create_static((sensor_reader_storage_t*)storage, pdMS_TO_TICKS(100));
+    if (reader && !sensor_reader_attach_scheduler(reader, scheduler)) {
+        sensor_reader_destroy(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+static void* log_create(void* storage) {
+    return telemetry_log_create_static((telemetry_log_storage_t*)storage, discard_sink, NULL);
+}
+
+// No broker and no network: the task blocks on its queue throughout
+static void* uplink_create(void* storage) {
+    const mqtt_uplink_config_t config = MQTT_UPLINK_DEFAULT_CONFIG;
+    return mqtt_uplink_create_static((mqtt_uplink_storage_t*)storage, &config);
+}
+
+static void* scheduler_create(void* storage) {
+    return periodic_scheduler_create_static((periodic_scheduler_storage_t*)storage);
+}
+
+static const module_ops_t modules[] = {
+    { "led_controller", "led_controller", &led_storage, sizeof(led_storage), led_create,
+      (bool (*)(void*))led_controller_start, (void (*)(void*))led_controller_stop,
+      (void (*)(void*))led_controller_destroy },
+    { "sensor_reader", "sensor_reader", &reader_storage, sizeof(reader_storage), reader_create,
+      (bool (*)(void*))sensor_reader_start, (void (*)(void*))sensor_reader_stop,
+      (void (*)(void*))sensor_reader_destroy },
+    { "telemetry_log", "telemetry_log", &log_storage, sizeof(log_storage), log_create,
+      (bool (*)(void*))telemetry_log_start, (void (*)(void*))telemetry_log_stop,
+      (void (*)(void*))telemetry_log_destroy },
+    { "mqtt_uplink", "mqtt_uplink", &uplink_storage, sizeof(uplink_storage), uplink_create,
+      (bool (*)(void*))mqtt_uplink_start, (void (*)(void*))mqtt_uplink_stop,
+      (void (*)(void*))mqtt_uplink_destroy },
+    { "scheduler", "scheduler", &scheduler_storage, sizeof(scheduler_storage), scheduler_create,
+      (bool (*)(void*))periodic_scheduler_start, (void (*)(void*))periodic_scheduler_stop,
+      (void (*)(void*))periodic_scheduler_destroy },
+};
+
+#define MODULE_COUNT (sizeof(modules) / sizeof(modules[0]))
+
+// Tasks called name, or with NULL all tasks but the esp_timer service
+// task, which the shim starts on first use rather than at boot
+static UBaseType_t count_tasks(const char* name) {
+    static TaskStatus_t status[MAX_TASKS];
+    UBaseType_t total = uxTaskGetSystemState(status, MAX_TASKS, NULL);
+    UBaseType_t count = 0;
+
+    for (UBaseType_t i = 0; i < total; i++) {
+        if (name ? strcmp(status[i].pcTaskName, name) == 0 : strcmp(status[i].pcTaskName, "esp_timer") != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool storage_poisoned(const void* storage, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)storage;
+
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i] != POISON) return false;
+    }
+    return true;
+}
+
+// Starts and stops module repeatedly, stopping at a different point of
+// its cycle each time, then destroys it and watches the freed storage.
+// Returns the slowest stop in ticks.
+static TickType_t cycle_module(const module_ops_t* module) {
+    UBaseType_t baseline = count_tasks(NULL);
+    TickType_t slowest = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        memset(module->storage, 0, module->storage_size);
+        void* instance = module->create(module->storage);
+        TEST_ASSERT_NOT_NULL_MESSAGE(instance, module->name);
+
+        for (int cycle = 0; cycle < CYCLES_PER_ROUND; cycle++) {
+            TEST_ASSERT_TRUE_MESSAGE(module->start(instance), module->name);
+            if (module->task) TEST_ASSERT_EQUAL_MESSAGE(1, count_tasks(module->task), module->name);
+            vTaskDelay(pdMS_TO_TICKS(1 + 37 * round + 113 * cycle));
+
+            TickType_t before = xTaskGetTickCount();
+            module->stop(instance);
+            TickType_t latency = xTaskGetTickCount() - before;
+            if (latency > slowest) slowest = latency;
+            if (module->task) TEST_ASSERT_EQUAL_MESSAGE(0, count_tasks(module->task), module->name);
+        }
+
+        module->destroy(instance);
+        memset(module->storage, POISON, module->storage_size);
+        vTaskDelay(pdMS_TO_TICKS(POISON_CHECK_MS));
+        TEST_ASSERT_TRUE_MESSAGE(storage_poisoned(module->storage, module->storage_size), module->name);
+        TEST_ASSERT_EQUAL_MESSAGE(baseline, count_tasks(NULL), module->name);
+    }
+    return slowest;
+}
+
+static void blocked_task(void* arg) {
+    EventGroupHandle_t events = (EventGroupHandle_t)arg;
+
+    while (!task_lifecycle_wait(events, portMAX_DELAY)) {
+    }
+    task_lifecycle_exit(events);
+}
+
+// Never looks at the event group
+static void stubborn_task(void* arg) {
+    (void)arg;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        stubborn_ticks++;
+    }
+}
+
+// The join itself: immediate for a task waiting on the stop bit, bounded
+// by the timeout (and the task deleted anyway) for one that never checks
+void test_join_latency(void) {
+    EventGroupHandle_t events = xEventGroupCreate();
+    UBaseType_t baseline = count_tasks(NULL);
+    TaskHandle_t task = NULL;
+
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(blocked_task, "blocked", 4096, events, 2, &task));
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TickType_t before = xTaskGetTickCount();
+    TEST_ASSERT_TRUE(task_lifecycle_stop(events, &task, TASK_LIFECYCLE_JOIN_TIMEOUT));
+    TEST_ASSERT_EQUAL_UINT32(0, xTaskGetTickCount() - before);
+    TEST_ASSERT_NULL(task);
+    TEST_ASSERT_EQUAL(baseline, count_tasks(NULL));
+    TEST_ASSERT_EQUAL_HEX32(0, xEventGroupGetBits(events) & (TASK_EVENT_STOP | TASK_EVENT_EXITED));
+
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(stubborn_task, "stubborn", 4096, NULL, 2, &task));
+    vTaskDelay(pdMS_TO_TICKS(10));
+    before = xTaskGetTickCount();
+    TEST_ASSERT_FALSE(task_lifecycle_stop(events, &task, TASK_LIFECYCLE_JOIN_TIMEOUT));
+    TEST_ASSERT_EQUAL_UINT32(TASK_LIFECYCLE_JOIN_TIMEOUT, xTaskGetTickCount() - before);
+    TEST_ASSERT_NULL(task);
+    TEST_ASSERT_EQUAL(baseline, count_tasks(NULL));
+    TEST_ASSERT_EQUAL_HEX32(0, xEventGroupGetBits(events) & (TASK_EVENT_STOP | TASK_EVENT_EXITED));
+    uint32_t ticks_at_stop = stubborn_ticks;
+    vTaskDelay(pdMS_TO_TICKS(POISON_CHECK_MS));
+    TEST_ASSERT_EQUAL_UINT32(ticks_at_stop, stubborn_ticks);
+
+    vEventGroupDelete(events);
+}
+
+void test_module_stop_latency_and_reuse(void) {
+    printf("%-16s %8s %12s\n", "module", "cycles", "stop (ticks)");
+    for (size_t i = 0; i < MODULE_COUNT; i++) {
+        TickType_t slowest = cycle_module(&modules[i]);
+        printf("%-16s %8d %12lu\n", modules[i].name, ROUNDS * CYCLES_PER_ROUND, (unsigned long)slowest);
+        TEST_ASSERT_TRUE_MESSAGE(slowest <= STOP_LATENCY_TICKS, modules[i].name);
+    }
+}
+
+// The reader as a scheduler job: stop() removes the job, waiting for a
+// sample in progress, while the scheduler task keeps running
+void test_scheduled_reader_stop(void) {
+    static periodic_scheduler_storage_t storage;
+    const module_ops_t job = {
+        "sensor_reader", NULL, &reader_storage, sizeof(reader_storage), scheduled_reader_create,
+        (bool (*)(void*))sensor_reader_start, (void (*)(void*))sensor_reader_stop,
+        (void (*)(void*))sensor_reader_destroy
+    };
+
+    scheduler = periodic_scheduler_create_static(&storage);
+    TEST_ASSERT_NOT_NULL(scheduler);
+    TEST_ASSERT_TRUE(periodic_scheduler_start(scheduler));
+
+    TickType_t slowest = cycle_module(&job);
+    printf("%-16s %8d %12lu\n", "reader (job)", ROUNDS * CYCLES_PER_ROUND, (unsigned long)slowest);
+    TEST_ASSERT_TRUE(slowest <= STOP_LATENCY_TICKS);
+
+    periodic_scheduler_stats_t stats;
+    TEST_ASSERT_TRUE(periodic_scheduler_get_stats(scheduler, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.jobs);
+    periodic_scheduler_destroy(scheduler);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_join_latency);
+    RUN_TEST(test_module_stop_latency_and_reuse);
+    RUN_TEST(test_scheduled_reader_stop);
+}
+
+int main(void) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Binary telemetry records against the formatted log line they replace:
+// record contents, then host time (and TSC cycles on x86) and stack depth
+// per sample for each path. Stack depth is measured by running one call on
+// a host thread with a painted stack and finding the deepest byte it
+// overwrote; it is host stack, not Xtensa, so only the ratio carries over.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "modules/telemetry_log/telemetry_log.h"
+#include "../sim_test.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#endif
+
+#define BENCH_SAMPLES 200000
+#define STACK_PAINT_BYTES (256 * 1024)
+#define STACK_PAINT 0xA5
+
+typedef struct {
+    double ns;
+    double cycles;
+    size_t stack_bytes;
+} bench_result_t;
+
+static telemetry_log_t* log_under_test;
+static sensor_data_t sample;
+static char line[160];
+
+void setUp(void) {
+    sample.raw_value = 2048;
+    sensor_set_voltage_mv(&sample, 1650);
+    sensor_set_temperature_cdeg(&sample, 2312);
+    sensor_set_humidity_cpct(&sample, 4875);
+    sample.timestamp = 1000;
+}
+
+void tearDown(void) {
+}
+
+// What ESP_LOGI did per sample before the binary record: the level/time/tag
+// prefix and four float conversions. Formatted into a buffer so the UART
+// cost is left out.
+static __attribute__((noinline)) void format_sample(void) {
+    snprintf(line, sizeof(line), "I (%lu) SensorReader: Sensor Data - Raw: %lu, Temp: %.1fC, Hum: %.1f%%, Volt: %.2fV\n",
+             (unsigned long)sample.timestamp, (unsigned long)sample.raw_value, sensor_temperature_c(&sample),
+             sensor_humidity_pct(&sample), sensor_voltage_v(&sample));
+}
+
+static __attribute__((noinline)) void write_record(void) {
+    telemetry_log_write_sample(log_under_test, &sample);
+    // Stand in for the drain task so the ring never fills
+    __atomic_store_n(&log_under_test->tail, log_under_test->head, __ATOMIC_RELEASE);
+}
+
+static void* stack_thread(void* arg) {
+    ((void (*)(void))arg)();
+    return NULL;
+}
+
+// Bytes of a painted thread stack that one call of fn overwrote, thread
+// start-up included; subtract the depth of an empty function. The test
+// task waits in pthread_join meanwhile and no other task is runnable, so
+// the event group call in telemetry_log_write_sample() is safe from there.
+static size_t stack_depth(void (*fn)(void)) {
+    static uint8_t stack[STACK_PAINT_BYTES] __attribute__((aligned(64)));
+    pthread_attr_t attr;
+    pthread_t thread;
+    
+    memset(stack, STACK_PAINT, sizeof(stack));
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, sizeof(stack));
+    pthread_create(&thread, &attr, stack_thread, (void*)fn);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+    
+    size_t untouched = 0;
+    while (untouched < sizeof(stack) && stack[untouched] == STACK_PAINT) {
+        untouched++;
+    }
+    return sizeof(stack) - untouched;
+}
+
+static void noop(void) {
+}
+
+static bench_result_t bench(void (*fn)(void)) {
+    bench_result_t result;
+    struct timespec start, end;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+#ifdef BENCH_HAS_TSC
+    uint64_t tsc = __rdtsc();
+#endif
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        sample.raw_value = (uint32_t)i & 0xFFF;
+        sample.timestamp++;
+        fn();
+    }
+#ifdef BENCH_HAS_TSC
+    result.cycles = (double)(__rdtsc() - tsc) / BENCH_SAMPLES;
+#else
+    result.cycles = 0;
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    result.ns = ((double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec)) / BENCH_SAMPLES;
+    result.stack_bytes = stack_depth(fn) - stack_depth(noop);
+    return result;
+}
+
+static void test_sample_record_round_trip(void) {
+    telemetry_encoder_t encoder;
+    telemetry_record_t records[2];
+    telemetry_encoder_init(&encoder);
+    
+    TEST_ASSERT_TRUE(telemetry_encoder_needs_timebase(&encoder, 1000));
+    telemetry_encode_timebase(&encoder, 1000, &records[0]);
+    telemetry_encode_sample(&encoder, &sample, 1250, &records[1]);
+    TEST_ASSERT_FALSE(telemetry_encoder_needs_timebase(&encoder, 1300));
+    
+    TEST_ASSERT_EQUAL_size_t(16, sizeof(telemetry_record_t));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_RECORD_TIMEBASE, records[0].type);
+    TEST_ASSERT_EQUAL_UINT32(1000, records[0].timebase.time_ms);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_RECORD_SAMPLE, records[1].type);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)(records[0].seq + 1), records[1].seq);
+    TEST_ASSERT_EQUAL_UINT16(250, records[1].dt_ms);
+    TEST_ASSERT_EQUAL_UINT16(2048, records[1].sample.raw);
+    TEST_ASSERT_EQUAL_INT16(2312, records[1].sample.temperature_cdeg);
+    TEST_ASSERT_EQUAL_UINT16(4875, records[1].sample.humidity_cpct);
+    TEST_ASSERT_EQUAL_UINT16(1650, records[1].sample.voltage_mv);
+    
+    for (int i = 0; i < 2; i++) {
+        const uint8_t* bytes = (const uint8_t*)&records[i];
+        TEST_ASSERT_EQUAL_UINT16(telemetry_crc16(bytes + 2, sizeof(telemetry_record_t) - 4), records[i].crc);
+    }
+}
+
+static void test_record_vs_formatted_cost(void) {
+    log_under_test = telemetry_log_create(NULL, NULL);
+    TEST_ASSERT_NOT_NULL(log_under_test);
+    
+    bench_result_t text = bench(format_sample);
+    bench_result_t binary = bench(write_record);
+    
+    printf("per sample     %10s %10s %12s\n", "ns", "cycles", "stack bytes");
+    printf("formatted log  %10.1f %10.0f %12zu\n", text.ns, text.cycles, text.stack_bytes);
+    printf("binary record  %10.1f %10.0f %12zu\n", binary.ns, binary.cycles, binary.stack_bytes);
+    
+    telemetry_log_stats_t stats;
+    TEST_ASSERT_TRUE(telemetry_log_get_stats(log_under_test, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    TEST_ASSERT_TRUE(binary.ns < text.ns);
+    TEST_ASSERT_TRUE(binary.stack_bytes < text.stack_bytes);
+    
+    telemetry_log_destroy(log_under_test);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_sample_record_round_trip);
+    RUN_TEST(test_record_vs_formatted_cost);
+}
+
+int main(int argc, char** argv) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
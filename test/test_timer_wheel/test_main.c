@@ -0,0 +1,210 @@
+// Timer wheel against a plain list of deadlines: random inserts, re-arms
+// and removes while time moves on in steps from one tick to past the
+// wheel's range. Every entry must come back at the first expire() whose
+// time reaches it and not before, and next() must name the earliest
+// deadline. A cascade of one crowded slot must move at most
+// TIMER_WHEEL_CASCADE_BATCH entries per expire() call.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "modules/periodic_scheduler/timer_wheel.h"
+
+#define ENTRIES 512
+#define STEPS 4000
+#define CROWD 1000
+
+static timer_wheel_t wheel;
+static timer_wheel_entry_t entries[CROWD];
+static bool pending[CROWD];
+static uint32_t lcg_state;
+
+void setUp(void) {
+    lcg_state = 12345;
+    memset(entries, 0, sizeof(entries));
+    memset(pending, 0, sizeof(pending));
+}
+
+void tearDown(void) {
+}
+
+static uint32_t random_below(uint32_t limit) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (uint32_t)(((uint64_t)(lcg_state >> 1) * limit) >> 31);
+}
+
+// Mostly short timeouts, some spanning the upper levels, and with far set
+// a few beyond the wheel's range
+static TickType_t random_delay(bool far) {
+    switch (random_below(8)) {
+    case 0: return random_below(4);
+    case 1: return random_below(1u << 18);
+    case 2: return random_below(1u << 23);
+    case 3: return far ? TIMER_WHEEL_RANGE + random_below(TIMER_WHEEL_RANGE) : random_below(1u << 12);
+    default: return random_below(1u << 10);
+    }
+}
+
+// Lengths of the time steps; now and then a jump over a whole level
+static TickType_t random_step(void) {
+    switch (random_below(16)) {
+    case 0: return random_below(1u << 20);
+    case 1: return 0;
+    default: return 1 + random_below(300);
+    }
+}
+
+// Expires everything due by now, checking each entry against the list
+static uint32_t expire_until(TickType_t previous, TickType_t now) {
+    uint32_t expired = 0;
+
+    for (;;) {
+        timer_wheel_entry_t* entry = timer_wheel_expire(&wheel, now);
+        if (!entry) {
+            if (timer_wheel_cascading(&wheel)) continue;
+            break;
+        }
+        size_t index = (size_t)(entry - entries);
+        TEST_ASSERT_TRUE(pending[index]);
+        TEST_ASSERT_FALSE(timer_wheel_pending(entry));
+        TEST_ASSERT_TRUE((int32_t)(entry->expires - now) <= 0);
+        // Not due last time, unless it was inserted overdue
+        TEST_ASSERT_TRUE((int32_t)(entry->expires - previous) > 0 || entry->expires == previous);
+        pending[index] = false;
+        expired++;
+    }
+    return expired;
+}
+
+// The list's view once expire() is done: nothing left due, the count, and
+// the earliest deadline, which next() gives exactly unless a timeout beyond
+// the range is parked
+static void check_wheel(TickType_t now, bool exact) {
+    uint32_t count = 0;
+    int32_t earliest = INT32_MAX;
+
+    for (size_t i = 0; i < ENTRIES; i++) {
+        TEST_ASSERT_EQUAL(pending[i], timer_wheel_pending(&entries[i]));
+        if (!pending[i]) continue;
+
+        int32_t distance = (int32_t)(entries[i].expires - now);
+        TEST_ASSERT_TRUE(distance > 0);
+        if (distance < earliest) earliest = distance;
+        count++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(count, wheel.count);
+
+    TickType_t next;
+    TEST_ASSERT_EQUAL(count > 0, timer_wheel_next(&wheel, &next));
+    if (count == 0) return;
+    TEST_ASSERT_TRUE((int32_t)(next - now) > 0);
+    if (exact) {
+        TEST_ASSERT_EQUAL_UINT32(now + (TickType_t)earliest, next);
+    } else {
+        TEST_ASSERT_TRUE((int32_t)(next - now) <= earliest);
+    }
+}
+
+static void run_against_list(bool far) {
+    // Close to the tick counter wrapping, which it crosses on the way
+    TickType_t now = (TickType_t)0 - (1u << 22);
+    TickType_t previous = now;
+    uint32_t expired = 0;
+
+    timer_wheel_init(&wheel, now);
+    for (int step = 0; step < STEPS; step++) {
+        // Arm, re-arm or cancel a few entries
+        for (int op = 0; op < 8; op++) {
+            size_t i = random_below(ENTRIES);
+            if (pending[i] && random_below(4) == 0) {
+                timer_wheel_remove(&wheel, &entries[i]);
+                pending[i] = false;
+            } else {
+                timer_wheel_insert(&wheel, &entries[i], now + random_delay(far));
+                pending[i] = true;
+            }
+        }
+
+        previous = now;
+        now += random_step();
+        expired += expire_until(previous, now);
+        check_wheel(now, !far);
+    }
+    printf("%s: %lu expired, %lu pending\n", far ? "with parked timeouts" : "within range",
+           (unsigned long)expired, (unsigned long)wheel.count);
+    TEST_ASSERT_TRUE(expired > STEPS);
+}
+
+void test_expiry_matches_list(void) {
+    run_against_list(false);
+}
+
+void test_expiry_matches_list_with_parked_timeouts(void) {
+    run_against_list(true);
+}
+
+// CROWD entries in one level-2 slot, all falling to lower levels at once
+// when its span begins: each expire() call moves a batch of them and
+// returns, and none is lost or expires early
+void test_cascade_is_bounded(void) {
+    const TickType_t span_start = 3u << (2 * TIMER_WHEEL_SLOT_BITS);
+    const TickType_t now = span_start + 1000;
+    static uint16_t buckets[CROWD];
+    uint32_t calls = 0;
+    uint32_t busy_calls = 0;
+    uint32_t most_moved = 0;
+    uint32_t expired = 0;
+
+    timer_wheel_init(&wheel, 0);
+    for (uint32_t i = 0; i < CROWD; i++) {
+        timer_wheel_insert(&wheel, &entries[i], span_start + (i * 7) % (1u << (2 * TIMER_WHEEL_SLOT_BITS)));
+        pending[i] = true;
+        TEST_ASSERT_EQUAL_UINT16(2 * TIMER_WHEEL_SLOTS + 3, entries[i].bucket);
+    }
+
+    for (;;) {
+        for (uint32_t i = 0; i < CROWD; i++) {
+            buckets[i] = entries[i].bucket;
+        }
+        timer_wheel_entry_t* entry = timer_wheel_expire(&wheel, now);
+        calls++;
+
+        uint32_t moved = 0;
+        for (uint32_t i = 0; i < CROWD; i++) {
+            if (timer_wheel_pending(&entries[i]) && entries[i].bucket != buckets[i]) moved++;
+        }
+        if (moved > most_moved) most_moved = moved;
+
+        if (entry) {
+            size_t index = (size_t)(entry - entries);
+            TEST_ASSERT_TRUE((int32_t)(entry->expires - now) <= 0);
+            pending[index] = false;
+            expired++;
+        } else if (timer_wheel_cascading(&wheel)) {
+            busy_calls++;
+        } else {
+            break;
+        }
+    }
+
+    uint32_t due = 0;
+    for (uint32_t i = 0; i < CROWD; i++) {
+        if ((int32_t)(entries[i].expires - now) <= 0) due++;
+        TEST_ASSERT_EQUAL(pending[i], timer_wheel_pending(&entries[i]));
+    }
+    printf("%u entries cascaded: %lu calls, %lu returned for the next batch, at most %lu moved per call\n",
+           (unsigned)CROWD, (unsigned long)calls, (unsigned long)busy_calls, (unsigned long)most_moved);
+
+    TEST_ASSERT_EQUAL_UINT32(due, expired);
+    TEST_ASSERT_EQUAL_UINT32(CROWD - due, wheel.count);
+    TEST_ASSERT_TRUE(most_moved <= TIMER_WHEEL_CASCADE_BATCH);
+    TEST_ASSERT_TRUE(busy_calls >= CROWD / TIMER_WHEEL_CASCADE_BATCH - 1);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_expiry_matches_list);
+    RUN_TEST(test_expiry_matches_list_with_parked_timeouts);
+    RUN_TEST(test_cascade_is_bounded);
+    return UNITY_END();
+}
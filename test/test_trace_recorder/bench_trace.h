@@ -0,0 +1,24 @@
+#ifndef BENCH_TRACE_H
+#define BENCH_TRACE_H
+
+#include <stdint.h>
+#include "modules/sensor_reader/sensor_fusion.h"
+
+// Instrumented code built once with trace_recorder recording and once
+// without (bench_traced.c, bench_untraced.c)
+
+#define BENCH_STEPS 4096
+
+typedef struct {
+    double ns_per_event; // A bare TRACE_INSTANT
+    double ns_per_step;  // One fusion step inside a span: two events
+    uint32_t recorded;   // trace_recorder_get_stats() before the dump
+    uint32_t lost;
+    uint32_t written;    // Events in the dump
+    uint32_t dump_lost;  // As the dump counted them
+} bench_trace_result_t;
+
+void bench_trace_traced(const sensor_data_t* samples, uint32_t passes, bench_trace_result_t* result);
+void bench_trace_untraced(const sensor_data_t* samples, uint32_t passes, bench_trace_result_t* result);
+
+#endif
@@ -0,0 +1,20 @@
+// Recording on, whatever the build's flags. The shim's esp_timer_get_time()
+// only reads the virtual tick, so events are stamped from the host's
+// monotonic clock instead, as the device reads its hardware timer.
+#ifndef TRACE_RECORDER_ENABLED
+#define TRACE_RECORDER_ENABLED
+#endif
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t bench_trace_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u);
+}
+
+#define TRACE_RECORDER_CLOCK() bench_trace_clock()
+#define TRACE_RECORDER_CLOCK_HZ 1000000
+#define BENCH_KERNEL bench_trace_traced
+#define BENCH_PREFIX(name) traced_##name
+#include "bench_trace.inc"
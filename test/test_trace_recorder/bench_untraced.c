@@ -0,0 +1,5 @@
+// Recording off, whatever the build's flags: the macros compile to nothing
+#undef TRACE_RECORDER_ENABLED
+#define BENCH_KERNEL bench_trace_untraced
+#define BENCH_PREFIX(name) untraced_##name
+#include "bench_trace.inc"
@@ -0,0 +1,79 @@
+// Cost of trace_recorder per event: a bare TRACE_INSTANT, and a span around
+// one fusion step (the reader's processing span), built with recording on
+// and off in one binary. The difference between the two builds is what
+// instrumenting a path costs; the host's clock read stands in for the
+// device's timer, so the absolute figures are only indicative. Also checks
+// that the ring kept the newest TRACE_RECORDER_RING_EVENTS and counted the
+// rest as lost.
+
+#include <unity.h>
+#include <stdio.h>
+#include "bench_trace.h"
+#include "modules/trace_recorder/trace_recorder.h"
+
+#define BENCH_PASSES 200
+// Per event, far above the host's cost; a slower path means the writer
+// picked up a lock or a syscall
+#define EVENT_BUDGET_NS 1000.0
+
+static sensor_data_t samples[BENCH_STEPS];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void make_samples(void) {
+    uint32_t lcg = 1;
+
+    for (uint32_t i = 0; i < BENCH_STEPS; i++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        sensor_set_temperature_cdeg(&samples[i], 2200 + (int32_t)(lcg >> 26));
+        sensor_set_humidity_cpct(&samples[i], 4500 + (int32_t)(lcg >> 24) % 200);
+        sensor_set_voltage_mv(&samples[i], 3300 + (int32_t)(lcg >> 27));
+        samples[i].raw_value = 2048 + (lcg >> 25);
+        samples[i].timestamp = i * 100;
+    }
+}
+
+static void print_result(const char* name, const bench_trace_result_t* result) {
+    printf("%-9s %11.1f %11.1f %10lu %10lu %10lu\n", name, result->ns_per_event, result->ns_per_step,
+           (unsigned long)result->recorded, (unsigned long)result->lost, (unsigned long)result->written);
+}
+
+void test_cost_per_event(void) {
+    bench_trace_result_t traced;
+    bench_trace_result_t untraced;
+
+    make_samples();
+    bench_trace_untraced(samples, BENCH_PASSES, &untraced);
+    bench_trace_traced(samples, BENCH_PASSES, &traced);
+
+    printf("%-9s %11s %11s %10s %10s %10s\n", "build", "ns/event", "ns/step", "recorded", "lost", "dumped");
+    print_result("untraced", &untraced);
+    print_result("traced", &traced);
+    double span_ns = (traced.ns_per_step - untraced.ns_per_step) / 2;
+    printf("span overhead %.1f ns/event on a %.1f ns step\n", span_ns, untraced.ns_per_step);
+
+    // Without the flag nothing is recorded or dumped
+    TEST_ASSERT_EQUAL_UINT32(0, untraced.recorded);
+    TEST_ASSERT_EQUAL_UINT32(0, untraced.written);
+
+    // One instant per step, then a begin and an end; all from one core,
+    // whose ring keeps only the newest
+    const uint32_t events = 3 * BENCH_PASSES * BENCH_STEPS;
+    TEST_ASSERT_EQUAL_UINT32(events, traced.recorded);
+    TEST_ASSERT_EQUAL_UINT32(events - TRACE_RECORDER_RING_EVENTS, traced.lost);
+    TEST_ASSERT_EQUAL_UINT32(TRACE_RECORDER_RING_EVENTS, traced.written);
+    TEST_ASSERT_EQUAL_UINT32(traced.lost, traced.dump_lost);
+
+    TEST_ASSERT_TRUE(traced.ns_per_event < EVENT_BUDGET_NS);
+    TEST_ASSERT_TRUE(span_ns < EVENT_BUDGET_NS);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cost_per_event);
+    return UNITY_END();
+}
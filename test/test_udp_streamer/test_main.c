@@ -0,0 +1,193 @@
+// UDP streamer over loopback, with the test task as the subscribing host:
+// the streamer's port is held by another socket when WiFi comes up, so
+// the first open fails and has to be retried; once it binds, a subscriber
+// gets self-contained datagrams (timebase, then samples) in sequence, and
+// stops getting them after unsubscribing.
+
+#include <unity.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "modules/udp_streamer/udp_streamer.h"
+#include "modules/wifi_manager/wifi_state.h"
+#include "../sim_test.h"
+
+#define BATCH_SIZE 4
+#define POLL_MS 100
+#define SAMPLE_PERIOD_MS 10
+
+static uint16_t stream_port;
+static int client = -1;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void publish_wifi_state(wifi_state_t state) {
+    message_t message;
+    message.topic = MESSAGE_TOPIC_WIFI_STATE;
+    message.wifi_state = (uint8_t)state;
+    message_bus_publish(&message);
+}
+
+static void publish_sample(TickType_t timestamp, uint32_t raw) {
+    message_t message;
+    memset(&message, 0, sizeof(message));
+    message.topic = MESSAGE_TOPIC_SENSOR_SAMPLE;
+    message.sample.raw_value = raw;
+    message.sample.timestamp = timestamp;
+    message_bus_publish(&message);
+}
+
+// A free local UDP port, and a socket holding it without SO_REUSEADDR so
+// the streamer cannot bind it until the socket is closed
+static int hold_free_port(uint16_t* port) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int holder = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    TEST_ASSERT_EQUAL(0, bind(holder, (struct sockaddr*)&address, sizeof(address)));
+    getsockname(holder, (struct sockaddr*)&address, &length);
+    *port = ntohs(address.sin_port);
+    return holder;
+}
+
+static void send_request(uint8_t type) {
+    udp_stream_header_t request;
+    struct sockaddr_in to;
+
+    memset(&request, 0, sizeof(request));
+    request.magic[0] = UDP_STREAM_MAGIC_0;
+    request.magic[1] = UDP_STREAM_MAGIC_1;
+    request.version = UDP_STREAM_VERSION;
+    request.type = type;
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    to.sin_port = htons(stream_port);
+    TEST_ASSERT_EQUAL((ssize_t)sizeof(request),
+                      sendto(client, &request, sizeof(request), 0, (struct sockaddr*)&to, sizeof(to)));
+}
+
+// Checks one received datagram and appends its samples; returns the
+// sample count, or -1 if it does not decode on its own
+static int read_datagram(uint32_t* seq, uint32_t* times_ms, uint32_t* raws) {
+    static uint8_t datagram[UDP_STREAMER_MAX_DATAGRAM];
+    ssize_t length = recv(client, datagram, sizeof(datagram), MSG_DONTWAIT);
+    if (length < 0) return 0;
+
+    const udp_stream_header_t* header = (const udp_stream_header_t*)datagram;
+    const telemetry_record_t* records = (const telemetry_record_t*)(datagram + sizeof(*header));
+    if (header->magic[0] != UDP_STREAM_MAGIC_0 || header->magic[1] != UDP_STREAM_MAGIC_1 ||
+        header->type != UDP_STREAM_DATA ||
+        (size_t)length != sizeof(*header) + (header->count + 1u) * sizeof(telemetry_record_t) ||
+        records[0].type != TELEMETRY_RECORD_TIMEBASE) {
+        return -1;
+    }
+
+    *seq = header->seq;
+    uint32_t time_ms = records[0].timebase.time_ms;
+    for (uint16_t i = 0; i < header->count; i++) {
+        const telemetry_record_t* record = &records[1 + i];
+        uint16_t crc = telemetry_crc16(&record->type, offsetof(telemetry_record_t, crc) - offsetof(telemetry_record_t, type));
+        if (record->type == TELEMETRY_RECORD_TIMEBASE || record->crc != crc) return -1;
+        time_ms += record->dt_ms;
+        times_ms[i] = time_ms;
+        raws[i] = record->sample.raw;
+    }
+    return header->count;
+}
+
+static void stream_samples(uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; i++) {
+        publish_sample(pdMS_TO_TICKS(1000 + SAMPLE_PERIOD_MS * i), i);
+        vTaskDelay(pdMS_TO_TICKS(SAMPLE_PERIOD_MS));
+    }
+    vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+}
+
+void test_open_retried_then_streams_over_loopback(void) {
+    udp_streamer_config_t config = UDP_STREAMER_DEFAULT_CONFIG;
+    int holder = hold_free_port(&stream_port);
+    config.port = stream_port;
+    config.batch_size = BATCH_SIZE;
+    config.poll_ms = POLL_MS;
+
+    client = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT_TRUE(client >= 0);
+
+    udp_streamer_t* streamer = udp_streamer_create(&config);
+    TEST_ASSERT_NOT_NULL(streamer);
+    TEST_ASSERT_TRUE(udp_streamer_start(streamer));
+    vTaskDelay(1); // Let the task subscribe
+
+    // WiFi up, port taken: the open fails, nothing can subscribe
+    publish_wifi_state(WIFI_STATE_CONNECTED);
+    vTaskDelay(pdMS_TO_TICKS(3 * POLL_MS));
+    udp_streamer_stats_t stats;
+    udp_streamer_get_stats(streamer, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.subscribers);
+
+    // Port released: bound at the next poll, without another WiFi event
+    close(holder);
+    vTaskDelay(pdMS_TO_TICKS(2 * POLL_MS));
+    send_request(UDP_STREAM_SUBSCRIBE);
+    vTaskDelay(pdMS_TO_TICKS(2 * POLL_MS));
+    udp_streamer_get_stats(streamer, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.subscribers);
+
+    const uint32_t streamed = 5 * BATCH_SIZE;
+    stream_samples(0, streamed);
+
+    uint32_t seq = 0;
+    uint32_t times_ms[UDP_STREAMER_MAX_BATCH];
+    uint32_t raws[UDP_STREAMER_MAX_BATCH];
+    uint32_t sample = 0;
+    int datagrams = 0;
+    for (;;) {
+        int count = read_datagram(&seq, times_ms, raws);
+        if (count == 0) break;
+        TEST_ASSERT_EQUAL(BATCH_SIZE, count);
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)datagrams, seq);
+        for (int i = 0; i < count; i++, sample++) {
+            TEST_ASSERT_EQUAL_UINT32(1000 + SAMPLE_PERIOD_MS * sample, times_ms[i]);
+            TEST_ASSERT_EQUAL_UINT32(sample, raws[i]);
+        }
+        datagrams++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(streamed, sample);
+
+    // Unsubscribed: samples keep arriving from the bus, nothing is sent
+    send_request(UDP_STREAM_UNSUBSCRIBE);
+    vTaskDelay(pdMS_TO_TICKS(2 * POLL_MS));
+    stream_samples(streamed, 2 * BATCH_SIZE);
+    TEST_ASSERT_EQUAL(0, read_datagram(&seq, times_ms, raws));
+
+    udp_streamer_get_stats(streamer, &stats);
+    udp_streamer_stop(streamer);
+    udp_streamer_destroy(streamer);
+    close(client);
+
+    TEST_ASSERT_EQUAL_UINT32(streamed + 2 * BATCH_SIZE, stats.received);
+    TEST_ASSERT_EQUAL_UINT32(streamed, stats.streamed);
+    TEST_ASSERT_EQUAL_UINT32(streamed / BATCH_SIZE, stats.datagrams);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.send_errors);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.subscribers);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_open_retried_then_streams_over_loopback);
+}
+
+int main(void) {
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+    return 0;
+}
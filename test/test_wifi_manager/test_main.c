@@ -0,0 +1,84 @@
+// wifi_manager state machine against the shim's simulated AP, which is set
+// to take longer to associate than the connect deadline allows. Driver
+// events can also be injected with wifi_manager_post_event().
+
+#include <unity.h>
+#include <stdlib.h>
+#include "modules/wifi_manager/wifi_manager.h"
+#include "../sim_test.h"
+
+// Longer than WIFI_MANAGER_CONNECT_TIMEOUT_MS
+#define SLOW_ASSOCIATION_MS "15000"
+
+static wifi_manager_t* manager;
+
+void setUp(void) {
+    manager = wifi_manager_create("test-ap", "secret");
+    TEST_ASSERT_NOT_NULL(manager);
+    TEST_ASSERT_TRUE(wifi_manager_start(manager));
+}
+
+void tearDown(void) {
+    wifi_manager_destroy(manager);
+}
+
+static void test_attempt_times_out_and_retries_through_policy(void) {
+    TickType_t start = xTaskGetTickCount();
+    TEST_ASSERT_TRUE(wifi_manager_connect(manager));
+    
+    EventBits_t bits = xEventGroupWaitBits(manager->event_group, WIFI_EVENT_FAILED, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(2 * WIFI_MANAGER_CONNECT_TIMEOUT_MS));
+    TEST_ASSERT_BITS_HIGH(WIFI_EVENT_FAILED, bits);
+    TEST_ASSERT_EQUAL_UINT32(start + pdMS_TO_TICKS(WIFI_MANAGER_CONNECT_TIMEOUT_MS), xTaskGetTickCount());
+    TEST_ASSERT_EQUAL_INT(WIFI_STATE_FAILED, wifi_manager_get_state(manager));
+    
+    // The retry comes after the policy's backoff, not straight away
+    wifi_reconnect_stats_t stats;
+    TEST_ASSERT_TRUE(wifi_manager_get_reconnect_stats(manager, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.attempts);
+    TickType_t failed_at = xTaskGetTickCount();
+    while (wifi_manager_get_state(manager) == WIFI_STATE_FAILED) {
+        vTaskDelay(1);
+        TEST_ASSERT_TRUE(xTaskGetTickCount() - failed_at <= pdMS_TO_TICKS(manager->reconnect.config.max_delay_ms));
+    }
+    TEST_ASSERT_EQUAL_INT(WIFI_STATE_CONNECTING, wifi_manager_get_state(manager));
+    TEST_ASSERT_TRUE(wifi_manager_get_reconnect_stats(manager, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.attempts);
+    
+    // And that attempt is abandoned at its own deadline
+    TickType_t retried_at = xTaskGetTickCount();
+    xEventGroupWaitBits(manager->event_group, WIFI_EVENT_FAILED, pdFALSE, pdFALSE,
+                        pdMS_TO_TICKS(2 * WIFI_MANAGER_CONNECT_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT32(retried_at + pdMS_TO_TICKS(WIFI_MANAGER_CONNECT_TIMEOUT_MS), xTaskGetTickCount());
+}
+
+static void test_deadline_cleared_once_connected(void) {
+    TEST_ASSERT_TRUE(wifi_manager_connect(manager));
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    TEST_ASSERT_EQUAL_INT(WIFI_STATE_CONNECTING, wifi_manager_get_state(manager));
+    
+    // Injected driver event, as the WiFi event task would post it
+    TEST_ASSERT_TRUE(wifi_manager_post_event(manager, WIFI_MANAGER_EVENT_GOT_IP, 0));
+    EventBits_t bits = xEventGroupWaitBits(manager->event_group, WIFI_EVENT_CONNECTED, pdFALSE, pdFALSE, 0);
+    TEST_ASSERT_BITS_HIGH(WIFI_EVENT_CONNECTED, bits);
+    
+    uint32_t last_us;
+    TEST_ASSERT_TRUE(wifi_manager_get_event_latency(manager, &last_us, NULL));
+    TEST_ASSERT_EQUAL_UINT32(0, last_us); // Handled within the tick it was posted in
+    
+    vTaskDelay(pdMS_TO_TICKS(2 * WIFI_MANAGER_CONNECT_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_INT(WIFI_STATE_CONNECTED, wifi_manager_get_state(manager));
+    wifi_reconnect_stats_t stats;
+    TEST_ASSERT_TRUE(wifi_manager_get_reconnect_stats(manager, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.attempts);
+}
+
+static void run_tests(void) {
+    RUN_TEST(test_attempt_times_out_and_retries_through_policy);
+    RUN_TEST(test_deadline_cleared_once_connected);
+}
+
+int main(int argc, char** argv) {
+    setenv("SIM_WIFI_CONNECT_MS", SLOW_ASSOCIATION_MS, 1);
+    sim_test_run(run_tests, SIM_TEST_DEFAULT_DURATION_MS);
+}
@@ -0,0 +1,173 @@
+// Reconnect policy on a simulated millisecond clock: backoff bounds, seed
+// determinism, stats, and a fleet of devices dropped by the same AP at once
+// spreading their retries instead of retrying in lockstep.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "modules/wifi_manager/wifi_reconnect.h"
+
+#define FLEET_SIZE 200
+#define AP_BACK_MS 45000      // The AP returns this long after dropping everyone
+#define RETRY_WINDOW_MS 100   // Retries landing in one window hit the AP together
+#define FIXED_INTERVAL_MS 10000 // The old fixed retry interval, for comparison
+
+static const wifi_reconnect_config_t config = WIFI_RECONNECT_DEFAULT_CONFIG;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_delay_within_capped_backoff(void) {
+    wifi_reconnect_policy_t policy;
+    wifi_reconnect_init(&policy, &config, 1);
+    
+    uint32_t cap = config.base_delay_ms;
+    for (int failure = 0; failure < 12; failure++) {
+        uint32_t delay = wifi_reconnect_on_disconnect(&policy, 0);
+        TEST_ASSERT_TRUE(delay >= cap / 2);
+        TEST_ASSERT_TRUE(delay <= cap);
+        
+        wifi_reconnect_on_attempt(&policy, 0);
+        cap = cap * 2 > config.max_delay_ms ? config.max_delay_ms : cap * 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(config.max_delay_ms, cap);
+}
+
+static void test_same_seed_same_schedule(void) {
+    wifi_reconnect_policy_t a, b, c;
+    wifi_reconnect_init(&a, &config, 42);
+    wifi_reconnect_init(&b, &config, 42);
+    wifi_reconnect_init(&c, &config, 43);
+    
+    bool differs = false;
+    for (int i = 0; i < 10; i++) {
+        uint32_t delay = wifi_reconnect_on_disconnect(&a, 0);
+        TEST_ASSERT_EQUAL_UINT32(delay, wifi_reconnect_on_disconnect(&b, 0));
+        differs |= delay != wifi_reconnect_on_disconnect(&c, 0);
+        wifi_reconnect_on_attempt(&a, 0);
+        wifi_reconnect_on_attempt(&b, 0);
+        wifi_reconnect_on_attempt(&c, 0);
+    }
+    TEST_ASSERT_TRUE(differs);
+}
+
+static void test_stats_and_fast_path(void) {
+    wifi_reconnect_policy_t policy;
+    wifi_reconnect_init(&policy, &config, 7);
+    
+    // Outage from t=1000 to t=8500: three attempts, the first two on the cached AP
+    uint32_t now = 1000;
+    wifi_reconnect_on_disconnect(&policy, now);
+    TEST_ASSERT_TRUE(wifi_reconnect_on_attempt(&policy, now += 500));
+    TEST_ASSERT_TRUE(wifi_reconnect_on_attempt(&policy, now += 2000));
+    TEST_ASSERT_FALSE(wifi_reconnect_on_attempt(&policy, now += 4000));
+    wifi_reconnect_on_connected(&policy, now += 1000);
+    
+    TEST_ASSERT_EQUAL_UINT32(3, policy.stats.attempts);
+    TEST_ASSERT_EQUAL_UINT32(2, policy.stats.fast_attempts);
+    TEST_ASSERT_EQUAL_UINT32(1, policy.stats.successes);
+    TEST_ASSERT_EQUAL_UINT32(1, policy.stats.time_to_connect[3]); // 7.5 s: [5 s, 10 s)
+    
+    // Success resets the backoff and the fast path, not the stats
+    TEST_ASSERT_TRUE(wifi_reconnect_on_disconnect(&policy, now) <= config.base_delay_ms);
+    TEST_ASSERT_TRUE(wifi_reconnect_on_attempt(&policy, now + 200));
+    wifi_reconnect_on_connected(&policy, now + 700);
+    TEST_ASSERT_EQUAL_UINT32(4, policy.stats.attempts);
+    TEST_ASSERT_EQUAL_UINT32(1, policy.stats.time_to_connect[0]);
+    
+    // A deliberate disconnect forgets the outage without counting it
+    wifi_reconnect_on_attempt(&policy, now + 800);
+    wifi_reconnect_reset(&policy);
+    TEST_ASSERT_EQUAL_UINT32(0, policy.failures);
+    TEST_ASSERT_FALSE(policy.in_outage);
+    TEST_ASSERT_EQUAL_UINT32(5, policy.stats.attempts);
+}
+
+// Largest number of retries falling into any one window
+static uint32_t busiest_window(const uint32_t* retry_counts, size_t windows) {
+    uint32_t busiest = 0;
+    for (size_t i = 0; i < windows; i++) {
+        if (retry_counts[i] > busiest) {
+            busiest = retry_counts[i];
+        }
+    }
+    return busiest;
+}
+
+static void test_fleet_spreads_retries(void) {
+    static wifi_reconnect_policy_t fleet[FLEET_SIZE];
+    static uint32_t jittered[AP_BACK_MS / RETRY_WINDOW_MS];
+    static uint32_t fixed[AP_BACK_MS / RETRY_WINDOW_MS];
+    uint32_t next_attempt[FLEET_SIZE];
+    uint32_t connected_at[FLEET_SIZE];
+    
+    memset(jittered, 0, sizeof(jittered));
+    memset(fixed, 0, sizeof(fixed));
+    
+    // Everyone drops at t=0; each device seeds from its own MAC in practice
+    for (int i = 0; i < FLEET_SIZE; i++) {
+        wifi_reconnect_init(&fleet[i], &config, 0x1000u + (uint32_t)i * 7919u);
+        next_attempt[i] = wifi_reconnect_on_disconnect(&fleet[i], 0);
+        connected_at[i] = 0;
+    }
+    
+    // Simulated clock: attempts take no time and fail until the AP is back
+    for (uint32_t now = 0, remaining = FLEET_SIZE; remaining > 0; now++) {
+        for (int i = 0; i < FLEET_SIZE; i++) {
+            if (connected_at[i] || next_attempt[i] != now) continue;
+            
+            wifi_reconnect_on_attempt(&fleet[i], now);
+            if (now >= AP_BACK_MS) {
+                wifi_reconnect_on_connected(&fleet[i], now);
+                connected_at[i] = now;
+                remaining--;
+            } else {
+                jittered[now / RETRY_WINDOW_MS]++;
+                next_attempt[i] = now + wifi_reconnect_on_disconnect(&fleet[i], now);
+            }
+        }
+    }
+    for (uint32_t now = FIXED_INTERVAL_MS; now < AP_BACK_MS; now += FIXED_INTERVAL_MS) {
+        fixed[now / RETRY_WINDOW_MS] += FLEET_SIZE;
+    }
+    
+    uint32_t attempts = 0, successes = 0, last_connect = 0;
+    uint32_t histogram[WIFI_RECONNECT_HISTOGRAM_BUCKETS] = { 0 };
+    for (int i = 0; i < FLEET_SIZE; i++) {
+        attempts += fleet[i].stats.attempts;
+        successes += fleet[i].stats.successes;
+        for (int bucket = 0; bucket < WIFI_RECONNECT_HISTOGRAM_BUCKETS; bucket++) {
+            histogram[bucket] += fleet[i].stats.time_to_connect[bucket];
+        }
+        if (connected_at[i] > last_connect) {
+            last_connect = connected_at[i];
+        }
+    }
+    
+    size_t windows = AP_BACK_MS / RETRY_WINDOW_MS;
+    printf("%d devices, AP back at %u ms: %u attempts, busiest %u ms window %u (fixed interval: %u), "
+           "last connected at %u ms\n", FLEET_SIZE, AP_BACK_MS, attempts, RETRY_WINDOW_MS,
+           busiest_window(jittered, windows), busiest_window(fixed, windows), last_connect);
+    printf("time to connect: <1s %u, <2s %u, <5s %u, <10s %u, <30s %u, >=30s %u\n",
+           histogram[0], histogram[1], histogram[2], histogram[3], histogram[4], histogram[5]);
+    
+    TEST_ASSERT_EQUAL_UINT32(FLEET_SIZE, successes);
+    TEST_ASSERT_EQUAL_UINT32(FLEET_SIZE, histogram[WIFI_RECONNECT_HISTOGRAM_BUCKETS - 1]);
+    // First retries share [base/2, base], so windows early on stay busiest;
+    // with a fixed interval every device lands in the same one
+    TEST_ASSERT_TRUE(busiest_window(jittered, windows) * 3 <= busiest_window(fixed, windows));
+    // Nobody waits more than one capped delay past the AP's return
+    TEST_ASSERT_TRUE(last_connect <= AP_BACK_MS + config.max_delay_ms);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_delay_within_capped_backoff);
+    RUN_TEST(test_same_seed_same_schedule);
+    RUN_TEST(test_stats_and_fast_path);
+    RUN_TEST(test_fleet_spreads_retries);
+    return UNITY_END();
+}
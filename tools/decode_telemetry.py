@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Decode binary telemetry records (src/modules/telemetry_log) to CSV or text.
+
+Reads a raw capture of the serial port (or the native build's stdout) and
+extracts the 16-byte records, skipping text logs and corrupt bytes around them.
+
+    python tools/decode_telemetry.py capture.bin
+    .pio/build/native/program 60000 | python tools/decode_telemetry.py --format text
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+RECORD_SIZE = 16
+RECORD_SAMPLE = 0x01
+RECORD_TIMEBASE = 0x02
+
+# sync[2] type seq dt_ms payload[8] crc
+HEADER = struct.Struct("<2sBBH")
+SAMPLE = struct.Struct("<HhHH")
+TIMEBASE = struct.Struct("<II")
+CRC = struct.Struct("<H")
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def records(stream):
+    """Yield (type, seq, dt_ms, payload) for every record with a valid CRC."""
+    buffer = bytearray()
+    stats = {"crc_errors": 0, "skipped_bytes": 0}
+
+    while True:
+        chunk = stream.read(4096)
+        if chunk:
+            buffer += chunk
+
+        while True:
+            start = buffer.find(SYNC)
+            if start < 0:
+                keep = 1 if buffer.endswith(SYNC[:1]) else 0
+                stats["skipped_bytes"] += len(buffer) - keep
+                del buffer[:len(buffer) - keep]
+                break
+            stats["skipped_bytes"] += start
+            del buffer[:start]
+            if len(buffer) < RECORD_SIZE:
+                break
+
+            record = bytes(buffer[:RECORD_SIZE])
+            (crc,) = CRC.unpack_from(record, RECORD_SIZE - 2)
+            if crc16_ccitt(record[2:RECORD_SIZE - 2]) != crc:
+                # False sync inside text or a damaged record: resync one byte on
+                stats["crc_errors"] += 1
+                del buffer[:1]
+                continue
+
+            del buffer[:RECORD_SIZE]
+            _, kind, seq, dt_ms = HEADER.unpack_from(record)
+            yield kind, seq, dt_ms, record[HEADER.size:RECORD_SIZE - 2]
+
+        if not chunk:
+            break
+
+    records.stats = stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="capture file (default: stdin)")
+    parser.add_argument("--format", choices=("csv", "text"), default="csv")
+    args = parser.parse_args()
+
+    stream = open(args.input, "rb") if args.input else sys.stdin.buffer
+    out = sys.stdout
+
+    if args.format == "csv":
+        out.write("time_ms,seq,raw,temperature_c,humidity_pct,voltage_v\n")
+
+    time_ms = None
+    expected_seq = None
+    samples = 0
+    lost = 0
+
+    for kind, seq, dt_ms, payload in records(stream):
+        # A timebase at seq 0 starts a new encoder (reboot, or one MQTT
+        # uplink payload per batch), so it is not a gap
+        fresh_stream = kind == RECORD_TIMEBASE and seq == 0
+        if expected_seq is not None and seq != expected_seq and not fresh_stream:
+            lost += (seq - expected_seq) & 0xFF
+        expected_seq = (seq + 1) & 0xFF
+
+        if kind == RECORD_TIMEBASE:
+            time_ms, _ = TIMEBASE.unpack(payload)
+            continue
+        if kind != RECORD_SAMPLE or time_ms is None:
+            continue  # Unknown type, or no timebase seen yet
+
+        time_ms += dt_ms
+        raw, temp_cdeg, hum_cpct, volt_mv = SAMPLE.unpack(payload)
+        samples += 1
+
+        if args.format == "csv":
+            out.write("%d,%d,%d,%.2f,%.2f,%.3f\n"
+                      % (time_ms, seq, raw, temp_cdeg / 100.0, hum_cpct / 100.0, volt_mv / 1000.0))
+        else:
+            out.write("[%8d] Raw: %d, Temp: %.2fC, Hum: %.2f%%, Volt: %.3fV\n"
+                      % (time_ms, raw, temp_cdeg / 100.0, hum_cpct / 100.0, volt_mv / 1000.0))
+
+    stats = getattr(records, "stats", {})
+    sys.stderr.write("%d samples, %d records lost, %d CRC errors\n"
+                     % (samples, lost, stats.get("crc_errors", 0)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""Convert trace_recorder dumps (src/modules/trace_recorder) to Chrome trace JSON.
+
+Reads a capture of the serial port (or the native build's stdout), picks out
+the "TRACE ..." lines of every dump in it and writes one timeline that loads
+in chrome://tracing or https://ui.perfetto.dev: a "CPU" process with one row
+per core showing which task ran, and a "Tasks" process with one row per task
+showing its spans and instants.
+
+    python tools/trace_to_chrome.py capture.txt -o trace.json
+    .pio/build/native/program 20000 | python tools/trace_to_chrome.py > trace.json
+"""
+
+import argparse
+import json
+import sys
+
+TASK_IN = 1
+TASK_OUT = 2
+SPAN_BEGIN = 3
+SPAN_END = 4
+INSTANT = 5
+
+CPU_PID = 0
+TASKS_PID = 1
+
+# Instant arguments worth naming
+WIFI_STATES = ("disconnected", "connecting", "connected", "failed")
+
+
+def trace_lines(stream):
+    """Yield the fields of each TRACE line, skipping logs and binary records."""
+    for raw in stream:
+        line = raw.decode("latin-1")
+        start = line.find("TRACE ")
+        if start >= 0:
+            yield line[start:].split()[1:]
+
+
+class Timeline:
+    def __init__(self):
+        self.clock_hz = 1000000
+        self.spans = {}
+        self.tasks = {}
+        self.events = {}   # core -> [(time, order, type, task, span, arg)]
+        self.epoch = {}    # core -> (last raw time, wrap offset)
+        self.order = 0
+        self.dumps = 0
+        self.lost = 0
+        self.malformed = 0
+        self.cost_ns = []  # Per dump, measured on the device
+
+    def add(self, fields):
+        try:
+            kind = fields[0]
+            if kind == "begin":
+                self.clock_hz = int(fields[2])
+            elif kind == "span":
+                self.spans[int(fields[1])] = fields[2]
+            elif kind == "task":
+                self.tasks[int(fields[1], 16)] = "%s (prio %s)" % (fields[3], fields[2])
+            elif kind == "ev":
+                core, time, event_type, task, span, arg = (int(fields[1]), int(fields[2]), int(fields[3]),
+                                                            int(fields[4], 16), int(fields[5]), int(fields[6]))
+                self.add_event(core, time, event_type, task, span, arg)
+            elif kind == "cost":
+                self.cost_ns.append(int(fields[1]))
+            elif kind == "end":
+                self.dumps += 1
+                self.lost += int(fields[2])
+        except (IndexError, ValueError):
+            self.malformed += 1  # Cut short, or another task wrote into the line
+
+    def add_event(self, core, time, kind, task, span, arg):
+        # 32-bit clock: a large step backwards is a wrap
+        last, offset = self.epoch.get(core, (time, 0))
+        if time < last and last - time > 1 << 31:
+            offset += 1 << 32
+        self.epoch[core] = (time, offset)
+        self.order += 1
+        self.events.setdefault(core, []).append((time + offset, self.order, kind, task, span, arg))
+
+    def task_name(self, task):
+        return self.tasks.get(task, "task %08x" % task)
+
+    def chrome_events(self):
+        out = []
+        threads = {}
+
+        def task_tid(task):
+            if task not in threads:
+                threads[task] = len(threads)
+                out.append({"ph": "M", "name": "thread_name", "pid": TASKS_PID, "tid": threads[task],
+                            "args": {"name": self.task_name(task)}})
+            return threads[task]
+
+        out.append({"ph": "M", "name": "process_name", "pid": CPU_PID, "args": {"name": "CPU"}})
+        out.append({"ph": "M", "name": "process_name", "pid": TASKS_PID, "args": {"name": "Tasks"}})
+
+        merged = []
+        for core, events in sorted(self.events.items()):
+            out.append({"ph": "M", "name": "thread_name", "pid": CPU_PID, "tid": core,
+                        "args": {"name": "Core %d" % core}})
+            events.sort()
+            # Events within one clock tick keep their ring order, 1 ns apart
+            previous = None
+            for time, order, kind, task, span, arg in events:
+                us = time * 1e6 / self.clock_hz
+                if previous is not None and us <= previous:
+                    us = previous + 0.001
+                previous = us
+                merged.append((us, order, core, kind, task, span, arg))
+        merged.sort()
+
+        running = {}  # core -> (task, start)
+        open_spans = {}  # task -> [(span, start)]
+        end_us = merged[-1][0] if merged else 0
+
+        def switch_out(core, us):
+            if core in running:
+                task, start = running.pop(core)
+                out.append({"ph": "X", "name": self.task_name(task), "pid": CPU_PID, "tid": core,
+                            "ts": start, "dur": us - start})
+
+        for us, _, core, kind, task, span, arg in merged:
+            name = self.spans.get(span, "span %d" % span)
+            if kind == TASK_IN:
+                switch_out(core, us)
+                running[core] = (task, us)
+            elif kind == TASK_OUT:
+                if core in running and running[core][0] == task:
+                    switch_out(core, us)
+            elif kind == SPAN_BEGIN:
+                open_spans.setdefault(task, []).append((span, us))
+            elif kind == SPAN_END:
+                stack = open_spans.get(task, [])
+                for i in range(len(stack) - 1, -1, -1):
+                    if stack[i][0] == span:
+                        start = stack.pop(i)[1]
+                        out.append({"ph": "X", "name": name, "pid": TASKS_PID, "tid": task_tid(task),
+                                    "ts": start, "dur": us - start, "args": {"core": core}})
+                        break
+                # No begin: it was overwritten before the dump
+            elif kind == INSTANT:
+                args = {"arg": arg, "core": core}
+                if name == "wifi_state" and arg < len(WIFI_STATES):
+                    args["state"] = WIFI_STATES[arg]
+                out.append({"ph": "i", "s": "t", "name": name, "pid": TASKS_PID, "tid": task_tid(task),
+                            "ts": us, "args": args})
+
+        for core in list(running):
+            switch_out(core, end_us)
+        for task, stack in open_spans.items():
+            for span, start in stack:
+                # Still open when the last dump was taken
+                out.append({"ph": "B", "name": self.spans.get(span, "span %d" % span), "pid": TASKS_PID,
+                            "tid": task_tid(task), "ts": start})
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="capture file (default: stdin)")
+    parser.add_argument("-o", "--output", help="JSON file (default: stdout)")
+    args = parser.parse_args()
+
+    stream = open(args.input, "rb") if args.input else sys.stdin.buffer
+    timeline = Timeline()
+    for fields in trace_lines(stream):
+        if fields:
+            timeline.add(fields)
+
+    events = timeline.chrome_events()
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, out)
+    out.write("\n")
+
+    recorded = sum(len(core_events) for core_events in timeline.events.values())
+    sys.stderr.write("%d dumps, %d events, %d tasks named, %d events lost, %d malformed lines\n"
+                     % (timeline.dumps, recorded, len(timeline.tasks), timeline.lost, timeline.malformed))
+    if timeline.cost_ns:
+        sys.stderr.write("recording cost %d-%d ns/event (measured by the device at each dump)\n"
+                         % (min(timeline.cost_ns), max(timeline.cost_ns)))
+
+
+if __name__ == "__main__":
+    main()
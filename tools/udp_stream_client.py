@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Subscribe to the UDP sample stream (src/modules/udp_streamer) and report rate and loss.
+
+Sends a subscribe request to the device, renews it while running, and prints
+one line per interval: samples/s, datagrams/s, datagrams lost (seq gaps) and
+the device-side batching latency (send time minus oldest sample time).
+
+    python tools/udp_stream_client.py 192.168.1.50
+    python tools/udp_stream_client.py 127.0.0.1 --duration 30 --csv samples.csv
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+from decode_telemetry import (CRC, HEADER, RECORD_SAMPLE, RECORD_SIZE, RECORD_TIMEBASE,
+                              SAMPLE, TIMEBASE, crc16_ccitt)
+
+MAGIC = b"SS"
+VERSION = 1
+DATA = 0x01
+SUBSCRIBE = 0x02
+UNSUBSCRIBE = 0x03
+
+# magic[2] version type seq time_ms count reserved
+STREAM_HEADER = struct.Struct("<2sBBIIHH")
+
+
+def request(kind):
+    return STREAM_HEADER.pack(MAGIC, VERSION, kind, 0, 0, 0, 0)
+
+
+def parse(datagram):
+    """Return (seq, time_ms, [(time_ms, raw, temp_c, hum_pct, volt_v)]), or None."""
+    if len(datagram) < STREAM_HEADER.size:
+        return None
+    magic, version, kind, seq, sent_ms, count, _ = STREAM_HEADER.unpack_from(datagram)
+    if magic != MAGIC or version != VERSION or kind != DATA:
+        return None
+
+    samples = []
+    time_ms = None
+    for offset in range(STREAM_HEADER.size, len(datagram) - RECORD_SIZE + 1, RECORD_SIZE):
+        record = datagram[offset:offset + RECORD_SIZE]
+        (crc,) = CRC.unpack_from(record, RECORD_SIZE - 2)
+        if crc16_ccitt(record[2:RECORD_SIZE - 2]) != crc:
+            return None
+        _, kind, _, dt_ms = HEADER.unpack_from(record)
+        payload = record[HEADER.size:RECORD_SIZE - 2]
+        if kind == RECORD_TIMEBASE:
+            time_ms, _ = TIMEBASE.unpack(payload)
+        elif kind == RECORD_SAMPLE and time_ms is not None:
+            time_ms += dt_ms
+            raw, temp_cdeg, hum_cpct, volt_mv = SAMPLE.unpack(payload)
+            samples.append((time_ms, raw, temp_cdeg / 100.0, hum_cpct / 100.0, volt_mv / 1000.0))
+
+    if len(samples) != count:
+        return None
+    return seq, sent_ms, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="device address (127.0.0.1 for the native build)")
+    parser.add_argument("--port", type=int, default=4950)
+    parser.add_argument("--duration", type=float, default=0, help="seconds to run (default: until Ctrl-C)")
+    parser.add_argument("--interval", type=float, default=1.0, help="seconds between report lines")
+    parser.add_argument("--renew", type=float, default=10.0, help="seconds between subscribe renewals")
+    parser.add_argument("--csv", help="also write every sample to this file")
+    args = parser.parse_args()
+
+    device = (args.host, args.port)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+    sock.settimeout(0.2)
+    csv = open(args.csv, "w") if args.csv else None
+    if csv:
+        csv.write("time_ms,raw,temperature_c,humidity_pct,voltage_v\n")
+
+    start = time.monotonic()
+    renew_at = start
+    report_at = start + args.interval
+    expected_seq = None
+    totals = {"samples": 0, "datagrams": 0, "lost": 0, "bad": 0}
+    window = {"samples": 0, "datagrams": 0, "lost": 0, "latency": []}
+
+    try:
+        while not args.duration or time.monotonic() - start < args.duration:
+            now = time.monotonic()
+            if now >= renew_at:
+                sock.sendto(request(SUBSCRIBE), device)
+                renew_at = now + args.renew
+
+            try:
+                datagram, _ = sock.recvfrom(2048)
+                parsed = parse(datagram)
+            except socket.timeout:
+                parsed = False
+
+            if parsed is None:
+                totals["bad"] += 1
+            elif parsed:
+                seq, sent_ms, samples = parsed
+                if expected_seq is not None and seq != expected_seq:
+                    window["lost"] += (seq - expected_seq) & 0xFFFFFFFF
+                expected_seq = (seq + 1) & 0xFFFFFFFF
+                window["datagrams"] += 1
+                window["samples"] += len(samples)
+                if samples:
+                    window["latency"].append(sent_ms - samples[0][0])
+                if csv:
+                    for sample in samples:
+                        csv.write("%d,%d,%.2f,%.2f,%.3f\n" % sample)
+
+            now = time.monotonic()
+            if now >= report_at:
+                span = now - report_at + args.interval
+                latency = window["latency"]
+                print("%7.1f s  %9.0f samples/s  %7.0f datagrams/s  %5d lost  latency avg/max %.1f/%d ms"
+                      % (now - start, window["samples"] / span, window["datagrams"] / span, window["lost"],
+                         sum(latency) / len(latency) if latency else 0.0, max(latency) if latency else 0))
+                for key in ("samples", "datagrams", "lost"):
+                    totals[key] += window[key]
+                window = {"samples": 0, "datagrams": 0, "lost": 0, "latency": []}
+                report_at = now + args.interval
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.sendto(request(UNSUBSCRIBE), device)
+
+    for key in ("samples", "datagrams", "lost"):
+        totals[key] += window[key]
+    received = totals["datagrams"]
+    sys.stderr.write("%d samples in %d datagrams, %d datagrams lost (%.3f%%), %d malformed\n"
+                     % (totals["samples"], received, totals["lost"],
+                        100.0 * totals["lost"] / (received + totals["lost"]) if received else 0.0, totals["bad"]))
+
+
+if __name__ == "__main__":
+    main()